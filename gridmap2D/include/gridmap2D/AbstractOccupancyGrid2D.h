@@ -44,13 +44,14 @@
 namespace gridmap2D {
 
 	/**
-	 * Interface class for all grid types that store occupancy. This serves
-	 * as a common base class
+	 * Common base class of all grid types that store occupancy: the sensor
+	 * model, the occupancy queries and the binary IO, for any occupancy node.
+	 * AbstractOccupancyGrid2D adds the updates of Grid2DNode cells.
 	 */
-	class AbstractOccupancyGrid2D : public AbstractGrid2D {
+	class AbstractOccupancyGrid2DBase : public AbstractGrid2D {
 	public:
-		AbstractOccupancyGrid2D();
-		virtual ~AbstractOccupancyGrid2D() {};
+		AbstractOccupancyGrid2DBase();
+		virtual ~AbstractOccupancyGrid2DBase() {};
 
 		//-- IO
 
@@ -103,67 +104,31 @@ namespace gridmap2D {
 		// -- occupancy queries
 
 		/// queries whether a node is occupied according to the grid's parameter for "occupancy"
-		inline bool isNodeOccupied(const Grid2DNode* occupancyNode) const{
+		template <class NODE>
+		inline bool isNodeOccupied(NODE* occupancyNode) const{
 			return (occupancyNode->getLogOdds() >= this->occ_prob_thres_log);
 		}
 
 		/// queries whether a node is occupied according to the grid's parameter for "occupancy"
-		inline bool isNodeOccupied(const Grid2DNode& occupancyNode) const{
+		template <class NODE>
+		inline bool isNodeOccupied(const NODE& occupancyNode) const{
 			return (occupancyNode.getLogOdds() >= this->occ_prob_thres_log);
 		}
 
 		/// queries whether a node is at the clamping threshold according to the grid's parameter
-		inline bool isNodeAtThreshold(const Grid2DNode* occupancyNode) const{
+		template <class NODE>
+		inline bool isNodeAtThreshold(NODE* occupancyNode) const{
 			return (occupancyNode->getLogOdds() >= this->clamping_thres_max
 				|| occupancyNode->getLogOdds() <= this->clamping_thres_min);
 		}
 
 		/// queries whether a node is at the clamping threshold according to the grid's parameter
-		inline bool isNodeAtThreshold(const Grid2DNode& occupancyNode) const{
+		template <class NODE>
+		inline bool isNodeAtThreshold(const NODE& occupancyNode) const{
 			return (occupancyNode.getLogOdds() >= this->clamping_thres_max
 				|| occupancyNode.getLogOdds() <= this->clamping_thres_min);
 		}
 
-		// - update functions
-
-		/**
-		 * Manipulate log_odds value of voxel directly
-		 *
-		 * @param key of the NODE that is to be updated
-		 * @param log_odds_update value to be added (+) to log_odds value of node
-		 * @return pointer to the updated NODE
-		 */
-		virtual Grid2DNode* updateNode(const Grid2DKey& key, float log_odds_update) = 0;
-
-		/**
-		 * Manipulate log_odds value of voxel directly.
-		 * Looks up the Grid2DKey corresponding to the coordinate and then calls udpateNode() with it.
-		 *
-		 * @param value 2d coordinate of the NODE that is to be updated
-		 * @param log_odds_update value to be added (+) to log_odds value of node
-		 * @return pointer to the updated NODE
-		 */
-		virtual Grid2DNode* updateNode(const point2d& value, float log_odds_update) = 0;
-
-		/**
-		 * Integrate occupancy measurement.
-		 *
-		 * @param key of the NODE that is to be updated
-		 * @param occupied true if the node was measured occupied, else false
-		 * @return pointer to the updated NODE
-		 */
-		virtual Grid2DNode* updateNode(const Grid2DKey& key, bool occupied) = 0;
-
-		/**
-		 * Integrate occupancy measurement.
-		 * Looks up the Grid2DKey corresponding to the coordinate and then calls udpateNode() with it.
-		 *
-		 * @param value 2d coordinate of the NODE that is to be updated
-		 * @param occupied true if the node was measured occupied, else false
-		 * @return pointer to the updated NODE
-		 */
-		virtual Grid2DNode* updateNode(const point2d& value, bool occupied) = 0;
-
 		virtual void toMaxLikelihood() = 0;
 
 		//-- parameters for occupancy and sensor model:
@@ -213,6 +178,70 @@ namespace gridmap2D {
 		static const std::string binaryFileHeader;
 	};
 
+
+	/**
+	 * Interface class for all grid types that store occupancy in Grid2DNode
+	 * cells (or cells derived from it). This serves as a common base class
+	 */
+	class AbstractOccupancyGrid2D : public AbstractOccupancyGrid2DBase {
+	public:
+		virtual ~AbstractOccupancyGrid2D() {};
+
+		// - update functions
+
+		/**
+		 * Manipulate log_odds value of voxel directly
+		 *
+		 * @param key of the NODE that is to be updated
+		 * @param log_odds_update value to be added (+) to log_odds value of node
+		 * @return pointer to the updated NODE
+		 */
+		virtual Grid2DNode* updateNode(const Grid2DKey& key, float log_odds_update) = 0;
+
+		/**
+		 * Manipulate log_odds value of voxel directly.
+		 * Looks up the Grid2DKey corresponding to the coordinate and then calls udpateNode() with it.
+		 *
+		 * @param value 2d coordinate of the NODE that is to be updated
+		 * @param log_odds_update value to be added (+) to log_odds value of node
+		 * @return pointer to the updated NODE
+		 */
+		virtual Grid2DNode* updateNode(const point2d& value, float log_odds_update) = 0;
+
+		/**
+		 * Integrate occupancy measurement.
+		 *
+		 * @param key of the NODE that is to be updated
+		 * @param occupied true if the node was measured occupied, else false
+		 * @return pointer to the updated NODE
+		 */
+		virtual Grid2DNode* updateNode(const Grid2DKey& key, bool occupied) = 0;
+
+		/**
+		 * Integrate occupancy measurement.
+		 * Looks up the Grid2DKey corresponding to the coordinate and then calls udpateNode() with it.
+		 *
+		 * @param value 2d coordinate of the NODE that is to be updated
+		 * @param occupied true if the node was measured occupied, else false
+		 * @return pointer to the updated NODE
+		 */
+		virtual Grid2DNode* updateNode(const point2d& value, bool occupied) = 0;
+	};
+
+
+	/**
+	 * Interface of OccupancyGrid2DBase over NODE: AbstractOccupancyGrid2D for
+	 * Grid2DNode and nodes derived from it. Nodes of another value type, such as
+	 * Grid2DQuantizedNode, specialize it to AbstractOccupancyGrid2DBase, so that
+	 * their updateNode() returns their own node type.
+	 *
+	 * \tparam NODE Node class of the grid
+	 */
+	template <class NODE>
+	struct Grid2DOccupancyInterface {
+		typedef AbstractOccupancyGrid2D type;
+	};
+
 }; // end namespace
 
 
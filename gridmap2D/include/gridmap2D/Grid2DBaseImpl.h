@@ -42,6 +42,7 @@
 
 #include "gridmap2D_types.h"
 #include "Grid2DKey.h"
+#include "Grid2DStorage.h"
 #include "ScanGraph.h"
 
 namespace gridmap2D {
@@ -65,9 +66,13 @@ namespace gridmap2D {
 	 * \tparam NODE Node class to be used in grid (usually derived from
 	 *    Grid2DDataNode)
 	 * \tparam INTERFACE Interface to be derived from, should be either
-	 *    AbstractGrid2D or AbstractOccupancyGrid2D
+	 *    AbstractGrid2D, AbstractOccupancyGrid2D or AbstractOccupancyGrid2DBase
+	 * \tparam STORAGE Storage policy of the cells: Grid2DHashStorage (one hash
+	 *    entry per cell), Grid2DOpenStorage (open addressing with inline nodes)
+	 *    or Grid2DShardedStorage (hash maps with a lock per shard, for parallel
+	 *    updates, experimental)
 	 */
-	template <class NODE, class INTERFACE>
+	template <class NODE, class INTERFACE, class STORAGE = Grid2DHashStorage<NODE> >
 	class Grid2DBaseImpl : public INTERFACE {
 
 	public:
@@ -78,7 +83,7 @@ namespace gridmap2D {
 		virtual ~Grid2DBaseImpl();
 
 		/// Deep copy constructor
-		Grid2DBaseImpl(const Grid2DBaseImpl<NODE, INTERFACE>& rhs);
+		Grid2DBaseImpl(const Grid2DBaseImpl<NODE, INTERFACE, STORAGE>& rhs);
 
 
 		/**
@@ -87,11 +92,11 @@ namespace gridmap2D {
 		 * metadata (resolution etc) matches. No memory is cleared
 		 * in this function
 		 */
-		void swapContent(Grid2DBaseImpl<NODE, INTERFACE>& rhs);
+		void swapContent(Grid2DBaseImpl<NODE, INTERFACE, STORAGE>& rhs);
 
 		/// Comparison between two grids, all meta data, all
 		/// nodes, and the structure must be identical
-//		bool operator== (const Grid2DBaseImpl<NODE, INTERFACE>& rhs) const;
+//		bool operator== (const Grid2DBaseImpl<NODE, INTERFACE, STORAGE>& rhs) const;
 
 		std::string getGridType() const { return "Grid2DBaseImpl"; }
 
@@ -109,12 +114,13 @@ namespace gridmap2D {
 			keyrays.clear();
 		}
 
+		/// Storage of the cells, iterating it yields (Grid2DKey, NODE*) pairs
+		typedef STORAGE OccupancyGridMap;
 		/**
 		* \return Pointer to the grid. This pointer
 		* should not be modified or deleted externally, the Grid2D
 		* manages its memory itself.
 		*/
-		typedef unordered_ns::unordered_map<Grid2DKey, NODE*, Grid2DKey::KeyHash> OccupancyGridMap;
 		inline OccupancyGridMap* getGrid() const { return gridmap; }
 
 		/**
@@ -162,7 +168,7 @@ namespace gridmap2D {
 		virtual inline size_t size() const { return gridmap->size(); }
 
 		/// \return Memory usage of the grid2D in bytes (may vary between architectures)
-		virtual size_t memoryUsage() const;     // TODO: add the memory usage of hash table
+		virtual size_t memoryUsage() const;
 
 		/// \return Memory usage of a single grid2D node
 		virtual inline size_t memoryUsageNode() const { return sizeof(NODE); };
@@ -228,6 +234,18 @@ namespace gridmap2D {
 		/// Write complete state of grid to stream (without file header) unmodified.
 		std::ostream& writeData(std::ostream &s) const;
 
+		/**
+		 * Read all cells from the input stream in the bulk format of
+		 * writeBulkData() (without file header), for this the grid needs to
+		 * be already created and empty. With a concurrent storage, the cells
+		 * of a chunk are inserted in parallel. For general file IO, you
+		 * should probably use AbstractGrid2D::readBulk() instead.
+		 */
+		std::istream& readBulkData(std::istream &s);
+
+		/// Write all cells to stream in the bulk format (without file header), see AbstractGrid2D::writeBulk()
+		std::ostream& writeBulkData(std::ostream &s, bool delta_keys = false) const;
+
 		/// @return beginning of the grid as iterator
 //		const OccupancyGridMap::iterator begin() const { return gridmap->begin(); }
 		/// @return end of the grid as iterator
@@ -291,6 +309,22 @@ namespace gridmap2D {
 		}
 
 	protected:
+		/// Number of cells per chunk of the bulk format
+		static const uint32_t BULK_CHUNK_SIZE = 65536;
+		/// Flag of the bulk format: keys are stored as Morton code differences
+		static const uint8_t BULK_DELTA_KEYS = 1;
+		/// Largest number of bytes of a key in the bulk format (a LEB128 coded Morton code)
+		static const uint32_t BULK_MAX_KEY_BYTES = (8 * sizeof(uint32_t) + 6) / 7;
+
+		/// Writes one chunk of the bulk format and empties keys and values
+		static void writeBulkChunk(std::ostream &s, std::vector<uint8_t>& keys, std::vector<typename NODE::DataType>& values);
+
+		/// Sorts the cells of one chunk by Morton code, appends their keys as LEB128 coded differences and their values, and empties cells
+		static void writeBulkDeltaKeys(std::vector<std::pair<uint32_t, typename NODE::DataType> >& cells, std::vector<uint8_t>& keys, std::vector<typename NODE::DataType>& values);
+
+		/// Decodes the keys of one chunk of the bulk format, @return false if they are corrupt
+		static bool readBulkKeys(const std::vector<uint8_t>& keys, uint8_t flags, std::vector<Grid2DKey>& cell_keys);
+
 		/// Constructor to enable derived classes to change grid constants.
 		/// This usually requires a re-implementation of some core grid-traversal functions as well!
 		Grid2DBaseImpl(double resolution, unsigned int grid_max_val);
@@ -298,13 +332,13 @@ namespace gridmap2D {
 		/// initialize non-trivial members, helper for constructors
 		void init();
 
-		/// recalculates min and max in x, y. Does nothing when grid size didn't change.
+		/// updates min_value and max_value from the key bounds of the storage, O(1)
 		void calcMinMax();
 
 	private:
 		/// Assignment operator is private: don't (re-)assign grid2D
 		/// (const-parameters can't be changed) -  use the copy constructor instead.
-		Grid2DBaseImpl<NODE, INTERFACE>& operator=(const Grid2DBaseImpl<NODE, INTERFACE>&);
+		Grid2DBaseImpl<NODE, INTERFACE, STORAGE>& operator=(const Grid2DBaseImpl<NODE, INTERFACE, STORAGE>&);
 
 	protected:
 		OccupancyGridMap* gridmap;
@@ -45,7 +45,7 @@ namespace gridmap2D {
 	};
 
 	// forward declaration for friend in Grid2DDataNode
-	template<typename NODE, typename I> class Grid2DBaseImpl;
+	template<typename NODE, typename I, typename S> class Grid2DBaseImpl;
 
 	/**
 	 * Basic node in the Grid2D that can hold arbitrary data of type T in value.
@@ -54,7 +54,7 @@ namespace gridmap2D {
 	 * \tparam T data to be stored in the node (e.g. a float for probabilities)
 	 */
 	template<typename T> class Grid2DDataNode : public AbstractGrid2DNode {
-		template<typename NODE, typename I>
+		template<typename NODE, typename I, typename S>
 		friend class Grid2DBaseImpl;
 
 	public:
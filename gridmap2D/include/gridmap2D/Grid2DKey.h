@@ -106,17 +106,79 @@ namespace gridmap2D {
 
 		key_type k[2];
 
-		/// Provides a hash function on Keys
+		/// @return Morton code of the key: the bits of k[0] and k[1] interleaved,
+		/// with k[0] in the least significant position. Sorting by it yields the
+		/// Z-order curve over the grid, and keys close in space get close codes.
+		uint32_t mortonCode() const {
+			return spreadBits(k[0]) | (spreadBits(k[1]) << 1);
+		}
+
+		/// @return the key of a Morton code computed by mortonCode()
+		static Grid2DKey fromMortonCode(uint32_t code) {
+			return Grid2DKey(compactBits(code), compactBits(code >> 1));
+		}
+
+		/// Orders keys along the Z-order curve, so that consecutive lookups hit nearby cells
+		struct KeyMortonLess{
+			bool operator()(const Grid2DKey& a, const Grid2DKey& b) const{
+				return a.mortonCode() < b.mortonCode();
+			}
+		};
+
+		/**
+		 * Provides a hash function on Keys: the Morton code of the key. It is injective,
+		 * keeps spatially close keys close in the hash space (scan insertions touch
+		 * neighbouring buckets) and mixes the low bits of all coordinates into the low
+		 * bits of the hash, which also suits power-of-two bucket counts.
+		 */
 		struct KeyHash{
 			std::size_t operator()(const Grid2DKey& key) const{
-				// a simple hashing function 
-				// explicit casts to size_t to operate on the complete range
-				// constanst will be promoted according to C++ standard
+				return static_cast<std::size_t>(key.mortonCode());
+			}
+		};
+
+		/// Packs the two 16 bit coordinates into one integer and mixes it by a
+		/// multiplicative (Fibonacci) hash, so that every bit of the key reaches the
+		/// low bits. Use it for key sets that do not show any spatial coherence.
+		struct MixedKeyHash{
+			std::size_t operator()(const Grid2DKey& key) const{
+				uint64_t packed = static_cast<uint64_t>(key.k[0])
+					| (static_cast<uint64_t>(key.k[1]) << 16);
+				packed *= 0x9E3779B97F4A7C15ULL;
+				return static_cast<std::size_t>(packed ^ (packed >> 32));
+			}
+		};
+
+		/// The former linear hash function, kept for comparison. It maps many keys of a
+		/// map to the same value, e.g. the keys (x + 1447, y) and (x, y + 1).
+		struct LinearKeyHash{
+			std::size_t operator()(const Grid2DKey& key) const{
 				return static_cast<size_t>(key.k[0])
 					+ 1447 * static_cast<size_t>(key.k[1]);
 			}
 		};
 
+	protected:
+		/// spreads the 16 bits of v to every second bit
+		static uint32_t spreadBits(key_type v) {
+			uint32_t x = v;
+			x = (x | (x << 8)) & 0x00FF00FFu;
+			x = (x | (x << 4)) & 0x0F0F0F0Fu;
+			x = (x | (x << 2)) & 0x33333333u;
+			x = (x | (x << 1)) & 0x55555555u;
+			return x;
+		}
+
+		/// inverse of spreadBits(), collects every second bit
+		static key_type compactBits(uint32_t x) {
+			x &= 0x55555555u;
+			x = (x | (x >> 1)) & 0x33333333u;
+			x = (x | (x >> 2)) & 0x0F0F0F0Fu;
+			x = (x | (x >> 4)) & 0x00FF00FFu;
+			x = (x | (x >> 8)) & 0x0000FFFFu;
+			return static_cast<key_type>(x);
+		}
+
 	};
 
 	/**
@@ -49,7 +49,8 @@ namespace gridmap2D {
 	/**
 	 * Base implementation for Occupancy Grid2Ds (e.g. for mapping).
 	 * AbstractOccupancyGrid2D serves as a common
-	 * base interface for all these classes.
+	 * base interface for all these classes (AbstractOccupancyGrid2DBase for
+	 * grids of Grid2DQuantizedNode, see Grid2DOccupancyInterface).
 	 * Each class used as NODE type needs to be derived from
 	 * OccupancyGrid2DNode.
 	 *
@@ -60,9 +61,10 @@ namespace gridmap2D {
 	 *
 	 * \tparam NODE Node class to be used in grid (usually derived from
 	 *    Grid2DDataNode)
+	 * \tparam STORAGE Storage policy of the cells, see Grid2DBaseImpl
 	 */
-	template <class NODE>
-	class OccupancyGrid2DBase : public Grid2DBaseImpl<NODE, AbstractOccupancyGrid2D> {
+	template <class NODE, class STORAGE = Grid2DHashStorage<NODE> >
+	class OccupancyGrid2DBase : public Grid2DBaseImpl<NODE, typename Grid2DOccupancyInterface<NODE>::type, STORAGE> {
 
 	public:
 		/// Default constructor, sets resolution of leafs
@@ -70,7 +72,7 @@ namespace gridmap2D {
 		virtual ~OccupancyGrid2DBase();
 
 		/// Copy constructor
-		OccupancyGrid2DBase(const OccupancyGrid2DBase<NODE>& rhs);
+		OccupancyGrid2DBase(const OccupancyGrid2DBase<NODE, STORAGE>& rhs);
 
 		/**
 		 * Integrate a Pointcloud (in global reference frame), parallelized with OpenMP.
@@ -181,6 +183,31 @@ namespace gridmap2D {
 		 */
 		virtual void toMaxLikelihood();
 
+		/**
+		 * Clamps the log-odds of all cells to the current clamping thresholds.
+		 * Updates keep the cells clamped by themselves, so this is only needed
+		 * after the thresholds were narrowed with setClampingThresMin() or
+		 * setClampingThresMax().
+		 */
+		virtual void updateClamping();
+
+		/**
+		 * Counts the cells of the grid by occupancy. Unknown cells are counted
+		 * inside the bounding box of the known cells.
+		 *
+		 * @param[out] num_free number of known cells below the occupancy threshold
+		 * @param[out] num_occupied number of known cells at or above the occupancy threshold
+		 * @param[out] num_unknown number of unknown cells in the bounding box of the known cells
+		 */
+		void getOccupancyStatistics(size_t& num_free, size_t& num_occupied, size_t& num_unknown) const;
+
+		/**
+		 * Histogram of the log-odds of the known cells in num_bins bins of equal
+		 * width between the clamping thresholds. Cells outside of the thresholds
+		 * are counted in the first or last bin.
+		 */
+		void getOccupancyHistogram(std::vector<size_t>& histogram, unsigned int num_bins) const;
+
 		/**
 		 * Insert one ray between origin and end into the grid.
 		 * integrateMissOnRay() is called for the ray, the end point is updated as occupied.
@@ -214,6 +241,22 @@ namespace gridmap2D {
 		virtual bool castRay(const point2d& origin, const point2d& direction, point2d& end,
 			bool ignoreUnknownCells = false, double maxRange = -1.0) const;
 
+		/**
+		 * Performs castRay() for a batch of rays, in parallel with OpenMP. A cell is found
+		 * by one lookup in the storage, so there is no search path to share between the rays.
+		 *
+		 * @param[in] origins starting coordinates of the rays
+		 * @param[in] directions directions of the rays, one per origin (need not be normalized)
+		 * @param[out] ends the ends of the rays as castRay() returns them
+		 * @param[out] distances distance from the origin to the end of each ray that hit an occupied cell, -1 otherwise
+		 * @param[in] ignoreUnknownCells whether unknown cells are ignored (= treated as free), see castRay()
+		 * @param[in] maxRange Maximum range after which the raycast is aborted (<= 0: no limit, default)
+		 * @return number of rays that hit an occupied cell
+		 */
+		size_t castRays(const std::vector<point2d>& origins, const std::vector<point2d>& directions,
+			std::vector<point2d>& ends, std::vector<double>& distances,
+			bool ignoreUnknownCells = false, double maxRange = -1.0) const;
+
 		/**
 		 * Retrieves the entry point of a ray into a voxel. This is the closest intersection point of the ray
 		 * originating from origin and a plane of the axis aligned cube.
@@ -267,6 +310,51 @@ namespace gridmap2D {
 		/// Number of changes since last reset.
 		size_t numChangesDetected() const { return changed_keys.size(); }
 
+		//-- frontier tracking for exploration:
+		/// Connected set of frontier cells, see getFrontierClusters()
+		struct FrontierCluster {
+			std::vector<Grid2DKey> keys; ///< keys of the frontier cells
+			point2d centroid;            ///< mean of the cell centers
+			point2d bbx_min;             ///< minimum of the cell centers
+			point2d bbx_max;             ///< maximum of the cell centers
+		};
+
+		/**
+		 * Maintains an index of the frontier cells: known free cells with at least one
+		 * unknown edge neighbor (default: off). The node updates record the cells that
+		 * became known or changed their occupancy, and updateFrontiers() checks only
+		 * these cells and the neighbors of the new ones. The scan insertions call
+		 * updateFrontiers() when they are done.
+		 * Enabling builds the index of the current map with rebuildFrontiers().
+		 */
+		void enableFrontierTracking(bool enable);
+		bool isFrontierTrackingEnabled() const { return use_frontier_tracking; }
+
+		/// Checks the cells changed since the last call and updates the frontier index
+		void updateFrontiers();
+
+		/// Builds the frontier index from the whole map. Needed after changes which are not
+		/// recorded: deleteNode(), clear() or cells dropped by a rolling storage.
+		/// Reading a map rebuilds the index.
+		void rebuildFrontiers();
+
+		/// @return keys of all frontier cells, as of the last updateFrontiers()
+		const KeySet& getFrontiers() const { return frontier_keys; }
+
+		/// @return number of frontier cells, as of the last updateFrontiers()
+		size_t numFrontiers() const { return frontier_keys.size(); }
+
+		/// Appends the centers of all frontier cells to node_centers
+		void getFrontierCenters(point2d_list& node_centers) const;
+
+		/**
+		 * Groups the frontier cells into clusters of 8-connected cells. The cost depends
+		 * on the number of frontier cells only, not on the size of the map.
+		 * @param[out] clusters the clusters with at least min_cluster_size cells, largest first
+		 * @param[in] min_cluster_size smaller clusters (e.g. single cells from sensor noise) are dropped
+		 */
+		void getFrontierClusters(std::vector<FrontierCluster>& clusters, size_t min_cluster_size = 1) const;
+
 		// -- I/O  -----------------------------------------
 
 		/**
@@ -304,6 +392,103 @@ namespace gridmap2D {
 		 */
 		inline bool integrateMissOnRay(const point2d& origin, const point2d& end);
 
+		/**
+		 * Calls updateNode() while holding the lock of the key's shard, so that
+		 * rays can be integrated in parallel without a critical section if the
+		 * storage is concurrent (see Grid2DStorageTraits). Only the experimental
+		 * Grid2DShardedStorage is; with every other storage the updates are
+		 * serialized by the caller as before.
+		 */
+		void updateNodeLocked(const Grid2DKey& key, float log_odds_update);
+
+		/// Same as updateNodeLocked() for all cells of ray, but locks a shard only once per run of consecutive cells in it
+		void updateNodesLocked(const KeyRay& ray, float log_odds_update);
+
+		/// Records a key that was created (node_just_created) or changed its occupancy
+		/// for change detection and frontier tracking, safe to call from parallel updates
+		void trackChange(const Grid2DKey& key, bool node_just_created);
+
+		/// @return true if key is a known free cell with an unknown edge neighbor
+		bool isFrontier(const Grid2DKey& key) const;
+
+		/// Orders frontier clusters by decreasing size
+		struct FrontierClusterLarger {
+			bool operator()(const FrontierCluster& a, const FrontierCluster& b) const {
+				return a.keys.size() > b.keys.size();
+			}
+		};
+
+		/*
+		 * Kernels of the whole-map passes, run by the storage over its nodes
+		 * (see transformNodes() and reduceNodes() of the storages). The values
+		 * to set are converted to the node's data type once, so the per-cell
+		 * work is a comparison and a select without branches, which the
+		 * compiler vectorizes on the dense storages.
+		 */
+		typedef typename NODE::DataType DataType;
+
+		/// sets a node to the clamping threshold on its side of the occupancy threshold
+		struct MaxLikelihoodOp {
+			float occ_thres;
+			DataType occupied, free;
+			inline void operator()(NODE& node) const {
+				node.setValue(node.getLogOdds() >= occ_thres ? occupied : free);
+			}
+		};
+
+		/// clamps a node to the clamping thresholds
+		struct ClampingOp {
+			float thres_min, thres_max;
+			DataType value_min, value_max;
+			inline void operator()(NODE& node) const {
+				float log_odds = node.getLogOdds();
+				node.setValue(log_odds < thres_min ? value_min : (log_odds > thres_max ? value_max : node.getValue()));
+			}
+		};
+
+		/// counts the known and the occupied cells of a run of up to 64 cells
+		struct StatisticsOp {
+			float occ_thres;
+			size_t num_known, num_occupied;
+			inline void operator()(const NODE* nodes, unsigned int count, uint64_t known) {
+				unsigned int occupied = 0;
+				if (count == 64 && known == ~(uint64_t)0) {
+					for (unsigned int i = 0; i < 64; i++)
+						occupied += (unsigned int)(nodes[i].getLogOdds() >= occ_thres);
+					num_known += 64;
+				}
+				else {
+					for (unsigned int i = 0; i < count; i++) {
+						unsigned int is_known = (unsigned int)(known >> i) & 1u;
+						occupied += is_known & (unsigned int)(nodes[i].getLogOdds() >= occ_thres);
+						num_known += is_known;
+					}
+				}
+				num_occupied += occupied;
+			}
+			void merge(const StatisticsOp& other) {
+				num_known += other.num_known;
+				num_occupied += other.num_occupied;
+			}
+		};
+
+		/// histogram of the log-odds of the known cells of a run of up to 64 cells
+		struct HistogramOp {
+			float thres_min, bin_scale;
+			std::vector<size_t> bins;
+			inline void operator()(const NODE* nodes, unsigned int count, uint64_t known) {
+				for (unsigned int i = 0; i < count; i++) {
+					int bin = (int)((nodes[i].getLogOdds() - thres_min) * bin_scale);
+					bin = std::max(0, std::min(bin, (int)bins.size() - 1));
+					bins[bin] += (size_t)(known >> i) & 1;
+				}
+			}
+			void merge(const HistogramOp& other) {
+				for (size_t i = 0; i < bins.size(); i++)
+					bins[i] += other.bins[i];
+			}
+		};
+
 	protected:
 		bool use_bbx_limit;  ///< use bounding box for queries (needs to be set)?
 		point2d bbx_min;
@@ -314,6 +499,13 @@ namespace gridmap2D {
 		bool use_change_detection;
 		/// Set of keys which changed since last resetChangeDetection
 		KeyBoolMap changed_keys;
+
+		bool use_frontier_tracking;
+		/// Keys of the frontier cells
+		KeySet frontier_keys;
+		/// Keys changed since the last updateFrontiers(), true if the node was created. A plain
+		/// log (duplicates are removed by updateFrontiers()) does not allocate per change.
+		std::vector<std::pair<Grid2DKey, bool> > frontier_updates;
 	};
 
 } // namespace
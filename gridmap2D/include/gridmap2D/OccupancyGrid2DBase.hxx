@@ -36,36 +36,40 @@
 
 namespace gridmap2D {
 
-	template <class NODE>
-	OccupancyGrid2DBase<NODE>::OccupancyGrid2DBase(double in_resolution)
-		: Grid2DBaseImpl<NODE, AbstractOccupancyGrid2D>(in_resolution), use_bbx_limit(false), use_change_detection(false)
+	template <class NODE, class S>
+	OccupancyGrid2DBase<NODE, S>::OccupancyGrid2DBase(double in_resolution)
+		: Grid2DBaseImpl<NODE, typename Grid2DOccupancyInterface<NODE>::type, S>(in_resolution), use_bbx_limit(false), use_change_detection(false),
+		  use_frontier_tracking(false)
 	{
 		if (this->gridmap == NULL)
-			this->gridmap = new typename Grid2DBaseImpl<NODE, AbstractOccupancyGrid2D>::OccupancyGridMap;
+			this->gridmap = new typename Grid2DBaseImpl<NODE, typename Grid2DOccupancyInterface<NODE>::type, S>::OccupancyGridMap;
 	}
 
-	template <class NODE>
-	OccupancyGrid2DBase<NODE>::OccupancyGrid2DBase(double in_resolution, unsigned int in_grid_max_val)
-		: Grid2DBaseImpl<NODE, AbstractOccupancyGrid2D>(in_resolution, in_grid_max_val), use_bbx_limit(false), use_change_detection(false)
+	template <class NODE, class S>
+	OccupancyGrid2DBase<NODE, S>::OccupancyGrid2DBase(double in_resolution, unsigned int in_grid_max_val)
+		: Grid2DBaseImpl<NODE, typename Grid2DOccupancyInterface<NODE>::type, S>(in_resolution, in_grid_max_val), use_bbx_limit(false), use_change_detection(false),
+		  use_frontier_tracking(false)
 	{
 		if (this->gridmap == NULL)
-			this->gridmap = new typename Grid2DBaseImpl<NODE, AbstractOccupancyGrid2D>::OccupancyGridMap;
+			this->gridmap = new typename Grid2DBaseImpl<NODE, typename Grid2DOccupancyInterface<NODE>::type, S>::OccupancyGridMap;
 	}
 
-	template <class NODE>
-	OccupancyGrid2DBase<NODE>::~OccupancyGrid2DBase(){
+	template <class NODE, class S>
+	OccupancyGrid2DBase<NODE, S>::~OccupancyGrid2DBase(){
 		if (this->gridmap){
 			delete this->gridmap;
 			this->gridmap = NULL;
 		}
 	}
 
-	template <class NODE>
-	OccupancyGrid2DBase<NODE>::OccupancyGrid2DBase(const OccupancyGrid2DBase<NODE>& rhs) :
-		Grid2DBaseImpl<NODE, AbstractOccupancyGrid2D>(rhs), use_bbx_limit(rhs.use_bbx_limit),
+	template <class NODE, class S>
+	OccupancyGrid2DBase<NODE, S>::OccupancyGrid2DBase(const OccupancyGrid2DBase<NODE, S>& rhs) :
+		Grid2DBaseImpl<NODE, typename Grid2DOccupancyInterface<NODE>::type, S>(rhs), use_bbx_limit(rhs.use_bbx_limit),
 		bbx_min(rhs.bbx_min), bbx_max(rhs.bbx_max),
 		bbx_min_key(rhs.bbx_min_key), bbx_max_key(rhs.bbx_max_key),
-		use_change_detection(rhs.use_change_detection), changed_keys(rhs.changed_keys)
+		use_change_detection(rhs.use_change_detection), changed_keys(rhs.changed_keys),
+		use_frontier_tracking(rhs.use_frontier_tracking), frontier_keys(rhs.frontier_keys),
+		frontier_updates(rhs.frontier_updates)
 	{
 		this->clamping_thres_min = rhs.clamping_thres_min;
 		this->clamping_thres_max = rhs.clamping_thres_max;
@@ -74,8 +78,8 @@ namespace gridmap2D {
 		this->occ_prob_thres_log = rhs.occ_prob_thres_log;
 	}
 
-	template <class NODE>
-	void OccupancyGrid2DBase<NODE>::insertPointCloudRays(const Pointcloud& pc, const point2d& origin, double maxrange) {
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::insertPointCloudRays(const Pointcloud& pc, const point2d& origin, double maxrange) {
 		if (pc.size() < 1)
 			return;
 
@@ -92,40 +96,60 @@ namespace gridmap2D {
 			KeyRay* keyray = &(this->keyrays.at(threadIdx));
 
 			if (this->computeRayKeys(origin, p, *keyray)){
+				if (Grid2DStorageTraits<S>::concurrent) {
+					// the storage locks the shards of the cells, no need to serialize the rays
+					updateNodesLocked(*keyray, this->prob_miss_log); // insert freespace measurement
+					Grid2DKey key;
+					if (this->coordToKeyChecked(p, key))
+						updateNodeLocked(key, this->prob_hit_log); // update endpoint to be occupied
+				}
+				else {
 #ifdef _OPENMP
 #pragma omp critical
 #endif
-				{
-					for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
-						updateNode(*it, false); // insert freespace measurement
+					{
+						for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
+							updateNode(*it, false); // insert freespace measurement
+						}
+						updateNode(p, true); // update endpoint to be occupied
 					}
-					updateNode(p, true); // update endpoint to be occupied
 				}
 			}
 
 		}
+
+		if (use_frontier_tracking)
+			updateFrontiers();
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid2DBase<NODE>::setNodeValue(const Grid2DKey& key, float log_odds_value) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid2DBase<NODE, S>::setNodeValue(const Grid2DKey& key, float log_odds_value) {
 		// clamp log odds within range:
 		log_odds_value = std::min(std::max(log_odds_value, this->clamping_thres_min), this->clamping_thres_max);
 
-		typename Grid2DBaseImpl<NODE, AbstractOccupancyGrid2D>::OccupancyGridMap::iterator cell = this->gridmap->find(key);
-		if (cell == this->gridmap->end()){
-			NODE* node = new NODE();
+		if (use_change_detection || use_frontier_tracking) {
+			NODE* node = this->search(key);
+			bool node_just_created = (node == NULL);
+			bool occBefore = node && this->isNodeOccupied(node);
+			if (!node) {
+				node = this->gridmap->createNode(key);
+				if (!node)
+					return NULL;
+			}
 			node->setLogOdds(log_odds_value);
-			this->gridmap->insert(std::pair<Grid2DKey, NODE*>(key, node));
+			if (node_just_created || occBefore != this->isNodeOccupied(node))
+				trackChange(key, node_just_created);
 			return node;
 		}
-		else{
-			(cell->second)->setLogOdds(log_odds_value);
-			return cell->second;
-		}
+
+		NODE* node = this->gridmap->createNode(key);
+		if (node)
+			node->setLogOdds(log_odds_value);
+		return node;
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid2DBase<NODE>::setNodeValue(const point2d& value, float log_odds_value) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid2DBase<NODE, S>::setNodeValue(const point2d& value, float log_odds_value) {
 		Grid2DKey key;
 		if (!this->coordToKeyChecked(value, key))
 			return NULL;
@@ -133,8 +157,8 @@ namespace gridmap2D {
 		return setNodeValue(key, log_odds_value);
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid2DBase<NODE>::setNodeValue(double x, double y, float log_odds_value) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid2DBase<NODE, S>::setNodeValue(double x, double y, float log_odds_value) {
 		Grid2DKey key;
 		if (!this->coordToKeyChecked(x, y, key))
 			return NULL;
@@ -143,8 +167,8 @@ namespace gridmap2D {
 	}
 
 
-	template <class NODE>
-	NODE* OccupancyGrid2DBase<NODE>::updateNode(const Grid2DKey& key, float log_odds_update) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid2DBase<NODE, S>::updateNode(const Grid2DKey& key, float log_odds_update) {
 		// early abort (no change will happen).
 		// may cause an overhead in some configuration, but more often helps
 		NODE* node = this->search(key);
@@ -156,17 +180,221 @@ namespace gridmap2D {
 			return node;
 		}
 
-		if (!node){
-			node = new NODE();
-			this->gridmap->insert(std::pair<Grid2DKey, NODE*>(key, node));
+		bool node_just_created = (node == NULL);
+		if (!node) {
+			// the storage may not hold the cell (e.g., outside a rolling window)
+			node = this->gridmap->createNode(key);
+			if (!node)
+				return NULL;
+		}
+
+		if (use_change_detection || use_frontier_tracking) {
+			bool occBefore = !node_just_created && this->isNodeOccupied(node);
+			node->addValue(log_odds_update);
+			if (node_just_created || occBefore != this->isNodeOccupied(node))
+				trackChange(key, node_just_created);
+		}
+		else {
+			node->addValue(log_odds_update);
 		}
-		node->addValue(log_odds_update);
 
 		return node;
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid2DBase<NODE>::updateNode(const point2d& value, float log_odds_update) {
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::updateNodeLocked(const Grid2DKey& key, float log_odds_update) {
+		unsigned int shard = Grid2DStorageTraits<S>::shard(*this->gridmap, key);
+		Grid2DStorageTraits<S>::lock(*this->gridmap, shard);
+		updateNode(key, log_odds_update);
+		Grid2DStorageTraits<S>::unlock(*this->gridmap, shard);
+	}
+
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::updateNodesLocked(const KeyRay& ray, float log_odds_update) {
+		KeyRay::const_iterator it = ray.begin();
+		while (it != ray.end()) {
+			// keep the lock for the following cells of the ray in the same shard
+			unsigned int shard = Grid2DStorageTraits<S>::shard(*this->gridmap, *it);
+			Grid2DStorageTraits<S>::lock(*this->gridmap, shard);
+			do {
+				updateNode(*it, log_odds_update);
+			} while (++it != ray.end() && Grid2DStorageTraits<S>::shard(*this->gridmap, *it) == shard);
+			Grid2DStorageTraits<S>::unlock(*this->gridmap, shard);
+		}
+	}
+
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::trackChange(const Grid2DKey& key, bool node_just_created) {
+		// the updates of concurrent storages run in parallel, named to nest in the critical section of the rays
+#ifdef _OPENMP
+#pragma omp critical (gridmap2D_track_change)
+#endif
+		{
+			if (use_change_detection) {
+				if (node_just_created){  // new node
+					changed_keys.insert(std::pair<Grid2DKey, bool>(key, true));
+				}
+				else {  // occupancy changed, track it
+					KeyBoolMap::iterator it = changed_keys.find(key);
+					if (it == changed_keys.end())
+						changed_keys.insert(std::pair<Grid2DKey, bool>(key, false));
+					else if (it->second == false)
+						changed_keys.erase(it);
+				}
+			}
+			if (use_frontier_tracking) {
+				frontier_updates.push_back(std::pair<Grid2DKey, bool>(key, node_just_created));
+			}
+		}
+	}
+
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::enableFrontierTracking(bool enable) {
+		if (enable == use_frontier_tracking)
+			return;
+		use_frontier_tracking = enable;
+		if (enable)
+			rebuildFrontiers();
+		else {
+			KeySet().swap(frontier_keys);
+			std::vector<std::pair<Grid2DKey, bool> >().swap(frontier_updates);
+		}
+	}
+
+	template <class NODE, class S>
+	bool OccupancyGrid2DBase<NODE, S>::isFrontier(const Grid2DKey& key) const {
+		NODE* node = this->search(key);
+		if (node == NULL || this->isNodeOccupied(node))
+			return false;
+
+		const key_type max_key = (key_type) (2 * this->grid_max_val - 1);
+		Grid2DKey neighbor = key;
+		for (unsigned int i = 0; i < 2; ++i) {
+			if (key[i] > 0) {
+				neighbor[i] = key[i] - 1;
+				if (this->search(neighbor) == NULL)
+					return true;
+			}
+			if (key[i] < max_key) {
+				neighbor[i] = key[i] + 1;
+				if (this->search(neighbor) == NULL)
+					return true;
+			}
+			neighbor[i] = key[i];
+		}
+		return false;
+	}
+
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::updateFrontiers() {
+		if (frontier_updates.empty())
+			return;
+
+		// A cell that became known can only stop its edge neighbors from being frontiers,
+		// a cell that changed its occupancy can only change its own state
+		const key_type max_key = (key_type) (2 * this->grid_max_val - 1);
+		std::vector<Grid2DKey> candidates;
+		candidates.reserve(2 * frontier_updates.size());
+		for (std::vector<std::pair<Grid2DKey, bool> >::const_iterator it = frontier_updates.begin(); it != frontier_updates.end(); ++it) {
+			candidates.push_back(it->first);
+			if (!it->second)
+				continue;
+			for (unsigned int i = 0; i < 2; ++i) {
+				Grid2DKey neighbor = it->first;
+				if (neighbor[i] > 0) {
+					neighbor[i]--;
+					if (frontier_keys.count(neighbor))
+						candidates.push_back(neighbor);
+					neighbor[i]++;
+				}
+				if (neighbor[i] < max_key) {
+					neighbor[i]++;
+					if (frontier_keys.count(neighbor))
+						candidates.push_back(neighbor);
+				}
+			}
+		}
+		frontier_updates.clear();
+
+		std::sort(candidates.begin(), candidates.end(), Grid2DKey::KeyMortonLess());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+		for (size_t i = 0; i < candidates.size(); ++i) {
+			if (isFrontier(candidates[i]))
+				frontier_keys.insert(candidates[i]);
+			else
+				frontier_keys.erase(candidates[i]);
+		}
+	}
+
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::rebuildFrontiers() {
+		KeySet().swap(frontier_keys);
+		frontier_updates.clear();
+
+		for (typename Grid2DBaseImpl<NODE, typename Grid2DOccupancyInterface<NODE>::type, S>::OccupancyGridMap::iterator it = this->gridmap->begin();
+			 it != this->gridmap->end(); ++it) {
+			if (isFrontier(it->first))
+				frontier_keys.insert(it->first);
+		}
+	}
+
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::getFrontierCenters(point2d_list& node_centers) const {
+		for (KeySet::const_iterator it = frontier_keys.begin(); it != frontier_keys.end(); ++it)
+			node_centers.push_back(this->keyToCoord(*it));
+	}
+
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::getFrontierClusters(std::vector<FrontierCluster>& clusters, size_t min_cluster_size) const {
+		clusters.clear();
+
+		// flood fill over the 8-neighborhood, the cells are removed from unvisited when reached
+		KeySet unvisited(frontier_keys);
+		std::vector<Grid2DKey> keys;
+		const int max_key = 2 * this->grid_max_val - 1;
+		for (KeySet::const_iterator it = frontier_keys.begin(); it != frontier_keys.end(); ++it) {
+			if (unvisited.erase(*it) == 0)
+				continue;
+
+			// the keys of the cluster serve as queue
+			keys.assign(1, *it);
+			for (size_t k = 0; k < keys.size(); ++k) {
+				const Grid2DKey current = keys[k];
+				for (int dx = -1; dx <= 1; ++dx) {
+					for (int dy = -1; dy <= 1; ++dy) {
+						int x = current[0] + dx, y = current[1] + dy;
+						if (x < 0 || y < 0 || x > max_key || y > max_key)
+							continue;
+						Grid2DKey neighbor((key_type) x, (key_type) y);
+						if (unvisited.erase(neighbor) != 0)
+							keys.push_back(neighbor);
+					}
+				}
+			}
+			if (keys.size() < min_cluster_size)
+				continue;
+
+			clusters.push_back(FrontierCluster());
+			FrontierCluster& cluster = clusters.back();
+			cluster.keys.swap(keys);
+			double sum[2] = {0.0, 0.0};
+			cluster.bbx_min = cluster.bbx_max = this->keyToCoord(cluster.keys[0]);
+			for (size_t k = 0; k < cluster.keys.size(); ++k) {
+				point2d center = this->keyToCoord(cluster.keys[k]);
+				for (unsigned int i = 0; i < 2; ++i) {
+					sum[i] += center(i);
+					cluster.bbx_min(i) = std::min(cluster.bbx_min(i), center(i));
+					cluster.bbx_max(i) = std::max(cluster.bbx_max(i), center(i));
+				}
+			}
+			cluster.centroid = point2d((float) (sum[0] / cluster.keys.size()), (float) (sum[1] / cluster.keys.size()));
+		}
+
+		std::sort(clusters.begin(), clusters.end(), FrontierClusterLarger());
+	}
+
+	template <class NODE, class S>
+	NODE* OccupancyGrid2DBase<NODE, S>::updateNode(const point2d& value, float log_odds_update) {
 		Grid2DKey key;
 		if (!this->coordToKeyChecked(value, key))
 			return NULL;
@@ -174,8 +402,8 @@ namespace gridmap2D {
 		return updateNode(key, log_odds_update);
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid2DBase<NODE>::updateNode(double x, double y, float log_odds_update) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid2DBase<NODE, S>::updateNode(double x, double y, float log_odds_update) {
 		Grid2DKey key;
 		if (!this->coordToKeyChecked(x, y, key))
 			return NULL;
@@ -183,8 +411,8 @@ namespace gridmap2D {
 		return updateNode(key, log_odds_update);
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid2DBase<NODE>::updateNode(const Grid2DKey& key, bool occupied) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid2DBase<NODE, S>::updateNode(const Grid2DKey& key, bool occupied) {
 		float logOdds = this->prob_miss_log;
 		if (occupied)
 			logOdds = this->prob_hit_log;
@@ -192,41 +420,96 @@ namespace gridmap2D {
 		return updateNode(key, logOdds);
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid2DBase<NODE>::updateNode(const point2d& value, bool occupied) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid2DBase<NODE, S>::updateNode(const point2d& value, bool occupied) {
 		Grid2DKey key;
 		if (!this->coordToKeyChecked(value, key))
 			return NULL;
 		return updateNode(key, occupied);
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid2DBase<NODE>::updateNode(double x, double y, bool occupied) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid2DBase<NODE, S>::updateNode(double x, double y, bool occupied) {
 		Grid2DKey key;
 		if (!this->coordToKeyChecked(x, y, key))
 			return NULL;
 		return updateNode(key, occupied);
 	}
 
-	template <class NODE>
-	void OccupancyGrid2DBase<NODE>::toMaxLikelihood() {
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::toMaxLikelihood() {
 		if (this->gridmap == NULL)
 			return;
 
-		for (typename Grid2DBaseImpl<NODE, AbstractOccupancyGrid2D>::OccupancyGridMap::iterator cell = this->gridmap->begin(); cell != this->gridmap->end(); cell++){
-			nodeToMaxLikelihood(cell->second);
-		}
+		NODE node;
+		MaxLikelihoodOp op;
+		op.occ_thres = this->occ_prob_thres_log;
+		node.setLogOdds(this->clamping_thres_max);
+		op.occupied = node.getValue();
+		node.setLogOdds(this->clamping_thres_min);
+		op.free = node.getValue();
+		this->gridmap->transformNodes(op);
 	}
 
-	template <class NODE>
-	bool OccupancyGrid2DBase<NODE>::castRay(const point2d& origin, const point2d& directionP, point2d& end,
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::updateClamping() {
+		if (this->gridmap == NULL)
+			return;
+
+		NODE node;
+		ClampingOp op;
+		op.thres_min = this->clamping_thres_min;
+		op.thres_max = this->clamping_thres_max;
+		node.setLogOdds(this->clamping_thres_min);
+		op.value_min = node.getValue();
+		node.setLogOdds(this->clamping_thres_max);
+		op.value_max = node.getValue();
+		this->gridmap->transformNodes(op);
+	}
+
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::getOccupancyStatistics(size_t& num_free, size_t& num_occupied, size_t& num_unknown) const {
+		num_free = num_occupied = num_unknown = 0;
+		if (this->gridmap == NULL || this->gridmap->size() == 0)
+			return;
+
+		StatisticsOp op;
+		op.occ_thres = this->occ_prob_thres_log;
+		op.num_known = op.num_occupied = 0;
+		this->gridmap->reduceNodes(op);
+		num_occupied = op.num_occupied;
+		num_free = op.num_known - op.num_occupied;
+
+		const Grid2DKeyBounds& bounds = this->gridmap->getKeyBounds();
+		size_t area = 1;
+		for (unsigned int i = 0; i < 2; i++)
+			area *= (size_t)(bounds.getMax()[i] - bounds.getMin()[i]) + 1;
+		num_unknown = area - op.num_known;
+	}
+
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::getOccupancyHistogram(std::vector<size_t>& histogram, unsigned int num_bins) const {
+		histogram.assign(num_bins, 0);
+		if (this->gridmap == NULL || num_bins == 0)
+			return;
+
+		HistogramOp op;
+		op.thres_min = this->clamping_thres_min;
+		op.bin_scale = num_bins / (this->clamping_thres_max - this->clamping_thres_min);
+		op.bins.assign(num_bins, 0);
+		this->gridmap->reduceNodes(op);
+		histogram.swap(op.bins);
+	}
+
+	template <class NODE, class S>
+	bool OccupancyGrid2DBase<NODE, S>::castRay(const point2d& origin, const point2d& directionP, point2d& end,
 		bool ignoreUnknown, double maxRange) const {
 
 		/// ----------  see Grid2DBase::computeRayKeys  -----------
 
 		// Initialization phase -------------------------------------------------------
 		Grid2DKey current_key;
-		if (!Grid2DBaseImpl<NODE, AbstractOccupancyGrid2D>::coordToKeyChecked(origin, current_key)) {
+		if (!Grid2DBaseImpl<NODE, typename Grid2DOccupancyInterface<NODE>::type, S>::coordToKeyChecked(origin, current_key)) {
 			GRIDMAP2D_WARNING_STR("Coordinates out of bounds during ray casting");
 			return false;
 		}
@@ -336,8 +619,34 @@ namespace gridmap2D {
 		return true;
 	}
 
-	template <class NODE>
-	bool OccupancyGrid2DBase<NODE>::getRayIntersection(const point2d& origin, const point2d& direction, const point2d& center,
+	template <class NODE, class S>
+	size_t OccupancyGrid2DBase<NODE, S>::castRays(const std::vector<point2d>& origins, const std::vector<point2d>& directions,
+		std::vector<point2d>& ends, std::vector<double>& distances,
+		bool ignoreUnknown, double maxRange) const {
+		if (origins.size() != directions.size()) {
+			GRIDMAP2D_ERROR("castRays: %zu origins, but %zu directions given\n", origins.size(), directions.size());
+			return 0;
+		}
+		ends.resize(origins.size());
+		distances.resize(origins.size());
+
+		size_t num_hits = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64) reduction(+ : num_hits)
+#endif
+		for (int i = 0; i < (int)origins.size(); ++i) {
+			if (castRay(origins[i], directions[i], ends[i], ignoreUnknown, maxRange)) {
+				distances[i] = (ends[i] - origins[i]).norm();
+				num_hits++;
+			}
+			else
+				distances[i] = -1.0;
+		}
+		return num_hits;
+	}
+
+	template <class NODE, class S>
+	bool OccupancyGrid2DBase<NODE, S>::getRayIntersection(const point2d& origin, const point2d& direction, const point2d& center,
 		point2d& intersection, double delta) const {
 		// We only need three normals for the six planes
 		gridmap2D::point2d normalX(1, 0);
@@ -399,8 +708,8 @@ namespace gridmap2D {
 		return found;
 	}
 
-	template <class NODE> inline bool
-		OccupancyGrid2DBase<NODE>::integrateMissOnRay(const point2d& origin, const point2d& end) {
+	template <class NODE, class S> inline bool
+		OccupancyGrid2DBase<NODE, S>::integrateMissOnRay(const point2d& origin, const point2d& end) {
 
 		if (!this->computeRayKeys(origin, end, this->keyrays.at(0))) {
 			return false;
@@ -413,8 +722,8 @@ namespace gridmap2D {
 		return true;
 	}
 
-	template <class NODE> bool
-		OccupancyGrid2DBase<NODE>::insertRay(const point2d& origin, const point2d& end, double maxrange)
+	template <class NODE, class S> bool
+		OccupancyGrid2DBase<NODE, S>::insertRay(const point2d& origin, const point2d& end, double maxrange)
 	{
 		// cut ray at maxrange
 		if ((maxrange > 0) && ((end - origin).norm() > maxrange))
@@ -433,41 +742,41 @@ namespace gridmap2D {
 		}
 	}
 
-	template <class NODE>
-	void OccupancyGrid2DBase<NODE>::setBBXMin(point2d& min) {
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::setBBXMin(point2d& min) {
 		bbx_min = min;
 		if (!this->coordToKeyChecked(bbx_min, bbx_min_key)) {
 			GRIDMAP2D_ERROR("ERROR while generating bbx min key.\n");
 		}
 	}
 
-	template <class NODE>
-	void OccupancyGrid2DBase<NODE>::setBBXMax(point2d& max) {
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::setBBXMax(point2d& max) {
 		bbx_max = max;
 		if (!this->coordToKeyChecked(bbx_max, bbx_max_key)) {
 			GRIDMAP2D_ERROR("ERROR while generating bbx max key.\n");
 		}
 	}
 
-	template <class NODE>
-	bool OccupancyGrid2DBase<NODE>::inBBX(const point2d& p) const {
+	template <class NODE, class S>
+	bool OccupancyGrid2DBase<NODE, S>::inBBX(const point2d& p) const {
 		return ((p.x() >= bbx_min.x()) && (p.y() >= bbx_min.y()) && (p.x() <= bbx_max.x()) && (p.y() <= bbx_max.y()));
 	}
 
-	template <class NODE>
-	bool OccupancyGrid2DBase<NODE>::inBBX(const Grid2DKey& key) const {
+	template <class NODE, class S>
+	bool OccupancyGrid2DBase<NODE, S>::inBBX(const Grid2DKey& key) const {
 		return ((key[0] >= bbx_min_key[0]) && (key[1] >= bbx_min_key[1]) &&	(key[0] <= bbx_max_key[0]) && (key[1] <= bbx_max_key[1]));
 	}
 
-	template <class NODE>
-	point2d OccupancyGrid2DBase<NODE>::getBBXBounds() const {
+	template <class NODE, class S>
+	point2d OccupancyGrid2DBase<NODE, S>::getBBXBounds() const {
 		gridmap2D::point2d obj_bounds = (bbx_max - bbx_min);
 		obj_bounds /= 2.;
 		return obj_bounds;
 	}
 
-	template <class NODE>
-	point2d OccupancyGrid2DBase<NODE>::getBBXCenter() const {
+	template <class NODE, class S>
+	point2d OccupancyGrid2DBase<NODE, S>::getBBXCenter() const {
 		gridmap2D::point2d obj_bounds = (bbx_max - bbx_min);
 		obj_bounds /= 2.;
 		return bbx_min + obj_bounds;
@@ -476,8 +785,8 @@ namespace gridmap2D {
 
 	//-- Occupancy queries on nodes:
 
-	template <class NODE>
-	void OccupancyGrid2DBase<NODE>::updateNodeLogOdds(NODE* occupancyNode, const float& update) const {
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::updateNodeLogOdds(NODE* occupancyNode, const float& update) const {
 		occupancyNode->addValue(update);
 		if (occupancyNode->getLogOdds() < this->clamping_thres_min) {
 			occupancyNode->setLogOdds(this->clamping_thres_min);
@@ -488,39 +797,44 @@ namespace gridmap2D {
 		}
 	}
 
-	template <class NODE>
-	void OccupancyGrid2DBase<NODE>::integrateHit(NODE* occupancyNode) const {
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::integrateHit(NODE* occupancyNode) const {
 		updateNodeLogOdds(occupancyNode, this->prob_hit_log);
 	}
 
-	template <class NODE>
-	void OccupancyGrid2DBase<NODE>::integrateMiss(NODE* occupancyNode) const {
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::integrateMiss(NODE* occupancyNode) const {
 		updateNodeLogOdds(occupancyNode, this->prob_miss_log);
 	}
 
-	template <class NODE>
-	void OccupancyGrid2DBase<NODE>::nodeToMaxLikelihood(NODE* occupancyNode) const{
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::nodeToMaxLikelihood(NODE* occupancyNode) const{
 		if (this->isNodeOccupied(occupancyNode))
 			occupancyNode->setLogOdds(this->clamping_thres_max);
 		else
 			occupancyNode->setLogOdds(this->clamping_thres_min);
 	}
 
-	template <class NODE>
-	void OccupancyGrid2DBase<NODE>::nodeToMaxLikelihood(NODE& occupancyNode) const{
+	template <class NODE, class S>
+	void OccupancyGrid2DBase<NODE, S>::nodeToMaxLikelihood(NODE& occupancyNode) const{
 		if (this->isNodeOccupied(occupancyNode))
 			occupancyNode.setLogOdds(this->clamping_thres_max);
 		else
 			occupancyNode.setLogOdds(this->clamping_thres_min);
 	}
 
-    template <class NODE>
-    std::istream& OccupancyGrid2DBase<NODE>::readBinaryData(std::istream &s){
+    template <class NODE, class S>
+    std::istream& OccupancyGrid2DBase<NODE, S>::readBinaryData(std::istream &s){
         if (this->size() > 0) {
             GRIDMAP2D_ERROR_STR("Trying to read into an existing grid.");
             return s;
         }
 
+        // the cells read are not changes of the map
+        bool change_detection = use_change_detection;
+        bool frontier_tracking = use_frontier_tracking;
+        use_change_detection = use_frontier_tracking = false;
+
         size_t number_of_cells = 0;
         s.read((char*)&number_of_cells, sizeof(number_of_cells));
 
@@ -535,12 +849,7 @@ namespace gridmap2D {
                 std::bitset<8> binary_occupancy((unsigned long long) binary_occupancy_char);	// 1: occupied, 0: free
 
                 for(unsigned int j = 0; j < 8; j++){
-                    Grid2DNode* new_node = new Grid2DNode();
-                    if(binary_occupancy[j] == 1)
-                        new_node->setLogOdds(this->clamping_thres_max);
-                    else
-                        new_node->setLogOdds(this->clamping_thres_min);
-                    this->gridmap->insert(std::pair<Grid2DKey, Grid2DNode*>(key_list[j], new_node));
+                    this->setNodeValue(key_list[j], binary_occupancy[j] == 1 ? this->clamping_thres_max : this->clamping_thres_min);
                 }
             }
         }
@@ -550,29 +859,28 @@ namespace gridmap2D {
             s.read((char*)&binary_occupancy_char, sizeof(char));
             std::bitset<8> binary_occupancy((unsigned long long) binary_occupancy_char);	// 1: occupied, 0: free
 
-            for(unsigned int j = 0; j <= (number_of_cells % 8); j++){
-                Grid2DNode* new_node = new Grid2DNode();
-                if(binary_occupancy[j] == 1)
-                    new_node->setLogOdds(this->clamping_thres_max);
-                else
-                    new_node->setLogOdds(this->clamping_thres_min);
-                this->gridmap->insert(std::pair<Grid2DKey, Grid2DNode*>(key_list[j], new_node));
+            for(unsigned int j = 0; j < (number_of_cells % 8); j++){
+                this->setNodeValue(key_list[j], binary_occupancy[j] == 1 ? this->clamping_thres_max : this->clamping_thres_min);
             }
         }
 
         this->size_changed = true;
 
+        use_change_detection = change_detection;
+        use_frontier_tracking = frontier_tracking;
+        if (use_frontier_tracking)
+            rebuildFrontiers();
         return s;
     }
 
-	template <class NODE>
-	std::ostream& OccupancyGrid2DBase<NODE>::writeBinaryData(std::ostream &s) const{
+	template <class NODE, class S>
+	std::ostream& OccupancyGrid2DBase<NODE, S>::writeBinaryData(std::ostream &s) const{
 		GRIDMAP2D_DEBUG("Writing %zu nodes to output stream...", this->size());
 
 		size_t number_of_cells = this->size();
 		s.write((char*)&number_of_cells, sizeof(number_of_cells));
 
-		typename OccupancyGrid2DBase<NODE>::OccupancyGridMap::iterator it = this->gridmap->begin();
+		typename OccupancyGrid2DBase<NODE, S>::OccupancyGridMap::iterator it = this->gridmap->begin();
 		std::bitset<8> binary_occupancy;	// 1: occupied, 0: free
 		for(size_t i = 0; i < number_of_cells; i++, it++){
 			s.write((char*) it->first.k, sizeof(it->first.k));
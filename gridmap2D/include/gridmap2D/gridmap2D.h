@@ -35,4 +35,5 @@
 #include "Pointcloud.h"
 #include "ScanGraph.h"
 #include "Grid2D.h"
+#include "Grid2DQuantizedNode.h"
 
@@ -69,7 +69,9 @@ namespace gridmap2D{
 		double GenerateMappingLine(PixelInfo& _pixelinfo, const unsigned int& _axisX, const unsigned int& _axisY, std::vector<double>& _mappingPlane);
 
 		// Utility functions
-		typedef unordered_ns::unordered_map<Grid2DKey, std::vector<point2d>, Grid2DKey::KeyHash> Voxelized_Pointclouds;
+		// The maps apply the super rays in the iteration order of this map (with clamping),
+		// so its hash stays fixed to keep the map results independent of the default KeyHash
+		typedef unordered_ns::unordered_map<Grid2DKey, std::vector<point2d>, Grid2DKey::LinearKeyHash> Voxelized_Pointclouds;
 		void ComputeAxis(const point2d& _min, const point2d& _max, Axis2D& _axis);
 
 		// Re-implmentation for Key / coordinate conversion functions
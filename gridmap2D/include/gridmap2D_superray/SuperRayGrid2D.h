@@ -31,10 +31,10 @@
 #define GRIDMAP2D_SUPERRAY_GRID2D_H
 
 #include <gridmap2D/gridmap2D.h>
-#include <gridmap2D_superray/SuperRayGenerator.h>
+#include <gridmap2D_superray/SuperRayGrid2DBase.h>
 
 namespace gridmap2D{
-	class SuperRayGrid2D : public OccupancyGrid2DBase<Grid2DNode> {
+	class SuperRayGrid2D : public SuperRayGrid2DBase<Grid2DNode> {
 	public:
 		/// Default constructor, sets resolution of grid
 		SuperRayGrid2D(double resolution);
@@ -44,7 +44,7 @@ namespace gridmap2D{
 		 * @param _filename
 		 *
 		 */
-		// SuperRayGrid2D(std::string _filename);
+		SuperRayGrid2D(std::string _filename);
 
 		virtual ~SuperRayGrid2D(){};
 
@@ -54,38 +54,6 @@ namespace gridmap2D{
 
 		std::string getGridType() const { return "SuperRayGrid2D"; }
 
-		// Super Ray based Updates
-
-		/**
-		 * Integrate a Pointcloud (in global reference frame), parallelized with OpenMP.
-		 * This function simply inserts all rays of the point clouds, similar to insertPointCloudRays of gridmap2D::Grid2D.
-		 * Occupied nodes have a preference over free ones.
-		 *
-		 * @param scan Pointcloud (measurement endpoints), in global reference frame
-		 * @param sensor_origin measurement origin in global reference frame
-		 */
-		virtual void insertPointCloudRays(const Pointcloud& scan, const point2d& origin);
-
-		/**
-		 * Integrate a Pointcloud (in global reference frame) using SuperRay, parallelized with OpenMP.
-		 * This function converts a point clouds into superrays, and then inserts all superrays out of the point clouds.
-		 * Occupied nodes have a preference over free ones.
-		 *
-		 * @param scan Pointcloud (measurement endpoints), in global reference frame
-		 * @param sensor_origin measurement origin in global reference frame
-		 * @param threshold threshold for limiting to generate super rays
-		 */
-		virtual void insertSuperRayCloudRays(const Pointcloud& scan, const point2d& origin, const int threshold);
-
-		/**
-		 * Integrate a SuperRayCloud (in global reference frame), parallelized with OpenMP.
-		 * This function inserts all superrays out of a point clouds.
-		 * Occupied nodes have a preference over free ones.
-		 *
-		 * @param superray SuperRayCloud (generated by a point clouds and a origin), in global reference frame
-		 */
-		virtual void insertSuperRayCloudRays(const SuperRayCloud& superray);
-
 	protected:
 		/**
 		 * Static member object which ensures that this Grid2D's prototype
@@ -112,6 +80,50 @@ namespace gridmap2D{
 		/// static member to ensure static initialization (only once)
 		static StaticMemberInitializer superrayGrid2DMemberInit;
 	};
+
+	/**
+	 * SuperRayGrid2D with the cells in a Grid2DOpenStorage: less memory and faster
+	 * updates and iteration than the hash storage of SuperRayGrid2D.
+	 *
+	 * \note Node pointers returned by search(), updateNode() and setNodeValue() are
+	 * only valid until the next insertion or deletion of a cell, and getGrid()
+	 * returns the open-addressing table.
+	 */
+	class SuperRayOpenGrid2D : public SuperRayGrid2DBase<Grid2DNode, Grid2DOpenStorage<Grid2DNode> > {
+	public:
+		/// Default constructor, sets resolution of grid
+		SuperRayOpenGrid2D(double resolution);
+
+		/**
+		 * Reads a Grid2D from a binary file
+		 * @param _filename
+		 *
+		 */
+		SuperRayOpenGrid2D(std::string _filename);
+
+		virtual ~SuperRayOpenGrid2D(){};
+
+		/// virtual constructor: creates a new object of same type
+		/// (Covariant return type requires an up-to-date compiler)
+		SuperRayOpenGrid2D* create() const { return new SuperRayOpenGrid2D(resolution); }
+
+		std::string getGridType() const { return "SuperRayOpenGrid2D"; }
+
+	protected:
+		/// Registers the prototype of this grid type, see SuperRayGrid2D::StaticMemberInitializer
+		class StaticMemberInitializer{
+		public:
+			StaticMemberInitializer() {
+				SuperRayOpenGrid2D* grid = new SuperRayOpenGrid2D(0.1);
+				grid->clearKeyRays();
+				AbstractGrid2D::registerGridType(grid);
+			}
+
+			void ensureLinking() {};
+		};
+		/// static member to ensure static initialization (only once)
+		static StaticMemberInitializer superrayOpenGrid2DMemberInit;
+	};
 }
 
 #endif
@@ -0,0 +1,93 @@
+/*
+* Copyright(c) 2016, Youngsun Kwon, Donghyuk Kim, and Sung-eui Yoon, KAIST
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met :
+*
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and / or other materials provided with the distribution.
+*     * Neither the name of SuperRay nor the names of its
+*       contributors may be used to endorse or promote products derived from
+*       this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef GRIDMAP2D_SUPERRAY_GRID2D_BASE_H
+#define GRIDMAP2D_SUPERRAY_GRID2D_BASE_H
+
+#include <gridmap2D/OccupancyGrid2DBase.h>
+#include <gridmap2D_superray/SuperRayGenerator.h>
+
+namespace gridmap2D{
+	/**
+	 * Super ray based updates on top of OccupancyGrid2DBase, for any occupancy
+	 * node (Grid2DNode or the fixed-point Grid2DNode8 and Grid2DNode16) and
+	 * any storage policy. SuperRayGrid2D is the map with Grid2DNode cells in the
+	 * default hash storage. SuperRayOpenGrid2D, i.e.
+	 * SuperRayGrid2DBase<Grid2DNode, Grid2DOpenStorage<Grid2DNode> >, keeps them in
+	 * the smaller and faster open-addressing table instead, but its node pointers
+	 * are only valid until the next insertion or deletion of a cell.
+	 *
+	 * \tparam NODE Occupancy node class
+	 * \tparam STORAGE Storage policy of the cells
+	 */
+	template <class NODE, class STORAGE = Grid2DHashStorage<NODE> >
+	class SuperRayGrid2DBase : public OccupancyGrid2DBase<NODE, STORAGE> {
+	public:
+		/// Default constructor, sets resolution of grid
+		SuperRayGrid2DBase(double resolution);
+
+		virtual ~SuperRayGrid2DBase(){};
+
+		// Super Ray based Updates
+
+		/**
+		 * Integrate a Pointcloud (in global reference frame), parallelized with OpenMP.
+		 * This function simply inserts all rays of the point clouds, similar to insertPointCloudRays of gridmap2D::Grid2D.
+		 * Occupied nodes have a preference over free ones.
+		 *
+		 * @param scan Pointcloud (measurement endpoints), in global reference frame
+		 * @param sensor_origin measurement origin in global reference frame
+		 */
+		virtual void insertPointCloudRays(const Pointcloud& scan, const point2d& origin);
+
+		/**
+		 * Integrate a Pointcloud (in global reference frame) using SuperRay, parallelized with OpenMP.
+		 * This function converts a point clouds into superrays, and then inserts all superrays out of the point clouds.
+		 * Occupied nodes have a preference over free ones.
+		 *
+		 * @param scan Pointcloud (measurement endpoints), in global reference frame
+		 * @param sensor_origin measurement origin in global reference frame
+		 * @param threshold threshold for limiting to generate super rays
+		 */
+		virtual void insertSuperRayCloudRays(const Pointcloud& scan, const point2d& origin, const int threshold);
+
+		/**
+		 * Integrate a SuperRayCloud (in global reference frame), parallelized with OpenMP.
+		 * This function inserts all superrays out of a point clouds.
+		 * Occupied nodes have a preference over free ones.
+		 *
+		 * @param superray SuperRayCloud (generated by a point clouds and a origin), in global reference frame
+		 */
+		virtual void insertSuperRayCloudRays(const SuperRayCloud& superray);
+	};
+}
+
+#include "gridmap2D_superray/SuperRayGrid2DBase.hxx"
+
+#endif
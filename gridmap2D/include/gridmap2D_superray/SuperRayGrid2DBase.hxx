@@ -0,0 +1,134 @@
+/*
+* Copyright(c) 2016, Youngsun Kwon, Donghyuk Kim, and Sung-eui Yoon, KAIST
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met :
+*
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and / or other materials provided with the distribution.
+*     * Neither the name of SuperRay nor the names of its
+*       contributors may be used to endorse or promote products derived from
+*       this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+namespace gridmap2D{
+	template <class NODE, class STORAGE>
+	SuperRayGrid2DBase<NODE, STORAGE>::SuperRayGrid2DBase(double in_resolution)
+	: OccupancyGrid2DBase<NODE, STORAGE>(in_resolution) {
+	}
+
+	template <class NODE, class STORAGE>
+	void SuperRayGrid2DBase<NODE, STORAGE>::insertPointCloudRays(const Pointcloud& pc, const point2d& origin)
+	{
+		if (pc.size() < 1)
+			return;
+
+	#ifdef _OPENMP
+		omp_set_num_threads(this->keyrays.size());
+	#pragma omp parallel for
+	#endif
+		for (int i = 0; i < (int)pc.size(); ++i) {
+			const point2d& p = pc[i];
+			unsigned threadIdx = 0;
+	#ifdef _OPENMP
+			threadIdx = omp_get_thread_num();
+	#endif
+			KeyRay* keyray = &(this->keyrays.at(threadIdx));
+
+			// free cells
+			if (this->computeRayKeys(origin, p, *keyray)){
+				if (Grid2DStorageTraits<STORAGE>::concurrent) {
+					this->updateNodesLocked(*keyray, this->prob_miss_log);
+				}
+				else {
+	#ifdef _OPENMP
+	#pragma omp critical
+	#endif
+					{
+						for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
+							this->updateNode(*it, false); // insert freespace measurement
+						}
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < (int)pc.size(); ++i){
+			this->updateNode(pc[i], true); // update endpoint to be occupied
+		}
+
+		if (this->isFrontierTrackingEnabled())
+			this->updateFrontiers();
+	}
+
+	template <class NODE, class STORAGE>
+	void SuperRayGrid2DBase<NODE, STORAGE>::insertSuperRayCloudRays(const Pointcloud& scan, const point2d& origin, const int threshold)
+	{
+		SuperRayGenerator srgenerator(this->resolution, this->grid_max_val, threshold);
+		SuperRayCloud srcloud;
+		srgenerator.GenerateSuperRay(scan, origin, srcloud);
+		insertSuperRayCloudRays(srcloud);
+	}
+
+	template <class NODE, class STORAGE>
+	void SuperRayGrid2DBase<NODE, STORAGE>::insertSuperRayCloudRays(const SuperRayCloud& superray)
+	{
+		if (superray.size() < 1)
+			return;
+
+		point2d origin = superray.origin;
+	#ifdef _OPENMP
+		omp_set_num_threads(this->keyrays.size());
+	#pragma omp parallel for
+	#endif
+		for (int i = 0; i < (int)superray.size(); ++i) {
+			const point2d& p = superray[i].p;
+			const float& missprob = this->prob_miss_log * superray[i].w;
+			unsigned threadIdx = 0;
+	#ifdef _OPENMP
+			threadIdx = omp_get_thread_num();
+	#endif
+			KeyRay* keyray = &(this->keyrays.at(threadIdx));
+
+			// free cells
+			if (this->computeRayKeys(origin, p, *keyray)){
+				if (Grid2DStorageTraits<STORAGE>::concurrent) {
+					this->updateNodesLocked(*keyray, missprob);
+				}
+				else {
+	#ifdef _OPENMP
+	#pragma omp critical
+	#endif
+					{
+						for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
+							this->updateNode(*it, missprob);
+						}
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < (int)superray.size(); ++i){
+			this->updateNode(superray[i].p, this->prob_hit_log * superray[i].w);
+		}
+
+		if (this->isFrontierTrackingEnabled())
+			this->updateFrontiers();
+	}
+}
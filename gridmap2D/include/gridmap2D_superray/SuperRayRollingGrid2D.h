@@ -0,0 +1,173 @@
+/*
+* Copyright(c) 2016, Youngsun Kwon, Donghyuk Kim, and Sung-eui Yoon, KAIST
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met :
+*
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and / or other materials provided with the distribution.
+*     * Neither the name of SuperRay nor the names of its
+*       contributors may be used to endorse or promote products derived from
+*       this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef GRIDMAP2D_SUPERRAY_ROLLING_GRID2D_H
+#define GRIDMAP2D_SUPERRAY_ROLLING_GRID2D_H
+
+#include <gridmap2D/gridmap2D.h>
+#include <gridmap2D_superray/SuperRayGenerator.h>
+
+namespace gridmap2D{
+	/**
+	 * Robot-centric occupancy grid which only keeps a square window of cells
+	 * around a moving center (see Grid2DRollingStorage). Memory and update
+	 * costs are bounded by the window, updates outside of it are dropped.
+	 * The window is moved with moveWindow(), which only clears the cells
+	 * scrolling out of the window.
+	 */
+	class SuperRayRollingGrid2D : public OccupancyGrid2DBase<Grid2DNode, Grid2DRollingStorage<Grid2DNode> > {
+	public:
+		/**
+		 * Default constructor, sets resolution of grid and the width of the window,
+		 * which is initially centered at the origin
+		 *
+		 * @param resolution resolution of the grid
+		 * @param window_width width of the window in cells, rounded up to a power of two
+		 *        and limited to 2^Grid2DRollingStorage::MAX_WIDTH_BITS
+		 */
+		SuperRayRollingGrid2D(double resolution, unsigned int window_width = 128);
+
+		virtual ~SuperRayRollingGrid2D(){};
+
+		/// virtual constructor: creates a new object of same type
+		/// (Covariant return type requires an up-to-date compiler)
+		SuperRayRollingGrid2D* create() const { return new SuperRayRollingGrid2D(resolution, gridmap->getWindowWidth()); }
+
+		std::string getGridType() const { return "SuperRayRollingGrid2D"; }
+
+		// Window
+
+		/**
+		 * Moves the window to be centered at center. The cells which stay within
+		 * the window are kept, the ones scrolling out of it are cleared.
+		 *
+		 * @param center new center of the window in global reference frame
+		 */
+		void moveWindow(const point2d& center);
+
+		/// @return width of the window in cells
+		unsigned int getWindowWidth() const { return gridmap->getWindowWidth(); }
+
+		/// @return metric bounds of the window
+		void getWindowBounds(point2d& min, point2d& max) const;
+
+		/// @return true if the cell of key lies within the window
+		bool inWindow(const Grid2DKey& key) const { return gridmap->inWindow(key); }
+
+		// File IO: the window (width and lower corner) precedes the cells, so that
+		// grids read through the AbstractGrid2D factory get their window back
+
+		std::istream& readData(std::istream &s);
+		std::ostream& writeData(std::ostream &s) const;
+		std::istream& readBinaryData(std::istream &s);
+		std::ostream& writeBinaryData(std::ostream &s) const;
+		std::istream& readBulkData(std::istream &s);
+		std::ostream& writeBulkData(std::ostream &s, bool delta_keys) const;
+
+		// Super Ray based Updates
+
+		/**
+		 * Integrate a Pointcloud (in global reference frame), parallelized with OpenMP.
+		 * This function simply inserts all rays of the point clouds, similar to insertPointCloudRays of gridmap2D::Grid2D.
+		 * Rays are clipped to the window before they are traced.
+		 * Occupied nodes have a preference over free ones.
+		 *
+		 * @param scan Pointcloud (measurement endpoints), in global reference frame
+		 * @param sensor_origin measurement origin in global reference frame
+		 */
+		virtual void insertPointCloudRays(const Pointcloud& scan, const point2d& origin);
+
+		/**
+		 * Integrate a Pointcloud (in global reference frame) using SuperRay, parallelized with OpenMP.
+		 * This function converts a point clouds into superrays, and then inserts all superrays out of the point clouds.
+		 * Occupied nodes have a preference over free ones.
+		 *
+		 * @param scan Pointcloud (measurement endpoints), in global reference frame
+		 * @param sensor_origin measurement origin in global reference frame
+		 * @param threshold threshold for limiting to generate super rays
+		 */
+		virtual void insertSuperRayCloudRays(const Pointcloud& scan, const point2d& origin, const int threshold);
+
+		/**
+		 * Integrate a SuperRayCloud (in global reference frame), parallelized with OpenMP.
+		 * This function inserts all superrays out of a point clouds.
+		 * Rays are clipped to the window before they are traced.
+		 * Occupied nodes have a preference over free ones.
+		 *
+		 * @param superray SuperRayCloud (generated by a point clouds and a origin), in global reference frame
+		 */
+		virtual void insertSuperRayCloudRays(const SuperRayCloud& superray);
+
+	protected:
+		/// @return log2 of window_width rounded up to a power of two, limited to the largest window
+		static unsigned int windowWidthBits(unsigned int window_width);
+
+		/// Reads the window and sets it up, false if it is invalid or the grid is not empty
+		bool readWindow(std::istream &s);
+
+		/// Writes the width and the lower corner of the window
+		void writeWindow(std::ostream &s) const;
+
+		/**
+		 * Clips the ray from origin to end against the window, enlarged by one cell
+		 * so that every cell of the window on the ray is still traversed.
+		 *
+		 * @return false if the ray misses the window
+		 */
+		bool clipRay(const point2d& origin, const point2d& end, point2d& clipped_origin, point2d& clipped_end) const;
+
+		/**
+		 * Static member object which ensures that this Grid2D's prototype
+		 * ends up in the classIDMapping only once. You need this as a
+		 * static member in any derived grid2D class in order to read .og2
+		 * files through the AbstractGrid2D factory. You should also call
+		 * ensureLinking() once from the constructor.
+		 */
+		class StaticMemberInitializer{
+		public:
+			StaticMemberInitializer() {
+				// a single cell window keeps the prototype small
+				SuperRayRollingGrid2D* grid = new SuperRayRollingGrid2D(0.1, 1);
+				grid->clearKeyRays();
+				AbstractGrid2D::registerGridType(grid);
+			}
+
+			/**
+			 * Dummy function to ensure that MSVC does not drop the
+			 * StaticMemberInitializer, causing this tree failing to register.
+			 * Needs to be called from the constructor of this grid.
+			 */
+			void ensureLinking() {};
+		};
+		/// static member to ensure static initialization (only once)
+		static StaticMemberInitializer superrayRollingGrid2DMemberInit;
+	};
+}
+
+#endif
@@ -116,6 +116,80 @@ namespace gridmap2D {
 		return grid;
 	}
 
+	bool AbstractGrid2D::writeBulk(const std::string& filename, bool delta_keys) const{
+		std::ofstream file(filename.c_str(), std::ios_base::out | std::ios_base::binary);
+
+		if (!file.is_open()){
+			GRIDMAP2D_ERROR_STR("Filestream to " << filename << " not open, nothing written.");
+			return false;
+		}
+
+		return writeBulk(file, delta_keys);
+	}
+
+	bool AbstractGrid2D::writeBulk(std::ostream &s, bool delta_keys) const{
+		s << bulkFileHeader << "\n# (feel free to add / change comments, but leave the first line as it is!)\n#\n";
+		s << "id " << getGridType() << std::endl;
+		s << "size " << size() << std::endl;
+		s << "res " << getResolution() << std::endl;
+		s << "data" << std::endl;
+
+		writeBulkData(s, delta_keys);
+
+		if (!s.good()){
+			GRIDMAP2D_WARNING_STR("Output stream not \"good\" after writing grid");
+			return false;
+		}
+		return true;
+	}
+
+	AbstractGrid2D* AbstractGrid2D::readBulk(const std::string& filename){
+		std::ifstream file(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+
+		if (!file.is_open()){
+			GRIDMAP2D_ERROR_STR("Filestream to " << filename << " not open, nothing read.");
+			return NULL;
+		}
+		else {
+			return readBulk(file);
+		}
+	}
+
+	AbstractGrid2D* AbstractGrid2D::readBulk(std::istream &s){
+
+		// check if first line valid:
+		std::string line;
+		std::getline(s, line);
+		if (line.compare(0, bulkFileHeader.length(), bulkFileHeader) != 0){
+			GRIDMAP2D_ERROR_STR("First line of Grid2D bulk file header does not start with \"" << bulkFileHeader);
+			return NULL;
+		}
+
+		std::string id;
+		unsigned size;
+		double res;
+		if (!AbstractGrid2D::readHeader(s, id, size, res))
+			return NULL;
+
+		GRIDMAP2D_DEBUG_STR("Reading grid type " << id);
+
+		AbstractGrid2D* grid = createGrid(id, res);
+
+		if (grid){
+			if (size > 0)
+				grid->readBulkData(s);
+
+			if (size != grid->size()){
+				GRIDMAP2D_ERROR("Grid size mismatch: # read nodes (%zu) != # expected nodes (%d)\n", grid->size(), size);
+				delete grid;
+				return NULL;
+			}
+			GRIDMAP2D_DEBUG_STR("Done (" << grid->size() << " nodes)");
+		}
+
+		return grid;
+	}
+
 	bool AbstractGrid2D::readHeader(std::istream& s, std::string& id, unsigned& size, double& res){
 		id = "";
 		size = 0;
@@ -209,4 +283,5 @@ namespace gridmap2D {
 
 
 	const std::string AbstractGrid2D::fileHeader = "# Gridmap2D Grid2D file";
+	const std::string AbstractGrid2D::bulkFileHeader = "# Gridmap2D Grid2D bulk file";
 }
@@ -36,7 +36,7 @@
 #include <gridmap2D/gridmap2D_types.h>
 
 namespace gridmap2D {
-	AbstractOccupancyGrid2D::AbstractOccupancyGrid2D(){
+	AbstractOccupancyGrid2DBase::AbstractOccupancyGrid2DBase(){
 		// some sane default values:
 		setOccupancyThres(0.5);   // = 0.0 in logodds
 		setProbHit(0.7);          // = 0.85 in logodds
@@ -46,7 +46,7 @@ namespace gridmap2D {
 		setClampingThresMax(0.971); // = 3.5 in log odds
 	}
 
-	bool AbstractOccupancyGrid2D::writeBinary(const std::string& filename){
+	bool AbstractOccupancyGrid2DBase::writeBinary(const std::string& filename){
 		std::ofstream binary_outfile(filename.c_str(), std::ios_base::binary);
 
 		if (!binary_outfile.is_open()){
@@ -56,7 +56,7 @@ namespace gridmap2D {
 		return writeBinary(binary_outfile);
 	}
 
-	bool AbstractOccupancyGrid2D::writeBinaryConst(const std::string& filename) const{
+	bool AbstractOccupancyGrid2DBase::writeBinaryConst(const std::string& filename) const{
 		std::ofstream binary_outfile(filename.c_str(), std::ios_base::binary);
 
 		if (!binary_outfile.is_open()){
@@ -68,13 +68,13 @@ namespace gridmap2D {
 		return true;
 	}
 
-	bool AbstractOccupancyGrid2D::writeBinary(std::ostream &s){
+	bool AbstractOccupancyGrid2DBase::writeBinary(std::ostream &s){
 		// convert to max likelihood
 		this->toMaxLikelihood();
 		return writeBinaryConst(s);
 	}
 
-	bool AbstractOccupancyGrid2D::writeBinaryConst(std::ostream &s) const{
+	bool AbstractOccupancyGrid2DBase::writeBinaryConst(std::ostream &s) const{
 		// write new header first:
 		s << binaryFileHeader << "\n# (feel free to add / change comments, but leave the first line as it is!)\n#\n";
 		s << "id " << this->getGridType() << std::endl;
@@ -94,7 +94,7 @@ namespace gridmap2D {
 		}
 	}
 
-	bool AbstractOccupancyGrid2D::readBinary(const std::string& filename){
+	bool AbstractOccupancyGrid2DBase::readBinary(const std::string& filename){
 		std::ifstream binary_infile(filename.c_str(), std::ios_base::binary);
 		if (!binary_infile.is_open()){
 			GRIDMAP2D_ERROR_STR("Filestream to " << filename << " not open, nothing read.");
@@ -103,7 +103,7 @@ namespace gridmap2D {
 		return readBinary(binary_infile);
 	}
 
-	bool AbstractOccupancyGrid2D::readBinary(std::istream &s) {
+	bool AbstractOccupancyGrid2DBase::readBinary(std::istream &s) {
 		if (!s.good()){
 			GRIDMAP2D_WARNING_STR("Input filestream not \"good\" in Grid2D::readBinary");
 		}
@@ -113,7 +113,7 @@ namespace gridmap2D {
 		std::getline(s, line);
 		unsigned size;
 		double res;
-		if (line.compare(0, AbstractOccupancyGrid2D::binaryFileHeader.length(), AbstractOccupancyGrid2D::binaryFileHeader) == 0){
+		if (line.compare(0, AbstractOccupancyGrid2DBase::binaryFileHeader.length(), AbstractOccupancyGrid2DBase::binaryFileHeader) == 0){
 			std::string id;
 			if (!AbstractGrid2D::readHeader(s, id, size, res))
 				return false;
@@ -136,5 +136,5 @@ namespace gridmap2D {
 		return true;
 	}
 
-	const std::string AbstractOccupancyGrid2D::binaryFileHeader = "# GridMap2D Grid2D binary file";
+	const std::string AbstractOccupancyGrid2DBase::binaryFileHeader = "# GridMap2D Grid2D binary file";
 }
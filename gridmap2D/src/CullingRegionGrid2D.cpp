@@ -31,14 +31,15 @@
 
 namespace gridmap2D{
     CullingRegionGrid2D::CullingRegionGrid2D(double in_resolution)
-            : OccupancyGrid2DBase<Grid2DNode>(in_resolution) {
+            : OccupancyGrid2DBase<Grid2DNode>(in_resolution), use_polar_culling(false) {
         cullingregionGrid2DMemberInit.ensureLinking();
     };
 
-    /*CullingRegionGrid2D::CullingRegionGrid2D(std::string _filename)
-            : OccupancyGrid2DBase<Grid2DNode>(0.1)  { // resolution will be set according to grid file
+    CullingRegionGrid2D::CullingRegionGrid2D(std::string _filename)
+            : OccupancyGrid2DBase<Grid2DNode>(0.1), use_polar_culling(false) { // resolution will be set according to grid file
+        cullingregionGrid2DMemberInit.ensureLinking();
         readBinary(_filename);
-    }*/
+    }
 
     CullingRegionGrid2D::StaticMemberInitializer CullingRegionGrid2D::cullingregionGrid2DMemberInit;
 
@@ -47,8 +48,13 @@ namespace gridmap2D{
         if (pc.size() < 1)
             return;
 
-        // Build a culling region
-        KeySet cullingregion = buildCullingRegion(pc, origin);
+        // Build a culling region, or a visibility profile in the polar culling mode
+        KeySet cullingregion;
+        VisibilityProfile profile;
+        if (use_polar_culling)
+            profile = buildVisibilityProfile(pc, origin);
+        else
+            cullingregion = buildCullingRegion(pc, origin);
 
         // Update the occupancies of the map
 #ifdef _OPENMP
@@ -63,7 +69,9 @@ namespace gridmap2D{
 #endif
             KeyRay* keyray = &(this->keyrays.at(threadIdx));
 
-            if (this->computeInverseRayKeys(p, origin, *keyray, cullingregion)){
+            bool traced = use_polar_culling ? this->computeInverseRayKeys(p, origin, *keyray, profile)
+                                            : this->computeInverseRayKeys(p, origin, *keyray, cullingregion);
+            if (traced){
 #ifdef _OPENMP
 #pragma omp critical
 #endif
@@ -92,8 +100,13 @@ namespace gridmap2D{
         SuperRayCloud srcloud;
         srgenerator.GenerateSuperRay(pc, origin, srcloud);
 
-        // Build a culling region
-        KeySet cullingregion = buildCullingRegion(srcloud, origin);
+        // Build a culling region, or a visibility profile in the polar culling mode
+        KeySet cullingregion;
+        VisibilityProfile profile;
+        if (use_polar_culling)
+            profile = buildVisibilityProfile(srcloud, origin);
+        else
+            cullingregion = buildCullingRegion(srcloud, origin);
 
         // Update the occupancies of the map
 #ifdef _OPENMP
@@ -108,7 +121,9 @@ namespace gridmap2D{
 #endif
             KeyRay* keyray = &(this->keyrays.at(threadIdx));
 
-            if (this->computeInverseRayKeys(p, origin, *keyray, cullingregion)){
+            bool traced = use_polar_culling ? this->computeInverseRayKeys(p, origin, *keyray, profile)
+                                            : this->computeInverseRayKeys(p, origin, *keyray, cullingregion);
+            if (traced){
 #ifdef _OPENMP
 #pragma omp critical
 #endif
@@ -235,6 +250,129 @@ namespace gridmap2D{
         return buildCullingRegion(origin, (int)(max_dist / resolution));
     }
 
+    CullingRegionGrid2D::VisibilityProfile CullingRegionGrid2D::buildVisibilityProfile(const point2d& origin, const int max_propagation)
+    {
+        VisibilityProfile profile;
+        profile.origin = origin;
+
+        // One bin per cell on the circumference at the maximum range, and no culling beyond the range
+        const int num_bins = std::max(8, (int)ceil(2.0 * M_PI * max_propagation));
+        profile.bin_width = 2.0 * M_PI / num_bins;
+        profile.radius.assign(num_bins, std::max(max_propagation - 1, 0) * resolution);
+
+        Grid2DKey originKey = coordToKey(origin);
+        Grid2DNode* node = search(originKey);
+        if (!node || node->getLogOdds() > clamping_thres_min) {
+            std::fill(profile.radius.begin(), profile.radius.end(), 0.0);
+            return profile;
+        }
+
+        // Flood the fully free cells from the origin cell within the window of the propagation
+        const int width = 2 * max_propagation + 1;
+        std::vector<unsigned char> visited(width * width, 0);
+        std::vector<std::pair<int, int> > stack;
+        visited[max_propagation * width + max_propagation] = 1;
+        stack.push_back(std::make_pair(0, 0));
+
+        while (!stack.empty()) {
+            const std::pair<int, int> cell = stack.back();
+            stack.pop_back();
+
+            for (int dx = -1; dx <= 1; dx++) {
+                for (int dy = -1; dy <= 1; dy++) {
+                    const int x = cell.first + dx;
+                    const int y = cell.second + dy;
+                    if (abs(x) > max_propagation || abs(y) > max_propagation)
+                        continue;
+
+                    unsigned char& cell_visited = visited[(y + max_propagation) * width + (x + max_propagation)];
+                    if (cell_visited)
+                        continue;
+                    cell_visited = 1;
+
+                    const int key_x = (int)originKey[0] + x;
+                    const int key_y = (int)originKey[1] + y;
+                    if (key_x < 0 || key_y < 0 || key_x >= 2 * (int)grid_max_val || key_y >= 2 * (int)grid_max_val)
+                        continue;
+
+                    // The fully free cells are flooded, and the others bound the visibility
+                    Grid2DKey key((key_type)key_x, (key_type)key_y);
+                    node = search(key);
+                    if (node && node->getLogOdds() <= clamping_thres_min)
+                        stack.push_back(std::make_pair(x, y));
+                    else
+                        blockVisibilityProfile(profile, key);
+                }
+            }
+        }
+
+        return profile;
+    }
+
+    CullingRegionGrid2D::VisibilityProfile CullingRegionGrid2D::buildVisibilityProfile(const Pointcloud& pc, const point2d& origin)
+    {
+        // Find the maximum distance between the sensor origin and the end point
+        double max_dist = 0.0;
+        for(int i = 0; i < (int)pc.size(); i++){
+            double distance = (pc[i] - origin).norm();
+            if(distance > max_dist)
+                max_dist = distance;
+        }
+
+        // Build a visibility profile limited by the range of sensor measurements
+        return buildVisibilityProfile(origin, (int)(max_dist / resolution));
+    }
+
+    CullingRegionGrid2D::VisibilityProfile CullingRegionGrid2D::buildVisibilityProfile(const SuperRayCloud& superrays, const point2d& origin)
+    {
+        // Find the maximum distance between the sensor origin and the end point
+        double max_dist = 0.0;
+        for(int i = 0; i < (int)superrays.size(); i++){
+            double distance = (superrays[i].p - origin).norm();
+            if(distance > max_dist)
+                max_dist = distance;
+        }
+
+        // Build a visibility profile limited by the range of sensor measurements
+        return buildVisibilityProfile(origin, (int)(max_dist / resolution));
+    }
+
+    void CullingRegionGrid2D::blockVisibilityProfile(VisibilityProfile& profile, const Grid2DKey& key) const
+    {
+        const int num_bins = (int)profile.radius.size();
+        const point2d center = keyToCoord(key);
+        const double half = 0.5 * resolution;
+        const double cx = center.x() - profile.origin.x();
+        const double cy = center.y() - profile.origin.y();
+
+        // Nearest distance to the cell, with a margin for the discretization errors of the traversals
+        const double dx = std::max(fabs(cx) - half, 0.0);
+        const double dy = std::max(fabs(cy) - half, 0.0);
+        const double distance = sqrt(dx * dx + dy * dy) - 0.01 * resolution;
+        if (distance <= 0.0) {
+            std::fill(profile.radius.begin(), profile.radius.end(), 0.0);
+            return;
+        }
+
+        // Angular span of the cell seen from the origin, with a margin as well
+        const double center_angle = atan2(cy, cx);
+        double min_angle = 0.0, max_angle = 0.0;
+        for (int corner = 0; corner < 4; corner++) {
+            double angle = atan2(cy + ((corner & 2) ? half : -half), cx + ((corner & 1) ? half : -half)) - center_angle;
+            if (angle > M_PI)           angle -= 2.0 * M_PI;
+            else if (angle < -M_PI)     angle += 2.0 * M_PI;
+            min_angle = std::min(min_angle, angle);
+            max_angle = std::max(max_angle, angle);
+        }
+        const int first_bin = (int)floor((center_angle + min_angle - 1e-4 + M_PI) / profile.bin_width);
+        const int last_bin = (int)floor((center_angle + max_angle + 1e-4 + M_PI) / profile.bin_width);
+
+        for (int bin = first_bin; bin <= last_bin; bin++) {
+            double& radius = profile.radius[((bin % num_bins) + num_bins) % num_bins];
+            radius = std::min(radius, distance);
+        }
+    }
+
     bool CullingRegionGrid2D::computeInverseRayKeys(const point2d& origin, const point2d& end, KeyRay& ray, KeySet& cullingregion)
     {
         // see "A Faster Voxel Traversal Algorithm for Ray Tracing" by Amanatides & Woo
@@ -326,4 +464,99 @@ namespace gridmap2D{
 
         return true;
     }
-}
\ No newline at end of file
+
+    bool CullingRegionGrid2D::computeInverseRayKeys(const point2d& origin, const point2d& end, KeyRay& ray, const VisibilityProfile& profile)
+    {
+        // see "A Faster Voxel Traversal Algorithm for Ray Tracing" by Amanatides & Woo
+        // basically: DDA in 3D
+
+        ray.reset();
+
+        Grid2DKey key_origin, key_end;
+        if ( !coordToKeyChecked(origin, key_origin) || !coordToKeyChecked(end, key_end) ) {
+            GRIDMAP2D_WARNING_STR("coordinates ( " << origin << " -> " << end << ") out of bounds in computeRayKeys");
+            return false;
+        }
+
+        if (key_origin == key_end)
+            return true; // same tree cell, we're done.
+
+        // Initialization phase -------------------------------------------------------
+        point2d direction = (end - origin);
+        float length = (float) direction.norm();
+        direction /= length; // normalize vector
+
+        // All cells within the free radius towards the end point are fully free
+        const double free_radius = profile.getFreeRadius(origin);
+
+        int    step[2];
+        double tMax[2];
+        double tDelta[2];
+
+        Grid2DKey current_key = key_origin;
+
+        for(unsigned int i = 0; i < 2; ++i) {
+            // compute step direction
+            if (direction(i) > 0.0)         step[i] = 1;
+            else if (direction(i) < 0.0)    step[i] = -1;
+            else                            step[i] = 0;
+
+            // compute tMax, tDelta
+            if (step[i] != 0) {
+                // corner point of voxel (in direction of ray)
+                double voxelBorder = this->keyToCoord(current_key[i]);
+                voxelBorder += (float) (step[i] * this->resolution * 0.5);
+
+                tMax[i] = ( voxelBorder - origin(i) ) / direction(i);
+                tDelta[i] = this->resolution / fabs( direction(i) );
+            }
+            else {
+                tMax[i] =  std::numeric_limits<double>::max( );
+                tDelta[i] = std::numeric_limits<double>::max( );
+            }
+        }
+
+        // Incremental phase  ---------------------------------------------------------
+        bool done = false;
+        while (!done) {
+            // find minimum tMax:
+            unsigned int dim = tMax[0] < tMax[1] ? 0 : 1;
+
+            // advance in direction "dim"
+            current_key[dim] += step[dim];
+            tMax[dim] += tDelta[dim];
+
+            assert (current_key[dim] < 2*this->grid_max_val);
+
+            // Culling out the traversal when the current cell reaches into the free radius
+            if (free_radius > 0.0 && length - std::min(tMax[0], tMax[1]) < free_radius){
+                done = true;
+                break;
+            }
+            // reached endpoint, key equv?
+            else if (current_key == key_end) {
+                ray.addKey(current_key);
+                done = true;
+                break;
+            }
+            else {
+                // reached endpoint world coords?
+                // dist_from_origin now contains the length of the ray when traveled until the border of the current voxel
+                double dist_from_origin = std::min(tMax[0], tMax[1]);
+                // if this is longer than the expected ray length, we should have already hit the voxel containing the end point with the code above (key_end).
+                // However, we did not hit it due to accumulating discretization errors, so this is the point here to stop the ray as we would never reach the voxel key_end
+                if (dist_from_origin > length) {
+                    done = true;
+                    break;
+                }
+                else {  // continue to add freespace cells
+                    ray.addKey(current_key);
+                }
+            }
+
+            assert ( ray.size() < ray.sizeMax() - 1);
+        } // end while
+
+        return true;
+    }
+}
@@ -31,89 +31,28 @@
 
 namespace gridmap2D{
 	SuperRayGrid2D::SuperRayGrid2D(double in_resolution)
-	: OccupancyGrid2DBase<Grid2DNode>(in_resolution) {
+	: SuperRayGrid2DBase<Grid2DNode>(in_resolution) {
 		superrayGrid2DMemberInit.ensureLinking();
 	};
 
-	SuperRayGrid2D::StaticMemberInitializer SuperRayGrid2D::superrayGrid2DMemberInit;
-
-	void SuperRayGrid2D::insertPointCloudRays(const Pointcloud& pc, const point2d& origin)
-	{
-		if (pc.size() < 1)
-			return;
-
-	#ifdef _OPENMP
-		omp_set_num_threads(this->keyrays.size());
-	#pragma omp parallel for
-	#endif
-		for (int i = 0; i < (int)pc.size(); ++i) {
-			const point2d& p = pc[i];
-			unsigned threadIdx = 0;
-	#ifdef _OPENMP
-			threadIdx = omp_get_thread_num();
-	#endif
-			KeyRay* keyray = &(this->keyrays.at(threadIdx));
-
-			// free cells
-			if (this->computeRayKeys(origin, p, *keyray)){
-	#ifdef _OPENMP
-	#pragma omp critical
-	#endif
-				{
-					for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
-						updateNode(*it, false); // insert freespace measurement
-					}
-				}
-			}
-		}
-
-		for (int i = 0; i < (int)pc.size(); ++i){
-			updateNode(pc[i], true); // update endpoint to be occupied
-		}
-	}
-
-	void SuperRayGrid2D::insertSuperRayCloudRays(const Pointcloud& scan, const point2d& origin, const int threshold)
-	{
-		SuperRayGenerator srgenerator(resolution, grid_max_val, threshold);
-		SuperRayCloud srcloud;
-		srgenerator.GenerateSuperRay(scan, origin, srcloud);
-		insertSuperRayCloudRays(srcloud);
+	SuperRayGrid2D::SuperRayGrid2D(std::string _filename)
+	: SuperRayGrid2DBase<Grid2DNode>(0.1) { // resolution will be set according to grid file
+		superrayGrid2DMemberInit.ensureLinking();
+		readBinary(_filename);
 	}
 
-	void SuperRayGrid2D::insertSuperRayCloudRays(const SuperRayCloud& superray)
-	{
-		if (superray.size() < 1)
-			return;
-
-		point2d origin = superray.origin;
-	#ifdef _OPENMP
-		omp_set_num_threads(this->keyrays.size());
-	#pragma omp parallel
-	#endif
-		for (int i = 0; i < (int)superray.size(); ++i) {
-			const point2d& p = superray[i].p;
-			const float& missprob = prob_miss_log * superray[i].w;
-			unsigned threadIdx = 0;
-	#ifdef _OPENMP
-			threadIdx = omp_get_thread_num();
-	#endif
-			KeyRay* keyray = &(this->keyrays.at(threadIdx));
+	SuperRayGrid2D::StaticMemberInitializer SuperRayGrid2D::superrayGrid2DMemberInit;
 
-			// free cells
-			if (this->computeRayKeys(origin, p, *keyray)){
-	#ifdef _OPENMP
-	#pragma omp critical
-	#endif
-				{
-					for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
-						updateNode(*it, missprob);
-					}
-				}
-			}
-		}
+	SuperRayOpenGrid2D::SuperRayOpenGrid2D(double in_resolution)
+	: SuperRayGrid2DBase<Grid2DNode, Grid2DOpenStorage<Grid2DNode> >(in_resolution) {
+		superrayOpenGrid2DMemberInit.ensureLinking();
+	};
 
-		for (int i = 0; i < (int)superray.size(); ++i){
-			updateNode(superray[i].p, prob_hit_log * superray[i].w);
-		}
+	SuperRayOpenGrid2D::SuperRayOpenGrid2D(std::string _filename)
+	: SuperRayGrid2DBase<Grid2DNode, Grid2DOpenStorage<Grid2DNode> >(0.1) { // resolution will be set according to grid file
+		superrayOpenGrid2DMemberInit.ensureLinking();
+		readBinary(_filename);
 	}
-}
\ No newline at end of file
+
+	SuperRayOpenGrid2D::StaticMemberInitializer SuperRayOpenGrid2D::superrayOpenGrid2DMemberInit;
+}
@@ -0,0 +1,260 @@
+/*
+* Copyright(c) 2016, Youngsun Kwon, Donghyuk Kim, and Sung-eui Yoon, KAIST
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met :
+*
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and / or other materials provided with the distribution.
+*     * Neither the name of SuperRay nor the names of its
+*       contributors may be used to endorse or promote products derived from
+*       this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include <gridmap2D_superray/SuperRayRollingGrid2D.h>
+
+namespace gridmap2D{
+	SuperRayRollingGrid2D::SuperRayRollingGrid2D(double in_resolution, unsigned int window_width)
+	: OccupancyGrid2DBase<Grid2DNode, Grid2DRollingStorage<Grid2DNode> >(in_resolution) {
+		superrayRollingGrid2DMemberInit.ensureLinking();
+
+		unsigned int width_bits = windowWidthBits(window_width);
+		if ((1u << width_bits) < window_width)
+			GRIDMAP2D_WARNING_STR("Window width " << window_width << " exceeds the largest window, limited to " << (1u << width_bits) << " cells.");
+		key_type half = (key_type)((1u << width_bits) / 2);
+		key_type center = coordToKey(0.0);
+		gridmap->setWindow(width_bits, Grid2DKey(center - half, center - half));
+	};
+
+	SuperRayRollingGrid2D::StaticMemberInitializer SuperRayRollingGrid2D::superrayRollingGrid2DMemberInit;
+
+	unsigned int SuperRayRollingGrid2D::windowWidthBits(unsigned int window_width)
+	{
+		unsigned int width_bits = 0;
+		while ((1u << width_bits) < window_width && width_bits < Grid2DRollingStorage<Grid2DNode>::MAX_WIDTH_BITS)
+			width_bits++;
+		return width_bits;
+	}
+
+	bool SuperRayRollingGrid2D::readWindow(std::istream &s)
+	{
+		uint32_t window_width = 0;
+		Grid2DKey window_min;
+		s.read((char*)&window_width, sizeof(window_width));
+		for (unsigned int i = 0; i < 2; i++)
+			s.read((char*)&(window_min[i]), sizeof(window_min[i]));
+
+		unsigned int width_bits = windowWidthBits(window_width);
+		if (s.fail() || window_width == 0 || (1u << width_bits) != window_width){
+			GRIDMAP2D_ERROR_STR("SuperRayRollingGrid2D: invalid window of width " << window_width << ", nothing read.");
+			s.setstate(std::ios::failbit);
+			return false;
+		}
+
+		// grid needs to be newly created or cleared externally
+		if (gridmap->size() != 0){
+			GRIDMAP2D_ERROR_STR("Trying to read into an existing grid.");
+			return false;
+		}
+		gridmap->setWindow(width_bits, window_min);
+		return true;
+	}
+
+	void SuperRayRollingGrid2D::writeWindow(std::ostream &s) const
+	{
+		uint32_t window_width = gridmap->getWindowWidth();
+		const Grid2DKey& window_min = gridmap->getWindowMin();
+		s.write((char*)&window_width, sizeof(window_width));
+		for (unsigned int i = 0; i < 2; i++)
+			s.write((char*)&(window_min[i]), sizeof(window_min[i]));
+	}
+
+	std::istream& SuperRayRollingGrid2D::readData(std::istream &s)
+	{
+		if (readWindow(s))
+			OccupancyGrid2DBase<Grid2DNode, Grid2DRollingStorage<Grid2DNode> >::readData(s);
+		return s;
+	}
+
+	std::ostream& SuperRayRollingGrid2D::writeData(std::ostream &s) const
+	{
+		writeWindow(s);
+		return OccupancyGrid2DBase<Grid2DNode, Grid2DRollingStorage<Grid2DNode> >::writeData(s);
+	}
+
+	std::istream& SuperRayRollingGrid2D::readBinaryData(std::istream &s)
+	{
+		if (readWindow(s))
+			OccupancyGrid2DBase<Grid2DNode, Grid2DRollingStorage<Grid2DNode> >::readBinaryData(s);
+		return s;
+	}
+
+	std::ostream& SuperRayRollingGrid2D::writeBinaryData(std::ostream &s) const
+	{
+		writeWindow(s);
+		return OccupancyGrid2DBase<Grid2DNode, Grid2DRollingStorage<Grid2DNode> >::writeBinaryData(s);
+	}
+
+	std::istream& SuperRayRollingGrid2D::readBulkData(std::istream &s)
+	{
+		if (readWindow(s))
+			OccupancyGrid2DBase<Grid2DNode, Grid2DRollingStorage<Grid2DNode> >::readBulkData(s);
+		return s;
+	}
+
+	std::ostream& SuperRayRollingGrid2D::writeBulkData(std::ostream &s, bool delta_keys) const
+	{
+		writeWindow(s);
+		return OccupancyGrid2DBase<Grid2DNode, Grid2DRollingStorage<Grid2DNode> >::writeBulkData(s, delta_keys);
+	}
+
+	void SuperRayRollingGrid2D::moveWindow(const point2d& center)
+	{
+		Grid2DKey key;
+		if (!coordToKeyChecked(center, key)){
+			GRIDMAP2D_WARNING_STR("Window center " << center << " is out of Grid2D bounds, window not moved.");
+			return;
+		}
+
+		key_type half = (key_type)(gridmap->getWindowWidth() / 2);
+		gridmap->moveWindow(Grid2DKey(key[0] - half, key[1] - half));
+	}
+
+	void SuperRayRollingGrid2D::getWindowBounds(point2d& min, point2d& max) const
+	{
+		float half_resolution = float(resolution / 2.0);
+		min = keyToCoord(gridmap->getWindowMin()) - point2d(half_resolution, half_resolution);
+		float extent = float(gridmap->getWindowWidth() * resolution);
+		max = min + point2d(extent, extent);
+	}
+
+	bool SuperRayRollingGrid2D::clipRay(const point2d& origin, const point2d& end, point2d& clipped_origin, point2d& clipped_end) const
+	{
+		point2d window_min, window_max;
+		getWindowBounds(window_min, window_max);
+
+		// slab test of the segment against the window enlarged by one cell
+		point2d direction = end - origin;
+		double t_min = 0.0, t_max = 1.0;
+		for (unsigned int i = 0; i < 2; i++){
+			double lower = window_min(i) - resolution;
+			double upper = window_max(i) + resolution;
+			if (direction(i) == 0.0){
+				if (origin(i) < lower || origin(i) > upper)
+					return false;
+				continue;
+			}
+			double t0 = (lower - origin(i)) / direction(i);
+			double t1 = (upper - origin(i)) / direction(i);
+			if (t0 > t1)
+				std::swap(t0, t1);
+			t_min = std::max(t_min, t0);
+			t_max = std::min(t_max, t1);
+			if (t_min > t_max)
+				return false;
+		}
+
+		// keep the original points when they are inside to trace the same cells as an unclipped ray
+		clipped_origin = (t_min > 0.0) ? origin + direction * (float)t_min : origin;
+		clipped_end = (t_max < 1.0) ? origin + direction * (float)t_max : end;
+		return true;
+	}
+
+	void SuperRayRollingGrid2D::insertPointCloudRays(const Pointcloud& pc, const point2d& origin)
+	{
+		if (pc.size() < 1)
+			return;
+
+	#ifdef _OPENMP
+		omp_set_num_threads(this->keyrays.size());
+	#pragma omp parallel for
+	#endif
+		for (int i = 0; i < (int)pc.size(); ++i) {
+			const point2d& p = pc[i];
+			unsigned threadIdx = 0;
+	#ifdef _OPENMP
+			threadIdx = omp_get_thread_num();
+	#endif
+			KeyRay* keyray = &(this->keyrays.at(threadIdx));
+
+			// free cells within the window
+			point2d ray_origin, ray_end;
+			if (clipRay(origin, p, ray_origin, ray_end) && this->computeRayKeys(ray_origin, ray_end, *keyray)){
+	#ifdef _OPENMP
+	#pragma omp critical
+	#endif
+				{
+					for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
+						updateNode(*it, false); // insert freespace measurement
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < (int)pc.size(); ++i){
+			updateNode(pc[i], true); // update endpoint to be occupied
+		}
+	}
+
+	void SuperRayRollingGrid2D::insertSuperRayCloudRays(const Pointcloud& scan, const point2d& origin, const int threshold)
+	{
+		SuperRayGenerator srgenerator(resolution, grid_max_val, threshold);
+		SuperRayCloud srcloud;
+		srgenerator.GenerateSuperRay(scan, origin, srcloud);
+		insertSuperRayCloudRays(srcloud);
+	}
+
+	void SuperRayRollingGrid2D::insertSuperRayCloudRays(const SuperRayCloud& superray)
+	{
+		if (superray.size() < 1)
+			return;
+
+		point2d origin = superray.origin;
+	#ifdef _OPENMP
+		omp_set_num_threads(this->keyrays.size());
+	#pragma omp parallel for
+	#endif
+		for (int i = 0; i < (int)superray.size(); ++i) {
+			const point2d& p = superray[i].p;
+			const float& missprob = prob_miss_log * superray[i].w;
+			unsigned threadIdx = 0;
+	#ifdef _OPENMP
+			threadIdx = omp_get_thread_num();
+	#endif
+			KeyRay* keyray = &(this->keyrays.at(threadIdx));
+
+			// free cells within the window
+			point2d ray_origin, ray_end;
+			if (clipRay(origin, p, ray_origin, ray_end) && this->computeRayKeys(ray_origin, ray_end, *keyray)){
+	#ifdef _OPENMP
+	#pragma omp critical
+	#endif
+				{
+					for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
+						updateNode(*it, missprob);
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < (int)superray.size(); ++i){
+			updateNode(superray[i].p, prob_hit_log * superray[i].w);
+		}
+	}
+}
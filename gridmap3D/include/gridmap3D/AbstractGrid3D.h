@@ -108,6 +108,34 @@ namespace gridmap3D {
 		/// Write complete state of grid to stream (without file header) unmodified.
 		/// Pruning the grid first produces smaller files (lossless compression)
 		virtual std::ostream& writeData(std::ostream &s) const = 0;
+
+		/**
+		 * Write file header and complete grid to file in the bulk format, which
+		 * stores the cells in chunks of keys and raw node values with a
+		 * single write per chunk instead of several per cell. With delta_keys,
+		 * the cells of each chunk are sorted by the Morton code of their key
+		 * and every key is stored as the variable-length difference to the
+		 * previous one (mostly 1-2 bytes instead of 6), at the cost of a sort
+		 * per chunk.
+		 * Read it with readBulk().
+		 */
+		bool writeBulk(const std::string& filename, bool delta_keys = false) const;
+		/// Write file header and complete grid to stream in the bulk format, see writeBulk()
+		bool writeBulk(std::ostream& s, bool delta_keys = false) const;
+
+		/// Read a file written by writeBulk(), create the appropriate class and deserialize.
+		/// This creates a new grid3D which you need to delete yourself.
+		static AbstractGrid3D* readBulk(const std::string& filename);
+
+		/// Read a stream written by writeBulk(), create the appropriate class and deserialize.
+		/// This creates a new grid3D which you need to delete yourself.
+		static AbstractGrid3D* readBulk(std::istream &s);
+
+		/// Read all cells in the bulk format from the input stream (without file header)
+		virtual std::istream& readBulkData(std::istream &s) = 0;
+
+		/// Write all cells in the bulk format to stream (without file header)
+		virtual std::ostream& writeBulkData(std::ostream &s, bool delta_keys) const = 0;
 	private:
 		/// create private store, Construct on first use
 		static std::map<std::string, AbstractGrid3D*>& classIDMapping();
@@ -117,6 +145,7 @@ namespace gridmap3D {
 		static void registerGridType(AbstractGrid3D* grid);
 
 		static const std::string fileHeader;
+		static const std::string bulkFileHeader;
 	};
 } // end namespace
 
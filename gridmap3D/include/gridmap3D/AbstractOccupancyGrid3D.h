@@ -44,13 +44,14 @@
 namespace gridmap3D {
 
 	/**
-	 * Interface class for all grid types that store occupancy. This serves
-	 * as a common base class
+	 * Common base class of all grid types that store occupancy: the sensor
+	 * model, the occupancy queries and the binary IO, for any occupancy node.
+	 * AbstractOccupancyGrid3D adds the updates of Grid3DNode cells.
 	 */
-	class AbstractOccupancyGrid3D : public AbstractGrid3D {
+	class AbstractOccupancyGrid3DBase : public AbstractGrid3D {
 	public:
-		AbstractOccupancyGrid3D();
-		virtual ~AbstractOccupancyGrid3D() {};
+		AbstractOccupancyGrid3DBase();
+		virtual ~AbstractOccupancyGrid3DBase() {};
 
 		//-- IO
 
@@ -103,67 +104,31 @@ namespace gridmap3D {
 		// -- occupancy queries
 
 		/// queries whether a node is occupied according to the grid's parameter for "occupancy"
-		inline bool isNodeOccupied(const Grid3DNode* occupancyNode) const{
+		template <class NODE>
+		inline bool isNodeOccupied(NODE* occupancyNode) const{
 			return (occupancyNode->getLogOdds() >= this->occ_prob_thres_log);
 		}
 
 		/// queries whether a node is occupied according to the grid's parameter for "occupancy"
-		inline bool isNodeOccupied(const Grid3DNode& occupancyNode) const{
+		template <class NODE>
+		inline bool isNodeOccupied(const NODE& occupancyNode) const{
 			return (occupancyNode.getLogOdds() >= this->occ_prob_thres_log);
 		}
 
 		/// queries whether a node is at the clamping threshold according to the grid's parameter
-		inline bool isNodeAtThreshold(const Grid3DNode* occupancyNode) const{
+		template <class NODE>
+		inline bool isNodeAtThreshold(NODE* occupancyNode) const{
 			return (occupancyNode->getLogOdds() >= this->clamping_thres_max
 				|| occupancyNode->getLogOdds() <= this->clamping_thres_min);
 		}
 
 		/// queries whether a node is at the clamping threshold according to the grid's parameter
-		inline bool isNodeAtThreshold(const Grid3DNode& occupancyNode) const{
+		template <class NODE>
+		inline bool isNodeAtThreshold(const NODE& occupancyNode) const{
 			return (occupancyNode.getLogOdds() >= this->clamping_thres_max
 				|| occupancyNode.getLogOdds() <= this->clamping_thres_min);
 		}
 
-		// - update functions
-
-		/**
-		 * Manipulate log_odds value of voxel directly
-		 *
-		 * @param key of the NODE that is to be updated
-		 * @param log_odds_update value to be added (+) to log_odds value of node
-		 * @return pointer to the updated NODE
-		 */
-		virtual Grid3DNode* updateNode(const Grid3DKey& key, float log_odds_update) = 0;
-
-		/**
-		 * Manipulate log_odds value of voxel directly.
-		 * Looks up the Grid3DKey corresponding to the coordinate and then calls udpateNode() with it.
-		 *
-		 * @param value 3d coordinate of the NODE that is to be updated
-		 * @param log_odds_update value to be added (+) to log_odds value of node
-		 * @return pointer to the updated NODE
-		 */
-		virtual Grid3DNode* updateNode(const point3d& value, float log_odds_update) = 0;
-
-		/**
-		 * Integrate occupancy measurement.
-		 *
-		 * @param key of the NODE that is to be updated
-		 * @param occupied true if the node was measured occupied, else false
-		 * @return pointer to the updated NODE
-		 */
-		virtual Grid3DNode* updateNode(const Grid3DKey& key, bool occupied) = 0;
-
-		/**
-		 * Integrate occupancy measurement.
-		 * Looks up the Grid3DKey corresponding to the coordinate and then calls udpateNode() with it.
-		 *
-		 * @param value 3d coordinate of the NODE that is to be updated
-		 * @param occupied true if the node was measured occupied, else false
-		 * @return pointer to the updated NODE
-		 */
-		virtual Grid3DNode* updateNode(const point3d& value, bool occupied) = 0;
-
 		virtual void toMaxLikelihood() = 0;
 
 		//-- parameters for occupancy and sensor model:
@@ -214,6 +179,70 @@ namespace gridmap3D {
 		static const std::string binaryFileHeader;
 	};
 
+
+	/**
+	 * Interface class for all grid types that store occupancy in Grid3DNode
+	 * cells (or cells derived from it). This serves as a common base class
+	 */
+	class AbstractOccupancyGrid3D : public AbstractOccupancyGrid3DBase {
+	public:
+		virtual ~AbstractOccupancyGrid3D() {};
+
+		// - update functions
+
+		/**
+		 * Manipulate log_odds value of voxel directly
+		 *
+		 * @param key of the NODE that is to be updated
+		 * @param log_odds_update value to be added (+) to log_odds value of node
+		 * @return pointer to the updated NODE
+		 */
+		virtual Grid3DNode* updateNode(const Grid3DKey& key, float log_odds_update) = 0;
+
+		/**
+		 * Manipulate log_odds value of voxel directly.
+		 * Looks up the Grid3DKey corresponding to the coordinate and then calls udpateNode() with it.
+		 *
+		 * @param value 3d coordinate of the NODE that is to be updated
+		 * @param log_odds_update value to be added (+) to log_odds value of node
+		 * @return pointer to the updated NODE
+		 */
+		virtual Grid3DNode* updateNode(const point3d& value, float log_odds_update) = 0;
+
+		/**
+		 * Integrate occupancy measurement.
+		 *
+		 * @param key of the NODE that is to be updated
+		 * @param occupied true if the node was measured occupied, else false
+		 * @return pointer to the updated NODE
+		 */
+		virtual Grid3DNode* updateNode(const Grid3DKey& key, bool occupied) = 0;
+
+		/**
+		 * Integrate occupancy measurement.
+		 * Looks up the Grid3DKey corresponding to the coordinate and then calls udpateNode() with it.
+		 *
+		 * @param value 3d coordinate of the NODE that is to be updated
+		 * @param occupied true if the node was measured occupied, else false
+		 * @return pointer to the updated NODE
+		 */
+		virtual Grid3DNode* updateNode(const point3d& value, bool occupied) = 0;
+	};
+
+
+	/**
+	 * Interface of OccupancyGrid3DBase over NODE: AbstractOccupancyGrid3D for
+	 * Grid3DNode and nodes derived from it. Nodes of another value type, such as
+	 * Grid3DQuantizedNode, specialize it to AbstractOccupancyGrid3DBase, so that
+	 * their updateNode() returns their own node type.
+	 *
+	 * \tparam NODE Node class of the grid
+	 */
+	template <class NODE>
+	struct Grid3DOccupancyInterface {
+		typedef AbstractOccupancyGrid3D type;
+	};
+
 }; // end namespace
 
 
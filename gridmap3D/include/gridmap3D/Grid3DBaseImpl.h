@@ -42,6 +42,7 @@
 
 #include "gridmap3D_types.h"
 #include "Grid3DKey.h"
+#include "Grid3DStorage.h"
 #include "ScanGraph.h"
 
 namespace gridmap3D {
@@ -65,9 +66,14 @@ namespace gridmap3D {
 	 * \tparam NODE Node class to be used in grid (usually derived from
 	 *    Grid3DDataNode)
 	 * \tparam INTERFACE Interface to be derived from, should be either
-	 *    AbstractGrid3D or AbstractOccupancyGrid3D
+	 *    AbstractGrid3D, AbstractOccupancyGrid3D or AbstractOccupancyGrid3DBase
+	 * \tparam STORAGE Storage policy of the cells: Grid3DHashStorage (one hash
+	 *    entry per cell), Grid3DBlockStorage (dense blocks of cells),
+	 *    Grid3DOpenStorage (open addressing with inline nodes) or
+	 *    Grid3DShardedStorage (hash maps with a lock per shard, for
+	 *    parallel updates, experimental)
 	 */
-	template <class NODE, class INTERFACE>
+	template <class NODE, class INTERFACE, class STORAGE = Grid3DHashStorage<NODE> >
 	class Grid3DBaseImpl : public INTERFACE {
 
 	public:
@@ -78,7 +84,7 @@ namespace gridmap3D {
 		virtual ~Grid3DBaseImpl();
 
 		/// Deep copy constructor
-		Grid3DBaseImpl(const Grid3DBaseImpl<NODE, INTERFACE>& rhs);
+		Grid3DBaseImpl(const Grid3DBaseImpl<NODE, INTERFACE, STORAGE>& rhs);
 
 
 		/**
@@ -87,11 +93,11 @@ namespace gridmap3D {
 		 * metadata (resolution etc) matches. No memory is cleared
 		 * in this function
 		 */
-		void swapContent(Grid3DBaseImpl<NODE, INTERFACE>& rhs);
+		void swapContent(Grid3DBaseImpl<NODE, INTERFACE, STORAGE>& rhs);
 
 		/// Comparison between two grids, all meta data, all
 		/// nodes, and the structure must be identical
-//		bool operator== (const Grid3DBaseImpl<NODE, INTERFACE>& rhs) const;
+//		bool operator== (const Grid3DBaseImpl<NODE, INTERFACE, STORAGE>& rhs) const;
 
 		std::string getGridType() const { return "Grid3DBaseImpl"; }
 
@@ -109,12 +115,13 @@ namespace gridmap3D {
 			keyrays.clear();
 		}
 
+		/// Storage of the cells, iterating it yields (Grid3DKey, NODE*) pairs
+		typedef STORAGE OccupancyGridMap;
 		/**
 		* \return Pointer to the grid. This pointer
 		* should not be modified or deleted externally, the Grid3D
 		* manages its memory itself.
 		*/
-		typedef unordered_ns::unordered_map<Grid3DKey, NODE*, Grid3DKey::KeyHash> OccupancyGridMap;
 		inline OccupancyGridMap* getGrid() const { return gridmap; }
 
 		/**
@@ -162,7 +169,7 @@ namespace gridmap3D {
 		virtual inline size_t size() const { return gridmap->size(); }
 
 		/// \return Memory usage of the grid3D in bytes (may vary between architectures)
-		virtual size_t memoryUsage() const;     // TODO: add the memory usage of hash table
+		virtual size_t memoryUsage() const;
 
 		/// \return Memory usage of a single grid3D node
 		virtual inline size_t memoryUsageNode() const { return sizeof(NODE); };
@@ -228,6 +235,18 @@ namespace gridmap3D {
 		/// Write complete state of grid to stream (without file header) unmodified.
 		std::ostream& writeData(std::ostream &s) const;
 
+		/**
+		 * Read all cells from the input stream in the bulk format of
+		 * writeBulkData() (without file header), for this the grid needs to
+		 * be already created and empty. With a concurrent storage, the cells
+		 * of a chunk are inserted in parallel. For general file IO, you
+		 * should probably use AbstractGrid3D::readBulk() instead.
+		 */
+		std::istream& readBulkData(std::istream &s);
+
+		/// Write all cells to stream in the bulk format (without file header), see AbstractGrid3D::writeBulk()
+		std::ostream& writeBulkData(std::ostream &s, bool delta_keys = false) const;
+
 		/// @return beginning of the grid as iterator
 //		const OccupancyGridMap::iterator begin() const { return gridmap->begin(); }
 		/// @return end of the grid as iterator
@@ -292,6 +311,22 @@ namespace gridmap3D {
 		}
 
 	protected:
+		/// Number of cells per chunk of the bulk format
+		static const uint32_t BULK_CHUNK_SIZE = 65536;
+		/// Flag of the bulk format: keys are stored as Morton code differences
+		static const uint8_t BULK_DELTA_KEYS = 1;
+		/// Largest number of bytes of a key in the bulk format (a LEB128 coded Morton code)
+		static const uint32_t BULK_MAX_KEY_BYTES = (8 * sizeof(uint64_t) + 6) / 7;
+
+		/// Writes one chunk of the bulk format and empties keys and values
+		static void writeBulkChunk(std::ostream &s, std::vector<uint8_t>& keys, std::vector<typename NODE::DataType>& values);
+
+		/// Sorts the cells of one chunk by Morton code, appends their keys as LEB128 coded differences and their values, and empties cells
+		static void writeBulkDeltaKeys(std::vector<std::pair<uint64_t, typename NODE::DataType> >& cells, std::vector<uint8_t>& keys, std::vector<typename NODE::DataType>& values);
+
+		/// Decodes the keys of one chunk of the bulk format, @return false if they are corrupt
+		static bool readBulkKeys(const std::vector<uint8_t>& keys, uint8_t flags, std::vector<Grid3DKey>& cell_keys);
+
 		/// Constructor to enable derived classes to change grid constants.
 		/// This usually requires a re-implementation of some core grid-traversal functions as well!
 		Grid3DBaseImpl(double resolution, unsigned int grid_max_val);
@@ -299,13 +334,13 @@ namespace gridmap3D {
 		/// initialize non-trivial members, helper for constructors
 		void init();
 
-		/// recalculates min and max in x, y. Does nothing when grid size didn't change.
+		/// updates min_value and max_value from the key bounds of the storage, O(1)
 		void calcMinMax();
 
 	private:
 		/// Assignment operator is private: don't (re-)assign grid3D
 		/// (const-parameters can't be changed) -  use the copy constructor instead.
-		Grid3DBaseImpl<NODE, INTERFACE>& operator=(const Grid3DBaseImpl<NODE, INTERFACE>&);
+		Grid3DBaseImpl<NODE, INTERFACE, STORAGE>& operator=(const Grid3DBaseImpl<NODE, INTERFACE, STORAGE>&);
 
 	protected:
 		OccupancyGridMap* gridmap;
@@ -315,7 +350,7 @@ namespace gridmap3D {
 		double resolution;  ///< in meters
 		double resolution_factor; ///< = 1. / resolution
 
-		/// flag to denote whether the grid extent changed (for lazy min/max eval)
+		/// flag to denote whether min_value and max_value are out of date
 		bool size_changed;
 
 		point3d grid_center;  // coordinate offset of grid
@@ -34,6 +34,8 @@
 #undef max
 #undef min
 #include <limits>
+#include <algorithm>
+#include <cstring>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -41,16 +43,16 @@
 
 namespace gridmap3D {
 
-	template <class NODE, class I>
-	Grid3DBaseImpl<NODE, I>::Grid3DBaseImpl(double in_resolution) :
+	template <class NODE, class I, class S>
+	Grid3DBaseImpl<NODE, I, S>::Grid3DBaseImpl(double in_resolution) :
 		I(), gridmap(NULL), grid_max_val(32768),
 		resolution(in_resolution)
 	{
 		init();
 	}
 
-	template <class NODE, class I>
-	Grid3DBaseImpl<NODE, I>::Grid3DBaseImpl(double in_resolution, unsigned int in_grid_max_val) :
+	template <class NODE, class I, class S>
+	Grid3DBaseImpl<NODE, I, S>::Grid3DBaseImpl(double in_resolution, unsigned int in_grid_max_val) :
 		I(), gridmap(NULL), grid_max_val(in_grid_max_val),
 		resolution(in_resolution)
 	{
@@ -58,30 +60,26 @@ namespace gridmap3D {
 	}
 
 
-	template <class NODE, class I>
-	Grid3DBaseImpl<NODE, I>::~Grid3DBaseImpl(){
+	template <class NODE, class I, class S>
+	Grid3DBaseImpl<NODE, I, S>::~Grid3DBaseImpl(){
 		clear();
 	}
 
 
-	template <class NODE, class I>
-	Grid3DBaseImpl<NODE, I>::Grid3DBaseImpl(const Grid3DBaseImpl<NODE, I>& rhs) :
+	template <class NODE, class I, class S>
+	Grid3DBaseImpl<NODE, I, S>::Grid3DBaseImpl(const Grid3DBaseImpl<NODE, I, S>& rhs) :
 		gridmap(NULL), grid_max_val(rhs.grid_max_val),
 		resolution(rhs.resolution)
 	{
 		init();
 
 		// Copy all of node
-		if (rhs.gridmap){
-			// TODO: copy operator?
-			for (typename OccupancyGridMap::iterator it = rhs.gridmap->begin(); it != rhs.gridmap->end(); it++){
-				gridmap->insert(std::pair<Grid3DKey, NODE*>(it->first, new NODE(*(it->second))));
-			}
-		}
+		if (rhs.gridmap)
+			gridmap = new OccupancyGridMap(*(rhs.gridmap));
 	}
 
-	template <class NODE, class I>
-	void Grid3DBaseImpl<NODE, I>::init(){
+	template <class NODE, class I, class S>
+	void Grid3DBaseImpl<NODE, I, S>::init(){
 		this->setResolution(this->resolution);
 		for (unsigned i = 0; i < 3; i++){
 			max_value[i] = -(std::numeric_limits<double>::max());
@@ -106,15 +104,15 @@ namespace gridmap3D {
 
 	}
 
-	template <class NODE, class I>
-	void Grid3DBaseImpl<NODE, I>::swapContent(Grid3DBaseImpl<NODE, I>& other){
-		OccupancyGridMap* this_gridmap = this->gridamp;
-		this->gridamp = other.gridamp;
-		other.gridamp = this_gridmap;
+	template <class NODE, class I, class S>
+	void Grid3DBaseImpl<NODE, I, S>::swapContent(Grid3DBaseImpl<NODE, I, S>& other){
+		OccupancyGridMap* this_gridmap = this->gridmap;
+		this->gridmap = other.gridmap;
+		other.gridmap = this_gridmap;
 	}
 
-    /*template <class NODE, class I>
-	bool Grid3DBaseImpl<NODE, I>::operator== (const Grid3DBaseImpl<NODE, I>& other) const{
+    /*template <class NODE, class I, class S>
+	bool Grid3DBaseImpl<NODE, I, S>::operator== (const Grid3DBaseImpl<NODE, I, S>& other) const{
 		if (grid_max_val != other.grid_max_val || resolution != other.resolution || this->size() != other.size()){
 			return false;
 		}
@@ -133,8 +131,8 @@ namespace gridmap3D {
 		return true;
 	}*/
 
-	template <class NODE, class I>
-	void Grid3DBaseImpl<NODE, I>::setResolution(double r) {
+	template <class NODE, class I, class S>
+	void Grid3DBaseImpl<NODE, I, S>::setResolution(double r) {
 		resolution = r;
 		resolution_factor = 1. / resolution;
 
@@ -143,8 +141,8 @@ namespace gridmap3D {
 		size_changed = true;
 	}
 
-	template <class NODE, class I>
-	bool Grid3DBaseImpl<NODE, I>::coordToKeyChecked(double coordinate, key_type& keyval) const {
+	template <class NODE, class I, class S>
+	bool Grid3DBaseImpl<NODE, I, S>::coordToKeyChecked(double coordinate, key_type& keyval) const {
 		// scale to resolution and shift center for grid_max_val
 		int scaled_coord = ((int)floor(resolution_factor * coordinate)) + grid_max_val;
 
@@ -156,16 +154,16 @@ namespace gridmap3D {
 		return false;
 	}
 
-	template <class NODE, class I>
-	bool Grid3DBaseImpl<NODE, I>::coordToKeyChecked(const point3d& point, Grid3DKey& key) const{
+	template <class NODE, class I, class S>
+	bool Grid3DBaseImpl<NODE, I, S>::coordToKeyChecked(const point3d& point, Grid3DKey& key) const{
 		for (unsigned int i = 0; i < 3; i++) {
 			if (!coordToKeyChecked(point(i), key[i])) return false;
 		}
 		return true;
 	}
 
-	template <class NODE, class I>
-	bool Grid3DBaseImpl<NODE, I>::coordToKeyChecked(double x, double y, double z, Grid3DKey& key) const{
+	template <class NODE, class I, class S>
+	bool Grid3DBaseImpl<NODE, I, S>::coordToKeyChecked(double x, double y, double z, Grid3DKey& key) const{
 		if (!(coordToKeyChecked(x, key[0]) && coordToKeyChecked(y, key[1]) && coordToKeyChecked(z, key[2]))) {
 			return false;
 		}
@@ -174,8 +172,8 @@ namespace gridmap3D {
 		}
 	}
 
-	template <class NODE, class I>
-	NODE* Grid3DBaseImpl<NODE, I>::search(const point3d& value) const {
+	template <class NODE, class I, class S>
+	NODE* Grid3DBaseImpl<NODE, I, S>::search(const point3d& value) const {
 		Grid3DKey key;
 		if (!coordToKeyChecked(value, key)){
 			GRIDMAP3D_ERROR_STR("Error in search: [" << value << "] is out of Grid3D bounds!");
@@ -187,8 +185,8 @@ namespace gridmap3D {
 
 	}
 
-	template <class NODE, class I>
-	NODE* Grid3DBaseImpl<NODE, I>::search(double x, double y, double z) const {
+	template <class NODE, class I, class S>
+	NODE* Grid3DBaseImpl<NODE, I, S>::search(double x, double y, double z) const {
 		Grid3DKey key;
 		if (!coordToKeyChecked(x, y, z, key)){
 			GRIDMAP3D_ERROR_STR("Error in search: [" << x << " " << y << " " << z << "] is out of Grid3D bounds!");
@@ -200,19 +198,17 @@ namespace gridmap3D {
 	}
 
 
-	template <class NODE, class I>
-	NODE* Grid3DBaseImpl<NODE, I>::search(const Grid3DKey& key) const {
-		if (gridmap->size() == 0)
+	template <class NODE, class I, class S>
+	NODE* Grid3DBaseImpl<NODE, I, S>::search(const Grid3DKey& key) const {
+		// the size of a concurrent storage may be changed by other threads meanwhile
+		if (!Grid3DStorageTraits<S>::concurrent && gridmap->size() == 0)
 			return NULL;
 
-		typename OccupancyGridMap::iterator cell = gridmap->find(key);
-		if (cell == gridmap->end())
-			return NULL;
-		return cell->second;
+		return gridmap->search(key);
 	}
 
-	template <class NODE, class I>
-	bool Grid3DBaseImpl<NODE, I>::deleteNode(const point3d& value) {
+	template <class NODE, class I, class S>
+	bool Grid3DBaseImpl<NODE, I, S>::deleteNode(const point3d& value) {
 		Grid3DKey key;
 		if (!coordToKeyChecked(value, key)){
 			GRIDMAP3D_ERROR_STR("Error in deleteNode: [" << value << "] is out of Grid3D bounds!");
@@ -223,8 +219,8 @@ namespace gridmap3D {
 		}
 	}
 
-	template <class NODE, class I>
-	bool Grid3DBaseImpl<NODE, I>::deleteNode(double x, double y, double z) {
+	template <class NODE, class I, class S>
+	bool Grid3DBaseImpl<NODE, I, S>::deleteNode(double x, double y, double z) {
 		Grid3DKey key;
 		if (!coordToKeyChecked(x, y, z, key)){
 			GRIDMAP3D_ERROR_STR("Error in deleteNode: [" << x << " " << y << " " << z << "] is out of Grid3D bounds!");
@@ -236,28 +232,22 @@ namespace gridmap3D {
 	}
 
 
-	template <class NODE, class I>
-	bool Grid3DBaseImpl<NODE, I>::deleteNode(const Grid3DKey& key) {
+	template <class NODE, class I, class S>
+	bool Grid3DBaseImpl<NODE, I, S>::deleteNode(const Grid3DKey& key) {
 		if (gridmap->size() == 0)
 			return true;
 
-		typename OccupancyGridMap::iterator cell = gridmap->find(key);
-		if (cell == gridmap->end())
-			return false;
-
-		gridmap->erase(cell);
-
-		return true;
+		return gridmap->deleteNode(key);
 	}
 
-	template <class NODE, class I>
-	void Grid3DBaseImpl<NODE, I>::clear() {
+	template <class NODE, class I, class S>
+	void Grid3DBaseImpl<NODE, I, S>::clear() {
 		if (gridmap != NULL)
 			gridmap->clear();
 	}
 
-	template <class NODE, class I>
-	bool Grid3DBaseImpl<NODE, I>::computeRayKeys(const point3d& origin, const point3d& end, KeyRay& ray) const {
+	template <class NODE, class I, class S>
+	bool Grid3DBaseImpl<NODE, I, S>::computeRayKeys(const point3d& origin, const point3d& end, KeyRay& ray) const {
 
 		// see "A Faster Voxel Traversal Algorithm for Ray Tracing" by Amanatides & Woo
 		// basically: DDA in 3D
@@ -265,8 +255,8 @@ namespace gridmap3D {
 		ray.reset();
 
 		Grid3DKey key_origin, key_end;
-		if (!Grid3DBaseImpl<NODE, I>::coordToKeyChecked(origin, key_origin) ||
-			!Grid3DBaseImpl<NODE, I>::coordToKeyChecked(end, key_end)) {
+		if (!Grid3DBaseImpl<NODE, I, S>::coordToKeyChecked(origin, key_origin) ||
+			!Grid3DBaseImpl<NODE, I, S>::coordToKeyChecked(end, key_end)) {
 			GRIDMAP3D_WARNING_STR("coordinates ( " << origin << " -> " << end << ") out of bounds in computeRayKeys");
 			return false;
 		}
@@ -362,8 +352,8 @@ namespace gridmap3D {
 		return true;
 	}
 
-	template <class NODE, class I>
-	bool Grid3DBaseImpl<NODE, I>::computeRay(const point3d& origin, const point3d& end, std::vector<point3d>& _ray) {
+	template <class NODE, class I, class S>
+	bool Grid3DBaseImpl<NODE, I, S>::computeRay(const point3d& origin, const point3d& end, std::vector<point3d>& _ray) {
 		_ray.clear();
 		if (!computeRayKeys(origin, end, keyrays.at(0))) return false;
 		for (KeyRay::const_iterator it = keyrays[0].begin(); it != keyrays[0].end(); ++it) {
@@ -372,8 +362,8 @@ namespace gridmap3D {
 		return true;
 	}
 
-	template <class NODE, class I>
-	std::ostream& Grid3DBaseImpl<NODE, I>::writeData(std::ostream &s) const{
+	template <class NODE, class I, class S>
+	std::ostream& Grid3DBaseImpl<NODE, I, S>::writeData(std::ostream &s) const{
 		if (gridmap){
 			size_t node_size = gridmap->size();
 			s.write((char*)&node_size, sizeof(node_size));
@@ -392,8 +382,8 @@ namespace gridmap3D {
 		return s;
 	}
 
-	template <class NODE, class I>
-	std::istream& Grid3DBaseImpl<NODE, I>::readData(std::istream &s) {
+	template <class NODE, class I, class S>
+	std::istream& Grid3DBaseImpl<NODE, I, S>::readData(std::istream &s) {
 		if (!s.good()){
 			GRIDMAP3D_WARNING_STR(__FILE__ << ":" << __LINE__ << "Warning: Input filestream not \"good\"");
 		}
@@ -411,19 +401,21 @@ namespace gridmap3D {
 		}
 
 		if (node_size > 0){
+			gridmap->reserve(node_size);
 			for (unsigned int i = 0; i < node_size; i++){
-				NODE* node;
+				NODE node;
 				Grid3DKey key;
 				// Read key of grid node
 				s.read((char*)&(key[0]), sizeof(key[0]));
 				s.read((char*)&(key[1]), sizeof(key[1]));
 				s.read((char*)&(key[2]), sizeof(key[2]));
 				// Read occupancy of grid node
-				node = new NODE;
-				node->readData(s);
+				node.readData(s);
 
 				if (!s.fail()){
-					gridmap->insert(std::pair<Grid3DKey, NODE*>(key, node));
+					NODE* cell = gridmap->createNode(key);
+					if (cell)
+						cell->copyData(node);
 				}
 				else{
 					GRIDMAP3D_ERROR_STR("Grid3DBaseImpl::ReadData: ERROR.\n");
@@ -435,11 +427,223 @@ namespace gridmap3D {
 		return s;
 	}
 
+	template <class NODE, class I, class S>
+	std::ostream& Grid3DBaseImpl<NODE, I, S>::writeBulkData(std::ostream &s, bool delta_keys) const{
+		typedef typename NODE::DataType DataType;
+
+		uint64_t num_cells = gridmap ? gridmap->size() : 0;
+		uint32_t value_size = sizeof(DataType);
+		uint8_t flags = delta_keys ? BULK_DELTA_KEYS : 0;
+		s.write((char*)&num_cells, sizeof(num_cells));
+		s.write((char*)&value_size, sizeof(value_size));
+		s.write((char*)&flags, sizeof(flags));
+		if (num_cells == 0)
+			return s;
+
+		std::vector<uint8_t> keys;
+		std::vector<DataType> values;
+		values.reserve(BULK_CHUNK_SIZE);
+
+		if (!delta_keys) {
+			// single pass in the order of the storage
+			keys.reserve(BULK_CHUNK_SIZE * sizeof(Grid3DKey().k));
+			for (typename OccupancyGridMap::iterator it = gridmap->begin(); it != gridmap->end(); it++){
+				const uint8_t* key = (const uint8_t*)it->first.k;
+				keys.insert(keys.end(), key, key + sizeof(it->first.k));
+				values.push_back(it->second->getValue());
+				if (values.size() == BULK_CHUNK_SIZE)
+					writeBulkChunk(s, keys, values);
+			}
+		}
+		else {
+			// single pass as well: every chunk is sorted by Morton code on its own,
+			// so only one chunk of cells is buffered instead of a sorted copy of the grid
+			std::vector<std::pair<uint64_t, DataType> > cells;
+			cells.reserve(BULK_CHUNK_SIZE);
+			keys.reserve(BULK_CHUNK_SIZE * 2);
+			for (typename OccupancyGridMap::iterator it = gridmap->begin(); it != gridmap->end(); it++){
+				cells.push_back(std::make_pair(it->first.mortonCode(), it->second->getValue()));
+				if (cells.size() == BULK_CHUNK_SIZE) {
+					writeBulkDeltaKeys(cells, keys, values);
+					writeBulkChunk(s, keys, values);
+				}
+			}
+			writeBulkDeltaKeys(cells, keys, values);
+		}
+
+		if (!values.empty())
+			writeBulkChunk(s, keys, values);
+
+		return s;
+	}
+
+	template <class NODE, class I, class S>
+	void Grid3DBaseImpl<NODE, I, S>::writeBulkChunk(std::ostream &s, std::vector<uint8_t>& keys, std::vector<typename NODE::DataType>& values){
+		uint32_t num_cells = (uint32_t)values.size();
+		uint32_t key_bytes = (uint32_t)keys.size();
+		s.write((char*)&num_cells, sizeof(num_cells));
+		s.write((char*)&key_bytes, sizeof(key_bytes));
+		s.write((char*)&keys[0], key_bytes);
+		s.write((char*)&values[0], num_cells * sizeof(typename NODE::DataType));
+		keys.clear();
+		values.clear();
+	}
+
+	template <class NODE, class I, class S>
+	void Grid3DBaseImpl<NODE, I, S>::writeBulkDeltaKeys(std::vector<std::pair<uint64_t, typename NODE::DataType> >& cells, std::vector<uint8_t>& keys, std::vector<typename NODE::DataType>& values){
+		std::sort(cells.begin(), cells.end());
+		uint64_t previous = 0;
+		for (size_t i = 0; i < cells.size(); i++){
+			uint64_t delta = cells[i].first - previous;
+			previous = cells[i].first;
+			while (delta >= 0x80) {
+				keys.push_back((uint8_t)(delta | 0x80));
+				delta >>= 7;
+			}
+			keys.push_back((uint8_t)delta);
+			values.push_back(cells[i].second);
+		}
+		cells.clear();
+	}
+
+	template <class NODE, class I, class S>
+	bool Grid3DBaseImpl<NODE, I, S>::readBulkKeys(const std::vector<uint8_t>& keys, uint8_t flags, std::vector<Grid3DKey>& cell_keys){
+		if (!(flags & BULK_DELTA_KEYS)) {
+			if (keys.size() != cell_keys.size() * sizeof(Grid3DKey().k))
+				return false;
+			for (size_t i = 0; i < cell_keys.size(); i++)
+				memcpy(cell_keys[i].k, &keys[i * sizeof(Grid3DKey().k)], sizeof(Grid3DKey().k));
+			return true;
+		}
+
+		size_t pos = 0;
+		uint64_t code = 0;
+		for (size_t i = 0; i < cell_keys.size(); i++){
+			uint64_t delta = 0;
+			unsigned int shift = 0;
+			do {
+				if (pos == keys.size() || shift >= 8 * sizeof(uint64_t))
+					return false;
+				delta |= (uint64_t)(keys[pos] & 0x7f) << shift;
+				shift += 7;
+			} while (keys[pos++] & 0x80);
+			code += delta;
+			cell_keys[i] = Grid3DKey::fromMortonCode(code);
+		}
+		return pos == keys.size();
+	}
+
+	template <class NODE, class I, class S>
+	std::istream& Grid3DBaseImpl<NODE, I, S>::readBulkData(std::istream &s) {
+		typedef typename NODE::DataType DataType;
+
+		if (!s.good()){
+			GRIDMAP3D_WARNING_STR(__FILE__ << ":" << __LINE__ << "Warning: Input filestream not \"good\"");
+		}
+
+		uint64_t num_cells = 0;
+		uint32_t value_size = 0;
+		uint8_t flags = 0;
+		s.read((char*)&num_cells, sizeof(num_cells));
+		s.read((char*)&value_size, sizeof(value_size));
+		s.read((char*)&flags, sizeof(flags));
+		if (value_size != sizeof(DataType)){
+			GRIDMAP3D_ERROR_STR("Grid3DBaseImpl::readBulkData: cell values of " << value_size << " bytes do not match the node type.");
+			s.setstate(std::ios::failbit);
+			return s;
+		}
+		if (flags & ~BULK_DELTA_KEYS){
+			GRIDMAP3D_ERROR_STR("Grid3DBaseImpl::readBulkData: unknown flags " << (int)flags << ".");
+			s.setstate(std::ios::failbit);
+			return s;
+		}
+
+		// every cell takes at least one key byte and its value, a cell count
+		// the rest of a seekable stream can not hold is corrupt
+		bool known_length = false;
+		const std::streampos start = s.tellg();
+		if (start != std::streampos(-1)) {
+			s.seekg(0, std::ios::end);
+			const std::streampos end = s.tellg();
+			s.seekg(start);
+			if (end != std::streampos(-1) && end >= start) {
+				known_length = true;
+				if (num_cells > (uint64_t)(end - start) / (1 + value_size)){
+					GRIDMAP3D_ERROR_STR("Grid3DBaseImpl::readBulkData: " << num_cells << " cells exceed the length of the stream.");
+					s.setstate(std::ios::failbit);
+					return s;
+				}
+			}
+		}
+
+		size_changed = true;
+
+		// grid needs to be newly created or cleared externally
+		if (gridmap->size() != 0) {
+			GRIDMAP3D_ERROR_STR("Trying to read into an existing grid.");
+			return s;
+		}
+		if (known_length)
+			gridmap->reserve((size_t)num_cells);
+
+		std::vector<uint8_t> keys;
+		std::vector<DataType> values;
+		std::vector<Grid3DKey> cell_keys;
+		uint64_t num_read = 0;
+		while (num_read < num_cells){
+			uint32_t chunk_cells = 0;
+			uint32_t key_bytes = 0;
+			s.read((char*)&chunk_cells, sizeof(chunk_cells));
+			s.read((char*)&key_bytes, sizeof(key_bytes));
+			if (s.fail() || chunk_cells == 0 || chunk_cells > num_cells - num_read || chunk_cells > BULK_CHUNK_SIZE
+				|| key_bytes < chunk_cells || key_bytes > chunk_cells * BULK_MAX_KEY_BYTES){
+				GRIDMAP3D_ERROR_STR("Grid3DBaseImpl::readBulkData: ERROR.\n");
+				s.setstate(std::ios::failbit);
+				break;
+			}
+
+			keys.resize(key_bytes);
+			values.resize(chunk_cells);
+			cell_keys.resize(chunk_cells);
+			s.read((char*)&keys[0], key_bytes);
+			s.read((char*)&values[0], chunk_cells * sizeof(DataType));
+			if (s.fail() || !readBulkKeys(keys, flags, cell_keys)){
+				GRIDMAP3D_ERROR_STR("Grid3DBaseImpl::readBulkData: ERROR.\n");
+				s.setstate(std::ios::failbit);
+				break;
+			}
+
+			if (Grid3DStorageTraits<S>::concurrent) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+				for (int i = 0; i < (int)chunk_cells; i++){
+					unsigned int shard = Grid3DStorageTraits<S>::shard(*gridmap, cell_keys[i]);
+					Grid3DStorageTraits<S>::lock(*gridmap, shard);
+					NODE* cell = gridmap->createNode(cell_keys[i]);
+					if (cell)
+						cell->setValue(values[i]);
+					Grid3DStorageTraits<S>::unlock(*gridmap, shard);
+				}
+			}
+			else {
+				for (uint32_t i = 0; i < chunk_cells; i++){
+					NODE* cell = gridmap->createNode(cell_keys[i]);
+					if (cell)
+						cell->setValue(values[i]);
+				}
+			}
+			num_read += chunk_cells;
+		}
+
+		return s;
+	}
+
 	// non-const versions, 
 	// change min/max/size_changed members
 
-	template <class NODE, class I>
-	void Grid3DBaseImpl<NODE, I>::getMetricSize(double& x, double& y, double& z){
+	template <class NODE, class I, class S>
+	void Grid3DBaseImpl<NODE, I, S>::getMetricSize(double& x, double& y, double& z){
 
 		double minX, minY, minZ;
 		double maxX, maxY, maxZ;
@@ -452,8 +656,8 @@ namespace gridmap3D {
 		z = maxZ - minZ;
 	}
 
-	template <class NODE, class I>
-	void Grid3DBaseImpl<NODE, I>::getMetricSize(double& x, double& y, double& z) const{
+	template <class NODE, class I, class S>
+	void Grid3DBaseImpl<NODE, I, S>::getMetricSize(double& x, double& y, double& z) const{
 
 		double minX, minY, minZ;
 		double maxX, maxY, maxZ;
@@ -466,56 +670,38 @@ namespace gridmap3D {
 		z = maxZ - minZ;
 	}
 
-	template <class NODE, class I>
-	void Grid3DBaseImpl<NODE, I>::calcMinMax() {
-		if (!size_changed)
-			return;
+	template <class NODE, class I, class S>
+	void Grid3DBaseImpl<NODE, I, S>::calcMinMax() {
+		// the storage keeps the bounding box of its cells in key space up to date
+		const Grid3DKeyBounds& bounds = gridmap->getKeyBounds();
 
 		// empty grid
-		if (gridmap->size() == 0){
+		if (bounds.empty()){
 			min_value[0] = min_value[1] = min_value[2] = 0.0;
 			max_value[0] = max_value[1] = max_value[2] = 0.0;
 			size_changed = false;
 			return;
 		}
 
+		double halfSize = this->resolution / 2.0;
 		for (unsigned i = 0; i < 3; i++){
-			max_value[i] = -std::numeric_limits<double>::max();
-			min_value[i] = std::numeric_limits<double>::max();
-		}
-
-		for (typename Grid3DBaseImpl<NODE, I>::OccupancyGridMap::iterator it = this->gridmap->begin(), end = this->gridmap->end(); it != end; ++it)
-		{
-			double size = this->resolution;
-			double halfSize = size / 2.0;
-			double x = keyToCoord(it->first[0]) - halfSize;
-			double y = keyToCoord(it->first[1]) - halfSize;
-			double z = keyToCoord(it->first[2]) - halfSize;
-			if (x < min_value[0]) min_value[0] = x;
-			if (y < min_value[1]) min_value[1] = y;
-			if (z < min_value[2]) min_value[2] = z;
-
-			x += size;
-			y += size;
-			z += size;
-			if (x > max_value[0]) max_value[0] = x;
-			if (y > max_value[1]) max_value[1] = y;
-			if (z > max_value[2]) max_value[2] = z;
+			min_value[i] = keyToCoord(bounds.getMin()[i]) - halfSize;
+			max_value[i] = keyToCoord(bounds.getMax()[i]) + halfSize;
 		}
 
 		size_changed = false;
 	}
 
-	template <class NODE, class I>
-	void Grid3DBaseImpl<NODE, I>::getMetricMin(double& x, double& y, double& z){
+	template <class NODE, class I, class S>
+	void Grid3DBaseImpl<NODE, I, S>::getMetricMin(double& x, double& y, double& z){
 		calcMinMax();
 		x = min_value[0];
 		y = min_value[1];
 		z = min_value[2];
 	}
 
-	template <class NODE, class I>
-	void Grid3DBaseImpl<NODE, I>::getMetricMax(double& x, double& y, double& z){
+	template <class NODE, class I, class S>
+	void Grid3DBaseImpl<NODE, I, S>::getMetricMax(double& x, double& y, double& z){
 		calcMinMax();
 		x = max_value[0];
 		y = max_value[1];
@@ -523,68 +709,44 @@ namespace gridmap3D {
 	}
 
 	// const versions
-	template <class NODE, class I>
-	void Grid3DBaseImpl<NODE, I>::getMetricMin(double& mx, double& my, double& mz) const {
-		mx = my = mz = std::numeric_limits<double>::max();
-		if (size_changed) {
-			// empty grid
-			if (gridmap->size() == 0){
-				mx = my = mz = 0.0;
-				return;
-			}
-
-			for (typename Grid3DBaseImpl<NODE, I>::OccupancyGridMap::iterator it = this->gridmap->begin(), end = this->gridmap->end(); it != end; ++it) {
-				double halfSize = this->resolution / 2.0;
-				double x = keyToCoord(it->first[0]) - halfSize;
-				double y = keyToCoord(it->first[1]) - halfSize;
-				double z = keyToCoord(it->first[2]) - halfSize;
-				if (x < mx) mx = x;
-				if (y < my) my = y;
-				if (z < mz) mz = z;
-			}
-		} // end if size changed 
-		else {
-			mx = min_value[0];
-			my = min_value[1];
-			mz = min_value[2];
+	template <class NODE, class I, class S>
+	void Grid3DBaseImpl<NODE, I, S>::getMetricMin(double& mx, double& my, double& mz) const {
+		const Grid3DKeyBounds& bounds = gridmap->getKeyBounds();
+		// empty grid
+		if (bounds.empty()){
+			mx = my = mz = 0.0;
+			return;
 		}
-	}
 
-	template <class NODE, class I>
-	void Grid3DBaseImpl<NODE, I>::getMetricMax(double& mx, double& my, double& mz) const {
-		mx = my = mz = -std::numeric_limits<double>::max();
-		if (size_changed) {
-			// empty grid
-			if (gridmap->size() == 0){
-				mx = my = mz = 0.0;
-				return;
-			}
+		double halfSize = this->resolution / 2.0;
+		mx = keyToCoord(bounds.getMin()[0]) - halfSize;
+		my = keyToCoord(bounds.getMin()[1]) - halfSize;
+		mz = keyToCoord(bounds.getMin()[2]) - halfSize;
+	}
 
-			for (typename Grid3DBaseImpl<NODE, I>::OccupancyGridMap::iterator it = this->gridmap->begin(), end = this->gridmap->end(); it != end; ++it) {
-				double halfSize = this->resolution / 2.0;
-				double x = keyToCoord(it->first[0]) + halfSize;
-				double y = keyToCoord(it->first[1]) + halfSize;
-				double z = keyToCoord(it->first[2]) + halfSize;
-				if (x > mx) mx = x;
-				if (y > my) my = y;
-				if (z > mz) mz = z;
-			}
-		}
-		else {
-			mx = max_value[0];
-			my = max_value[1];
-			mz = max_value[2];
+	template <class NODE, class I, class S>
+	void Grid3DBaseImpl<NODE, I, S>::getMetricMax(double& mx, double& my, double& mz) const {
+		const Grid3DKeyBounds& bounds = gridmap->getKeyBounds();
+		// empty grid
+		if (bounds.empty()){
+			mx = my = mz = 0.0;
+			return;
 		}
+
+		double halfSize = this->resolution / 2.0;
+		mx = keyToCoord(bounds.getMax()[0]) + halfSize;
+		my = keyToCoord(bounds.getMax()[1]) + halfSize;
+		mz = keyToCoord(bounds.getMax()[2]) + halfSize;
 	}
 
-	template <class NODE, class I>
-	size_t Grid3DBaseImpl<NODE, I>::memoryUsage() const{
-		return (sizeof(Grid3DBaseImpl<NODE, I>) + memoryUsageNode() * this->size());
+	template <class NODE, class I, class S>
+	size_t Grid3DBaseImpl<NODE, I, S>::memoryUsage() const{
+		return sizeof(Grid3DBaseImpl<NODE, I, S>) + (gridmap ? gridmap->memoryUsage() : 0);
 	}
 
 	// Implement getUnknownLeafCenters - To do.
-	/*template <class NODE, class I>
-	void Grid3DBaseImpl<NODE, I>::getUnknownLeafCenters(point3d_list& node_centers, point3d pmin, point3d pmax, unsigned int depth) const {
+	/*template <class NODE, class I, class S>
+	void Grid3DBaseImpl<NODE, I, S>::getUnknownLeafCenters(point3d_list& node_centers, point3d pmin, point3d pmax, unsigned int depth) const {
 
 		assert(depth <= tree_depth);
       if (depth == 0)
@@ -622,8 +784,8 @@ namespace gridmap3D {
       }
 	}*/
 
-	template <class NODE, class I>
-	double Grid3DBaseImpl<NODE, I>::volume() {
+	template <class NODE, class I, class S>
+	double Grid3DBaseImpl<NODE, I, S>::volume() {
 		double x, y, z;
 		getMetricSize(x, y, z);
 		return x * y * z;
@@ -45,7 +45,7 @@ namespace gridmap3D {
 	};
 
 	// forward declaration for friend in Grid3DDataNode
-	template<typename NODE, typename I> class Grid3DBaseImpl;
+	template<typename NODE, typename I, typename S> class Grid3DBaseImpl;
 
 	/**
 	 * Basic node in the Grid3D that can hold arbitrary data of type T in value.
@@ -54,7 +54,7 @@ namespace gridmap3D {
 	 * \tparam T data to be stored in the node (e.g. a float for probabilities)
 	 */
 	template<typename T> class Grid3DDataNode : public AbstractGrid3DNode {
-		template<typename NODE, typename I>
+		template<typename NODE, typename I, typename S>
 		friend class Grid3DBaseImpl;
 
 	public:
@@ -106,18 +106,74 @@ namespace gridmap3D {
 
 		key_type k[3];
 
-		/// Provides a hash function on Keys
+		/// @return Morton code of the key: the bits of k[0], k[1] and k[2] interleaved,
+		/// with k[0] in the least significant position. Sorting by it yields the
+		/// Z-order curve over the grid, and keys close in space get close codes.
+		uint64_t mortonCode() const {
+			return spreadBits(k[0]) | (spreadBits(k[1]) << 1) | (spreadBits(k[2]) << 2);
+		}
+
+		/// @return the key of a Morton code computed by mortonCode()
+		static Grid3DKey fromMortonCode(uint64_t code) {
+			return Grid3DKey(compactBits(code), compactBits(code >> 1), compactBits(code >> 2));
+		}
+
+		/**
+		 * Provides a hash function on Keys: the Morton code of the key. It is injective,
+		 * keeps spatially close keys close in the hash space (scan insertions touch
+		 * neighbouring buckets) and mixes the low bits of all coordinates into the low
+		 * bits of the hash, which also suits power-of-two bucket counts.
+		 */
 		struct KeyHash{
 			std::size_t operator()(const Grid3DKey& key) const{
-				// a simple hashing function 
-				// explicit casts to size_t to operate on the complete range
-				// constanst will be promoted according to C++ standard
+				return static_cast<std::size_t>(key.mortonCode());
+			}
+		};
+
+		/// Packs the three 16 bit coordinates into one integer and mixes it by a
+		/// multiplicative (Fibonacci) hash, so that every bit of the key reaches the
+		/// low bits. Use it for key sets that do not show any spatial coherence.
+		struct MixedKeyHash{
+			std::size_t operator()(const Grid3DKey& key) const{
+				uint64_t packed = static_cast<uint64_t>(key.k[0])
+					| (static_cast<uint64_t>(key.k[1]) << 16)
+					| (static_cast<uint64_t>(key.k[2]) << 32);
+				packed *= 0x9E3779B97F4A7C15ULL;
+				return static_cast<std::size_t>(packed ^ (packed >> 32));
+			}
+		};
+
+		/// The former linear hash function, kept for comparison. It maps many keys of a
+		/// map to the same value, e.g. the keys (x + 1447, y) and (x, y + 1).
+		struct LinearKeyHash{
+			std::size_t operator()(const Grid3DKey& key) const{
 				return static_cast<size_t>(key.k[0])
 					+ 1447 * static_cast<size_t>(key.k[1])
 					+ 345637 * static_cast<size_t>(key.k[2]);
 			}
 		};
 
+	protected:
+		/// spreads the 16 bits of v to every third bit
+		static uint64_t spreadBits(key_type v) {
+			uint64_t x = v;
+			x = (x | (x << 16)) & 0x0000FF0000FFULL;
+			x = (x | (x << 8)) & 0x00F00F00F00FULL;
+			x = (x | (x << 4)) & 0x0C30C30C30C3ULL;
+			x = (x | (x << 2)) & 0x249249249249ULL;
+			return x;
+		}
+
+		/// inverse of spreadBits(), collects every third bit
+		static key_type compactBits(uint64_t x) {
+			x &= 0x249249249249ULL;
+			x = (x | (x >> 2)) & 0x0C30C30C30C3ULL;
+			x = (x | (x >> 4)) & 0x00F00F00F00FULL;
+			x = (x | (x >> 8)) & 0x0000FF0000FFULL;
+			x = (x | (x >> 16)) & 0x00000000FFFFULL;
+			return static_cast<key_type>(x);
+		}
+
 	};
 
 	/**
@@ -134,6 +190,7 @@ namespace gridmap3D {
 	 *
 	 */
 	typedef unordered_ns::unordered_map<Grid3DKey, bool, Grid3DKey::KeyHash> KeyBoolMap;
+	typedef unordered_ns::unordered_map<Grid3DKey, int, Grid3DKey::KeyHash> KeyIntMap;
 
 	class KeyRay {
 	public:
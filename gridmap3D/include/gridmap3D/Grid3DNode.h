@@ -57,9 +57,9 @@ namespace gridmap3D {
 		inline double getOccupancy() const { return probability(value); }
 
 		/// \return log odds representation of occupancy probability of node
-		inline float getLogOdds() const{ return value; }
+		inline float getLogOdds() const{ return getValue(); }
 		/// sets log odds occupancy of node
-		inline void setLogOdds(float l) { value = l; }
+		inline void setLogOdds(float l) { setValue(l); }
 
 		/// adds p to the node's logOdds value (with no boundary / threshold checking!)
 		void addValue(const float& p);
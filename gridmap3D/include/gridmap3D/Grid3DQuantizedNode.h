@@ -0,0 +1,121 @@
+/*
+* Copyright(c) 2019, Youngsun Kwon, Donghyuk Kim, Inkyu An, and Sung-eui Yoon, KAIST
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met :
+*
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and / or other materials provided with the distribution.
+*     * Neither the name of SuperRay nor the names of its
+*       contributors may be used to endorse or promote products derived from
+*       this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef GRIDMAP3D_GRID3D_QUANTIZED_NODE_H
+#define GRIDMAP3D_GRID3D_QUANTIZED_NODE_H
+
+#include <limits>
+#include <stdint.h>
+
+#include "gridmap3D_types.h"
+#include "gridmap3D_utils.h"
+#include "Grid3DDataNode.h"
+#include "AbstractOccupancyGrid3D.h"
+
+namespace gridmap3D {
+
+	/**
+	 * Occupancy grid cell storing its log-odds as a fixed-point number: an
+	 * integer of type T with FRACTION_BITS fractional bits, i.e. the log-odds
+	 * value is value / 2^FRACTION_BITS. It offers the occupancy API of
+	 * Grid3DNode and can be used as NODE of OccupancyGrid3DBase and
+	 * SuperRayGrid3DBase with every storage policy, at sizeof(T) instead of 4
+	 * bytes per cell. Such grids derive from AbstractOccupancyGrid3DBase, not
+	 * AbstractOccupancyGrid3D, whose updateNode() returns Grid3DNode*.
+	 *
+	 * Only these grid maps take quantized cells. The octrees and quadtrees,
+	 * the rolling grids and the culling-region grids store float log-odds.
+	 *
+	 * Every update is rounded to the fixed-point step and added as an integer
+	 * that saturates at the range of T. The clamping thresholds of the grid
+	 * therefore only take effect if they lie within +-getMaxLogOdds()
+	 * (+-3.97 for Grid3DNode8, +-8.0 for Grid3DNode16; the defaults are
+	 * -2.0 and 3.5).
+	 *
+	 * \tparam T signed integer type of the fixed-point value
+	 * \tparam FRACTION_BITS number of fractional bits of the fixed-point value
+	 */
+	template <typename T, unsigned int FRACTION_BITS>
+	class Grid3DQuantizedNode : public Grid3DDataNode<T> {
+
+	public:
+		Grid3DQuantizedNode() : Grid3DDataNode<T>(0) {}
+
+		// -- node occupancy  ----------------------------
+
+		/// \return occupancy probability of node
+		inline double getOccupancy() const { return probability(getLogOdds()); }
+
+		/// \return log odds representation of occupancy probability of node
+		inline float getLogOdds() const { return this->getValue() * getStep(); }
+		/// sets log odds occupancy of node, rounded to the fixed-point step and saturated
+		inline void setLogOdds(float l) { this->setValue((T)quantize(l)); }
+
+		/// adds p to the node's logOdds value (saturating at the range of T, no threshold checking!)
+		inline void addValue(const float& p) { this->value = (T)saturate((int)this->value + quantize(p)); }
+
+		/// \return log-odds difference of two adjacent fixed-point values
+		static inline float getStep() { return 1.0f / (float)(1 << FRACTION_BITS); }
+
+		/// \return largest representable log-odds magnitude
+		static inline float getMaxLogOdds() { return maxValue() * getStep(); }
+
+	protected:
+		static inline int maxValue() { return (int)std::numeric_limits<T>::max(); }
+
+		static inline int saturate(int v) {
+			return v > maxValue() ? maxValue() : (v < -maxValue() ? -maxValue() : v);
+		}
+
+		/// rounds l to the nearest fixed-point value within the range of T
+		static inline int quantize(float l) {
+			float scaled = l * (float)(1 << FRACTION_BITS);
+			if (scaled >= (float)maxValue())
+				return maxValue();
+			if (scaled <= (float)-maxValue())
+				return -maxValue();
+			return (int)(scaled >= 0.0f ? scaled + 0.5f : scaled - 0.5f);
+		}
+	};
+
+	/// 8 bit cell, log-odds in steps of 1/32 within +-3.97
+	typedef Grid3DQuantizedNode<int8_t, 5> Grid3DNode8;
+
+	/// 16 bit cell, log-odds in steps of 1/4096 within +-8.0
+	typedef Grid3DQuantizedNode<int16_t, 12> Grid3DNode16;
+
+	/// Grids of quantized cells have no Grid3DNode to return from the abstract updateNode()
+	template <typename T, unsigned int FRACTION_BITS>
+	struct Grid3DOccupancyInterface<Grid3DQuantizedNode<T, FRACTION_BITS> > {
+		typedef AbstractOccupancyGrid3DBase type;
+	};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,1704 @@
+/*
+* Copyright(c) 2019, Youngsun Kwon, Donghyuk Kim, Inkyu An, and Sung-eui Yoon, KAIST
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met :
+*
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and / or other materials provided with the distribution.
+*     * Neither the name of SuperRay nor the names of its
+*       contributors may be used to endorse or promote products derived from
+*       this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef GRIDMAP3D_GRID3D_STORAGE_H
+#define GRIDMAP3D_GRID3D_STORAGE_H
+
+#include <cstddef>
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "gridmap3D_types.h"
+#include "Grid3DKey.h"
+
+namespace gridmap3D {
+
+	/**
+	 * Bounding box of the known cells in key space, kept up to date as cells
+	 * are inserted and erased. For every axis, a histogram counts the cells
+	 * per key value and a bitmap marks the populated key values, so an erased
+	 * extreme cell moves the bound to the next populated key value without a
+	 * rescan of the grid. Insertions and queries cost O(1), and so do erasures
+	 * except of the last cell of an extreme key value: it scans the bitmap
+	 * across the gap to the next populated value, O(gap / 64 + 64) for a gap
+	 * of up to 65536 values.
+	 *
+	 * Every histogram only covers a window of the key values around the cells
+	 * on its axis, so its memory follows the extent of the grid rather than
+	 * the 65536 values of a key. The window grows by at least half its size to
+	 * cover a new cell. It shrinks to the cells plus a margin of half their
+	 * extent on both sides once they fill less than a quarter of it, but only
+	 * after at least as many erasures as it has values since it was last
+	 * resized. A far outlier inserted and erased over and over thus does not
+	 * reallocate the window every time, and resizing costs amortized O(1).
+	 */
+	class Grid3DKeyBounds {
+
+	public:
+		Grid3DKeyBounds() : num_keys(0), min_key(0, 0, 0), max_key(0, 0, 0) {
+			for (unsigned int axis = 0; axis < 3; axis++) {
+				offset[axis] = 0;
+				num_erased[axis] = 0;
+			}
+		}
+
+		/// Adds a cell at key
+		inline void insert(const Grid3DKey& key) {
+			if (num_keys++ == 0)
+				min_key = max_key = key;
+			for (unsigned int axis = 0; axis < 3; axis++) {
+				if (key[axis] < offset[axis] || (size_t)(key[axis] - offset[axis]) >= counts[axis].size())
+					cover(axis, key[axis]);
+				const size_t i = key[axis] - offset[axis];
+				if (counts[axis][i]++ == 0)
+					populated[axis][i >> 6] |= (uint64_t)1 << (i & 63);
+				if (key[axis] < min_key[axis]) min_key[axis] = key[axis];
+				if (key[axis] > max_key[axis]) max_key[axis] = key[axis];
+			}
+		}
+
+		/// Removes a cell at key, which has to be inserted before
+		inline void erase(const Grid3DKey& key) {
+			num_keys--;
+			for (unsigned int axis = 0; axis < 3; axis++) {
+				std::vector<unsigned int>& count = counts[axis];
+				const size_t i = key[axis] - offset[axis];
+				num_erased[axis]++;
+				if (--count[i] != 0)
+					continue;
+				populated[axis][i >> 6] &= ~((uint64_t)1 << (i & 63));
+				if (num_keys == 0)
+					continue;
+				if (key[axis] == min_key[axis])
+					min_key[axis] = (key_type)(offset[axis] + nextPopulated(axis, i));
+				if (key[axis] == max_key[axis])
+					max_key[axis] = (key_type)(offset[axis] + previousPopulated(axis, i));
+				const size_t extent = (size_t)max_key[axis] - min_key[axis] + 1;
+				if (count.size() > MIN_WINDOW && 4 * extent < count.size() && num_erased[axis] >= count.size())
+					shrink(axis, extent / 2);
+			}
+		}
+
+		/// Removes all cells and frees the histograms
+		void clear() {
+			for (unsigned int axis = 0; axis < 3; axis++) {
+				std::vector<unsigned int>().swap(counts[axis]);
+				std::vector<uint64_t>().swap(populated[axis]);
+				offset[axis] = 0;
+				num_erased[axis] = 0;
+			}
+			num_keys = 0;
+			min_key = max_key = Grid3DKey(0, 0, 0);
+		}
+
+		/// @return true if there is no cell
+		inline bool empty() const { return num_keys == 0; }
+
+		/// @return smallest key value of the cells in x, y and z, only valid if not empty()
+		inline const Grid3DKey& getMin() const { return min_key; }
+
+		/// @return largest key value of the cells in x, y and z, only valid if not empty()
+		inline const Grid3DKey& getMax() const { return max_key; }
+
+		/// @return memory usage of the histograms and bitmaps in bytes
+		size_t memoryUsage() const {
+			size_t memory = 0;
+			for (unsigned int axis = 0; axis < 3; axis++)
+				memory += counts[axis].capacity() * sizeof(unsigned int) + populated[axis].capacity() * sizeof(uint64_t);
+			return memory;
+		}
+
+	protected:
+		/// Smallest number of key values a histogram grows by
+		static const size_t MIN_WINDOW = 64;
+
+		/// Grows the window of axis to cover value, by at least half of its size
+		void cover(unsigned int axis, key_type value) {
+			const size_t num_values = std::numeric_limits<key_type>::max() + (size_t)1;
+			const size_t slack = (counts[axis].size() / 2 > MIN_WINDOW) ? counts[axis].size() / 2 : MIN_WINDOW;
+			size_t begin = offset[axis];
+			size_t end = begin + counts[axis].size();
+			if (counts[axis].empty())
+				begin = end = value;
+			if (value < begin)
+				begin = (value > slack) ? value - slack : 0;
+			else
+				end = (value + 1 + slack < num_values) ? value + 1 + slack : num_values;
+			resize(axis, begin, end);
+		}
+
+		/// Shrinks the window of axis to the cells and margin key values on both sides of them
+		void shrink(unsigned int axis, size_t margin) {
+			const size_t num_values = std::numeric_limits<key_type>::max() + (size_t)1;
+			const size_t begin = (min_key[axis] > margin) ? min_key[axis] - margin : 0;
+			const size_t end = ((size_t)max_key[axis] + 1 + margin < num_values) ? (size_t)max_key[axis] + 1 + margin : num_values;
+			resize(axis, begin, end);
+		}
+
+		/// Moves the window of axis to the key values [begin, end), which cover all counted cells
+		void resize(unsigned int axis, size_t begin, size_t end) {
+			std::vector<unsigned int> resized(end - begin, 0);
+			std::vector<uint64_t> resized_populated((end - begin + 63) / 64, 0);
+			for (size_t i = 0; i < counts[axis].size(); i++) {
+				if (counts[axis][i] != 0) {
+					const size_t j = offset[axis] + i - begin;
+					resized[j] = counts[axis][i];
+					resized_populated[j >> 6] |= (uint64_t)1 << (j & 63);
+				}
+			}
+			counts[axis].swap(resized);
+			populated[axis].swap(resized_populated);
+			offset[axis] = (key_type)begin;
+			num_erased[axis] = 0;
+		}
+
+		/// @return first populated index of the window of axis at or after i, which has to exist
+		size_t nextPopulated(unsigned int axis, size_t i) const {
+			size_t word = i >> 6;
+			uint64_t bits = populated[axis][word] & (~(uint64_t)0 << (i & 63));
+			while (bits == 0)
+				bits = populated[axis][++word];
+			for (i = word << 6; !(bits & 1); bits >>= 1)
+				i++;
+			return i;
+		}
+
+		/// @return last populated index of the window of axis at or before i, which has to exist
+		size_t previousPopulated(unsigned int axis, size_t i) const {
+			size_t word = i >> 6;
+			uint64_t bits = populated[axis][word] & (~(uint64_t)0 >> (63 - (i & 63)));
+			while (bits == 0)
+				bits = populated[axis][--word];
+			for (i = (word << 6) + 63; !(bits >> 63); bits <<= 1)
+				i--;
+			return i;
+		}
+
+		std::vector<unsigned int> counts[3];	///< number of cells per key value in the window, for each axis
+		std::vector<uint64_t> populated[3];	///< bit per key value in the window, set if its count is not zero
+		key_type offset[3];					///< first key value of the window, for each axis
+		size_t num_erased[3];					///< erasures since the window was last resized, for each axis
+		size_t num_keys;
+		Grid3DKey min_key;
+		Grid3DKey max_key;
+	};
+
+
+	/**
+	 * Slab allocator for the nodes of a grid. Nodes are constructed in place
+	 * inside slabs of slab_size slots, freed slots are kept in a free list and
+	 * reused, and release() returns all slabs at once. A slot has the size of a
+	 * NODE (at least of a pointer), which saves the per-allocation overhead of
+	 * the heap for small nodes and keeps consecutive nodes contiguous.
+	 *
+	 * The pool does not keep track of the live nodes: their destructors have to
+	 * be called (destroy()) before release() if NODE is not trivially destructible.
+	 *
+	 * \tparam NODE Node class to be allocated
+	 */
+	template <class NODE>
+	class Grid3DNodePool {
+
+	public:
+		Grid3DNodePool(size_t slab_size = 4096)
+			: free_slots(NULL), slab_size(slab_size), next_slot(slab_size), num_nodes(0) {}
+
+		~Grid3DNodePool() { release(); }
+
+		/// @return a default constructed node
+		inline NODE* create() { return new (allocate()) NODE(); }
+
+		/// @return a copy of rhs
+		inline NODE* create(const NODE& rhs) { return new (allocate()) NODE(rhs); }
+
+		/// Destructs node and puts its slot on the free list
+		inline void destroy(NODE* node) {
+			node->~NODE();
+			Slot* slot = reinterpret_cast<Slot*>(node);
+			slot->next = free_slots;
+			free_slots = slot;
+			num_nodes--;
+		}
+
+		/// Frees all slabs at once, without calling any node destructor
+		void release() {
+			for (size_t i = 0; i < slabs.size(); i++)
+				delete[] slabs[i];
+			slabs.clear();
+			free_slots = NULL;
+			next_slot = slab_size;
+			num_nodes = 0;
+		}
+
+		/// @return number of live nodes
+		inline size_t size() const { return num_nodes; }
+
+		/// @return memory of the slabs in bytes
+		size_t memoryUsage() const {
+			return slabs.size() * slab_size * sizeof(Slot) + slabs.capacity() * sizeof(Slot*);
+		}
+
+	protected:
+		/// Storage of one node, aligned for the node as well as for the free list link
+		union Slot {
+			Slot* next;
+			char data[sizeof(NODE)];
+			double align_double;
+			long long align_long;
+		};
+
+		inline void* allocate() {
+			num_nodes++;
+			if (free_slots != NULL) {
+				Slot* slot = free_slots;
+				free_slots = slot->next;
+				return slot;
+			}
+			if (next_slot == slab_size) {
+				slabs.push_back(new Slot[slab_size]);
+				next_slot = 0;
+			}
+			return &slabs.back()[next_slot++];
+		}
+
+		std::vector<Slot*> slabs;
+		Slot* free_slots;
+		size_t slab_size;
+		size_t next_slot;   ///< next unused slot of the last slab
+		size_t num_nodes;
+
+	private:
+		Grid3DNodePool(const Grid3DNodePool<NODE>&);
+		Grid3DNodePool<NODE>& operator=(const Grid3DNodePool<NODE>&);
+	};
+
+
+	/**
+	 * Default storage policy of Grid3DBaseImpl: every known cell is a NODE
+	 * allocated from a Grid3DNodePool, indexed by its Grid3DKey in a hash map.
+	 *
+	 * A storage policy provides search(), createNode(), deleteNode(), clear(),
+	 * size(), getKeyBounds() (a Grid3DKeyBounds of its cells), memoryUsage() and an
+	 * iterator whose value is a
+	 * std::pair<Grid3DKey, NODE*> (it->first is the key, it->second the node).
+	 *
+	 * \tparam NODE Node class to be stored
+	 * \tparam HASH Hash function on the keys, e.g. Grid3DKey::MixedKeyHash
+	 */
+	template <class NODE, class HASH = Grid3DKey::KeyHash>
+	class Grid3DHashStorage {
+
+	public:
+		typedef unordered_ns::unordered_map<Grid3DKey, NODE*, HASH> CellMap;
+		typedef typename CellMap::iterator iterator;
+		typedef typename CellMap::const_iterator const_iterator;
+
+		Grid3DHashStorage() {}
+
+		/// Deep copy constructor
+		Grid3DHashStorage(const Grid3DHashStorage<NODE, HASH>& rhs) : bounds(rhs.bounds) {
+			for (const_iterator it = rhs.cells.begin(); it != rhs.cells.end(); ++it)
+				cells.insert(std::pair<Grid3DKey, NODE*>(it->first, nodes.create(*(it->second))));
+		}
+
+		~Grid3DHashStorage() { clear(); }
+
+		/// @return pointer to the node of key, NULL if the cell is unknown
+		inline NODE* search(const Grid3DKey& key) const {
+			const_iterator cell = cells.find(key);
+			if (cell == cells.end())
+				return NULL;
+			return cell->second;
+		}
+
+		/// @return pointer to the node of key, a default NODE is created if the cell is unknown
+		inline NODE* createNode(const Grid3DKey& key) {
+			NODE*& node = cells[key];
+			if (node == NULL) {
+				node = nodes.create();
+				bounds.insert(key);
+			}
+			return node;
+		}
+
+		/// Deletes the node of key, @return false if the cell is unknown
+		bool deleteNode(const Grid3DKey& key) {
+			iterator cell = cells.find(key);
+			if (cell == cells.end())
+				return false;
+			nodes.destroy(cell->second);
+			cells.erase(cell);
+			bounds.erase(key);
+			return true;
+		}
+
+		/// Deletes all nodes, their memory is released in bulk by the pool
+		void clear() {
+			for (iterator it = cells.begin(); it != cells.end(); ++it)
+				it->second->~NODE();
+			cells.clear();
+			nodes.release();
+			bounds.clear();
+		}
+
+		/// Prepares the storage for num_cells cells without rehashing the map
+		void reserve(size_t num_cells) { cells.rehash((size_t)(num_cells / cells.max_load_factor()) + 1); }
+
+		/**
+		 * Applies op(NODE&) to every node, with OpenMP in parallel over the
+		 * buckets of the hash map. Must not run concurrently with other updates.
+		 */
+		template <class OP>
+		void transformNodes(const OP& op) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
+			for (int b = 0; b < (int)cells.bucket_count(); b++) {
+				for (typename CellMap::local_iterator it = cells.begin(b); it != cells.end(b); ++it)
+					op(*it->second);
+			}
+		}
+
+		/**
+		 * Calls op(node, 1, 1), i.e. a run of one known cell, for every node.
+		 * With OpenMP the buckets are reduced in parallel into copies of op,
+		 * which are then combined into op by op.merge(), so op has to start out
+		 * empty.
+		 */
+		template <class OP>
+		void reduceNodes(OP& op) const {
+			const OP initial(op);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+			{
+				OP local(initial);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 256) nowait
+#endif
+				for (int b = 0; b < (int)cells.bucket_count(); b++) {
+					for (typename CellMap::const_local_iterator it = cells.begin(b); it != cells.end(b); ++it)
+						local(it->second, 1u, (uint64_t)1);
+				}
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+				op.merge(local);
+			}
+		}
+
+		inline size_t size() const { return cells.size(); }
+
+		/// @return bounding box of the known cells in key space
+		inline const Grid3DKeyBounds& getKeyBounds() const { return bounds; }
+
+		/// @return approximate memory usage of the nodes and the hash table in bytes
+		size_t memoryUsage() const {
+			return cells.size() * (sizeof(typename CellMap::value_type) + sizeof(void*))
+				+ cells.bucket_count() * sizeof(void*) + nodes.memoryUsage() + bounds.memoryUsage();
+		}
+
+		inline iterator begin() { return cells.begin(); }
+		inline iterator end() { return cells.end(); }
+		inline const_iterator begin() const { return cells.begin(); }
+		inline const_iterator end() const { return cells.end(); }
+
+		/// Lookups of the map that getGrid() returned before the storage policies
+		inline iterator find(const Grid3DKey& key) { return cells.find(key); }
+		inline const_iterator find(const Grid3DKey& key) const { return cells.find(key); }
+		inline size_t count(const Grid3DKey& key) const { return cells.count(key); }
+
+	protected:
+		CellMap cells;
+		Grid3DNodePool<NODE> nodes;
+		Grid3DKeyBounds bounds;
+
+	private:
+		Grid3DHashStorage<NODE, HASH>& operator=(const Grid3DHashStorage<NODE, HASH>&);
+	};
+
+
+	/**
+	 * Storage policy of Grid3DBaseImpl made of dense blocks of
+	 * 2^BLOCK_BITS x 2^BLOCK_BITS x 2^BLOCK_BITS cells. Blocks are indexed by
+	 * a hash map over their block key (the cell key shifted by BLOCK_BITS),
+	 * inside a block the nodes sit in one contiguous array and a bitmask
+	 * marks which of them are known.
+	 *
+	 * Compared to Grid3DHashStorage, this trades the memory of the unknown
+	 * cells inside a touched block for one hash lookup per block instead of
+	 * per cell and no per-cell allocation, which suits the spatially coherent
+	 * updates of ray casting. Node pointers stay valid until the cell is
+	 * deleted or the grid is cleared.
+	 *
+	 * \tparam NODE Node class to be stored, needs a default constructor
+	 * \tparam BLOCK_BITS log2 of the block width (3: 8^3 cells per block)
+	 */
+	template <class NODE, unsigned int BLOCK_BITS = 3>
+	class Grid3DBlockStorage {
+
+	public:
+		static const unsigned int BLOCK_WIDTH = 1u << BLOCK_BITS;
+		static const unsigned int BLOCK_MASK = BLOCK_WIDTH - 1;
+		static const unsigned int BLOCK_SIZE = BLOCK_WIDTH * BLOCK_WIDTH * BLOCK_WIDTH;
+		static const unsigned int BLOCK_WORDS = (BLOCK_SIZE + 63) / 64;
+
+		/// Dense block of cells
+		struct Block {
+			Block() : num_known(0) {
+				for (unsigned int i = 0; i < BLOCK_WORDS; i++)
+					known[i] = 0;
+			}
+
+			inline bool isKnown(unsigned int index) const { return ((known[index >> 6] >> (index & 63)) & 1) != 0; }
+
+			NODE cells[BLOCK_SIZE];
+			uint64_t known[BLOCK_WORDS];	///< bit i is set if cells[i] is a known cell
+			unsigned int num_known;
+		};
+
+		typedef unordered_ns::unordered_map<Grid3DKey, Block*, Grid3DKey::KeyHash> BlockMap;
+
+		/// Iterates over the known cells, block by block
+		class iterator {
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef std::pair<Grid3DKey, NODE*> value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef value_type* pointer;
+			typedef value_type& reference;
+
+			iterator() : index(0) {}
+			iterator(typename BlockMap::const_iterator _block_it, typename BlockMap::const_iterator _block_end)
+				: block_it(_block_it), block_end(_block_end), index(0) {
+				seek();
+			}
+
+			bool operator==(const iterator& other) const { return block_it == other.block_it && index == other.index; }
+			bool operator!=(const iterator& other) const { return !(*this == other); }
+
+			iterator& operator++() {
+				index++;
+				seek();
+				return *this;
+			}
+			iterator operator++(int) {
+				iterator result = *this;
+				++(*this);
+				return result;
+			}
+
+			inline reference operator*() { return current; }
+			inline pointer operator->() { return &current; }
+
+		protected:
+			/// moves to the first known cell at or after the current position
+			void seek() {
+				while (block_it != block_end) {
+					const Block* block = block_it->second;
+					while (index < BLOCK_SIZE) {
+						uint64_t word = block->known[index >> 6] >> (index & 63);
+						if (word == 0) {
+							index = (index | 63) + 1;
+							continue;
+						}
+						while ((word & 1) == 0) {
+							word >>= 1;
+							index++;
+						}
+						const Grid3DKey& block_key = block_it->first;
+						current.first = Grid3DKey((key_type)((block_key[0] << BLOCK_BITS) | (index & BLOCK_MASK)),
+												  (key_type)((block_key[1] << BLOCK_BITS) | ((index >> BLOCK_BITS) & BLOCK_MASK)),
+												  (key_type)((block_key[2] << BLOCK_BITS) | (index >> (2 * BLOCK_BITS))));
+						current.second = const_cast<NODE*>(&block->cells[index]);
+						return;
+					}
+					++block_it;
+					index = 0;
+				}
+			}
+
+			typename BlockMap::const_iterator block_it;
+			typename BlockMap::const_iterator block_end;
+			unsigned int index;
+			value_type current;
+		};
+		typedef iterator const_iterator;
+
+		Grid3DBlockStorage() : num_known(0) {}
+
+		/// Deep copy constructor
+		Grid3DBlockStorage(const Grid3DBlockStorage<NODE, BLOCK_BITS>& rhs) : num_known(rhs.num_known), bounds(rhs.bounds) {
+			for (typename BlockMap::const_iterator it = rhs.blocks.begin(); it != rhs.blocks.end(); ++it)
+				blocks.insert(std::pair<Grid3DKey, Block*>(it->first, new Block(*(it->second))));
+		}
+
+		~Grid3DBlockStorage() { clear(); }
+
+		/// @return pointer to the node of key, NULL if the cell is unknown
+		inline NODE* search(const Grid3DKey& key) const {
+			typename BlockMap::const_iterator block = blocks.find(blockKey(key));
+			if (block == blocks.end())
+				return NULL;
+			unsigned int index = cellIndex(key);
+			if (!block->second->isKnown(index))
+				return NULL;
+			return &block->second->cells[index];
+		}
+
+		/// @return pointer to the node of key, a default NODE is created if the cell is unknown
+		inline NODE* createNode(const Grid3DKey& key) {
+			Block*& block = blocks[blockKey(key)];
+			if (block == NULL)
+				block = new Block();
+			unsigned int index = cellIndex(key);
+			if (!block->isKnown(index)) {
+				block->known[index >> 6] |= (uint64_t)1 << (index & 63);
+				block->num_known++;
+				block->cells[index] = NODE();
+				num_known++;
+				bounds.insert(key);
+			}
+			return &block->cells[index];
+		}
+
+		/// Deletes the node of key, @return false if the cell is unknown. Empty blocks are released.
+		bool deleteNode(const Grid3DKey& key) {
+			typename BlockMap::iterator block = blocks.find(blockKey(key));
+			if (block == blocks.end())
+				return false;
+			unsigned int index = cellIndex(key);
+			if (!block->second->isKnown(index))
+				return false;
+			block->second->known[index >> 6] &= ~((uint64_t)1 << (index & 63));
+			num_known--;
+			bounds.erase(key);
+			if (--block->second->num_known == 0) {
+				delete block->second;
+				blocks.erase(block);
+			}
+			return true;
+		}
+
+		/// Deletes all blocks
+		void clear() {
+			for (typename BlockMap::iterator it = blocks.begin(); it != blocks.end(); ++it)
+				delete it->second;
+			blocks.clear();
+			num_known = 0;
+			bounds.clear();
+		}
+
+		/// Prepares the block map for num_cells cells in fully known blocks
+		void reserve(size_t num_cells) { blocks.rehash((size_t)(num_cells / BLOCK_SIZE / blocks.max_load_factor()) + 1); }
+
+		/**
+		 * Applies op(NODE&) to all cells of the allocated blocks, unknown cells
+		 * included (createNode() resets them), so that the loop over a block
+		 * has no branches and vectorizes. With OpenMP the blocks are processed
+		 * in parallel. Must not run concurrently with other updates.
+		 */
+		template <class OP>
+		void transformNodes(const OP& op) {
+			std::vector<Block*> block_list;
+			getBlocks(block_list);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+			for (int b = 0; b < (int)block_list.size(); b++) {
+				NODE* block_cells = block_list[b]->cells;
+				for (unsigned int i = 0; i < BLOCK_SIZE; i++)
+					op(block_cells[i]);
+			}
+		}
+
+		/**
+		 * Calls op(nodes, count, known) for the cells of the allocated blocks in
+		 * runs of up to 64 cells, bit i of known is set if nodes[i] is a known
+		 * cell. Runs without known cells are skipped. The ops can check for
+		 * fully known runs, which are the common case, and process them
+		 * without masking. With OpenMP the blocks are reduced in parallel into
+		 * copies of op, which are then combined into op by op.merge(), so op
+		 * has to start out empty.
+		 */
+		template <class OP>
+		void reduceNodes(OP& op) const {
+			std::vector<Block*> block_list;
+			getBlocks(block_list);
+			const OP initial(op);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+			{
+				OP local(initial);
+#ifdef _OPENMP
+#pragma omp for nowait
+#endif
+				for (int b = 0; b < (int)block_list.size(); b++) {
+					const Block* block = block_list[b];
+					for (unsigned int w = 0; w < BLOCK_WORDS; w++) {
+						if (block->known[w] != 0)
+							local(block->cells + 64 * w, std::min(64u, BLOCK_SIZE - 64 * w), block->known[w]);
+					}
+				}
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+				op.merge(local);
+			}
+		}
+
+		/// @return number of known cells
+		inline size_t size() const { return num_known; }
+
+		/// @return bounding box of the known cells in key space
+		inline const Grid3DKeyBounds& getKeyBounds() const { return bounds; }
+
+		/// @return number of allocated blocks
+		inline size_t numBlocks() const { return blocks.size(); }
+
+		/// @return true if the block of key is allocated, i.e. holds at least one known cell
+		inline bool blockExists(const Grid3DKey& key) const { return blocks.find(blockKey(key)) != blocks.end(); }
+
+		/// @return approximate memory usage of the blocks and the block hash table in bytes
+		size_t memoryUsage() const {
+			return blocks.size() * (sizeof(Block) + sizeof(typename BlockMap::value_type) + sizeof(void*))
+				+ blocks.bucket_count() * sizeof(void*) + bounds.memoryUsage();
+		}
+
+		inline iterator begin() const { return iterator(blocks.begin(), blocks.end()); }
+		inline iterator end() const { return iterator(blocks.end(), blocks.end()); }
+
+	protected:
+		static inline Grid3DKey blockKey(const Grid3DKey& key) {
+			return Grid3DKey(key[0] >> BLOCK_BITS, key[1] >> BLOCK_BITS, key[2] >> BLOCK_BITS);
+		}
+
+		static inline unsigned int cellIndex(const Grid3DKey& key) {
+			return (key[0] & BLOCK_MASK) | ((key[1] & BLOCK_MASK) << BLOCK_BITS) | ((key[2] & BLOCK_MASK) << (2 * BLOCK_BITS));
+		}
+
+		/// collects the allocated blocks for the parallel loops of transformNodes() and reduceNodes()
+		void getBlocks(std::vector<Block*>& block_list) const {
+			block_list.reserve(blocks.size());
+			for (typename BlockMap::const_iterator it = blocks.begin(); it != blocks.end(); ++it)
+				block_list.push_back(it->second);
+		}
+
+		BlockMap blocks;
+		size_t num_known;
+		Grid3DKeyBounds bounds;
+
+	private:
+		Grid3DBlockStorage<NODE, BLOCK_BITS>& operator=(const Grid3DBlockStorage<NODE, BLOCK_BITS>&);
+	};
+
+
+	/**
+	 * Storage policy of Grid3DBaseImpl based on a flat open-addressing hash
+	 * table with linear probing. The keys are packed into 64 bit words and
+	 * kept in one contiguous array, the nodes are stored inline in a
+	 * parallel array, so there is neither a NODE* indirection nor a per-cell
+	 * allocation. Deleting a cell shifts the following entries of its probe
+	 * sequence back instead of leaving tombstones.
+	 *
+	 * \note Node pointers returned by search() and createNode() are only
+	 * valid until the next createNode() or deleteNode() call, since both may
+	 * move entries within the table.
+	 *
+	 * \tparam NODE Node class to be stored, needs a default constructor
+	 */
+	template <class NODE>
+	class Grid3DOpenStorage {
+
+	public:
+		/// number of slots per parallel chunk of transformNodes() and reduceNodes()
+		static const size_t NODE_CHUNK = 4096;
+
+		/// Iterates over the occupied slots of the table
+		class iterator {
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef std::pair<Grid3DKey, NODE*> value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef value_type* pointer;
+			typedef value_type& reference;
+
+			iterator() : storage(NULL), index(0) {}
+			iterator(const Grid3DOpenStorage<NODE>* _storage, size_t _index)
+				: storage(_storage), index(_index) {
+				seek();
+			}
+
+			bool operator==(const iterator& other) const { return index == other.index; }
+			bool operator!=(const iterator& other) const { return index != other.index; }
+
+			iterator& operator++() {
+				index++;
+				seek();
+				return *this;
+			}
+			iterator operator++(int) {
+				iterator result = *this;
+				++(*this);
+				return result;
+			}
+
+			inline reference operator*() { return current; }
+			inline pointer operator->() { return &current; }
+
+		protected:
+			/// moves to the first occupied slot at or after the current position
+			void seek() {
+				while (index < storage->capacity && storage->slots[index] == 0)
+					index++;
+				if (index < storage->capacity) {
+					current.first = unpackKey(storage->slots[index]);
+					current.second = &storage->values[index];
+				}
+			}
+
+			const Grid3DOpenStorage<NODE>* storage;
+			size_t index;
+			value_type current;
+		};
+		typedef iterator const_iterator;
+
+		Grid3DOpenStorage() : slots(NULL), values(NULL), capacity(0), shift(64), num_cells(0) {}
+
+		/// Deep copy constructor
+		Grid3DOpenStorage(const Grid3DOpenStorage<NODE>& rhs)
+			: slots(NULL), values(NULL), capacity(rhs.capacity), shift(rhs.shift), num_cells(rhs.num_cells), bounds(rhs.bounds) {
+			if (capacity > 0) {
+				slots = new uint64_t[capacity];
+				values = new NODE[capacity];
+				for (size_t i = 0; i < capacity; i++) {
+					slots[i] = rhs.slots[i];
+					values[i] = rhs.values[i];
+				}
+			}
+		}
+
+		~Grid3DOpenStorage() { clear(); }
+
+		/// @return pointer to the node of key, NULL if the cell is unknown
+		inline NODE* search(const Grid3DKey& key) const {
+			if (num_cells == 0)
+				return NULL;
+			uint64_t packed = packKey(key);
+			for (size_t i = slotIndex(packed); slots[i] != 0; i = (i + 1) & (capacity - 1)) {
+				if (slots[i] == packed)
+					return &values[i];
+			}
+			return NULL;
+		}
+
+		/// @return pointer to the node of key, a default NODE is created if the cell is unknown
+		NODE* createNode(const Grid3DKey& key) {
+			// keep the load factor below 0.7
+			if ((num_cells + 1) * 10 > capacity * 7)
+				rehash(capacity == 0 ? 64 : 2 * capacity);
+
+			uint64_t packed = packKey(key);
+			size_t i = slotIndex(packed);
+			for (; slots[i] != 0; i = (i + 1) & (capacity - 1)) {
+				if (slots[i] == packed)
+					return &values[i];
+			}
+			slots[i] = packed;
+			values[i] = NODE();
+			num_cells++;
+			bounds.insert(key);
+			return &values[i];
+		}
+
+		/// Deletes the node of key, @return false if the cell is unknown
+		bool deleteNode(const Grid3DKey& key) {
+			if (num_cells == 0)
+				return false;
+			uint64_t packed = packKey(key);
+			size_t i = slotIndex(packed);
+			for (; slots[i] != packed; i = (i + 1) & (capacity - 1)) {
+				if (slots[i] == 0)
+					return false;
+			}
+
+			// backward shift: move up the entries whose probe sequence passes the hole
+			for (size_t j = (i + 1) & (capacity - 1); slots[j] != 0; j = (j + 1) & (capacity - 1)) {
+				size_t home = slotIndex(slots[j]);
+				if (((j - home) & (capacity - 1)) >= ((j - i) & (capacity - 1))) {
+					slots[i] = slots[j];
+					values[i] = values[j];
+					i = j;
+				}
+			}
+			slots[i] = 0;
+			num_cells--;
+			bounds.erase(key);
+			return true;
+		}
+
+		/// Deletes all nodes and releases the table
+		void clear() {
+			delete[] slots;
+			delete[] values;
+			slots = NULL;
+			values = NULL;
+			capacity = 0;
+			shift = 64;
+			num_cells = 0;
+			bounds.clear();
+		}
+
+		/// Grows the table to hold num_cells cells below the maximum load factor,
+		/// so that cells inserted in the slot order of another table never meet a half-grown table
+		void reserve(size_t num_cells_max) {
+			// stops before new_capacity * 7 overflows, such a table can not be allocated anyway
+			const size_t max_capacity = std::numeric_limits<size_t>::max() / 14;
+			size_t new_capacity = capacity == 0 ? 64 : capacity;
+			while (new_capacity <= max_capacity && num_cells_max > new_capacity * 7 / 10)
+				new_capacity *= 2;
+			if (new_capacity != capacity)
+				rehash(new_capacity);
+		}
+
+		/**
+		 * Applies op(NODE&) to all slots of the table, unknown cells included
+		 * (createNode() resets them), so that the loop has no branches and
+		 * vectorizes. With OpenMP the array is processed in parallel chunks.
+		 * Must not run concurrently with other updates.
+		 */
+		template <class OP>
+		void transformNodes(const OP& op) {
+			const int num_chunks = (int)((capacity + NODE_CHUNK - 1) / NODE_CHUNK);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+			for (int c = 0; c < num_chunks; c++) {
+				const size_t end = std::min((size_t)(c + 1) * NODE_CHUNK, capacity);
+				for (size_t i = (size_t)c * NODE_CHUNK; i < end; i++)
+					op(values[i]);
+			}
+		}
+
+		/**
+		 * Calls op(nodes, count, known) for the slots of the table in runs of
+		 * up to 64, bit i of known is set if nodes[i] is a known cell. With
+		 * OpenMP the chunks are reduced in parallel into copies of op, which are
+		 * then combined into op by op.merge(), so op has to start out empty.
+		 */
+		template <class OP>
+		void reduceNodes(OP& op) const {
+			const int num_chunks = (int)((capacity + NODE_CHUNK - 1) / NODE_CHUNK);
+			const OP initial(op);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+			{
+				OP local(initial);
+#ifdef _OPENMP
+#pragma omp for nowait
+#endif
+				for (int c = 0; c < num_chunks; c++) {
+					const size_t end = std::min((size_t)(c + 1) * NODE_CHUNK, capacity);
+					for (size_t w = (size_t)c * NODE_CHUNK; w < end; w += 64) {
+						const unsigned int count = (unsigned int)std::min((size_t)64, end - w);
+						uint64_t word = 0;
+						for (unsigned int i = 0; i < count; i++)
+							word |= (uint64_t)(slots[w + i] != 0) << i;
+						if (word != 0)
+							local(values + w, count, word);
+					}
+				}
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+				op.merge(local);
+			}
+		}
+
+		/// @return number of known cells
+		inline size_t size() const { return num_cells; }
+
+		/// @return bounding box of the known cells in key space
+		inline const Grid3DKeyBounds& getKeyBounds() const { return bounds; }
+
+		/// @return memory usage of the table in bytes
+		size_t memoryUsage() const { return capacity * (sizeof(uint64_t) + sizeof(NODE)) + bounds.memoryUsage(); }
+
+		inline iterator begin() const { return iterator(this, 0); }
+		inline iterator end() const { return iterator(this, capacity); }
+
+	protected:
+		/// packs the key into the lower 48 bits, bit 48 marks the slot as occupied
+		static inline uint64_t packKey(const Grid3DKey& key) {
+			return ((uint64_t)1 << 48) | (uint64_t)key[0] | ((uint64_t)key[1] << 16) | ((uint64_t)key[2] << 32);
+		}
+
+		static inline Grid3DKey unpackKey(uint64_t packed) {
+			return Grid3DKey((key_type)(packed & 0xFFFF), (key_type)((packed >> 16) & 0xFFFF), (key_type)((packed >> 32) & 0xFFFF));
+		}
+
+		/// Fibonacci hashing of the packed key onto the table
+		inline size_t slotIndex(uint64_t packed) const {
+			return (size_t)((packed * 0x9E3779B97F4A7C15ULL) >> shift);
+		}
+
+		/// reallocates the table with new_capacity (a power of two) slots and reinserts all cells
+		void rehash(size_t new_capacity) {
+			uint64_t* old_slots = slots;
+			NODE* old_values = values;
+			size_t old_capacity = capacity;
+
+			slots = new uint64_t[new_capacity];
+			values = new NODE[new_capacity];
+			capacity = new_capacity;
+			shift = 64;
+			for (size_t c = new_capacity; c > 1; c >>= 1)
+				shift--;
+			for (size_t i = 0; i < capacity; i++)
+				slots[i] = 0;
+
+			for (size_t i = 0; i < old_capacity; i++) {
+				if (old_slots[i] == 0)
+					continue;
+				size_t j = slotIndex(old_slots[i]);
+				while (slots[j] != 0)
+					j = (j + 1) & (capacity - 1);
+				slots[j] = old_slots[i];
+				values[j] = old_values[i];
+			}
+			delete[] old_slots;
+			delete[] old_values;
+		}
+
+		uint64_t* slots;	///< packed keys, 0 marks an empty slot
+		NODE* values;		///< nodes, inline and parallel to slots
+		size_t capacity;	///< number of slots, a power of two
+		unsigned int shift;	///< 64 - log2(capacity)
+		size_t num_cells;
+		Grid3DKeyBounds bounds;
+
+	private:
+		Grid3DOpenStorage<NODE>& operator=(const Grid3DOpenStorage<NODE>&);
+	};
+
+
+	/**
+	 * Storage policy of Grid3DBaseImpl holding only a cubic window of
+	 * 2^n x 2^n x 2^n cells in a dense circular array. A cell lives at the
+	 * array position given by its key modulo the window width, so moving the
+	 * window with moveWindow() keeps every cell in place and only clears the
+	 * slabs that scroll out of the window.
+	 *
+	 * Cells outside the window are unknown: search() returns NULL for them
+	 * and createNode() does not create them (it returns NULL as well).
+	 *
+	 * \tparam NODE Node class to be stored, needs a default constructor
+	 */
+	template <class NODE>
+	class Grid3DRollingStorage {
+
+	public:
+		/// number of slots per parallel chunk of transformNodes() and reduceNodes()
+		static const size_t NODE_CHUNK = 4096;
+
+		/// log2 of the largest window width (512^3 cells)
+		static const unsigned int MAX_WIDTH_BITS = 9;
+
+		/// Iterates over the known cells of the window
+		class iterator {
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef std::pair<Grid3DKey, NODE*> value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef value_type* pointer;
+			typedef value_type& reference;
+
+			iterator() : storage(NULL), index(0) {}
+			iterator(const Grid3DRollingStorage<NODE>* _storage, size_t _index)
+				: storage(_storage), index(_index) {
+				seek();
+			}
+
+			bool operator==(const iterator& other) const { return index == other.index; }
+			bool operator!=(const iterator& other) const { return index != other.index; }
+
+			iterator& operator++() {
+				index++;
+				seek();
+				return *this;
+			}
+			iterator operator++(int) {
+				iterator result = *this;
+				++(*this);
+				return result;
+			}
+
+			inline reference operator*() { return current; }
+			inline pointer operator->() { return &current; }
+
+		protected:
+			/// moves to the first known cell at or after the current position
+			void seek() {
+				while (index < storage->num_slots) {
+					uint64_t word = storage->known[index >> 6] >> (index & 63);
+					if (word == 0) {
+						index = (index | 63) + 1;
+						continue;
+					}
+					while ((word & 1) == 0) {
+						word >>= 1;
+						index++;
+					}
+					current.first = storage->cellKey(index);
+					current.second = &storage->values[index];
+					return;
+				}
+				index = storage->num_slots;
+			}
+
+			const Grid3DRollingStorage<NODE>* storage;
+			size_t index;
+			value_type current;
+		};
+		typedef iterator const_iterator;
+
+		Grid3DRollingStorage()
+			: values(NULL), known(NULL), width_bits(0), width(0), num_slots(0), num_cells(0), window_min(0, 0, 0) {}
+
+		/// Deep copy constructor
+		Grid3DRollingStorage(const Grid3DRollingStorage<NODE>& rhs)
+			: values(NULL), known(NULL), width_bits(0), width(0), num_slots(0), num_cells(0), window_min(rhs.window_min) {
+			if (rhs.num_slots > 0) {
+				setWindow(rhs.width_bits, rhs.window_min);
+				for (size_t i = 0; i < num_slots; i++)
+					values[i] = rhs.values[i];
+				for (size_t i = 0; i < (num_slots + 63) / 64; i++)
+					known[i] = rhs.known[i];
+				num_cells = rhs.num_cells;
+				bounds = rhs.bounds;
+			}
+		}
+
+		~Grid3DRollingStorage() {
+			delete[] values;
+			delete[] known;
+		}
+
+		/**
+		 * (Re-)allocates the window, all cells are cleared.
+		 *
+		 * @param _width_bits log2 of the window width in cells, limited to MAX_WIDTH_BITS
+		 * @param min_key key of the lower corner of the window
+		 */
+		void setWindow(unsigned int _width_bits, const Grid3DKey& min_key) {
+			if (_width_bits > MAX_WIDTH_BITS)
+				_width_bits = MAX_WIDTH_BITS;
+			delete[] values;
+			delete[] known;
+			width_bits = _width_bits;
+			width = 1u << width_bits;
+			num_slots = (size_t)1 << (3 * width_bits);
+			values = new NODE[num_slots];
+			known = new uint64_t[(num_slots + 63) / 64];
+			window_min = min_key;
+			clear();
+		}
+
+		/**
+		 * Moves the lower corner of the window to min_key. Only the cells which
+		 * leave the window are cleared, the cost is proportional to the
+		 * volume scrolled out.
+		 */
+		void moveWindow(const Grid3DKey& min_key) {
+			for (unsigned int axis = 0; axis < 3; axis++) {
+				int shift = (int)min_key[axis] - (int)window_min[axis];
+				if (shift >= (int)width || -shift >= (int)width) {
+					// nothing of the old window remains
+					clear();
+					window_min = min_key;
+					return;
+				}
+
+				for (int s = 0; s < std::abs(shift); s++) {
+					if (shift > 0)
+						clearSlab(axis, (key_type)(window_min[axis] + s));
+					else
+						clearSlab(axis, (key_type)(window_min[axis] + width - 1 - s));
+				}
+				window_min[axis] = min_key[axis];
+			}
+		}
+
+		/// @return key of the lower corner of the window
+		inline const Grid3DKey& getWindowMin() const { return window_min; }
+
+		/// @return width of the window in cells
+		inline unsigned int getWindowWidth() const { return width; }
+
+		/// @return true if key lies within the window
+		inline bool inWindow(const Grid3DKey& key) const {
+			return (key_type)(key[0] - window_min[0]) < width
+				&& (key_type)(key[1] - window_min[1]) < width
+				&& (key_type)(key[2] - window_min[2]) < width;
+		}
+
+		/// @return pointer to the node of key, NULL if the cell is unknown or outside the window
+		inline NODE* search(const Grid3DKey& key) const {
+			if (!inWindow(key))
+				return NULL;
+			size_t index = cellIndex(key);
+			if (((known[index >> 6] >> (index & 63)) & 1) == 0)
+				return NULL;
+			return &values[index];
+		}
+
+		/// @return pointer to the node of key, a default NODE is created if the cell is unknown. NULL outside the window.
+		inline NODE* createNode(const Grid3DKey& key) {
+			if (!inWindow(key))
+				return NULL;
+			size_t index = cellIndex(key);
+			uint64_t bit = (uint64_t)1 << (index & 63);
+			if ((known[index >> 6] & bit) == 0) {
+				known[index >> 6] |= bit;
+				values[index] = NODE();
+				num_cells++;
+				bounds.insert(key);
+			}
+			return &values[index];
+		}
+
+		/// Deletes the node of key, @return false if the cell is unknown
+		bool deleteNode(const Grid3DKey& key) {
+			if (!inWindow(key))
+				return false;
+			size_t index = cellIndex(key);
+			uint64_t bit = (uint64_t)1 << (index & 63);
+			if ((known[index >> 6] & bit) == 0)
+				return false;
+			known[index >> 6] &= ~bit;
+			num_cells--;
+			bounds.erase(key);
+			return true;
+		}
+
+		/// Marks all cells of the window unknown, the window itself is kept
+		void clear() {
+			for (size_t i = 0; i < (num_slots + 63) / 64; i++)
+				known[i] = 0;
+			num_cells = 0;
+			bounds.clear();
+		}
+
+		/// The window is preallocated, nothing to reserve
+		void reserve(size_t) {}
+
+		/**
+		 * Applies op(NODE&) to all cells of the window, unknown cells included
+		 * (createNode() resets them), so that the loop has no branches and
+		 * vectorizes. Runs of 64 unknown cells are skipped. With OpenMP the
+		 * array is processed in parallel chunks.
+		 * Must not run concurrently with other updates.
+		 */
+		template <class OP>
+		void transformNodes(const OP& op) {
+			const int num_chunks = (int)((num_slots + NODE_CHUNK - 1) / NODE_CHUNK);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+			for (int c = 0; c < num_chunks; c++) {
+				const size_t end = std::min((size_t)(c + 1) * NODE_CHUNK, num_slots);
+				for (size_t w = (size_t)c * NODE_CHUNK; w < end; w += 64) {
+					// skips the parts of the window without known cells
+					if (known[w >> 6] == 0)
+						continue;
+					const size_t word_end = std::min(w + 64, end);
+					for (size_t i = w; i < word_end; i++)
+						op(values[i]);
+				}
+			}
+		}
+
+		/**
+		 * Calls op(nodes, count, known) for the cells of the window in runs of
+		 * up to 64, bit i of known is set if nodes[i] is a known cell. Runs
+		 * without known cells are skipped. With OpenMP the chunks are reduced in
+		 * parallel into copies of op, which are then combined into op by
+		 * op.merge(), so op has to start out empty.
+		 */
+		template <class OP>
+		void reduceNodes(OP& op) const {
+			const int num_chunks = (int)((num_slots + NODE_CHUNK - 1) / NODE_CHUNK);
+			const OP initial(op);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+			{
+				OP local(initial);
+#ifdef _OPENMP
+#pragma omp for nowait
+#endif
+				for (int c = 0; c < num_chunks; c++) {
+					const size_t end = std::min((size_t)(c + 1) * NODE_CHUNK, num_slots);
+					for (size_t w = (size_t)c * NODE_CHUNK; w < end; w += 64) {
+						const uint64_t word = known[w >> 6];
+						if (word == 0)
+							continue;
+						local(values + w, (unsigned int)std::min((size_t)64, end - w), word);
+					}
+				}
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+				op.merge(local);
+			}
+		}
+
+		/// @return number of known cells
+		inline size_t size() const { return num_cells; }
+
+		/// @return bounding box of the known cells in key space
+		inline const Grid3DKeyBounds& getKeyBounds() const { return bounds; }
+
+		/// @return memory usage of the window in bytes
+		size_t memoryUsage() const { return num_slots * sizeof(NODE) + (num_slots + 63) / 64 * sizeof(uint64_t) + bounds.memoryUsage(); }
+
+		inline iterator begin() const { return iterator(this, 0); }
+		inline iterator end() const { return iterator(this, num_slots); }
+
+	protected:
+		/// position of the cell in the circular array, the key modulo the window width on each axis
+		inline size_t cellIndex(const Grid3DKey& key) const {
+			const unsigned int mask = width - 1;
+			return (size_t)(key[0] & mask) | ((size_t)(key[1] & mask) << width_bits) | ((size_t)(key[2] & mask) << (2 * width_bits));
+		}
+
+		/// inverse of cellIndex() for the current window
+		inline Grid3DKey cellKey(size_t index) const {
+			const unsigned int mask = width - 1;
+			Grid3DKey key;
+			for (unsigned int axis = 0; axis < 3; axis++) {
+				unsigned int slot = (unsigned int)(index >> (axis * width_bits)) & mask;
+				key[axis] = (key_type)(window_min[axis] + ((slot - window_min[axis]) & mask));
+			}
+			return key;
+		}
+
+		/// marks all cells whose key along axis equals key_value unknown
+		void clearSlab(unsigned int axis, key_type key_value) {
+			const size_t stride[3] = { 1, (size_t)width, (size_t)width * width };
+			const unsigned int axis1 = (axis + 1) % 3, axis2 = (axis + 2) % 3;
+			size_t base = (size_t)(key_value & (width - 1)) * stride[axis];
+			for (unsigned int u = 0; u < width; u++) {
+				for (unsigned int v = 0; v < width; v++) {
+					size_t index = base + u * stride[axis1] + v * stride[axis2];
+					uint64_t bit = (uint64_t)1 << (index & 63);
+					if (known[index >> 6] & bit) {
+						known[index >> 6] &= ~bit;
+						num_cells--;
+						bounds.erase(cellKey(index));
+					}
+				}
+			}
+		}
+
+		NODE* values;		///< dense circular array of the window
+		uint64_t* known;	///< bit i is set if values[i] is a known cell
+		unsigned int width_bits;
+		unsigned int width;
+		size_t num_slots;
+		size_t num_cells;
+		Grid3DKey window_min;
+		Grid3DKeyBounds bounds;
+
+	private:
+		Grid3DRollingStorage<NODE>& operator=(const Grid3DRollingStorage<NODE>&);
+	};
+
+
+	/**
+	 * Traits of a storage policy for parallel updates. A storage is concurrent
+	 * if updates of different cells may run in parallel as long as each update
+	 * holds the lock of the cell's shard (see shard(), lock() and unlock()).
+	 * Otherwise all updates have to be serialized, e.g. by a critical section,
+	 * and the shard functions do nothing.
+	 * Only the experimental Grid3DShardedStorage is concurrent.
+	 *
+	 * unknownBlockBits() tells ray casting how large an aligned block of
+	 * unknown cells around an unknown cell it may skip without lookups.
+	 *
+	 * \tparam STORAGE Storage policy
+	 */
+	template <class STORAGE>
+	struct Grid3DStorageTraits {
+		static const bool concurrent = false;
+
+		/// @return index of the shard of key
+		static inline unsigned int shard(const STORAGE&, const Grid3DKey&) { return 0; }
+		/// Acquires the lock of a shard
+		static inline void lock(STORAGE&, unsigned int) {}
+		/// Releases the lock of a shard
+		static inline void unlock(STORAGE&, unsigned int) {}
+		/// @return log2 of the width of the aligned block around the unknown cell key that only holds unknown cells
+		static inline unsigned int unknownBlockBits(const STORAGE&, const Grid3DKey&) { return 0; }
+	};
+
+
+	/// Grid3DBlockStorage only allocates blocks with known cells, so a missing block is unknown as a whole
+	template <class NODE, unsigned int BLOCK_BITS>
+	struct Grid3DStorageTraits<Grid3DBlockStorage<NODE, BLOCK_BITS> > {
+		static const bool concurrent = false;
+
+		static inline unsigned int shard(const Grid3DBlockStorage<NODE, BLOCK_BITS>&, const Grid3DKey&) { return 0; }
+		static inline void lock(Grid3DBlockStorage<NODE, BLOCK_BITS>&, unsigned int) {}
+		static inline void unlock(Grid3DBlockStorage<NODE, BLOCK_BITS>&, unsigned int) {}
+		static inline unsigned int unknownBlockBits(const Grid3DBlockStorage<NODE, BLOCK_BITS>& storage, const Grid3DKey& key) {
+			return storage.blockExists(key) ? 0 : BLOCK_BITS;
+		}
+	};
+
+
+	/**
+	 * Concurrent storage policy of Grid3DBaseImpl: the grid is divided into
+	 * blocks of 2^BLOCK_BITS x 2^BLOCK_BITS x 2^BLOCK_BITS cells, and the
+	 * blocks are distributed over 2^SHARD_BITS shards by the lowest SHARD_BITS
+	 * bits of the Morton code of their block key. Every shard is a hash map
+	 * with its own node pool and lock. Consecutive cells of a ray mostly stay
+	 * in one block, so a thread can update them under a single lock, while
+	 * rays of other threads in other directions lock other shards.
+	 *
+	 * Updates of a cell have to hold the lock of its shard (shardIndex(),
+	 * lock(), unlock(), see Grid3DStorageTraits); search(), createNode() and
+	 * deleteNode() may then be called from several threads at once. The bounds
+	 * of the known cells are shared by all shards and guarded by a lock of
+	 * their own, which is only taken when a cell is created or deleted.
+	 * Without OpenMP the locks are no-ops.
+	 *
+	 * \warning Experimental: the speedup over Grid3DHashStorage with the
+	 * critical section has not been measured on more than one core. On a single
+	 * core, inserting point clouds and super rays with one thread is 16-40%
+	 * slower with this storage because of the shard locks. No grid class of the
+	 * library uses it, it has to be chosen explicitly as STORAGE.
+	 *
+	 * \tparam NODE Node class to be stored
+	 * \tparam SHARD_BITS log2 of the number of shards
+	 * \tparam BLOCK_BITS log2 of the block width (3: 8^3 cells per block)
+	 * \tparam HASH Hash function on the keys within a shard
+	 */
+	template <class NODE, unsigned int SHARD_BITS = 6, unsigned int BLOCK_BITS = 3, class HASH = Grid3DKey::KeyHash>
+	class Grid3DShardedStorage {
+
+	public:
+		static const unsigned int NUM_SHARDS = 1u << SHARD_BITS;
+
+		typedef unordered_ns::unordered_map<Grid3DKey, NODE*, HASH> CellMap;
+
+		/// Cells of one shard and their lock
+		struct Shard {
+			Shard() {
+#ifdef _OPENMP
+				omp_init_lock(&lock);
+#endif
+			}
+			~Shard() {
+#ifdef _OPENMP
+				omp_destroy_lock(&lock);
+#endif
+			}
+
+			CellMap cells;
+			Grid3DNodePool<NODE> nodes;
+#ifdef _OPENMP
+			omp_lock_t lock;
+#endif
+		};
+
+		/// Iterates over the known cells, shard by shard
+		class iterator {
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef typename CellMap::value_type value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const value_type* pointer;
+			typedef const value_type& reference;
+
+			iterator() : shards(NULL), shard(NUM_SHARDS) {}
+			iterator(const Shard* _shards, unsigned int _shard) : shards(_shards), shard(_shard) {
+				if (shard < NUM_SHARDS) {
+					cell = shards[shard].cells.begin();
+					seek();
+				}
+			}
+
+			bool operator==(const iterator& other) const {
+				return shard == other.shard && (shard == NUM_SHARDS || cell == other.cell);
+			}
+			bool operator!=(const iterator& other) const { return !(*this == other); }
+
+			iterator& operator++() {
+				++cell;
+				seek();
+				return *this;
+			}
+			iterator operator++(int) {
+				iterator result = *this;
+				++(*this);
+				return result;
+			}
+
+			inline reference operator*() const { return *cell; }
+			inline pointer operator->() const { return &(*cell); }
+
+		protected:
+			/// moves to the next shard while the current one is exhausted
+			void seek() {
+				while (cell == shards[shard].cells.end()) {
+					if (++shard == NUM_SHARDS)
+						return;
+					cell = shards[shard].cells.begin();
+				}
+			}
+
+			const Shard* shards;
+			unsigned int shard;
+			typename CellMap::const_iterator cell;
+		};
+		typedef iterator const_iterator;
+
+		Grid3DShardedStorage() {
+#ifdef _OPENMP
+			omp_init_lock(&bounds_lock);
+#endif
+		}
+
+		/// Deep copy constructor, rhs must not be updated meanwhile
+		Grid3DShardedStorage(const Grid3DShardedStorage<NODE, SHARD_BITS, BLOCK_BITS, HASH>& rhs) : bounds(rhs.bounds) {
+#ifdef _OPENMP
+			omp_init_lock(&bounds_lock);
+#endif
+			for (unsigned int i = 0; i < NUM_SHARDS; i++) {
+				const CellMap& rhs_cells = rhs.shards[i].cells;
+				for (typename CellMap::const_iterator it = rhs_cells.begin(); it != rhs_cells.end(); ++it)
+					shards[i].cells.insert(std::pair<Grid3DKey, NODE*>(it->first, shards[i].nodes.create(*(it->second))));
+			}
+		}
+
+		~Grid3DShardedStorage() {
+			clear();
+#ifdef _OPENMP
+			omp_destroy_lock(&bounds_lock);
+#endif
+		}
+
+		/// @return index of the shard of key
+		static inline unsigned int shardIndex(const Grid3DKey& key) {
+			return (unsigned int)((key.mortonCode() >> (3 * BLOCK_BITS)) & (NUM_SHARDS - 1));
+		}
+
+		/// Acquires the lock of a shard
+		inline void lock(unsigned int shard) {
+#ifdef _OPENMP
+			omp_set_lock(&shards[shard].lock);
+#endif
+		}
+
+		/// Releases the lock of a shard
+		inline void unlock(unsigned int shard) {
+#ifdef _OPENMP
+			omp_unset_lock(&shards[shard].lock);
+#endif
+		}
+
+		/// @return pointer to the node of key, NULL if the cell is unknown
+		inline NODE* search(const Grid3DKey& key) const {
+			const CellMap& cells = shards[shardIndex(key)].cells;
+			typename CellMap::const_iterator cell = cells.find(key);
+			if (cell == cells.end())
+				return NULL;
+			return cell->second;
+		}
+
+		/// @return pointer to the node of key, a default NODE is created if the cell is unknown
+		inline NODE* createNode(const Grid3DKey& key) {
+			Shard& shard = shards[shardIndex(key)];
+			NODE*& node = shard.cells[key];
+			if (node == NULL) {
+				node = shard.nodes.create();
+#ifdef _OPENMP
+				omp_set_lock(&bounds_lock);
+#endif
+				bounds.insert(key);
+#ifdef _OPENMP
+				omp_unset_lock(&bounds_lock);
+#endif
+			}
+			return node;
+		}
+
+		/// Deletes the node of key, @return false if the cell is unknown
+		bool deleteNode(const Grid3DKey& key) {
+			Shard& shard = shards[shardIndex(key)];
+			typename CellMap::iterator cell = shard.cells.find(key);
+			if (cell == shard.cells.end())
+				return false;
+			shard.nodes.destroy(cell->second);
+			shard.cells.erase(cell);
+#ifdef _OPENMP
+			omp_set_lock(&bounds_lock);
+#endif
+			bounds.erase(key);
+#ifdef _OPENMP
+			omp_unset_lock(&bounds_lock);
+#endif
+			return true;
+		}
+
+		/// Deletes all nodes, their memory is released in bulk by the pools
+		void clear() {
+			for (unsigned int i = 0; i < NUM_SHARDS; i++) {
+				for (typename CellMap::iterator it = shards[i].cells.begin(); it != shards[i].cells.end(); ++it)
+					it->second->~NODE();
+				shards[i].cells.clear();
+				shards[i].nodes.release();
+			}
+			bounds.clear();
+		}
+
+		/// Prepares every shard for an even share of num_cells cells
+		void reserve(size_t num_cells) {
+			for (unsigned int i = 0; i < NUM_SHARDS; i++)
+				shards[i].cells.rehash((size_t)(num_cells / NUM_SHARDS / shards[i].cells.max_load_factor()) + 1);
+		}
+
+		/**
+		 * Applies op(NODE&) to every node, with OpenMP in parallel over the
+		 * shards. Must not run concurrently with other updates, the shard locks
+		 * are not taken.
+		 */
+		template <class OP>
+		void transformNodes(const OP& op) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+			for (int s = 0; s < (int)NUM_SHARDS; s++) {
+				CellMap& cells = shards[s].cells;
+				for (typename CellMap::iterator it = cells.begin(); it != cells.end(); ++it)
+					op(*it->second);
+			}
+		}
+
+		/**
+		 * Calls op(node, 1, 1), i.e. a run of one known cell, for every node.
+		 * With OpenMP the shards are reduced in parallel into copies of op,
+		 * which are then combined into op by op.merge(), so op has to start out
+		 * empty.
+		 */
+		template <class OP>
+		void reduceNodes(OP& op) const {
+			const OP initial(op);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+			{
+				OP local(initial);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1) nowait
+#endif
+				for (int s = 0; s < (int)NUM_SHARDS; s++) {
+					const CellMap& cells = shards[s].cells;
+					for (typename CellMap::const_iterator it = cells.begin(); it != cells.end(); ++it)
+						local(it->second, 1u, (uint64_t)1);
+				}
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+				op.merge(local);
+			}
+		}
+
+		/// @return number of known cells
+		inline size_t size() const {
+			size_t num_cells = 0;
+			for (unsigned int i = 0; i < NUM_SHARDS; i++)
+				num_cells += shards[i].cells.size();
+			return num_cells;
+		}
+
+		/// @return bounding box of the known cells in key space
+		inline const Grid3DKeyBounds& getKeyBounds() const { return bounds; }
+
+		/// @return approximate memory usage of the nodes and the hash tables in bytes
+		size_t memoryUsage() const {
+			size_t memory = sizeof(shards) + bounds.memoryUsage();
+			for (unsigned int i = 0; i < NUM_SHARDS; i++) {
+				memory += shards[i].cells.size() * (sizeof(typename CellMap::value_type) + sizeof(void*))
+					+ shards[i].cells.bucket_count() * sizeof(void*) + shards[i].nodes.memoryUsage();
+			}
+			return memory;
+		}
+
+		inline iterator begin() const { return iterator(shards, 0); }
+		inline iterator end() const { return iterator(shards, NUM_SHARDS); }
+
+	protected:
+		Shard shards[NUM_SHARDS];
+		Grid3DKeyBounds bounds;
+#ifdef _OPENMP
+		omp_lock_t bounds_lock;
+#endif
+
+	private:
+		Grid3DShardedStorage<NODE, SHARD_BITS, BLOCK_BITS, HASH>& operator=(const Grid3DShardedStorage<NODE, SHARD_BITS, BLOCK_BITS, HASH>&);
+	};
+
+	template <class NODE, unsigned int SHARD_BITS, unsigned int BLOCK_BITS, class HASH>
+	struct Grid3DStorageTraits<Grid3DShardedStorage<NODE, SHARD_BITS, BLOCK_BITS, HASH> > {
+		static const bool concurrent = true;
+
+		static inline unsigned int shard(const Grid3DShardedStorage<NODE, SHARD_BITS, BLOCK_BITS, HASH>&, const Grid3DKey& key) {
+			return Grid3DShardedStorage<NODE, SHARD_BITS, BLOCK_BITS, HASH>::shardIndex(key);
+		}
+		static inline void lock(Grid3DShardedStorage<NODE, SHARD_BITS, BLOCK_BITS, HASH>& storage, unsigned int shard) { storage.lock(shard); }
+		static inline void unlock(Grid3DShardedStorage<NODE, SHARD_BITS, BLOCK_BITS, HASH>& storage, unsigned int shard) { storage.unlock(shard); }
+		static inline unsigned int unknownBlockBits(const Grid3DShardedStorage<NODE, SHARD_BITS, BLOCK_BITS, HASH>&, const Grid3DKey&) { return 0; }
+	};
+
+}
+
+#endif
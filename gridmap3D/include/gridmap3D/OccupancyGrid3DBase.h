@@ -49,7 +49,8 @@ namespace gridmap3D {
 	/**
 	 * Base implementation for Occupancy Grid3Ds (e.g. for mapping).
 	 * AbstractOccupancyGrid3D serves as a common
-	 * base interface for all these classes.
+	 * base interface for all these classes (AbstractOccupancyGrid3DBase for
+	 * grids of Grid3DQuantizedNode, see Grid3DOccupancyInterface).
 	 * Each class used as NODE type needs to be derived from
 	 * OccupancyGrid3DNode.
 	 *
@@ -60,9 +61,10 @@ namespace gridmap3D {
 	 *
 	 * \tparam NODE Node class to be used in grid (usually derived from
 	 *    Grid3DDataNode)
+	 * \tparam STORAGE Storage policy of the cells, see Grid3DBaseImpl
 	 */
-	template <class NODE>
-	class OccupancyGrid3DBase : public Grid3DBaseImpl<NODE, AbstractOccupancyGrid3D> {
+	template <class NODE, class STORAGE = Grid3DHashStorage<NODE> >
+	class OccupancyGrid3DBase : public Grid3DBaseImpl<NODE, typename Grid3DOccupancyInterface<NODE>::type, STORAGE> {
 
 	public:
 		/// Default constructor, sets resolution of leafs
@@ -70,7 +72,7 @@ namespace gridmap3D {
 		virtual ~OccupancyGrid3DBase();
 
 		/// Copy constructor
-		OccupancyGrid3DBase(const OccupancyGrid3DBase<NODE>& rhs);
+		OccupancyGrid3DBase(const OccupancyGrid3DBase<NODE, STORAGE>& rhs);
 
 		/**
 		 * Integrate a Pointcloud (in global reference frame), parallelized with OpenMP.
@@ -184,6 +186,31 @@ namespace gridmap3D {
 		 */
 		virtual void toMaxLikelihood();
 
+		/**
+		 * Clamps the log-odds of all cells to the current clamping thresholds.
+		 * Updates keep the cells clamped by themselves, so this is only needed
+		 * after the thresholds were narrowed with setClampingThresMin() or
+		 * setClampingThresMax().
+		 */
+		virtual void updateClamping();
+
+		/**
+		 * Counts the cells of the grid by occupancy. Unknown cells are counted
+		 * inside the bounding box of the known cells.
+		 *
+		 * @param[out] num_free number of known cells below the occupancy threshold
+		 * @param[out] num_occupied number of known cells at or above the occupancy threshold
+		 * @param[out] num_unknown number of unknown cells in the bounding box of the known cells
+		 */
+		void getOccupancyStatistics(size_t& num_free, size_t& num_occupied, size_t& num_unknown) const;
+
+		/**
+		 * Histogram of the log-odds of the known cells in num_bins bins of equal
+		 * width between the clamping thresholds. Cells outside of the thresholds
+		 * are counted in the first or last bin.
+		 */
+		void getOccupancyHistogram(std::vector<size_t>& histogram, unsigned int num_bins) const;
+
 		/**
 		 * Insert one ray between origin and end into the grid.
 		 * integrateMissOnRay() is called for the ray, the end point is updated as occupied.
@@ -207,6 +234,11 @@ namespace gridmap3D {
 		 * was hit by the raycast. If the raycast returns false you can search() the node at 'end' and
 		 * see whether it's unknown space.
 		 *
+		 * If unknown cells are ignored, the ray jumps across blocks of unknown
+		 * cells that the storage reports (see Grid3DStorageTraits::unknownBlockBits(),
+		 * e.g. the unallocated blocks of Grid3DBlockStorage) without looking up
+		 * their cells. The voxels reached are the same as when stepping voxel by voxel.
+		 *
 		 * @param[in] origin starting coordinate of ray
 		 * @param[in] direction A vector pointing in the direction of the raycast (NOT a point in space). Does not need to be normalized.
 		 * @param[out] end returns the center of the last cell on the ray. If the function returns true, it is occupied.
@@ -217,6 +249,22 @@ namespace gridmap3D {
 		virtual bool castRay(const point3d& origin, const point3d& direction, point3d& end,
 			bool ignoreUnknownCells = false, double maxRange = -1.0) const;
 
+		/**
+		 * Performs castRay() for a batch of rays, in parallel with OpenMP. A cell is found
+		 * by one lookup in the storage, so there is no search path to share between the rays.
+		 *
+		 * @param[in] origins starting coordinates of the rays
+		 * @param[in] directions directions of the rays, one per origin (need not be normalized)
+		 * @param[out] ends the ends of the rays as castRay() returns them
+		 * @param[out] distances distance from the origin to the end of each ray that hit an occupied cell, -1 otherwise
+		 * @param[in] ignoreUnknownCells whether unknown cells are ignored (= treated as free), see castRay()
+		 * @param[in] maxRange Maximum range after which the raycast is aborted (<= 0: no limit, default)
+		 * @return number of rays that hit an occupied cell
+		 */
+		size_t castRays(const std::vector<point3d>& origins, const std::vector<point3d>& directions,
+			std::vector<point3d>& ends, std::vector<double>& distances,
+			bool ignoreUnknownCells = false, double maxRange = -1.0) const;
+
 		/**
 		 * Retrieves the entry point of a ray into a voxel. This is the closest intersection point of the ray
 		 * originating from origin and a plane of the axis aligned cube.
@@ -307,6 +355,97 @@ namespace gridmap3D {
 		 */
 		inline bool integrateMissOnRay(const point3d& origin, const point3d& end);
 
+		/// @return true if the centers of all voxels in the block of key (2^bits voxels wide) are within maxRange of origin
+		bool rayBlockInRange(const point3d& origin, const Grid3DKey& key, unsigned int bits, double maxrange_sq) const;
+
+		/// Advances the traversal state of castRay() to the last voxel the ray crosses
+		/// in the block of key (2^bits voxels wide)
+		static void skipRayBlock(Grid3DKey& key, const int step[3], double tMax[3], const double tDelta[3],
+			unsigned int bits);
+
+		/**
+		 * Calls updateNode() while holding the lock of the key's shard, so that
+		 * rays can be integrated in parallel without a critical section if the
+		 * storage is concurrent (see Grid3DStorageTraits). Only the experimental
+		 * Grid3DShardedStorage is; with every other storage the updates are
+		 * serialized by the caller as before.
+		 */
+		void updateNodeLocked(const Grid3DKey& key, float log_odds_update);
+
+		/// Same as updateNodeLocked() for all cells of ray, but locks a shard only once per run of consecutive cells in it
+		void updateNodesLocked(const KeyRay& ray, float log_odds_update);
+
+		/*
+		 * Kernels of the whole-map passes, run by the storage over its nodes
+		 * (see transformNodes() and reduceNodes() of the storages). The values
+		 * to set are converted to the node's data type once, so the per-cell
+		 * work is a comparison and a select without branches, which the
+		 * compiler vectorizes on the dense storages.
+		 */
+		typedef typename NODE::DataType DataType;
+
+		/// sets a node to the clamping threshold on its side of the occupancy threshold
+		struct MaxLikelihoodOp {
+			float occ_thres;
+			DataType occupied, free;
+			inline void operator()(NODE& node) const {
+				node.setValue(node.getLogOdds() >= occ_thres ? occupied : free);
+			}
+		};
+
+		/// clamps a node to the clamping thresholds
+		struct ClampingOp {
+			float thres_min, thres_max;
+			DataType value_min, value_max;
+			inline void operator()(NODE& node) const {
+				float log_odds = node.getLogOdds();
+				node.setValue(log_odds < thres_min ? value_min : (log_odds > thres_max ? value_max : node.getValue()));
+			}
+		};
+
+		/// counts the known and the occupied cells of a run of up to 64 cells
+		struct StatisticsOp {
+			float occ_thres;
+			size_t num_known, num_occupied;
+			inline void operator()(const NODE* nodes, unsigned int count, uint64_t known) {
+				unsigned int occupied = 0;
+				if (count == 64 && known == ~(uint64_t)0) {
+					for (unsigned int i = 0; i < 64; i++)
+						occupied += (unsigned int)(nodes[i].getLogOdds() >= occ_thres);
+					num_known += 64;
+				}
+				else {
+					for (unsigned int i = 0; i < count; i++) {
+						unsigned int is_known = (unsigned int)(known >> i) & 1u;
+						occupied += is_known & (unsigned int)(nodes[i].getLogOdds() >= occ_thres);
+						num_known += is_known;
+					}
+				}
+				num_occupied += occupied;
+			}
+			void merge(const StatisticsOp& other) {
+				num_known += other.num_known;
+				num_occupied += other.num_occupied;
+			}
+		};
+
+		/// histogram of the log-odds of the known cells of a run of up to 64 cells
+		struct HistogramOp {
+			float thres_min, bin_scale;
+			std::vector<size_t> bins;
+			inline void operator()(const NODE* nodes, unsigned int count, uint64_t known) {
+				for (unsigned int i = 0; i < count; i++) {
+					int bin = (int)((nodes[i].getLogOdds() - thres_min) * bin_scale);
+					bin = std::max(0, std::min(bin, (int)bins.size() - 1));
+					bins[bin] += (size_t)(known >> i) & 1;
+				}
+			}
+			void merge(const HistogramOp& other) {
+				for (size_t i = 0; i < bins.size(); i++)
+					bins[i] += other.bins[i];
+			}
+		};
+
 	protected:
 		bool use_bbx_limit;  ///< use bounding box for queries (needs to be set)?
 		point3d bbx_min;
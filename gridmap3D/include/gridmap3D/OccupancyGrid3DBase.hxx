@@ -36,33 +36,33 @@
 
 namespace gridmap3D {
 
-	template <class NODE>
-	OccupancyGrid3DBase<NODE>::OccupancyGrid3DBase(double in_resolution)
-		: Grid3DBaseImpl<NODE, AbstractOccupancyGrid3D>(in_resolution), use_bbx_limit(false), use_change_detection(false)
+	template <class NODE, class S>
+	OccupancyGrid3DBase<NODE, S>::OccupancyGrid3DBase(double in_resolution)
+		: Grid3DBaseImpl<NODE, typename Grid3DOccupancyInterface<NODE>::type, S>(in_resolution), use_bbx_limit(false), use_change_detection(false)
 	{
 		if (this->gridmap == NULL)
-			this->gridmap = new typename Grid3DBaseImpl<NODE, AbstractOccupancyGrid3D>::OccupancyGridMap;
+			this->gridmap = new typename Grid3DBaseImpl<NODE, typename Grid3DOccupancyInterface<NODE>::type, S>::OccupancyGridMap;
 	}
 
-	template <class NODE>
-	OccupancyGrid3DBase<NODE>::OccupancyGrid3DBase(double in_resolution, unsigned int in_grid_max_val)
-		: Grid3DBaseImpl<NODE, AbstractOccupancyGrid3D>(in_resolution, in_grid_max_val), use_bbx_limit(false), use_change_detection(false)
+	template <class NODE, class S>
+	OccupancyGrid3DBase<NODE, S>::OccupancyGrid3DBase(double in_resolution, unsigned int in_grid_max_val)
+		: Grid3DBaseImpl<NODE, typename Grid3DOccupancyInterface<NODE>::type, S>(in_resolution, in_grid_max_val), use_bbx_limit(false), use_change_detection(false)
 	{
 		if (this->gridmap == NULL)
-			this->gridmap = new typename Grid3DBaseImpl<NODE, AbstractOccupancyGrid3D>::OccupancyGridMap;
+			this->gridmap = new typename Grid3DBaseImpl<NODE, typename Grid3DOccupancyInterface<NODE>::type, S>::OccupancyGridMap;
 	}
 
-	template <class NODE>
-	OccupancyGrid3DBase<NODE>::~OccupancyGrid3DBase(){
+	template <class NODE, class S>
+	OccupancyGrid3DBase<NODE, S>::~OccupancyGrid3DBase(){
 		if (this->gridmap){
 			delete this->gridmap;
 			this->gridmap = NULL;
 		}
 	}
 
-	template <class NODE>
-	OccupancyGrid3DBase<NODE>::OccupancyGrid3DBase(const OccupancyGrid3DBase<NODE>& rhs) :
-		Grid3DBaseImpl<NODE, AbstractOccupancyGrid3D>(rhs), use_bbx_limit(rhs.use_bbx_limit),
+	template <class NODE, class S>
+	OccupancyGrid3DBase<NODE, S>::OccupancyGrid3DBase(const OccupancyGrid3DBase<NODE, S>& rhs) :
+		Grid3DBaseImpl<NODE, typename Grid3DOccupancyInterface<NODE>::type, S>(rhs), use_bbx_limit(rhs.use_bbx_limit),
 		bbx_min(rhs.bbx_min), bbx_max(rhs.bbx_max),
 		bbx_min_key(rhs.bbx_min_key), bbx_max_key(rhs.bbx_max_key),
 		use_change_detection(rhs.use_change_detection), changed_keys(rhs.changed_keys)
@@ -74,8 +74,8 @@ namespace gridmap3D {
 		this->occ_prob_thres_log = rhs.occ_prob_thres_log;
 	}
 
-	template <class NODE>
-	void OccupancyGrid3DBase<NODE>::insertPointCloudRays(const Pointcloud& pc, const point3d& origin, double maxrange) {
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::insertPointCloudRays(const Pointcloud& pc, const point3d& origin, double maxrange) {
 		if (pc.size() < 1)
 			return;
 
@@ -92,40 +92,42 @@ namespace gridmap3D {
 			KeyRay* keyray = &(this->keyrays.at(threadIdx));
 
 			if (this->computeRayKeys(origin, p, *keyray)){
+				if (Grid3DStorageTraits<S>::concurrent) {
+					// the storage locks the shards of the cells, no need to serialize the rays
+					updateNodesLocked(*keyray, this->prob_miss_log); // insert freespace measurement
+					Grid3DKey key;
+					if (this->coordToKeyChecked(p, key))
+						updateNodeLocked(key, this->prob_hit_log); // update endpoint to be occupied
+				}
+				else {
 #ifdef _OPENMP
 #pragma omp critical
 #endif
-				{
-					for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
-						updateNode(*it, false); // insert freespace measurement
+					{
+						for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
+							updateNode(*it, false); // insert freespace measurement
+						}
+						updateNode(p, true); // update endpoint to be occupied
 					}
-					updateNode(p, true); // update endpoint to be occupied
 				}
 			}
 
 		}
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid3DBase<NODE>::setNodeValue(const Grid3DKey& key, float log_odds_value) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid3DBase<NODE, S>::setNodeValue(const Grid3DKey& key, float log_odds_value) {
 		// clamp log odds within range:
 		log_odds_value = std::min(std::max(log_odds_value, this->clamping_thres_min), this->clamping_thres_max);
 
-		typename Grid3DBaseImpl<NODE, AbstractOccupancyGrid3D>::OccupancyGridMap::iterator cell = this->gridmap->find(key);
-		if (cell == this->gridmap->end()){
-			NODE* node = new NODE();
+		NODE* node = this->gridmap->createNode(key);
+		if (node)
 			node->setLogOdds(log_odds_value);
-			this->gridmap->insert(std::pair<Grid3DKey, NODE*>(key, node));
-			return node;
-		}
-		else{
-			(cell->second)->setLogOdds(log_odds_value);
-			return cell->second;
-		}
+		return node;
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid3DBase<NODE>::setNodeValue(const point3d& value, float log_odds_value) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid3DBase<NODE, S>::setNodeValue(const point3d& value, float log_odds_value) {
 		Grid3DKey key;
 		if (!this->coordToKeyChecked(value, key))
 			return NULL;
@@ -133,8 +135,8 @@ namespace gridmap3D {
 		return setNodeValue(key, log_odds_value);
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid3DBase<NODE>::setNodeValue(double x, double y, double z, float log_odds_value) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid3DBase<NODE, S>::setNodeValue(double x, double y, double z, float log_odds_value) {
 		Grid3DKey key;
 		if (!this->coordToKeyChecked(x, y, z, key))
 			return NULL;
@@ -143,8 +145,8 @@ namespace gridmap3D {
 	}
 
 
-	template <class NODE>
-	NODE* OccupancyGrid3DBase<NODE>::updateNode(const Grid3DKey& key, float log_odds_update) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid3DBase<NODE, S>::updateNode(const Grid3DKey& key, float log_odds_update) {
 		// early abort (no change will happen).
 		// may cause an overhead in some configuration, but more often helps
 		NODE* node = this->search(key);
@@ -156,17 +158,41 @@ namespace gridmap3D {
 			return node;
 		}
 
-		if (!node){
-			node = new NODE();
-			this->gridmap->insert(std::pair<Grid3DKey, NODE*>(key, node));
+		if (!node) {
+			// the storage may not hold the cell (e.g., outside a rolling window)
+			node = this->gridmap->createNode(key);
+			if (!node)
+				return NULL;
 		}
 		node->addValue(log_odds_update);
 
 		return node;
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid3DBase<NODE>::updateNode(const point3d& value, float log_odds_update) {
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::updateNodeLocked(const Grid3DKey& key, float log_odds_update) {
+		unsigned int shard = Grid3DStorageTraits<S>::shard(*this->gridmap, key);
+		Grid3DStorageTraits<S>::lock(*this->gridmap, shard);
+		updateNode(key, log_odds_update);
+		Grid3DStorageTraits<S>::unlock(*this->gridmap, shard);
+	}
+
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::updateNodesLocked(const KeyRay& ray, float log_odds_update) {
+		KeyRay::const_iterator it = ray.begin();
+		while (it != ray.end()) {
+			// keep the lock for the following cells of the ray in the same shard
+			unsigned int shard = Grid3DStorageTraits<S>::shard(*this->gridmap, *it);
+			Grid3DStorageTraits<S>::lock(*this->gridmap, shard);
+			do {
+				updateNode(*it, log_odds_update);
+			} while (++it != ray.end() && Grid3DStorageTraits<S>::shard(*this->gridmap, *it) == shard);
+			Grid3DStorageTraits<S>::unlock(*this->gridmap, shard);
+		}
+	}
+
+	template <class NODE, class S>
+	NODE* OccupancyGrid3DBase<NODE, S>::updateNode(const point3d& value, float log_odds_update) {
 		Grid3DKey key;
 		if (!this->coordToKeyChecked(value, key))
 			return NULL;
@@ -174,8 +200,8 @@ namespace gridmap3D {
 		return updateNode(key, log_odds_update);
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid3DBase<NODE>::updateNode(double x, double y, double z, float log_odds_update) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid3DBase<NODE, S>::updateNode(double x, double y, double z, float log_odds_update) {
 		Grid3DKey key;
 		if (!this->coordToKeyChecked(x, y, z, key))
 			return NULL;
@@ -183,8 +209,8 @@ namespace gridmap3D {
 		return updateNode(key, log_odds_update);
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid3DBase<NODE>::updateNode(const Grid3DKey& key, bool occupied) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid3DBase<NODE, S>::updateNode(const Grid3DKey& key, bool occupied) {
 		float logOdds = this->prob_miss_log;
 		if (occupied)
 			logOdds = this->prob_hit_log;
@@ -192,33 +218,88 @@ namespace gridmap3D {
 		return updateNode(key, logOdds);
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid3DBase<NODE>::updateNode(const point3d& value, bool occupied) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid3DBase<NODE, S>::updateNode(const point3d& value, bool occupied) {
 		Grid3DKey key;
 		if (!this->coordToKeyChecked(value, key))
 			return NULL;
 		return updateNode(key, occupied);
 	}
 
-	template <class NODE>
-	NODE* OccupancyGrid3DBase<NODE>::updateNode(double x, double y, double z, bool occupied) {
+	template <class NODE, class S>
+	NODE* OccupancyGrid3DBase<NODE, S>::updateNode(double x, double y, double z, bool occupied) {
 		Grid3DKey key;
 		if (!this->coordToKeyChecked(x, y, z, key))
 			return NULL;
 		return updateNode(key, occupied);
 	}
 
-	template <class NODE>
-	void OccupancyGrid3DBase<NODE>::toMaxLikelihood() {
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::toMaxLikelihood() {
 		if (this->gridmap == NULL)
 			return;
 
-		for (typename Grid3DBaseImpl<NODE, AbstractOccupancyGrid3D>::OccupancyGridMap::iterator cell = this->gridmap->begin(); cell != this->gridmap->end(); cell++){
-			nodeToMaxLikelihood(cell->second);
-		}
+		NODE node;
+		MaxLikelihoodOp op;
+		op.occ_thres = this->occ_prob_thres_log;
+		node.setLogOdds(this->clamping_thres_max);
+		op.occupied = node.getValue();
+		node.setLogOdds(this->clamping_thres_min);
+		op.free = node.getValue();
+		this->gridmap->transformNodes(op);
 	}
 
-/*	template <class NODE>
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::updateClamping() {
+		if (this->gridmap == NULL)
+			return;
+
+		NODE node;
+		ClampingOp op;
+		op.thres_min = this->clamping_thres_min;
+		op.thres_max = this->clamping_thres_max;
+		node.setLogOdds(this->clamping_thres_min);
+		op.value_min = node.getValue();
+		node.setLogOdds(this->clamping_thres_max);
+		op.value_max = node.getValue();
+		this->gridmap->transformNodes(op);
+	}
+
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::getOccupancyStatistics(size_t& num_free, size_t& num_occupied, size_t& num_unknown) const {
+		num_free = num_occupied = num_unknown = 0;
+		if (this->gridmap == NULL || this->gridmap->size() == 0)
+			return;
+
+		StatisticsOp op;
+		op.occ_thres = this->occ_prob_thres_log;
+		op.num_known = op.num_occupied = 0;
+		this->gridmap->reduceNodes(op);
+		num_occupied = op.num_occupied;
+		num_free = op.num_known - op.num_occupied;
+
+		const Grid3DKeyBounds& bounds = this->gridmap->getKeyBounds();
+		size_t volume = 1;
+		for (unsigned int i = 0; i < 3; i++)
+			volume *= (size_t)(bounds.getMax()[i] - bounds.getMin()[i]) + 1;
+		num_unknown = volume - op.num_known;
+	}
+
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::getOccupancyHistogram(std::vector<size_t>& histogram, unsigned int num_bins) const {
+		histogram.assign(num_bins, 0);
+		if (this->gridmap == NULL || num_bins == 0)
+			return;
+
+		HistogramOp op;
+		op.thres_min = this->clamping_thres_min;
+		op.bin_scale = num_bins / (this->clamping_thres_max - this->clamping_thres_min);
+		op.bins.assign(num_bins, 0);
+		this->gridmap->reduceNodes(op);
+		histogram.swap(op.bins);
+	}
+
+/*	template <class NODE, class S>
 	bool OccupancyQuadTreeBase<NODE>::getNormals(const point3d& point, std::vector<point3d>& normals,
 		bool unknownStatus) const {
 		normals.clear();
@@ -307,15 +388,15 @@ namespace gridmap3D {
 		return true;
 	}*/
 
-	template <class NODE>
-	bool OccupancyGrid3DBase<NODE>::castRay(const point3d& origin, const point3d& directionP, point3d& end,
+	template <class NODE, class S>
+	bool OccupancyGrid3DBase<NODE, S>::castRay(const point3d& origin, const point3d& directionP, point3d& end,
 		bool ignoreUnknown, double maxRange) const {
 
 		/// ----------  see Grid3DBase::computeRayKeys  -----------
 
 		// Initialization phase -------------------------------------------------------
 		Grid3DKey current_key;
-		if (!Grid3DBaseImpl<NODE, AbstractOccupancyGrid3D>::coordToKeyChecked(origin, current_key)) {
+		if (!Grid3DBaseImpl<NODE, typename Grid3DOccupancyInterface<NODE>::type, S>::coordToKeyChecked(origin, current_key)) {
 			GRIDMAP3D_WARNING_STR("Coordinates out of bounds during ray casting");
 			return false;
 		}
@@ -370,6 +451,17 @@ namespace gridmap3D {
 		// for speedup:
 		double maxrange_sq = maxRange * maxRange;
 
+		// An ignored unknown cell may lie in a block of unknown cells (see
+		// Grid3DStorageTraits::unknownBlockBits()), which needs no lookup: the ray
+		// jumps to the last cell of it that it crosses, or steps through it without
+		// lookups if the block reaches beyond maxRange. Keys in the block share the
+		// bits of block_key in block_mask.
+		Grid3DKey block_key = current_key;
+		unsigned int block_bits = startingNode ? 0 : Grid3DStorageTraits<S>::unknownBlockBits(*this->gridmap, current_key);
+		unsigned int block_mask = ~((1u << block_bits) - 1);
+		if (block_bits > 0 && (!max_range_set || rayBlockInRange(origin, block_key, block_bits, maxrange_sq)))
+			skipRayBlock(current_key, step, tMax, tDelta, block_bits);
+
 		// Incremental phase  ---------------------------------------------------------
 
 		bool done = false;
@@ -416,6 +508,10 @@ namespace gridmap3D {
 
 			}
 
+			// still inside the current unknown block
+			if ((((current_key[0] ^ block_key[0]) | (current_key[1] ^ block_key[1]) | (current_key[2] ^ block_key[2])) & block_mask) == 0)
+				continue;
+
 			NODE* currentNode = this->search(current_key);
 			if (currentNode){
 				if (this->isNodeOccupied(currentNode)) {
@@ -427,13 +523,98 @@ namespace gridmap3D {
 			else if (!ignoreUnknown){ // no node found, this usually means we are in "unknown" areas
 				return false;
 			}
+			else {
+				block_key = current_key;
+				block_bits = Grid3DStorageTraits<S>::unknownBlockBits(*this->gridmap, current_key);
+				block_mask = ~((1u << block_bits) - 1);
+				if (block_bits > 0 && (!max_range_set || rayBlockInRange(origin, block_key, block_bits, maxrange_sq)))
+					skipRayBlock(current_key, step, tMax, tDelta, block_bits);
+			}
 		} // end while
 
 		return true;
 	}
 
-	template <class NODE>
-	bool OccupancyGrid3DBase<NODE>::getRayIntersection(const point3d& origin, const point3d& direction, const point3d& center,
+	template <class NODE, class S>
+	bool OccupancyGrid3DBase<NODE, S>::rayBlockInRange(const point3d& origin, const Grid3DKey& key, unsigned int bits,
+		double maxrange_sq) const {
+		// castRay() tests the voxel centers, the farthest one from origin is in a corner of the block
+		const unsigned int block_max = (1u << bits) - 1;
+		double dist_from_origin_sq(0.0);
+		for (unsigned int j = 0; j < 3; j++) {
+			float low = float(this->keyToCoord((key_type)(key[j] & ~block_max))) - origin(j);
+			float high = float(this->keyToCoord((key_type)(key[j] | block_max))) - origin(j);
+			dist_from_origin_sq += std::max(low * low, high * high);
+		}
+		return dist_from_origin_sq <= maxrange_sq;
+	}
+
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::skipRayBlock(Grid3DKey& key, const int step[3], double tMax[3], const double tDelta[3],
+		unsigned int bits) {
+		const unsigned int block_max = (1u << bits) - 1;
+
+		// The ray leaves the block in the dimension whose boundary after the last voxel
+		// of the block it crosses first (the higher dimension on ties, as castRay() picks
+		// it). tMax is summed up step by step as in castRay() to reach the same voxels.
+		double tExit[3];
+		unsigned int exit_dim = 3;
+		for (unsigned int i = 0; i < 3; ++i) {
+			if (step[i] == 0)
+				continue;
+			unsigned int steps = (step[i] > 0) ? block_max - (key[i] & block_max) : (key[i] & block_max);
+			tExit[i] = tMax[i];
+			for (unsigned int s = 0; s < steps; ++s)
+				tExit[i] += tDelta[i];
+			if (exit_dim == 3 || tExit[i] <= tExit[exit_dim])
+				exit_dim = i;
+		}
+
+		// the other dimensions advance as far as they get before that crossing
+		for (unsigned int i = 0; i < 3; ++i) {
+			if (step[i] == 0)
+				continue;
+			if (i == exit_dim) {
+				key[i] = (key_type)((step[i] > 0) ? (key[i] | block_max) : (key[i] & ~block_max));
+				tMax[i] = tExit[i];
+			}
+			else {
+				while (tMax[i] < tExit[exit_dim] || (tMax[i] == tExit[exit_dim] && i > exit_dim)) {
+					key[i] += step[i];
+					tMax[i] += tDelta[i];
+				}
+			}
+		}
+	}
+
+	template <class NODE, class S>
+	size_t OccupancyGrid3DBase<NODE, S>::castRays(const std::vector<point3d>& origins, const std::vector<point3d>& directions,
+		std::vector<point3d>& ends, std::vector<double>& distances,
+		bool ignoreUnknown, double maxRange) const {
+		if (origins.size() != directions.size()) {
+			GRIDMAP3D_ERROR("castRays: %zu origins, but %zu directions given\n", origins.size(), directions.size());
+			return 0;
+		}
+		ends.resize(origins.size());
+		distances.resize(origins.size());
+
+		size_t num_hits = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64) reduction(+ : num_hits)
+#endif
+		for (int i = 0; i < (int)origins.size(); ++i) {
+			if (castRay(origins[i], directions[i], ends[i], ignoreUnknown, maxRange)) {
+				distances[i] = (ends[i] - origins[i]).norm();
+				num_hits++;
+			}
+			else
+				distances[i] = -1.0;
+		}
+		return num_hits;
+	}
+
+	template <class NODE, class S>
+	bool OccupancyGrid3DBase<NODE, S>::getRayIntersection(const point3d& origin, const point3d& direction, const point3d& center,
 		point3d& intersection, double delta) const {
 		// We only need three normals for the six planes
 		gridmap3D::point3d normalX(1, 0, 0);
@@ -520,8 +701,8 @@ namespace gridmap3D {
 		return found;
 	}
 
-	template <class NODE> inline bool
-		OccupancyGrid3DBase<NODE>::integrateMissOnRay(const point3d& origin, const point3d& end) {
+	template <class NODE, class S> inline bool
+		OccupancyGrid3DBase<NODE, S>::integrateMissOnRay(const point3d& origin, const point3d& end) {
 
 		if (!this->computeRayKeys(origin, end, this->keyrays.at(0))) {
 			return false;
@@ -534,8 +715,8 @@ namespace gridmap3D {
 		return true;
 	}
 
-	template <class NODE> bool
-		OccupancyGrid3DBase<NODE>::insertRay(const point3d& origin, const point3d& end, double maxrange)
+	template <class NODE, class S> bool
+		OccupancyGrid3DBase<NODE, S>::insertRay(const point3d& origin, const point3d& end, double maxrange)
 	{
 		// cut ray at maxrange
 		if ((maxrange > 0) && ((end - origin).norm() > maxrange))
@@ -554,43 +735,43 @@ namespace gridmap3D {
 		}
 	}
 
-	template <class NODE>
-	void OccupancyGrid3DBase<NODE>::setBBXMin(point3d& min) {
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::setBBXMin(point3d& min) {
 		bbx_min = min;
 		if (!this->coordToKeyChecked(bbx_min, bbx_min_key)) {
 			GRIDMAP3D_ERROR("ERROR while generating bbx min key.\n");
 		}
 	}
 
-	template <class NODE>
-	void OccupancyGrid3DBase<NODE>::setBBXMax(point3d& max) {
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::setBBXMax(point3d& max) {
 		bbx_max = max;
 		if (!this->coordToKeyChecked(bbx_max, bbx_max_key)) {
 			GRIDMAP3D_ERROR("ERROR while generating bbx max key.\n");
 		}
 	}
 
-	template <class NODE>
-	bool OccupancyGrid3DBase<NODE>::inBBX(const point3d& p) const {
+	template <class NODE, class S>
+	bool OccupancyGrid3DBase<NODE, S>::inBBX(const point3d& p) const {
 		return ((p.x() >= bbx_min.x()) && (p.y() >= bbx_min.y()) && (p.z() >= bbx_min.z()) &&
 			(p.x() <= bbx_max.x()) && (p.y() <= bbx_max.y()) && (p.z() <= bbx_max.z()));
 	}
 
-	template <class NODE>
-	bool OccupancyGrid3DBase<NODE>::inBBX(const Grid3DKey& key) const {
+	template <class NODE, class S>
+	bool OccupancyGrid3DBase<NODE, S>::inBBX(const Grid3DKey& key) const {
 		return ((key[0] >= bbx_min_key[0]) && (key[1] >= bbx_min_key[1]) && (key[2] >= bbx_min_key[2]) &&
 			(key[0] <= bbx_max_key[0]) && (key[1] <= bbx_max_key[1]) && (key[2] <= bbx_max_key[2]));
 	}
 
-	template <class NODE>
-	point3d OccupancyGrid3DBase<NODE>::getBBXBounds() const {
+	template <class NODE, class S>
+	point3d OccupancyGrid3DBase<NODE, S>::getBBXBounds() const {
 		gridmap3D::point3d obj_bounds = (bbx_max - bbx_min);
 		obj_bounds /= 2.;
 		return obj_bounds;
 	}
 
-	template <class NODE>
-	point3d OccupancyGrid3DBase<NODE>::getBBXCenter() const {
+	template <class NODE, class S>
+	point3d OccupancyGrid3DBase<NODE, S>::getBBXCenter() const {
 		gridmap3D::point3d obj_bounds = (bbx_max - bbx_min);
 		obj_bounds /= 2.;
 		return bbx_min + obj_bounds;
@@ -599,8 +780,8 @@ namespace gridmap3D {
 	
 	//-- Occupancy queries on nodes:
 
-	template <class NODE>
-	void OccupancyGrid3DBase<NODE>::updateNodeLogOdds(NODE* occupancyNode, const float& update) const {
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::updateNodeLogOdds(NODE* occupancyNode, const float& update) const {
 		occupancyNode->addValue(update);
 		if (occupancyNode->getLogOdds() < this->clamping_thres_min) {
 			occupancyNode->setLogOdds(this->clamping_thres_min);
@@ -611,34 +792,34 @@ namespace gridmap3D {
 		}
 	}
 
-	template <class NODE>
-	void OccupancyGrid3DBase<NODE>::integrateHit(NODE* occupancyNode) const {
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::integrateHit(NODE* occupancyNode) const {
 		updateNodeLogOdds(occupancyNode, this->prob_hit_log);
 	}
 
-	template <class NODE>
-	void OccupancyGrid3DBase<NODE>::integrateMiss(NODE* occupancyNode) const {
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::integrateMiss(NODE* occupancyNode) const {
 		updateNodeLogOdds(occupancyNode, this->prob_miss_log);
 	}
 
-	template <class NODE>
-	void OccupancyGrid3DBase<NODE>::nodeToMaxLikelihood(NODE* occupancyNode) const{
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::nodeToMaxLikelihood(NODE* occupancyNode) const{
 		if (this->isNodeOccupied(occupancyNode))
 			occupancyNode->setLogOdds(this->clamping_thres_max);
 		else
 			occupancyNode->setLogOdds(this->clamping_thres_min);
 	}
 
-	template <class NODE>
-	void OccupancyGrid3DBase<NODE>::nodeToMaxLikelihood(NODE& occupancyNode) const{
+	template <class NODE, class S>
+	void OccupancyGrid3DBase<NODE, S>::nodeToMaxLikelihood(NODE& occupancyNode) const{
 		if (this->isNodeOccupied(occupancyNode))
 			occupancyNode.setLogOdds(this->clamping_thres_max);
 		else
 			occupancyNode.setLogOdds(this->clamping_thres_min);
 	}
 
-	template <class NODE>
-	std::istream& OccupancyGrid3DBase<NODE>::readBinaryData(std::istream &s){
+	template <class NODE, class S>
+	std::istream& OccupancyGrid3DBase<NODE, S>::readBinaryData(std::istream &s){
 		if (this->size() > 0) {
 			GRIDMAP3D_ERROR_STR("Trying to read into an existing grid.");
 			return s;
@@ -658,12 +839,7 @@ namespace gridmap3D {
 				std::bitset<8> binary_occupancy((unsigned long long) binary_occupancy_char);	// 1: occupied, 0: free
 
 				for(unsigned int j = 0; j < 8; j++){
-					Grid3DNode* new_node = new Grid3DNode();
-					if(binary_occupancy[j] == 1)
-						new_node->setLogOdds(this->clamping_thres_max);
-					else
-						new_node->setLogOdds(this->clamping_thres_min);
-					this->gridmap->insert(std::pair<Grid3DKey, Grid3DNode*>(key_list[j], new_node));
+					this->setNodeValue(key_list[j], binary_occupancy[j] == 1 ? this->clamping_thres_max : this->clamping_thres_min);
 				}
 			}
 		}
@@ -673,13 +849,8 @@ namespace gridmap3D {
 			s.read((char*)&binary_occupancy_char, sizeof(char));
 			std::bitset<8> binary_occupancy((unsigned long long) binary_occupancy_char);	// 1: occupied, 0: free
 
-			for(unsigned int j = 0; j <= (number_of_cells % 8); j++){
-				Grid3DNode* new_node = new Grid3DNode();
-				if(binary_occupancy[j] == 1)
-					new_node->setLogOdds(this->clamping_thres_max);
-				else
-					new_node->setLogOdds(this->clamping_thres_min);
-				this->gridmap->insert(std::pair<Grid3DKey, Grid3DNode*>(key_list[j], new_node));
+			for(unsigned int j = 0; j < (number_of_cells % 8); j++){
+				this->setNodeValue(key_list[j], binary_occupancy[j] == 1 ? this->clamping_thres_max : this->clamping_thres_min);
 			}
 		}
 
@@ -688,14 +859,14 @@ namespace gridmap3D {
 		return s;
 	}
 
-	template <class NODE>
-	std::ostream& OccupancyGrid3DBase<NODE>::writeBinaryData(std::ostream &s) const{
+	template <class NODE, class S>
+	std::ostream& OccupancyGrid3DBase<NODE, S>::writeBinaryData(std::ostream &s) const{
 		GRIDMAP3D_DEBUG("Writing %zu nodes to output stream...", this->size());
 
 		size_t number_of_cells = this->size();
 		s.write((char*)&number_of_cells, sizeof(number_of_cells));
 
-		typename OccupancyGrid3DBase<NODE>::OccupancyGridMap::iterator it = this->gridmap->begin();
+		typename OccupancyGrid3DBase<NODE, S>::OccupancyGridMap::iterator it = this->gridmap->begin();
 		std::bitset<8> binary_occupancy;	// 1: occupied, 0: free
 		for(size_t i = 0; i < number_of_cells; i++, it++){
 			s.write((char*) it->first.k, sizeof(it->first.k));
@@ -35,4 +35,5 @@
 #include "Pointcloud.h"
 #include "ScanGraph.h"
 #include "Grid3D.h"
+#include "Grid3DQuantizedNode.h"
 
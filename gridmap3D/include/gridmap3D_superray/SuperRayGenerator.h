@@ -70,7 +70,9 @@ namespace gridmap3D{
 		double GenerateMappingLine(VoxelInfo& _voxelinfo, const unsigned int& _axisX, const unsigned int& _axisY, std::vector<double>& _mappingPlane);
 
 		// Utility functions
-		typedef unordered_ns::unordered_map<Grid3DKey, std::vector<point3d>, Grid3DKey::KeyHash> Voxelized_Pointclouds;
+		// The maps apply the super rays in the iteration order of this map (with clamping),
+		// so its hash stays fixed to keep the map results independent of the default KeyHash
+		typedef unordered_ns::unordered_map<Grid3DKey, std::vector<point3d>, Grid3DKey::LinearKeyHash> Voxelized_Pointclouds;
 		void ComputeAxis(const point3d& _min, const point3d& _max, Axis3D& _axis);
 
 		// Re-implmentation for Key / coordinate conversion functions
@@ -31,10 +31,10 @@
 #define GRIDMAP3D_SUPERRAY_GRID3D_H
 
 #include <gridmap3D/gridmap3D.h>
-#include <gridmap3D_superray/SuperRayGenerator.h>
+#include <gridmap3D_superray/SuperRayGrid3DBase.h>
 
 namespace gridmap3D{
-	class SuperRayGrid3D : public OccupancyGrid3DBase<Grid3DNode> {
+	class SuperRayGrid3D : public SuperRayGrid3DBase<Grid3DNode> {
 	public:
 		/// Default constructor, sets resolution of grid
 		SuperRayGrid3D(double resolution);
@@ -44,7 +44,7 @@ namespace gridmap3D{
 		 * @param _filename
 		 *
 		 */
-		// SuperRayGrid3D(std::string _filename);
+		SuperRayGrid3D(std::string _filename);
 
 		virtual ~SuperRayGrid3D(){};
 
@@ -54,38 +54,6 @@ namespace gridmap3D{
 
 		std::string getGridType() const { return "SuperRayGrid3D"; }
 
-		// Super Ray based Updates
-
-		/**
-		 * Integrate a Pointcloud (in global reference frame), parallelized with OpenMP.
-		 * This function simply inserts all rays of the point clouds, similar to insertPointCloudRays of gridmap3D::Grid3D.
-		 * Occupied nodes have a preference over free ones.
-		 *
-		 * @param scan Pointcloud (measurement endpoints), in global reference frame
-		 * @param sensor_origin measurement origin in global reference frame
-		 */
-		virtual void insertPointCloudRays(const Pointcloud& scan, const point3d& origin);
-
-		/**
-		 * Integrate a Pointcloud (in global reference frame) using SuperRay, parallelized with OpenMP.
-		 * This function converts a point clouds into superrays, and then inserts all superrays out of the point clouds.
-		 * Occupied nodes have a preference over free ones.
-		 *
-		 * @param scan Pointcloud (measurement endpoints), in global reference frame
-		 * @param sensor_origin measurement origin in global reference frame
-		 * @param threshold threshold for limiting to generate super rays
-		 */
-		virtual void insertSuperRayCloudRays(const Pointcloud& scan, const point3d& origin, const int threshold);
-
-		/**
-		 * Integrate a SuperRayCloud (in global reference frame), parallelized with OpenMP.
-		 * This function inserts all superrays out of a point clouds.
-		 * Occupied nodes have a preference over free ones.
-		 *
-		 * @param superray SuperRayCloud (generated by a point clouds and a origin), in global reference frame
-		 */
-		virtual void insertSuperRayCloudRays(const SuperRayCloud& superray);
-
 	protected:
 		/**
 		 * Static member object which ensures that this Grid3D's prototype
@@ -112,6 +80,49 @@ namespace gridmap3D{
 		/// static member to ensure static initialization (only once)
 		static StaticMemberInitializer superrayGrid3DMemberInit;
 	};
+
+	/**
+	 * SuperRayGrid3D with the cells in a Grid3DBlockStorage: less memory and faster
+	 * updates and iteration than the hash storage of SuperRayGrid3D.
+	 *
+	 * \note getGrid() returns the block storage, which has no find() or count();
+	 * use search() to look up cells.
+	 */
+	class SuperRayBlockGrid3D : public SuperRayGrid3DBase<Grid3DNode, Grid3DBlockStorage<Grid3DNode> > {
+	public:
+		/// Default constructor, sets resolution of grid
+		SuperRayBlockGrid3D(double resolution);
+
+		/**
+		 * Reads a Grid3D from a binary file
+		 * @param _filename
+		 *
+		 */
+		SuperRayBlockGrid3D(std::string _filename);
+
+		virtual ~SuperRayBlockGrid3D(){};
+
+		/// virtual constructor: creates a new object of same type
+		/// (Covariant return type requires an up-to-date compiler)
+		SuperRayBlockGrid3D* create() const { return new SuperRayBlockGrid3D(resolution); }
+
+		std::string getGridType() const { return "SuperRayBlockGrid3D"; }
+
+	protected:
+		/// Registers the prototype of this grid type, see SuperRayGrid3D::StaticMemberInitializer
+		class StaticMemberInitializer{
+		public:
+			StaticMemberInitializer() {
+				SuperRayBlockGrid3D* grid = new SuperRayBlockGrid3D(0.1);
+				grid->clearKeyRays();
+				AbstractGrid3D::registerGridType(grid);
+			}
+
+			void ensureLinking() {};
+		};
+		/// static member to ensure static initialization (only once)
+		static StaticMemberInitializer superrayBlockGrid3DMemberInit;
+	};
 }
 
 #endif
@@ -0,0 +1,92 @@
+/*
+* Copyright(c) 2016, Youngsun Kwon, Donghyuk Kim, and Sung-eui Yoon, KAIST
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met :
+*
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and / or other materials provided with the distribution.
+*     * Neither the name of SuperRay nor the names of its
+*       contributors may be used to endorse or promote products derived from
+*       this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef GRIDMAP3D_SUPERRAY_GRID3D_BASE_H
+#define GRIDMAP3D_SUPERRAY_GRID3D_BASE_H
+
+#include <gridmap3D/OccupancyGrid3DBase.h>
+#include <gridmap3D_superray/SuperRayGenerator.h>
+
+namespace gridmap3D{
+	/**
+	 * Super ray based updates on top of OccupancyGrid3DBase, for any occupancy
+	 * node (Grid3DNode or the fixed-point Grid3DNode8 and Grid3DNode16) and
+	 * any storage policy. SuperRayGrid3D is the map with Grid3DNode cells in the
+	 * default hash storage. SuperRayBlockGrid3D, i.e.
+	 * SuperRayGrid3DBase<Grid3DNode, Grid3DBlockStorage<Grid3DNode> >, keeps them in
+	 * dense blocks instead, which is smaller and faster for ray casting.
+	 *
+	 * \tparam NODE Occupancy node class
+	 * \tparam STORAGE Storage policy of the cells
+	 */
+	template <class NODE, class STORAGE = Grid3DHashStorage<NODE> >
+	class SuperRayGrid3DBase : public OccupancyGrid3DBase<NODE, STORAGE> {
+	public:
+		/// Default constructor, sets resolution of grid
+		SuperRayGrid3DBase(double resolution);
+
+		virtual ~SuperRayGrid3DBase(){};
+
+		// Super Ray based Updates
+
+		/**
+		 * Integrate a Pointcloud (in global reference frame), parallelized with OpenMP.
+		 * This function simply inserts all rays of the point clouds, similar to insertPointCloudRays of gridmap3D::Grid3D.
+		 * Occupied nodes have a preference over free ones.
+		 *
+		 * @param scan Pointcloud (measurement endpoints), in global reference frame
+		 * @param sensor_origin measurement origin in global reference frame
+		 */
+		virtual void insertPointCloudRays(const Pointcloud& scan, const point3d& origin);
+
+		/**
+		 * Integrate a Pointcloud (in global reference frame) using SuperRay, parallelized with OpenMP.
+		 * This function converts a point clouds into superrays, and then inserts all superrays out of the point clouds.
+		 * Occupied nodes have a preference over free ones.
+		 *
+		 * @param scan Pointcloud (measurement endpoints), in global reference frame
+		 * @param sensor_origin measurement origin in global reference frame
+		 * @param threshold threshold for limiting to generate super rays
+		 */
+		virtual void insertSuperRayCloudRays(const Pointcloud& scan, const point3d& origin, const int threshold);
+
+		/**
+		 * Integrate a SuperRayCloud (in global reference frame), parallelized with OpenMP.
+		 * This function inserts all superrays out of a point clouds.
+		 * Occupied nodes have a preference over free ones.
+		 *
+		 * @param superray SuperRayCloud (generated by a point clouds and a origin), in global reference frame
+		 */
+		virtual void insertSuperRayCloudRays(const SuperRayCloud& superray);
+	};
+}
+
+#include "gridmap3D_superray/SuperRayGrid3DBase.hxx"
+
+#endif
@@ -116,6 +116,80 @@ namespace gridmap3D {
 		return grid;
 	}
 
+	bool AbstractGrid3D::writeBulk(const std::string& filename, bool delta_keys) const{
+		std::ofstream file(filename.c_str(), std::ios_base::out | std::ios_base::binary);
+
+		if (!file.is_open()){
+			GRIDMAP3D_ERROR_STR("Filestream to " << filename << " not open, nothing written.");
+			return false;
+		}
+
+		return writeBulk(file, delta_keys);
+	}
+
+	bool AbstractGrid3D::writeBulk(std::ostream &s, bool delta_keys) const{
+		s << bulkFileHeader << "\n# (feel free to add / change comments, but leave the first line as it is!)\n#\n";
+		s << "id " << getGridType() << std::endl;
+		s << "size " << size() << std::endl;
+		s << "res " << getResolution() << std::endl;
+		s << "data" << std::endl;
+
+		writeBulkData(s, delta_keys);
+
+		if (!s.good()){
+			GRIDMAP3D_WARNING_STR("Output stream not \"good\" after writing grid");
+			return false;
+		}
+		return true;
+	}
+
+	AbstractGrid3D* AbstractGrid3D::readBulk(const std::string& filename){
+		std::ifstream file(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+
+		if (!file.is_open()){
+			GRIDMAP3D_ERROR_STR("Filestream to " << filename << " not open, nothing read.");
+			return NULL;
+		}
+		else {
+			return readBulk(file);
+		}
+	}
+
+	AbstractGrid3D* AbstractGrid3D::readBulk(std::istream &s){
+
+		// check if first line valid:
+		std::string line;
+		std::getline(s, line);
+		if (line.compare(0, bulkFileHeader.length(), bulkFileHeader) != 0){
+			GRIDMAP3D_ERROR_STR("First line of Grid3D bulk file header does not start with \"" << bulkFileHeader);
+			return NULL;
+		}
+
+		std::string id;
+		unsigned size;
+		double res;
+		if (!AbstractGrid3D::readHeader(s, id, size, res))
+			return NULL;
+
+		GRIDMAP3D_DEBUG_STR("Reading grid type " << id);
+
+		AbstractGrid3D* grid = createGrid(id, res);
+
+		if (grid){
+			if (size > 0)
+				grid->readBulkData(s);
+
+			if (size != grid->size()){
+				GRIDMAP3D_ERROR("Grid size mismatch: # read nodes (%zu) != # expected nodes (%d)\n", grid->size(), size);
+				delete grid;
+				return NULL;
+			}
+			GRIDMAP3D_DEBUG_STR("Done (" << grid->size() << " nodes)");
+		}
+
+		return grid;
+	}
+
 	bool AbstractGrid3D::readHeader(std::istream& s, std::string& id, unsigned& size, double& res){
 		id = "";
 		size = 0;
@@ -209,4 +283,5 @@ namespace gridmap3D {
 
 
 	const std::string AbstractGrid3D::fileHeader = "# Gridmap3D Grid3D file";
+	const std::string AbstractGrid3D::bulkFileHeader = "# Gridmap3D Grid3D bulk file";
 }
@@ -36,7 +36,7 @@
 #include <gridmap3D/gridmap3D_types.h>
 
 namespace gridmap3D {
-	AbstractOccupancyGrid3D::AbstractOccupancyGrid3D(){
+	AbstractOccupancyGrid3DBase::AbstractOccupancyGrid3DBase(){
 		// some sane default values:
 		setOccupancyThres(0.5);   // = 0.0 in logodds
 		setProbHit(0.7);          // = 0.85 in logodds
@@ -46,7 +46,7 @@ namespace gridmap3D {
 		setClampingThresMax(0.971); // = 3.5 in log odds
 	}
 
-	bool AbstractOccupancyGrid3D::writeBinary(const std::string& filename){
+	bool AbstractOccupancyGrid3DBase::writeBinary(const std::string& filename){
 		std::ofstream binary_outfile(filename.c_str(), std::ios_base::binary);
 
 		if (!binary_outfile.is_open()){
@@ -56,7 +56,7 @@ namespace gridmap3D {
 		return writeBinary(binary_outfile);
 	}
 
-	bool AbstractOccupancyGrid3D::writeBinaryConst(const std::string& filename) const{
+	bool AbstractOccupancyGrid3DBase::writeBinaryConst(const std::string& filename) const{
 		std::ofstream binary_outfile(filename.c_str(), std::ios_base::binary);
 
 		if (!binary_outfile.is_open()){
@@ -68,13 +68,13 @@ namespace gridmap3D {
 		return true;
 	}
 
-	bool AbstractOccupancyGrid3D::writeBinary(std::ostream &s){
+	bool AbstractOccupancyGrid3DBase::writeBinary(std::ostream &s){
 		// convert to max likelihood
 		this->toMaxLikelihood();
 		return writeBinaryConst(s);
 	}
 
-	bool AbstractOccupancyGrid3D::writeBinaryConst(std::ostream &s) const{
+	bool AbstractOccupancyGrid3DBase::writeBinaryConst(std::ostream &s) const{
 		// write new header first:
 		s << binaryFileHeader << "\n# (feel free to add / change comments, but leave the first line as it is!)\n#\n";
 		s << "id " << this->getGridType() << std::endl;
@@ -94,7 +94,7 @@ namespace gridmap3D {
 		}
 	}
 
-	bool AbstractOccupancyGrid3D::readBinary(const std::string& filename){
+	bool AbstractOccupancyGrid3DBase::readBinary(const std::string& filename){
 		std::ifstream binary_infile(filename.c_str(), std::ios_base::binary);
 		if (!binary_infile.is_open()){
 			GRIDMAP3D_ERROR_STR("Filestream to " << filename << " not open, nothing read.");
@@ -103,7 +103,7 @@ namespace gridmap3D {
 		return readBinary(binary_infile);
 	}
 
-	bool AbstractOccupancyGrid3D::readBinary(std::istream &s) {
+	bool AbstractOccupancyGrid3DBase::readBinary(std::istream &s) {
 		if (!s.good()){
 			GRIDMAP3D_WARNING_STR("Input filestream not \"good\" in Grid3D::readBinary");
 		}
@@ -113,7 +113,7 @@ namespace gridmap3D {
 		std::getline(s, line);
 		unsigned size;
 		double res;
-		if (line.compare(0, AbstractOccupancyGrid3D::binaryFileHeader.length(), AbstractOccupancyGrid3D::binaryFileHeader) == 0){
+		if (line.compare(0, AbstractOccupancyGrid3DBase::binaryFileHeader.length(), AbstractOccupancyGrid3DBase::binaryFileHeader) == 0){
 			std::string id;
 			if (!AbstractGrid3D::readHeader(s, id, size, res))
 				return false;
@@ -136,5 +136,5 @@ namespace gridmap3D {
 		return true;
 	}
 
-	const std::string AbstractOccupancyGrid3D::binaryFileHeader = "# GridMap3D Grid3D binary file";
+	const std::string AbstractOccupancyGrid3DBase::binaryFileHeader = "# GridMap3D Grid3D binary file";
 }
@@ -28,17 +28,19 @@
 */
 
 #include <gridmap3D_cullingregion/CullingRegionGrid3D.h>
+#include <deque>
 
 namespace gridmap3D{
     CullingRegionGrid3D::CullingRegionGrid3D(double in_resolution)
-            : OccupancyGrid3DBase<Grid3DNode>(in_resolution) {
+            : OccupancyGrid3DBase<Grid3DNode>(in_resolution), use_static_origin(false), cullingregion_hash(0), cullingregion_version(0), cache_frame(0), max_cached_rays(1 << 17), use_cullingregion_reuse(false) {
         cullingregionGrid3DMemberInit.ensureLinking();
     };
 
-    /*CullingRegionGrid3D::CullingRegionGrid3D(std::string _filename)
-            : OccupancyGrid3DBase<Grid3DNode>(0.1)  { // resolution will be set according to grid file
+    CullingRegionGrid3D::CullingRegionGrid3D(std::string _filename)
+            : OccupancyGrid3DBase<Grid3DNode>(0.1), use_static_origin(false), cullingregion_hash(0), cullingregion_version(0), cache_frame(0), max_cached_rays(1 << 17), use_cullingregion_reuse(false) { // resolution will be set according to grid file
+        cullingregionGrid3DMemberInit.ensureLinking();
         readBinary(_filename);
-    }*/
+    }
 
     CullingRegionGrid3D::StaticMemberInitializer CullingRegionGrid3D::cullingregionGrid3DMemberInit;
 
@@ -50,6 +52,15 @@ namespace gridmap3D{
         // Build a culling region
         KeySet cullingregion = buildCullingRegion(pc, origin);
 
+        if (use_static_origin) {
+            std::vector<std::pair<point3d, int> > rays;
+            rays.reserve(pc.size());
+            for (int i = 0; i < (int)pc.size(); ++i)
+                rays.push_back(std::make_pair(pc[i], 1));
+            insertCachedRays(rays, origin, cullingregion);
+            return;
+        }
+
         // Update the occupancies of the map
 #ifdef _OPENMP
         omp_set_num_threads(this->keyrays.size());
@@ -79,6 +90,8 @@ namespace gridmap3D{
         // Update the cells containing the end points to have the occupied states
         for (int i = 0; i < (int)pc.size(); ++i){
             updateNode(pc[i], true);
+            if (use_cullingregion_reuse)
+                reusable_unchanged &= (reusable_cullingregion.erase(coordToKey(pc[i])) == 0);
         }
     }
 
@@ -95,6 +108,15 @@ namespace gridmap3D{
         // Build a culling region
         KeySet cullingregion = buildCullingRegion(srcloud, origin);
 
+        if (use_static_origin) {
+            std::vector<std::pair<point3d, int> > rays;
+            rays.reserve(srcloud.size());
+            for (int i = 0; i < (int)srcloud.size(); ++i)
+                rays.push_back(std::make_pair(srcloud[i].p, srcloud[i].w));
+            insertCachedRays(rays, origin, cullingregion);
+            return;
+        }
+
         // Update the occupancies of the map
 #ifdef _OPENMP
         omp_set_num_threads(this->keyrays.size());
@@ -124,11 +146,162 @@ namespace gridmap3D{
         // Update the cells containing the end points to have the occupied states
         for (int i = 0; i < (int)srcloud.size(); ++i){
             updateNode(srcloud[i].p, prob_hit_log * srcloud[i].w);
+            if (use_cullingregion_reuse)
+                reusable_unchanged &= (reusable_cullingregion.erase(coordToKey(srcloud[i].p)) == 0);
+        }
+    }
+
+    void CullingRegionGrid3D::enableStaticOrigin(bool enable)
+    {
+        use_static_origin = enable;
+        if (!use_static_origin)
+            clearRayCache();
+    }
+
+    void CullingRegionGrid3D::clearRayCache()
+    {
+        ray_cache.clear();
+        cullingregion_hash = 0;
+        cullingregion_version = 0;
+    }
+
+    void CullingRegionGrid3D::enableCullingRegionReuse(bool enable)
+    {
+        use_cullingregion_reuse = enable;
+        reusable_cullingregion.clear();
+    }
+
+    void CullingRegionGrid3D::insertCachedRays(const std::vector<std::pair<point3d, int> >& rays, const point3d& origin, const KeySet& cullingregion)
+    {
+        Grid3DKey key_origin;
+        if (!coordToKeyChecked(origin, key_origin)) {
+            GRIDMAP3D_WARNING_STR("origin ( " << origin << ") out of bounds in insertCachedRays");
+            return;
+        }
+
+        // The cached traversals are valid only for the same origin
+        if (ray_cache.size() > 0 && !(origin == cached_origin))
+            clearRayCache();
+        cached_origin = origin;
+
+        // The culling boundaries of the cached traversals are valid only for the same culling region
+        uint64_t region_hash = hashCullingRegion(cullingregion);
+        if (cullingregion_version == 0 || region_hash != cullingregion_hash) {
+            cullingregion_hash = region_hash;
+            cullingregion_version++;
+        }
+        cache_frame++;
+
+        // Look up the traversals of the end points. New ones are traced and bounded before the updates,
+        // those beyond the limit of the cache go to scratch entries that are not kept.
+        std::vector<CachedRay*> cached_rays(rays.size());
+        std::deque<CachedRay> scratch;
+        std::vector<int> untraced;
+        std::vector<CachedRay*> unbounded;
+        for (size_t i = 0; i < rays.size(); i++) {
+            RayCache::iterator it = ray_cache.find(rays[i].first);
+            CachedRay* ray;
+            if (it != ray_cache.end()) {
+                ray = &(it->second);
+            }
+            else {
+                if (ray_cache.size() < max_cached_rays)
+                    ray = &(ray_cache[rays[i].first]);
+                else {
+                    scratch.push_back(CachedRay());
+                    ray = &(scratch.back());
+                }
+                untraced.push_back((int)i);
+            }
+            if (ray->version != cullingregion_version) {
+                ray->version = cullingregion_version;
+                unbounded.push_back(ray);
+            }
+            ray->frame = cache_frame;
+            cached_rays[i] = ray;
+        }
+
+        // Trace the complete rays of the new end points
+        KeySet unculled;
+#ifdef _OPENMP
+        omp_set_num_threads(this->keyrays.size());
+#pragma omp parallel for
+#endif
+        for (int i = 0; i < (int)untraced.size(); ++i) {
+            unsigned threadIdx = 0;
+#ifdef _OPENMP
+            threadIdx = omp_get_thread_num();
+#endif
+            KeyRay* keyray = &(this->keyrays.at(threadIdx));
+            CachedRay& ray = *(cached_rays[untraced[i]]);
+            ray.valid = this->computeInverseRayKeys(rays[untraced[i]].first, origin, *keyray, unculled);
+            ray.keys.assign(keyray->begin(), keyray->end());
+        }
+
+        // Find the culling boundaries on the rays only when the culling region changed
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int i = 0; i < (int)unbounded.size(); ++i) {
+            CachedRay& ray = *(unbounded[i]);
+            ray.length = 0;
+            while (ray.length < ray.keys.size() && cullingregion.find(ray.keys[ray.length]) == cullingregion.end())
+                ray.length++;
+        }
+
+        // Update the traversed cells to have the free states, in the order of the rays
+        for (size_t i = 0; i < rays.size(); ++i) {
+            const CachedRay& ray = *(cached_rays[i]);
+            if (!ray.valid)
+                continue;
+            for (size_t j = 0; j < ray.length; j++)
+                updateNode(ray.keys[j], prob_miss_log * rays[i].second);
+        }
+
+        // Update the cells containing the end points to have the occupied states
+        for (size_t i = 0; i < rays.size(); ++i){
+            updateNode(rays[i].first, prob_hit_log * rays[i].second);
+            if (use_cullingregion_reuse)
+                reusable_unchanged &= (reusable_cullingregion.erase(coordToKey(rays[i].first)) == 0);
+        }
+
+        // Drop the traversals unused by this update once the cache is full
+        if (ray_cache.size() >= max_cached_rays) {
+            for (RayCache::iterator it = ray_cache.begin(); it != ray_cache.end(); ) {
+                if (it->second.frame != cache_frame)
+                    ray_cache.erase(it++);
+                else
+                    ++it;
+            }
         }
     }
 
+    uint64_t CullingRegionGrid3D::hashCullingRegion(const KeySet& cullingregion)
+    {
+        // Sum of the mixed keys, so that the order of the set does not matter
+        uint64_t hash = cullingregion.size();
+        for (KeySet::const_iterator it = cullingregion.begin(); it != cullingregion.end(); ++it) {
+            uint64_t k = ((uint64_t)(*it)[0] << 32) | ((uint64_t)(*it)[1] << 16) | (uint64_t)(*it)[2];
+            k *= 0x9E3779B97F4A7C15ULL;
+            k ^= k >> 29;
+            k *= 0xBF58476D1CE4E5B9ULL;
+            k ^= k >> 32;
+            hash += k;
+        }
+        return hash;
+    }
+
     KeySet CullingRegionGrid3D::buildCullingRegion(const point3d& origin, const int max_propagation)
     {
+        if (use_cullingregion_reuse && reusable_cullingregion.size() > 0) {
+            // Translate the culling region of the previous update to the new origin
+            KeySet cullingregion = buildCullingRegion(origin, max_propagation, reusable_cullingregion, reusable_originKey, reusable_unchanged);
+            reusable_cullingregion = cullingregion;
+            reusable_originKey = coordToKey(origin);
+            reusable_unchanged = true;
+            return cullingregion;
+        }
+
         KeySet cullingregion;
 
         Grid3DKey originKey = coordToKey(origin);
@@ -202,6 +375,98 @@ namespace gridmap3D{
 
         delete cur_candidates;
 
+        // Keep the culling region for the next update
+        if (use_cullingregion_reuse) {
+            reusable_cullingregion = cullingregion;
+            reusable_originKey = originKey;
+            reusable_unchanged = true;
+        }
+
+        return cullingregion;
+    }
+
+    KeySet CullingRegionGrid3D::buildCullingRegion(const point3d& origin, const int max_propagation,
+                                          const KeySet& prev_cullingregion, const Grid3DKey& prev_originKey, const bool prev_unchanged)
+    {
+        Grid3DKey originKey = coordToKey(origin);
+
+        // Sort the cells of the previous culling region into the levels of propagation from the new origin
+        std::vector<std::vector<Grid3DKey> > levels(max_propagation + 1);
+        for (KeySet::const_iterator it = prev_cullingregion.begin(); it != prev_cullingregion.end(); ++it) {
+            int level = 0;
+            for (int axis = 0; axis < 3; axis++)
+                level += abs((int)(*it)[axis] - (int)originKey[axis]);
+            if (level <= max_propagation)
+                levels[level].push_back(*it);
+        }
+        std::vector<size_t> num_prev_cells(max_propagation + 1);
+        for (int level = 0; level <= max_propagation; level++)
+            num_prev_cells[level] = levels[level].size();
+        if (prev_cullingregion.find(originKey) == prev_cullingregion.end())
+            levels[0].push_back(originKey);
+
+        KeySet cullingregion;
+        KeySet shell;   // new candidates out of the previous culling region
+        for (int cur_level = 0; cur_level <= max_propagation; cur_level++) {
+            for (size_t i = 0; i < levels[cur_level].size(); i++) {
+                const Grid3DKey key = levels[cur_level][i];
+                const bool prev_cell = (i < num_prev_cells[cur_level]);
+
+                // The first condition: does the cell have a fully free state?
+                // (the cells in the previous culling region are known to be fully free)
+                if (!prev_cell) {
+                    Grid3DNode* node = search(key);
+                    if (!node || node->getLogOdds() > clamping_thres_min)
+                        continue;
+                }
+
+                // The second condition: are all the neighbor cells in the culling region?
+                // All cells between the cell and its previous origin are fully free, so that the condition holds
+                // for the new origin in between without any check, unless some of them have been updated since.
+                int step[3] = {0, 0, 0};
+                bool in_between = prev_cell && prev_unchanged;
+                for (int axis = 0; axis < 3; axis++) {
+                    if (key[axis] > originKey[axis])		step[axis] = -1;
+                    else if (key[axis] < originKey[axis])	step[axis] = 1;
+
+                    if (originKey[axis] < std::min(key[axis], prev_originKey[axis]) || originKey[axis] > std::max(key[axis], prev_originKey[axis]))
+                        in_between = false;
+                }
+
+                bool insertion = true;
+                for (int axis = 0; !in_between && axis < 3; axis++) {
+                    if (step[axis] != 0) {
+                        Grid3DKey checkKey = key;
+                        checkKey[axis] += step[axis];
+                        if (cullingregion.find(checkKey) == cullingregion.end()) {
+                            insertion = false;
+                            break;
+                        }
+                    }
+                }
+
+                // Insert the cell into the culling region
+                if (!insertion)
+                    continue;
+                cullingregion.insert(key);
+
+                // Find the new candidates in the next level, out of the previous culling region
+                if (cur_level != max_propagation) {
+                    for (int axis = 0; axis < 3; axis++) {
+                        for (int dir = -1; dir <= 1; dir += 2) {
+                            if (step[axis] != 0 && dir != -step[axis])
+                                continue;
+
+                            Grid3DKey candidate = key;
+                            candidate[axis] += dir;
+                            if (prev_cullingregion.find(candidate) == prev_cullingregion.end() && shell.insert(candidate).second)
+                                levels[cur_level + 1].push_back(candidate);
+                        }
+                    }
+                }
+            }
+        }
+
         return cullingregion;
     }
 
@@ -31,94 +31,28 @@
 
 namespace gridmap3D{
 	SuperRayGrid3D::SuperRayGrid3D(double in_resolution)
-	: OccupancyGrid3DBase<Grid3DNode>(in_resolution) {
+	: SuperRayGrid3DBase<Grid3DNode>(in_resolution) {
 		superrayGrid3DMemberInit.ensureLinking();
 	};
 
-	/*SuperRayGrid3D::SuperRayGrid3D(std::string _filename)
-    : OccupancyGrid3DBase<Grid3DNode>(0.1)  { // resolution will be set according to grid file
+	SuperRayGrid3D::SuperRayGrid3D(std::string _filename)
+	: SuperRayGrid3DBase<Grid3DNode>(0.1) { // resolution will be set according to grid file
+		superrayGrid3DMemberInit.ensureLinking();
 		readBinary(_filename);
-	}*/
+	}
 
 	SuperRayGrid3D::StaticMemberInitializer SuperRayGrid3D::superrayGrid3DMemberInit;
 
-	void SuperRayGrid3D::insertPointCloudRays(const Pointcloud& pc, const point3d& origin)
-	{
-		if (pc.size() < 1)
-			return;
-
-	#ifdef _OPENMP
-		omp_set_num_threads(this->keyrays.size());
-	#pragma omp parallel for
-	#endif
-		for (int i = 0; i < (int)pc.size(); ++i) {
-			const point3d& p = pc[i];
-			unsigned threadIdx = 0;
-	#ifdef _OPENMP
-			threadIdx = omp_get_thread_num();
-	#endif
-			KeyRay* keyray = &(this->keyrays.at(threadIdx));
-
-			// free cells
-			if (this->computeRayKeys(origin, p, *keyray)){
-	#ifdef _OPENMP
-	#pragma omp critical
-	#endif
-				{
-					for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
-						updateNode(*it, false); // insert freespace measurement
-					}
-				}
-			}
-		}
-
-		for (int i = 0; i < (int)pc.size(); ++i){
-			updateNode(pc[i], true); // update endpoint to be occupied
-		}
-	}
+	SuperRayBlockGrid3D::SuperRayBlockGrid3D(double in_resolution)
+	: SuperRayGrid3DBase<Grid3DNode, Grid3DBlockStorage<Grid3DNode> >(in_resolution) {
+		superrayBlockGrid3DMemberInit.ensureLinking();
+	};
 
-	void SuperRayGrid3D::insertSuperRayCloudRays(const Pointcloud& scan, const point3d& origin, const int threshold)
-	{
-		SuperRayGenerator srgenerator(resolution, grid_max_val, threshold);
-		SuperRayCloud srcloud;
-		srgenerator.GenerateSuperRay(scan, origin, srcloud);
-		insertSuperRayCloudRays(srcloud);
+	SuperRayBlockGrid3D::SuperRayBlockGrid3D(std::string _filename)
+	: SuperRayGrid3DBase<Grid3DNode, Grid3DBlockStorage<Grid3DNode> >(0.1) { // resolution will be set according to grid file
+		superrayBlockGrid3DMemberInit.ensureLinking();
+		readBinary(_filename);
 	}
 
-	void SuperRayGrid3D::insertSuperRayCloudRays(const SuperRayCloud& superray)
-	{
-		if (superray.size() < 1)
-			return;
-
-		point3d origin = superray.origin;
-	#ifdef _OPENMP
-		omp_set_num_threads(this->keyrays.size());
-	#pragma omp parallel
-	#endif
-		for (int i = 0; i < (int)superray.size(); ++i) {
-			const point3d& p = superray[i].p;
-			const float& missprob = prob_miss_log * superray[i].w;
-			unsigned threadIdx = 0;
-	#ifdef _OPENMP
-			threadIdx = omp_get_thread_num();
-	#endif
-			KeyRay* keyray = &(this->keyrays.at(threadIdx));
-
-			// free cells
-			if (this->computeRayKeys(origin, p, *keyray)){
-	#ifdef _OPENMP
-	#pragma omp critical
-	#endif
-				{
-					for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
-						updateNode(*it, missprob);
-					}
-				}
-			}
-		}
-
-		for (int i = 0; i < (int)superray.size(); ++i){
-			updateNode(superray[i].p, prob_hit_log * superray[i].w);
-		}
-	}
-}
\ No newline at end of file
+	SuperRayBlockGrid3D::StaticMemberInitializer SuperRayBlockGrid3D::superrayBlockGrid3DMemberInit;
+}
@@ -0,0 +1,260 @@
+/*
+* Copyright(c) 2016, Youngsun Kwon, Donghyuk Kim, and Sung-eui Yoon, KAIST
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met :
+*
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and / or other materials provided with the distribution.
+*     * Neither the name of SuperRay nor the names of its
+*       contributors may be used to endorse or promote products derived from
+*       this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include <gridmap3D_superray/SuperRayRollingGrid3D.h>
+
+namespace gridmap3D{
+	SuperRayRollingGrid3D::SuperRayRollingGrid3D(double in_resolution, unsigned int window_width)
+	: OccupancyGrid3DBase<Grid3DNode, Grid3DRollingStorage<Grid3DNode> >(in_resolution) {
+		superrayRollingGrid3DMemberInit.ensureLinking();
+
+		unsigned int width_bits = windowWidthBits(window_width);
+		if ((1u << width_bits) < window_width)
+			GRIDMAP3D_WARNING_STR("Window width " << window_width << " exceeds the largest window, limited to " << (1u << width_bits) << " cells.");
+		key_type half = (key_type)((1u << width_bits) / 2);
+		key_type center = coordToKey(0.0);
+		gridmap->setWindow(width_bits, Grid3DKey(center - half, center - half, center - half));
+	};
+
+	SuperRayRollingGrid3D::StaticMemberInitializer SuperRayRollingGrid3D::superrayRollingGrid3DMemberInit;
+
+	unsigned int SuperRayRollingGrid3D::windowWidthBits(unsigned int window_width)
+	{
+		unsigned int width_bits = 0;
+		while ((1u << width_bits) < window_width && width_bits < Grid3DRollingStorage<Grid3DNode>::MAX_WIDTH_BITS)
+			width_bits++;
+		return width_bits;
+	}
+
+	bool SuperRayRollingGrid3D::readWindow(std::istream &s)
+	{
+		uint32_t window_width = 0;
+		Grid3DKey window_min;
+		s.read((char*)&window_width, sizeof(window_width));
+		for (unsigned int i = 0; i < 3; i++)
+			s.read((char*)&(window_min[i]), sizeof(window_min[i]));
+
+		unsigned int width_bits = windowWidthBits(window_width);
+		if (s.fail() || window_width == 0 || (1u << width_bits) != window_width){
+			GRIDMAP3D_ERROR_STR("SuperRayRollingGrid3D: invalid window of width " << window_width << ", nothing read.");
+			s.setstate(std::ios::failbit);
+			return false;
+		}
+
+		// grid needs to be newly created or cleared externally
+		if (gridmap->size() != 0){
+			GRIDMAP3D_ERROR_STR("Trying to read into an existing grid.");
+			return false;
+		}
+		gridmap->setWindow(width_bits, window_min);
+		return true;
+	}
+
+	void SuperRayRollingGrid3D::writeWindow(std::ostream &s) const
+	{
+		uint32_t window_width = gridmap->getWindowWidth();
+		const Grid3DKey& window_min = gridmap->getWindowMin();
+		s.write((char*)&window_width, sizeof(window_width));
+		for (unsigned int i = 0; i < 3; i++)
+			s.write((char*)&(window_min[i]), sizeof(window_min[i]));
+	}
+
+	std::istream& SuperRayRollingGrid3D::readData(std::istream &s)
+	{
+		if (readWindow(s))
+			OccupancyGrid3DBase<Grid3DNode, Grid3DRollingStorage<Grid3DNode> >::readData(s);
+		return s;
+	}
+
+	std::ostream& SuperRayRollingGrid3D::writeData(std::ostream &s) const
+	{
+		writeWindow(s);
+		return OccupancyGrid3DBase<Grid3DNode, Grid3DRollingStorage<Grid3DNode> >::writeData(s);
+	}
+
+	std::istream& SuperRayRollingGrid3D::readBinaryData(std::istream &s)
+	{
+		if (readWindow(s))
+			OccupancyGrid3DBase<Grid3DNode, Grid3DRollingStorage<Grid3DNode> >::readBinaryData(s);
+		return s;
+	}
+
+	std::ostream& SuperRayRollingGrid3D::writeBinaryData(std::ostream &s) const
+	{
+		writeWindow(s);
+		return OccupancyGrid3DBase<Grid3DNode, Grid3DRollingStorage<Grid3DNode> >::writeBinaryData(s);
+	}
+
+	std::istream& SuperRayRollingGrid3D::readBulkData(std::istream &s)
+	{
+		if (readWindow(s))
+			OccupancyGrid3DBase<Grid3DNode, Grid3DRollingStorage<Grid3DNode> >::readBulkData(s);
+		return s;
+	}
+
+	std::ostream& SuperRayRollingGrid3D::writeBulkData(std::ostream &s, bool delta_keys) const
+	{
+		writeWindow(s);
+		return OccupancyGrid3DBase<Grid3DNode, Grid3DRollingStorage<Grid3DNode> >::writeBulkData(s, delta_keys);
+	}
+
+	void SuperRayRollingGrid3D::moveWindow(const point3d& center)
+	{
+		Grid3DKey key;
+		if (!coordToKeyChecked(center, key)){
+			GRIDMAP3D_WARNING_STR("Window center " << center << " is out of Grid3D bounds, window not moved.");
+			return;
+		}
+
+		key_type half = (key_type)(gridmap->getWindowWidth() / 2);
+		gridmap->moveWindow(Grid3DKey(key[0] - half, key[1] - half, key[2] - half));
+	}
+
+	void SuperRayRollingGrid3D::getWindowBounds(point3d& min, point3d& max) const
+	{
+		float half_resolution = float(resolution / 2.0);
+		min = keyToCoord(gridmap->getWindowMin()) - point3d(half_resolution, half_resolution, half_resolution);
+		float extent = float(gridmap->getWindowWidth() * resolution);
+		max = min + point3d(extent, extent, extent);
+	}
+
+	bool SuperRayRollingGrid3D::clipRay(const point3d& origin, const point3d& end, point3d& clipped_origin, point3d& clipped_end) const
+	{
+		point3d window_min, window_max;
+		getWindowBounds(window_min, window_max);
+
+		// slab test of the segment against the window enlarged by one cell
+		point3d direction = end - origin;
+		double t_min = 0.0, t_max = 1.0;
+		for (unsigned int i = 0; i < 3; i++){
+			double lower = window_min(i) - resolution;
+			double upper = window_max(i) + resolution;
+			if (direction(i) == 0.0){
+				if (origin(i) < lower || origin(i) > upper)
+					return false;
+				continue;
+			}
+			double t0 = (lower - origin(i)) / direction(i);
+			double t1 = (upper - origin(i)) / direction(i);
+			if (t0 > t1)
+				std::swap(t0, t1);
+			t_min = std::max(t_min, t0);
+			t_max = std::min(t_max, t1);
+			if (t_min > t_max)
+				return false;
+		}
+
+		// keep the original points when they are inside to trace the same cells as an unclipped ray
+		clipped_origin = (t_min > 0.0) ? origin + direction * (float)t_min : origin;
+		clipped_end = (t_max < 1.0) ? origin + direction * (float)t_max : end;
+		return true;
+	}
+
+	void SuperRayRollingGrid3D::insertPointCloudRays(const Pointcloud& pc, const point3d& origin)
+	{
+		if (pc.size() < 1)
+			return;
+
+	#ifdef _OPENMP
+		omp_set_num_threads(this->keyrays.size());
+	#pragma omp parallel for
+	#endif
+		for (int i = 0; i < (int)pc.size(); ++i) {
+			const point3d& p = pc[i];
+			unsigned threadIdx = 0;
+	#ifdef _OPENMP
+			threadIdx = omp_get_thread_num();
+	#endif
+			KeyRay* keyray = &(this->keyrays.at(threadIdx));
+
+			// free cells within the window
+			point3d ray_origin, ray_end;
+			if (clipRay(origin, p, ray_origin, ray_end) && this->computeRayKeys(ray_origin, ray_end, *keyray)){
+	#ifdef _OPENMP
+	#pragma omp critical
+	#endif
+				{
+					for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
+						updateNode(*it, false); // insert freespace measurement
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < (int)pc.size(); ++i){
+			updateNode(pc[i], true); // update endpoint to be occupied
+		}
+	}
+
+	void SuperRayRollingGrid3D::insertSuperRayCloudRays(const Pointcloud& scan, const point3d& origin, const int threshold)
+	{
+		SuperRayGenerator srgenerator(resolution, grid_max_val, threshold);
+		SuperRayCloud srcloud;
+		srgenerator.GenerateSuperRay(scan, origin, srcloud);
+		insertSuperRayCloudRays(srcloud);
+	}
+
+	void SuperRayRollingGrid3D::insertSuperRayCloudRays(const SuperRayCloud& superray)
+	{
+		if (superray.size() < 1)
+			return;
+
+		point3d origin = superray.origin;
+	#ifdef _OPENMP
+		omp_set_num_threads(this->keyrays.size());
+	#pragma omp parallel for
+	#endif
+		for (int i = 0; i < (int)superray.size(); ++i) {
+			const point3d& p = superray[i].p;
+			const float& missprob = prob_miss_log * superray[i].w;
+			unsigned threadIdx = 0;
+	#ifdef _OPENMP
+			threadIdx = omp_get_thread_num();
+	#endif
+			KeyRay* keyray = &(this->keyrays.at(threadIdx));
+
+			// free cells within the window
+			point3d ray_origin, ray_end;
+			if (clipRay(origin, p, ray_origin, ray_end) && this->computeRayKeys(ray_origin, ray_end, *keyray)){
+	#ifdef _OPENMP
+	#pragma omp critical
+	#endif
+				{
+					for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
+						updateNode(*it, missprob);
+					}
+				}
+			}
+		}
+
+		for (int i = 0; i < (int)superray.size(); ++i){
+			updateNode(superray[i].p, prob_hit_log * superray[i].w);
+		}
+	}
+}
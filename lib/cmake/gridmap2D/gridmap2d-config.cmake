@@ -0,0 +1,56 @@
+# ===================================================================================
+#  The GridMap2D CMake configuration file
+#
+#             ** File generated automatically, do not modify **
+#
+#  Usage from an external project:
+#    In your CMakeLists.txt, add these lines:
+#
+#    FIND_PACKAGE(gridmap2D REQUIRED )
+#    INCLUDE_DIRECTORIES(${GRIDMAP2D_INCLUDE_DIRS})
+#    TARGET_LINK_LIBRARIES(MY_TARGET_NAME ${GRIDMAP2D_LIBRARIES})
+#
+#
+#    This file will define the following variables:
+#      - GRIDMAP2D_LIBRARIES      : The list of libraries to links against.
+#      - GRIDMAP2D_LIBRARY_DIRS   : The directory where lib files are. Calling
+#                                 LINK_DIRECTORIES with this path is NOT needed.
+#      - GRIDMAP2D_INCLUDE_DIRS   : The QuadMap include directories.
+#
+# ===================================================================================
+
+
+####### Expanded from @PACKAGE_INIT@ by configure_package_config_file() #######
+####### Any changes to this file will be overwritten by the next CMake run ####
+####### The input file was gridmap2D-config.cmake.in                            ########
+
+get_filename_component(PACKAGE_PREFIX_DIR "${CMAKE_CURRENT_LIST_DIR}/../../" ABSOLUTE)
+
+macro(set_and_check _var _file)
+  set(${_var} "${_file}")
+  if(NOT EXISTS "${_file}")
+    message(FATAL_ERROR "File or directory ${_file} referenced by variable ${_var} does not exist !")
+  endif()
+endmacro()
+
+macro(check_required_components _NAME)
+  foreach(comp ${${_NAME}_FIND_COMPONENTS})
+    if(NOT ${_NAME}_${comp}_FOUND)
+      if(${_NAME}_FIND_REQUIRED_${comp})
+        set(${_NAME}_FOUND FALSE)
+      endif()
+    endif()
+  endforeach()
+endmacro()
+
+####################################################################################
+
+set_and_check(GRIDMAP2D_INCLUDE_DIRS "/root/repo/gridmap2D/include")
+set_and_check(GRIDMAP2D_LIBRARY_DIRS "/root/repo/lib")
+ 
+
+# Set library names
+set(GRIDMAP2D_LIBRARIES 
+  "/root/repo/lib/libgridmap2D.so"
+  "/root/repo/lib/libgridmath2D.so"
+)
@@ -0,0 +1,67 @@
+# ===================================================================================
+#  The QuadMap CMake configuration file
+#
+#             ** File generated automatically, do not modify **
+#
+#  Usage from an external project:
+#    In your CMakeLists.txt, add these lines:
+#
+#    FIND_PACKAGE(quadmap REQUIRED )
+#    INCLUDE_DIRECTORIES(${QUADMAP_INCLUDE_DIRS})
+#    TARGET_LINK_LIBRARIES(MY_TARGET_NAME ${QUADMAP_LIBRARIES})
+#
+#
+#    This file will define the following variables:
+#      - QUADMAP_LIBRARIES      : The list of libraries to links against.
+#      - QUADMAP_LIBRARY_DIRS   : The directory where lib files are. Calling
+#                                 LINK_DIRECTORIES with this path is NOT needed.
+#      - QUADMAP_INCLUDE_DIRS   : The QuadMap include directories.
+#      - QUADMAP_MAJOR_VERSION  : Major version.
+#      - QUADMAP_MINOR_VERSION  : Minor version.
+#      - QUADMAP_PATCH_VERSION  : Patch version.
+#      - QUADMAP_VERSION        : Major.Minor.Patch version.
+#
+# ===================================================================================
+
+
+####### Expanded from @PACKAGE_INIT@ by configure_package_config_file() #######
+####### Any changes to this file will be overwritten by the next CMake run ####
+####### The input file was quadmap-config.cmake.in                            ########
+
+get_filename_component(PACKAGE_PREFIX_DIR "${CMAKE_CURRENT_LIST_DIR}/../../" ABSOLUTE)
+
+macro(set_and_check _var _file)
+  set(${_var} "${_file}")
+  if(NOT EXISTS "${_file}")
+    message(FATAL_ERROR "File or directory ${_file} referenced by variable ${_var} does not exist !")
+  endif()
+endmacro()
+
+macro(check_required_components _NAME)
+  foreach(comp ${${_NAME}_FIND_COMPONENTS})
+    if(NOT ${_NAME}_${comp}_FOUND)
+      if(${_NAME}_FIND_REQUIRED_${comp})
+        set(${_NAME}_FOUND FALSE)
+      endif()
+    endif()
+  endforeach()
+endmacro()
+
+####################################################################################
+
+set(QUADMAP_MAJOR_VERSION "1")
+set(QUADMAP_MINOR_VERSION "0")
+set(QUADMAP_PATCH_VERSION "0")
+set(QUADMAP_VERSION "1.0.0")
+
+set_and_check(QUADMAP_INCLUDE_DIRS "/root/repo/quadmap/include")
+set_and_check(QUADMAP_LIBRARY_DIRS "/root/repo/lib")
+ 
+
+# Set library names
+set(QUADMAP_LIBRARIES 
+  "/root/repo/lib/libquadmap.so"
+  "/root/repo/lib/libquadmath.so"
+)
+
+
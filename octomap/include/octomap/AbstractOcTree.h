@@ -144,6 +144,31 @@ namespace octomap {
         /// Write complete state of tree to stream (without file header) unmodified.
         /// Pruning the tree first produces smaller files (lossless compression)
         virtual std::ostream& writeData(std::ostream &s) const = 0;
+
+        /**
+         * Write file header and complete tree to file in the chunked format: the
+         * nodes above a fixed depth, followed by the subtrees below it in
+         * separately sized sections, which are encoded and decoded in parallel
+         * (with OpenMP) and written / read in large blocks. The nodes are encoded
+         * as by writeData(). Read it with readChunked().
+         */
+        bool writeChunked(const std::string& filename) const;
+        /// Write file header and complete tree to stream in the chunked format, see writeChunked()
+        bool writeChunked(std::ostream& s) const;
+
+        /// Read a file written by writeChunked(), create the appropriate class and deserialize.
+        /// This creates a new octree which you need to delete yourself.
+        static AbstractOcTree* readChunked(const std::string& filename);
+
+        /// Read a stream written by writeChunked(), create the appropriate class and deserialize.
+        /// This creates a new octree which you need to delete yourself.
+        static AbstractOcTree* readChunked(std::istream &s);
+
+        /// Read all nodes in the chunked format from the input stream (without file header)
+        virtual std::istream& readChunkedData(std::istream &s) = 0;
+
+        /// Write all nodes in the chunked format to stream (without file header)
+        virtual std::ostream& writeChunkedData(std::ostream &s) const = 0;
     private:
         /// create private store, Construct on first use
         static std::map<std::string, AbstractOcTree*>& classIDMapping();
@@ -153,6 +178,7 @@ namespace octomap {
         static void registerTreeType(AbstractOcTree* tree);
 
         static const std::string fileHeader;
+        static const std::string chunkedFileHeader;
     };
 
 
@@ -105,7 +105,7 @@ namespace octomap {
 
 
     // tree definition
-    class ColorOcTree : public OccupancyOcTreeBase <ColorOcTreeNode> {
+    class ColorOcTree : public OccupancyOcTreeBase <ColorOcTreeNode, OcTreeNodeArena<ColorOcTreeNode> > {
 
     public:
         /// Default constructor, sets resolution of leafs
@@ -0,0 +1,390 @@
+/*
+* Copyright(c) 2016, Youngsun Kwon, Donghyuk Kim, and Sung-eui Yoon, KAIST
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met :
+*
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and / or other materials provided with the distribution.
+*     * Neither the name of SuperRay nor the names of its
+*       contributors may be used to endorse or promote products derived from
+*       this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef OCTOMAP_LINEAR_OCTREE_H
+#define OCTOMAP_LINEAR_OCTREE_H
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdint.h>
+
+#include "octomap_types.h"
+#include "octomap_utils.h"
+#include "OcTreeKey.h"
+#include "AbstractOcTree.h"
+
+namespace octomap {
+
+    /**
+     * Node of a LinearOcTree: the Morton code of its smallest key, its depth
+     * and its log-odds occupancy, packed into 12 bytes. For inner nodes the
+     * value is the maximum of the children (as in OcTree after
+     * updateInnerOccupancy()), and the record also tells which children
+     * exist and whether the subtree is completely known.
+     */
+    class LinearOcTreeNode {
+
+    public:
+        LinearOcTreeNode() : value(0.0f) { bits[0] = bits[1] = 0; }
+
+        LinearOcTreeNode(uint64_t code, unsigned int depth, float log_odds, unsigned int child_mask, bool complete)
+            : value(log_odds) {
+            bits[0] = (uint32_t)(code >> 16);
+            bits[1] = (uint32_t)((code & 0xFFFF) << 16) | (depth << 11) | ((complete ? 1u : 0u) << 8) | child_mask;
+        }
+
+        /// @return Morton code of the smallest key covered by the node
+        inline uint64_t getCode() const { return ((uint64_t)bits[0] << 16) | (bits[1] >> 16); }
+        inline unsigned int getDepth() const { return (bits[1] >> 11) & 0x1F; }
+
+        /// @return bit i is set if child i exists, 0 for leaves
+        inline unsigned int getChildMask() const { return bits[1] & 0xFF; }
+        inline bool hasChildren() const { return getChildMask() != 0; }
+
+        /// @return true if no cell of the subtree is unknown (always true for leaves)
+        inline bool isComplete() const { return ((bits[1] >> 8) & 1) != 0; }
+
+        inline float getValue() const { return value; }
+        inline float getLogOdds() const { return value; }
+        inline double getOccupancy() const { return probability(value); }
+
+        /// @return key ordering the nodes by Morton code, then by depth (depth-first order of the tree)
+        inline uint64_t getSortKey() const { return ((uint64_t)bits[0] << 32) | bits[1]; }
+
+        /// @return the sort key of the node at code and depth
+        static inline uint64_t sortKey(uint64_t code, unsigned int depth) { return (code << 16) | (depth << 11); }
+
+    protected:
+        uint32_t bits[2];   ///< code (48 bits), depth (5 bits), complete flag and child mask
+        float value;
+    };
+
+
+    /**
+     * Pointerless octree for read-mostly maps. The leaves are kept in an array
+     * sorted by Morton code, which is the depth-first order of the tree, so
+     * a leaf costs 12 bytes and neighbouring leaves are close in memory.
+     * A second sorted array summarizes the inner nodes (maximum occupancy,
+     * existing children, completeness); it answers searches above the leaf
+     * level and lets castRay() skip known free subtrees at once. Both arrays
+     * are searched through a sparse index of every INDEX_STRIDE-th key,
+     * which stays in cache, so a search touches few cache lines of the arrays.
+     *
+     * The tree is built from an OcTree (or any occupancy octree of the same
+     * depth, e.g. SuperRayOcTree or CullingRegionOcTree) by fromOcTree() and
+     * converted back by toOcTree(). It is not updated incrementally.
+     *
+     * writeFile() stores the arrays as they are in memory, and mapFile() maps
+     * such a file read-only and queries it in place: loading takes constant
+     * time, pages are read on first access, and processes mapping the same
+     * file share its pages. toOcTree() thaws the map into a mutable tree.
+     */
+    class LinearOcTree {
+
+    public:
+        typedef LinearOcTreeNode NodeType;
+
+        /// number of nodes per entry of the sparse key indices
+        static const size_t INDEX_STRIDE = 64;
+
+        /// Read-only array of nodes or keys, held by the tree or in a mapped file
+        template <class T>
+        class ConstArray {
+
+        public:
+            ConstArray() : first(NULL), num(0) {}
+            ConstArray(const T* data, size_t size) : first(size > 0 ? data : NULL), num(size) {}
+
+            inline const T* begin() const { return first; }
+            inline const T* end() const { return first + num; }
+            inline size_t size() const { return num; }
+            inline bool empty() const { return num == 0; }
+            inline const T& operator[](size_t i) const { return first[i]; }
+
+        protected:
+            const T* first;
+            size_t num;
+        };
+
+        /// Iterates over the leaves in Morton order
+        class leaf_iterator {
+
+        public:
+            leaf_iterator() : tree(NULL), node(NULL) {}
+            leaf_iterator(const LinearOcTree* tree, const LinearOcTreeNode* node) : tree(tree), node(node) {}
+
+            bool operator==(const leaf_iterator& other) const { return node == other.node; }
+            bool operator!=(const leaf_iterator& other) const { return node != other.node; }
+
+            leaf_iterator& operator++() { ++node; return *this; }
+
+            const LinearOcTreeNode& operator*() const { return *node; }
+            const LinearOcTreeNode* operator->() const { return node; }
+
+            /// @return key of the leaf, the center key for leaves above the maximum depth (as the OcTree iterators)
+            OcTreeKey getKey() const { return tree->nodeKey(*node); }
+            unsigned int getDepth() const { return node->getDepth(); }
+            point3d getCoordinate() const { return tree->keyToCoord(getKey(), getDepth()); }
+            double getX() const { return getCoordinate().x(); }
+            double getY() const { return getCoordinate().y(); }
+            double getZ() const { return getCoordinate().z(); }
+            double getSize() const { return tree->getNodeSize(getDepth()); }
+
+        protected:
+            const LinearOcTree* tree;
+            const LinearOcTreeNode* node;
+        };
+
+        /**
+         * Iterates over the leaves intersecting a bounding box in Morton order.
+         * Runs of leaves outside the box are skipped by jumping to the next
+         * Morton code inside the box (BIGMIN), leaves inside an aligned cube
+         * that lies in the box are passed without a test.
+         */
+        class leaf_bbx_iterator : public leaf_iterator {
+
+        public:
+            leaf_bbx_iterator() : leaf_iterator(), run_end(0) {}
+            leaf_bbx_iterator(const LinearOcTree* tree, const LinearOcTreeNode* node) : leaf_iterator(tree, node), run_end(0) {}
+            leaf_bbx_iterator(const LinearOcTree* tree, const OcTreeKey& min, const OcTreeKey& max);
+
+            leaf_bbx_iterator& operator++();
+
+        protected:
+            /// moves node to the first leaf from it on that intersects the box, code is
+            /// a Morton code inside the box and all leaves before it end below code
+            void seek(const LinearOcTreeNode* it, uint64_t code);
+
+            /// @return end of the largest aligned cube starting at code (inside the box) that lies inside the box
+            uint64_t runEnd(uint64_t code) const;
+
+            OcTreeKey min_key;
+            OcTreeKey max_key;
+            uint64_t min_code;
+            uint64_t max_code;
+            uint64_t run_end;  ///< leaves starting below this code are inside the box
+        };
+
+        LinearOcTree(double resolution);
+        ~LinearOcTree();
+
+        /// Deep copy constructor, the nodes of a mapped tree are copied into memory
+        LinearOcTree(const LinearOcTree& rhs);
+        LinearOcTree& operator=(const LinearOcTree& rhs);
+
+        /**
+         * Replaces the content by the leaves of tree. The resolution and the
+         * occupancy threshold are taken from tree.
+         * \tparam TREE occupancy octree of depth 16 with OcTreeNode values
+         */
+        template <class TREE>
+        void fromOcTree(const TREE& tree);
+
+        /**
+         * Replaces the content of tree, which has to use OcTreeNode as node
+         * (OcTree, SuperRayOcTree, CullingRegionOcTree), by the nodes of this
+         * tree. Nodes and values are restored exactly. This is also how a
+         * mapped tree is thawed for updates.
+         */
+        void toOcTree(AbstractOcTree& tree) const;
+
+        /**
+         * Writes the node arrays and their indices with a small header into a
+         * file that mapFile() can map. The file uses the byte order of the host.
+         * @return success of the operation
+         */
+        bool writeFile(const std::string& filename) const;
+
+        /**
+         * Replaces the content by the tree in a file written by writeFile(),
+         * mapped read-only instead of read. The file must not be changed while
+         * it is mapped, clear() or the destructor unmaps it.
+         * @return false if the file cannot be mapped or is not a valid tree file
+         */
+        bool mapFile(const std::string& filename);
+
+        /// @return true if the nodes are in a file mapped by mapFile()
+        inline bool isMapped() const { return mapped_data != NULL; }
+
+        void clear();
+
+        /// @return number of nodes, inner nodes included
+        inline size_t size() const { return leaves.size() + inner_nodes.size(); }
+        inline size_t getNumLeafNodes() const { return leaves.size(); }
+        inline size_t getNumInnerNodes() const { return inner_nodes.size(); }
+
+        /// @return memory of the node arrays and their indices in bytes, mapped files not included
+        size_t memoryUsage() const;
+
+        void setResolution(double r);
+        inline double getResolution() const { return resolution; }
+        inline unsigned int getTreeDepth() const { return tree_depth; }
+        inline double getNodeSize(unsigned depth) const { assert(depth <= tree_depth); return sizeLookupTable[depth]; }
+
+        void setOccupancyThres(double prob) { occ_prob_thres_log = logodds(prob); }
+        double getOccupancyThres() const { return probability(occ_prob_thres_log); }
+        float getOccupancyThresLog() const { return occ_prob_thres_log; }
+
+        inline bool isNodeOccupied(const LinearOcTreeNode* node) const { return node->getLogOdds() >= occ_prob_thres_log; }
+        inline bool isNodeOccupied(const LinearOcTreeNode& node) const { return node.getLogOdds() >= occ_prob_thres_log; }
+
+        /**
+         * Search node at specified depth given a key (depth=0: search full tree depth).
+         * Like OcTree::search(), a leaf above the depth is returned if it covers the key.
+         * @return pointer to node if found, NULL otherwise
+         */
+        const LinearOcTreeNode* search(const OcTreeKey& key, unsigned int depth = 0) const;
+
+        /// Search node at specified depth given a 3d point (depth=0: search full tree depth)
+        const LinearOcTreeNode* search(const point3d& value, unsigned int depth = 0) const;
+
+        /// Search node at specified depth given a 3d point (depth=0: search full tree depth)
+        const LinearOcTreeNode* search(double x, double y, double z, unsigned int depth = 0) const;
+
+        /**
+         * Performs raycasting in 3d with the semantics of OccupancyOcTreeBase::castRay():
+         * the same cells are visited and the same end point is returned. Cells
+         * inside the leaf, free subtree or unknown region found for the
+         * previous cell are passed without a search.
+         */
+        bool castRay(const point3d& origin, const point3d& direction, point3d& end,
+                     bool ignoreUnknown = false, double maxRange = -1.0) const;
+
+        leaf_iterator begin_leafs() const { return leaf_iterator(this, leaves.begin()); }
+        leaf_iterator end_leafs() const { return leaf_iterator(this, leaves.end()); }
+
+        leaf_bbx_iterator begin_leafs_bbx(const OcTreeKey& min, const OcTreeKey& max) const {
+            return leaf_bbx_iterator(this, min, max);
+        }
+        leaf_bbx_iterator begin_leafs_bbx(const point3d& min, const point3d& max) const {
+            return leaf_bbx_iterator(this, coordToKey(min), coordToKey(max));
+        }
+        leaf_bbx_iterator end_leafs_bbx() const { return leaf_bbx_iterator(this, leaves.end()); }
+
+        // -- access tree nodes and keys (as in OcTreeBaseImpl) --
+
+        inline key_type coordToKey(double coordinate) const {
+            return ((int) floor(resolution_factor * coordinate)) + tree_max_val;
+        }
+        inline OcTreeKey coordToKey(const point3d& coord) const {
+            return OcTreeKey(coordToKey(coord(0)), coordToKey(coord(1)), coordToKey(coord(2)));
+        }
+        bool coordToKeyChecked(const point3d& coord, OcTreeKey& key) const;
+
+        inline double keyToCoord(key_type key) const {
+            return (double((int) key - (int) tree_max_val) + 0.5) * resolution;
+        }
+        double keyToCoord(key_type key, unsigned depth) const;
+        inline point3d keyToCoord(const OcTreeKey& key) const {
+            return point3d(float(keyToCoord(key[0])), float(keyToCoord(key[1])), float(keyToCoord(key[2])));
+        }
+        inline point3d keyToCoord(const OcTreeKey& key, unsigned depth) const {
+            return point3d(float(keyToCoord(key[0], depth)), float(keyToCoord(key[1], depth)), float(keyToCoord(key[2], depth)));
+        }
+
+        /// @return key of node, the center key for nodes above the maximum depth
+        OcTreeKey nodeKey(const LinearOcTreeNode& node) const;
+
+    protected:
+        /// @return mask of the Morton code bits below a node at depth
+        inline uint64_t codeMask(unsigned int depth) const { return (((uint64_t)1) << (3 * (tree_depth - depth))) - 1; }
+
+        /// @return the first of the sorted nodes with a sort key above sort_key, found through their sparse index
+        static const LinearOcTreeNode* upperBound(const ConstArray<LinearOcTreeNode>& nodes, const ConstArray<uint64_t>& index,
+                                                  uint64_t sort_key);
+
+        /// @return the leaf covering the cell with Morton code code, NULL if the cell is unknown
+        const LinearOcTreeNode* findLeaf(uint64_t code) const;
+
+        /// @return the inner node at depth with Morton code code (low bits cleared), NULL if it does not exist
+        const LinearOcTreeNode* findInnerNode(uint64_t code, unsigned int depth) const;
+
+        /**
+         * Finds the largest cube around the cell of key that castRay() can pass
+         * with one answer: the occupied leaf, the largest completely known free
+         * subtree, or the largest unknown region of the cell.
+         * @param[out] shift the cube covers the keys equal to key above bit shift
+         * @param[out] state 1: occupied, 0: free, -1: unknown
+         */
+        void findRayCube(const OcTreeKey& key, unsigned int& shift, int& state) const;
+
+        /// sorts the leaves and builds the inner node summary and the key indices from them
+        void buildInnerNodes();
+
+        /// points the arrays to the vectors of the tree
+        void useStorage();
+
+        /// unmaps the file of mapFile(), if any
+        void unmapFile();
+
+        ConstArray<LinearOcTreeNode> leaves;       ///< sorted by Morton code
+        ConstArray<LinearOcTreeNode> inner_nodes;  ///< sorted by Morton code and depth
+        ConstArray<uint64_t> leaf_index;           ///< sort key of every INDEX_STRIDE-th leaf
+        ConstArray<uint64_t> inner_index;          ///< sort key of every INDEX_STRIDE-th inner node
+
+        // storage of the arrays unless they are mapped
+        std::vector<LinearOcTreeNode> leaf_storage;
+        std::vector<LinearOcTreeNode> inner_storage;
+        std::vector<uint64_t> leaf_index_storage;
+        std::vector<uint64_t> inner_index_storage;
+
+        void* mapped_data;   ///< file mapped by mapFile(), NULL if none
+        size_t mapped_size;
+
+        const unsigned int tree_depth;
+        const unsigned int tree_max_val;
+        double resolution;
+        double resolution_factor;
+        std::vector<double> sizeLookupTable;
+        float occ_prob_thres_log;
+    };
+
+
+    template <class TREE>
+    void LinearOcTree::fromOcTree(const TREE& tree) {
+        assert(tree.getTreeDepth() == tree_depth);
+        clear();
+        setResolution(tree.getResolution());
+        occ_prob_thres_log = tree.getOccupancyThresLog();
+
+        leaf_storage.reserve(tree.getNumLeafNodes());
+        for (typename TREE::leaf_iterator it = tree.begin_leafs(), end = tree.end_leafs(); it != end; ++it) {
+            unsigned int depth = it.getDepth();
+            uint64_t code = it.getKey().mortonCode() & ~codeMask(depth);
+            leaf_storage.push_back(LinearOcTreeNode(code, depth, it->getLogOdds(), 0, true));
+        }
+        buildInnerNodes();
+    }
+
+} // end namespace
+
+#endif
@@ -40,14 +40,14 @@
 
 
 namespace octomap {
-    template <class NODE>
-    class OcTreeBase : public OcTreeBaseImpl<NODE,AbstractOcTree> {
+    template <class NODE,class ALLOCATOR = OcTreeHeapAllocator<NODE> >
+    class OcTreeBase : public OcTreeBaseImpl<NODE,AbstractOcTree,ALLOCATOR> {
     public:
-        OcTreeBase<NODE>(double res) : OcTreeBaseImpl<NODE,AbstractOcTree>(res) {};
+        OcTreeBase(double res) : OcTreeBaseImpl<NODE,AbstractOcTree,ALLOCATOR>(res) {};
 
         /// virtual constructor: creates a new object of same type
         /// (Covariant return type requires an up-to-date compiler)
-        OcTreeBase<NODE>* create() const {return new OcTreeBase<NODE>(this->resolution); }
+        OcTreeBase<NODE,ALLOCATOR>* create() const {return new OcTreeBase<NODE,ALLOCATOR>(this->resolution); }
         std::string getTreeType() const {return "OcTreeBase";}
     };
 
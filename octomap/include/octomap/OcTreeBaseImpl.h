@@ -40,10 +40,13 @@
 #include <iterator>
 #include <stack>
 #include <bitset>
+#include <streambuf>
+#include <climits>
 
 #include "octomap_types.h"
 #include "OcTreeKey.h"
 #include "ScanGraph.h"
+#include "OcTreeNodeAllocator.h"
 
 
 namespace octomap {
@@ -70,23 +73,57 @@ namespace octomap {
      *    OcTreeDataNode)
      * \tparam INTERFACE Interface to be derived from, should be either
      *    AbstractOcTree or AbstractOccupancyOcTree
+     * \tparam ALLOCATOR Allocation policy of the nodes, OcTreeHeapAllocator
+     *    (default) or OcTreeNodeArena
      */
-    template <class NODE,class INTERFACE>
+    template <class NODE,class INTERFACE,class ALLOCATOR = OcTreeHeapAllocator<NODE> >
     class OcTreeBaseImpl : public INTERFACE {
 
     public:
         /// Make the templated NODE type available from the outside
         typedef NODE NodeType;
+        /// Make the allocation policy available from the outside
+        typedef ALLOCATOR AllocatorType;
 
         // the actual iterator implementation is included here
         // as a member from this file
 #include <octomap/OcTreeIterator.hxx>
 
+        /**
+         * Remembers the root-to-leaf path of the last search() made through it. The next
+         * search starts at the deepest common ancestor of the old and the new key instead
+         * of the root, so coherent accesses (ray traversal, neighbour queries, sorted keys)
+         * only descend the last few levels. The cursor notices node deletions in its tree
+         * and restarts at the root then; it must not be used after the tree is destroyed.
+         */
+        class SearchCursor {
+        public:
+          SearchCursor() : tree(NULL), node_deletions(0), key(0, 0, 0), depth(0) {}
+
+          /// Forgets the remembered path, the next search starts at the root
+          void reset() { tree = NULL; }
+
+          /// @return depth of the deepest node reached by the last search
+          unsigned int getDepth() const { return depth; }
+
+          /// @return node at depth d <= getDepth() on the path of the last search
+          NODE* getNode(unsigned int d) const { assert(d <= depth); return path[d]; }
+
+        private:
+          friend class OcTreeBaseImpl<NODE,INTERFACE,ALLOCATOR>;
+
+          const OcTreeBaseImpl<NODE,INTERFACE,ALLOCATOR>* tree; ///< tree of the path, NULL if none
+          size_t node_deletions; ///< deletion count of the tree when the path was recorded
+          OcTreeKey key;         ///< key of the last search
+          unsigned int depth;
+          NODE* path[17];        ///< path[0] is the root, the tree depth is at most 16
+        };
+
         OcTreeBaseImpl(double resolution);
         virtual ~OcTreeBaseImpl();
 
         /// Deep copy constructor
-        OcTreeBaseImpl(const OcTreeBaseImpl<NODE,INTERFACE>& rhs);
+        OcTreeBaseImpl(const OcTreeBaseImpl<NODE,INTERFACE,ALLOCATOR>& rhs);
 
 
         /**
@@ -95,11 +132,11 @@ namespace octomap {
          * metadata (resolution etc) matches. No memory is cleared
          * in this function
          */
-        void swapContent(OcTreeBaseImpl<NODE,INTERFACE>& rhs);
+        void swapContent(OcTreeBaseImpl<NODE,INTERFACE,ALLOCATOR>& rhs);
 
         /// Comparison between two octrees, all meta data, all
         /// nodes, and the structure must be identical
-        bool operator== (const OcTreeBaseImpl<NODE,INTERFACE>& rhs) const;
+        bool operator== (const OcTreeBaseImpl<NODE,INTERFACE,ALLOCATOR>& rhs) const;
 
         std::string getTreeType() const {return "OcTreeBaseImpl";}
 
@@ -199,6 +236,14 @@ namespace octomap {
          */
         NODE* search(const OcTreeKey& key, unsigned int depth = 0) const;
 
+        /**
+         *  Search a node like search(key, depth), resuming at the deepest node that the
+         *  path of the previous search through cursor shares with key. The path to the
+         *  returned node (or to the deepest existing node above key) is stored in cursor.
+         *  @return pointer to node if found, NULL otherwise
+         */
+        NODE* search(const OcTreeKey& key, SearchCursor& cursor, unsigned int depth = 0) const;
+
         /**
          *  Delete a node (if exists) given a 3d point. Will always
          *  delete at the lowest level unless depth !=0, and expand pruned inner nodes as needed.
@@ -228,10 +273,12 @@ namespace octomap {
          * children if they have identical values. You usually don't have to call
          * prune() after a regular occupancy update, updateNode() incrementally
          * prunes all affected nodes.
+         * With OpenMP, the subtrees are searched for collapsible nodes in parallel
+         * tasks, which take turns in pruning them.
          */
         virtual void prune();
 
-        /// Expands all pruned nodes (reverse of prune())
+        /// Expands all pruned nodes (reverse of prune()), in parallel subtree tasks with OpenMP
         /// \note This is an expensive operation, especially when the tree is nearly empty!
         virtual void expand();
 
@@ -321,6 +368,18 @@ namespace octomap {
         /// Pruning the tree first produces smaller files (lossless compression)
         std::ostream& writeData(std::ostream &s) const;
 
+        /**
+         * Read all nodes from the input stream in the chunked format of
+         * writeChunkedData() (without file header), for this the tree needs to
+         * be already created. The sections are read in batches of CHUNK_BATCH
+         * and decoded in parallel. For general file IO, you should probably
+         * use AbstractOcTree::readChunked() instead.
+         */
+        std::istream& readChunkedData(std::istream &s);
+
+        /// Write all nodes to stream in the chunked format (without file header), see AbstractOcTree::writeChunked()
+        std::ostream& writeChunkedData(std::ostream &s) const;
+
         typedef leaf_iterator iterator;
 
         /// @return beginning of the tree as leaf iterator
@@ -516,9 +575,21 @@ namespace octomap {
         /// recursive call of writeData()
         std::ostream& writeNodesRecurs(const NODE*, std::ostream &s) const;
 
-        /// Recursively delete a node and all children. Deallocates memory
-        /// but does NOT set the node ptr to NULL nor updates tree size.
-        void deleteNodeRecurs(NODE* node);
+        /// recursive call of readChunkedData() for the sections, allocates the children from allocator,
+        /// counts them in num_nodes and fails the stream on a child mask below the maximum depth
+        std::istream& readNodesRecurs(NODE* node, unsigned int depth, std::istream &s, ALLOCATOR& allocator, size_t& num_nodes);
+
+        /// reads the nodes above chunk_depth in the chunked format and collects the roots of the sections
+        void readChunkTopRecurs(NODE* node, unsigned int depth, unsigned int chunk_depth, std::istream &s,
+                                std::vector<NODE*>& sections);
+
+        /// writes the nodes above CHUNK_DEPTH in the chunked format and collects the roots of the sections
+        void writeChunkTopRecurs(const NODE* node, unsigned int depth, std::ostream &s,
+                                 std::vector<const NODE*>& sections) const;
+
+        /// Recursively delete all children of a node and its child pointer array.
+        /// Deallocates memory but does NOT free the node itself nor updates tree size.
+        void deleteNodeChildrenRecurs(NODE* node);
 
         /// recursive call of deleteNode()
         bool deleteNodeRecurs(NODE* node, unsigned int depth, unsigned int max_depth, const OcTreeKey& key);
@@ -526,19 +597,74 @@ namespace octomap {
         /// recursive call of prune()
         void pruneRecurs(NODE* node, unsigned int depth, unsigned int max_depth, unsigned int& num_pruned);
 
-        /// recursive call of expand()
-        void expandRecurs(NODE* node, unsigned int depth, unsigned int max_depth);
+        /// recursive call of expand(), allocates the new nodes from allocator and counts them in num_created
+        void expandRecurs(NODE* node, unsigned int depth, unsigned int max_depth, ALLOCATOR& allocator, size_t& num_created);
 
         size_t getNumLeafNodesRecurs(const NODE* parent) const;
 
     private:
         /// Assignment operator is private: don't (re-)assign octrees
         /// (const-parameters can't be changed) -  use the copy constructor instead.
-        OcTreeBaseImpl<NODE,INTERFACE>& operator=(const OcTreeBaseImpl<NODE,INTERFACE>&);
+        OcTreeBaseImpl<NODE,INTERFACE,ALLOCATOR>& operator=(const OcTreeBaseImpl<NODE,INTERFACE,ALLOCATOR>&);
 
     protected:
         void allocNodeChildren(NODE* node);
 
+        /// Frees the child pointer array of node, whose children have to be deleted already
+        void freeNodeChildren(NODE* node);
+
+        /// recursive call of the copy constructor, copies the children of rhs below node
+        void copyNodeChildrenRecurs(NODE* node, const NODE* rhs);
+
+        /// Shortens the path of cursor to depth and marks it current again, for
+        /// callers that deleted nodes of this tree below that depth only
+        void truncateCursor(SearchCursor& cursor, unsigned int depth) const;
+
+        /// Nodes above this depth fork an OpenMP task per child in the recursive passes
+        /// (prune(), expand(), updateInnerOccupancy()), deeper subtrees are processed by one task
+        static const unsigned int PARALLEL_TASK_DEPTH = 3;
+
+        /// Depth of the roots of the sections of the chunked format
+        static const unsigned int CHUNK_DEPTH = 3;
+        /// Number of sections of the chunked format that are buffered and encoded / decoded together
+        static const size_t CHUNK_BATCH = 64;
+
+        /// Input stream buffer over a section of the chunked format in memory
+        class SectionBuf : public std::streambuf {
+        public:
+          SectionBuf(char* data, size_t size) { setg(data, data, data + size); }
+        };
+
+        /// Output stream buffer that encodes a section of the chunked format into a string,
+        /// which keeps its capacity for the next section
+        class SectionWriteBuf : public std::streambuf {
+        public:
+          SectionWriteBuf(std::string& buffer) : buffer(buffer) {
+            buffer.resize(buffer.capacity());
+            setp(&buffer[0], &buffer[0] + buffer.size());
+          }
+          /// @return number of bytes written
+          size_t size() const { return pptr() - pbase(); }
+        protected:
+          int_type overflow(int_type c) {
+            size_t written = size();
+            buffer.resize(std::max(2 * buffer.size(), (size_t) 4096));
+            setp(&buffer[0], &buffer[0] + buffer.size());
+            for (; written > (size_t) INT_MAX; written -= INT_MAX)
+              pbump(INT_MAX);
+            pbump((int) written);
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+              *pptr() = traits_type::to_char_type(c);
+              pbump(1);
+            }
+            return traits_type::not_eof(c);
+          }
+        private:
+          std::string& buffer;
+        };
+
+        ALLOCATOR node_allocator; ///< Allocates all nodes and child pointer arrays of the tree
+
         NODE* root; ///< Pointer to the root NODE, NULL for empty tree
 
         // constants of the tree
@@ -548,6 +674,8 @@ namespace octomap {
         double resolution_factor; ///< = 1. / resolution
 
         size_t tree_size; ///< number of nodes in tree
+        /// counts the operations that deleted nodes, invalidates the path of a SearchCursor
+        size_t node_deletions;
         /// flag to denote whether the octree extent changed (for lazy min/max eval)
         bool size_changed;
 
@@ -42,10 +42,10 @@
 namespace octomap {
 
 
-    template <class NODE,class I>
-    OcTreeBaseImpl<NODE,I>::OcTreeBaseImpl(double in_resolution) :
+    template <class NODE,class I,class A>
+    OcTreeBaseImpl<NODE,I,A>::OcTreeBaseImpl(double in_resolution) :
             I(), root(NULL), tree_depth(16), tree_max_val(32768),
-            resolution(in_resolution), tree_size(0)
+            resolution(in_resolution), tree_size(0), node_deletions(0)
     {
 
       init();
@@ -53,10 +53,10 @@ namespace octomap {
       // no longer create an empty root node - only on demand
     }
 
-    template <class NODE,class I>
-    OcTreeBaseImpl<NODE,I>::OcTreeBaseImpl(double in_resolution, unsigned int in_tree_depth, unsigned int in_tree_max_val) :
+    template <class NODE,class I,class A>
+    OcTreeBaseImpl<NODE,I,A>::OcTreeBaseImpl(double in_resolution, unsigned int in_tree_depth, unsigned int in_tree_max_val) :
             I(), root(NULL), tree_depth(in_tree_depth), tree_max_val(in_tree_max_val),
-            resolution(in_resolution), tree_size(0)
+            resolution(in_resolution), tree_size(0), node_deletions(0)
     {
       init();
 
@@ -64,27 +64,30 @@ namespace octomap {
     }
 
 
-    template <class NODE,class I>
-    OcTreeBaseImpl<NODE,I>::~OcTreeBaseImpl(){
+    template <class NODE,class I,class A>
+    OcTreeBaseImpl<NODE,I,A>::~OcTreeBaseImpl(){
       clear();
     }
 
 
-    template <class NODE,class I>
-    OcTreeBaseImpl<NODE,I>::OcTreeBaseImpl(const OcTreeBaseImpl<NODE,I>& rhs) :
+    template <class NODE,class I,class A>
+    OcTreeBaseImpl<NODE,I,A>::OcTreeBaseImpl(const OcTreeBaseImpl<NODE,I,A>& rhs) :
             root(NULL), tree_depth(rhs.tree_depth), tree_max_val(rhs.tree_max_val),
-            resolution(rhs.resolution), tree_size(rhs.tree_size)
+            resolution(rhs.resolution), tree_size(rhs.tree_size), node_deletions(0)
     {
       init();
 
       // copy nodes recursively:
-      if (rhs.root)
-        root = new NODE(*(rhs.root));
+      if (rhs.root){
+        root = node_allocator.allocNode();
+        root->copyData(*(rhs.root));
+        copyNodeChildrenRecurs(root, rhs.root);
+      }
 
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::init(){
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::init(){
 
       this->setResolution(this->resolution);
       for (unsigned i = 0; i< 3; i++){
@@ -110,29 +113,34 @@ namespace octomap {
 
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::swapContent(OcTreeBaseImpl<NODE,I>& other){
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::swapContent(OcTreeBaseImpl<NODE,I,A>& other){
       NODE* this_root = root;
       root = other.root;
       other.root = this_root;
+      node_allocator.swap(other.node_allocator);
 
       size_t this_size = this->tree_size;
       this->tree_size = other.tree_size;
       other.tree_size = this_size;
+
+      // the roots changed, invalidate the cursors of both trees
+      this->node_deletions++;
+      other.node_deletions++;
     }
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::operator== (const OcTreeBaseImpl<NODE,I>& other) const{
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::operator== (const OcTreeBaseImpl<NODE,I,A>& other) const{
       if (tree_depth != other.tree_depth || tree_max_val != other.tree_max_val
           || resolution != other.resolution || tree_size != other.tree_size){
         return false;
       }
 
       // traverse all nodes, check if structure the same
-      typename OcTreeBaseImpl<NODE,I>::tree_iterator it = this->begin_tree();
-      typename OcTreeBaseImpl<NODE,I>::tree_iterator end = this->end_tree();
-      typename OcTreeBaseImpl<NODE,I>::tree_iterator other_it = other.begin_tree();
-      typename OcTreeBaseImpl<NODE,I>::tree_iterator other_end = other.end_tree();
+      typename OcTreeBaseImpl<NODE,I,A>::tree_iterator it = this->begin_tree();
+      typename OcTreeBaseImpl<NODE,I,A>::tree_iterator end = this->end_tree();
+      typename OcTreeBaseImpl<NODE,I,A>::tree_iterator other_it = other.begin_tree();
+      typename OcTreeBaseImpl<NODE,I,A>::tree_iterator other_end = other.end_tree();
 
       for (; it != end; ++it, ++other_it){
         if (other_it == other_end)
@@ -152,8 +160,8 @@ namespace octomap {
       return true;
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::setResolution(double r) {
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::setResolution(double r) {
       resolution = r;
       resolution_factor = 1. / resolution;
 
@@ -169,14 +177,14 @@ namespace octomap {
       size_changed = true;
     }
 
-    template <class NODE,class I>
-    NODE* OcTreeBaseImpl<NODE,I>::createNodeChild(NODE* node, unsigned int childIdx){
+    template <class NODE,class I,class A>
+    NODE* OcTreeBaseImpl<NODE,I,A>::createNodeChild(NODE* node, unsigned int childIdx){
       assert(childIdx < 8);
       if (node->children == NULL) {
         allocNodeChildren(node);
       }
       assert (node->children[childIdx] == NULL);
-      NODE* newNode = new NODE();
+      NODE* newNode = node_allocator.allocChild(node->children, childIdx);
       node->children[childIdx] = static_cast<AbstractOcTreeNode*>(newNode);
 
       tree_size++;
@@ -185,33 +193,34 @@ namespace octomap {
       return newNode;
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::deleteNodeChild(NODE* node, unsigned int childIdx){
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::deleteNodeChild(NODE* node, unsigned int childIdx){
       assert((childIdx < 8) && (node->children != NULL));
       assert(node->children[childIdx] != NULL);
-      delete static_cast<NODE*>(node->children[childIdx]); // TODO delete check if empty
+      node_allocator.freeChild(node->children, childIdx); // TODO delete check if empty
       node->children[childIdx] = NULL;
 
       tree_size--;
       size_changed = true;
+      node_deletions++;
     }
 
-    template <class NODE,class I>
-    NODE* OcTreeBaseImpl<NODE,I>::getNodeChild(NODE* node, unsigned int childIdx) const{
+    template <class NODE,class I,class A>
+    NODE* OcTreeBaseImpl<NODE,I,A>::getNodeChild(NODE* node, unsigned int childIdx) const{
       assert((childIdx < 8) && (node->children != NULL));
       assert(node->children[childIdx] != NULL);
       return static_cast<NODE*>(node->children[childIdx]);
     }
 
-    template <class NODE,class I>
-    const NODE* OcTreeBaseImpl<NODE,I>::getNodeChild(const NODE* node, unsigned int childIdx) const{
+    template <class NODE,class I,class A>
+    const NODE* OcTreeBaseImpl<NODE,I,A>::getNodeChild(const NODE* node, unsigned int childIdx) const{
       assert((childIdx < 8) && (node->children != NULL));
       assert(node->children[childIdx] != NULL);
       return static_cast<const NODE*>(node->children[childIdx]);
     }
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::isNodeCollapsible(const NODE* node) const{
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::isNodeCollapsible(const NODE* node) const{
       // all children must exist, must not have children of
       // their own and have the same occupancy probability
       if (!nodeChildExists(node, 0))
@@ -231,8 +240,8 @@ namespace octomap {
       return true;
     }
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::nodeChildExists(const NODE* node, unsigned int childIdx) const{
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::nodeChildExists(const NODE* node, unsigned int childIdx) const{
       assert(childIdx < 8);
       if ((node->children != NULL) && (node->children[childIdx] != NULL))
         return true;
@@ -240,8 +249,8 @@ namespace octomap {
         return false;
     }
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::nodeHasChildren(const NODE* node) const {
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::nodeHasChildren(const NODE* node) const {
       if (node->children == NULL)
         return false;
 
@@ -253,8 +262,8 @@ namespace octomap {
     }
 
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::expandNode(NODE* node){
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::expandNode(NODE* node){
       assert(!nodeHasChildren(node));
 
       for (unsigned int k=0; k<8; k++) {
@@ -263,8 +272,8 @@ namespace octomap {
       }
     }
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::pruneNode(NODE* node){
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::pruneNode(NODE* node){
 
       if (!isNodeCollapsible(node))
         return false;
@@ -276,25 +285,44 @@ namespace octomap {
       for (unsigned int i=0;i<8;i++) {
         deleteNodeChild(node, i);
       }
-      delete[] node->children;
-      node->children = NULL;
+      freeNodeChildren(node);
 
       return true;
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::allocNodeChildren(NODE* node){
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::allocNodeChildren(NODE* node){
       // TODO NODE*
-      node->children = new AbstractOcTreeNode*[8];
+      node->children = node_allocator.allocChildren();
+    }
+
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::freeNodeChildren(NODE* node){
+      node_allocator.freeChildren(node->children);
+      node->children = NULL;
+      node_deletions++;
+    }
+
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::copyNodeChildrenRecurs(NODE* node, const NODE* rhs){
+      if (rhs->children == NULL)
+        return;
+
+      allocNodeChildren(node);
       for (unsigned int i=0; i<8; i++) {
-        node->children[i] = NULL;
+        if (rhs->children[i] != NULL){
+          NODE* child = node_allocator.allocChild(node->children, i);
+          node->children[i] = static_cast<AbstractOcTreeNode*>(child);
+          child->copyData(*static_cast<const NODE*>(rhs->children[i]));
+          copyNodeChildrenRecurs(child, static_cast<const NODE*>(rhs->children[i]));
+        }
       }
     }
 
 
 
-    template <class NODE,class I>
-    inline key_type OcTreeBaseImpl<NODE,I>::coordToKey(double coordinate, unsigned depth) const{
+    template <class NODE,class I,class A>
+    inline key_type OcTreeBaseImpl<NODE,I,A>::coordToKey(double coordinate, unsigned depth) const{
       assert (depth <= tree_depth);
       int keyval = ((int) floor(resolution_factor * coordinate));
 
@@ -306,8 +334,8 @@ namespace octomap {
     }
 
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::coordToKeyChecked(double coordinate, key_type& keyval) const {
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::coordToKeyChecked(double coordinate, key_type& keyval) const {
 
       // scale to resolution and shift center for tree_max_val
       int scaled_coord =  ((int) floor(resolution_factor * coordinate)) + tree_max_val;
@@ -321,8 +349,8 @@ namespace octomap {
     }
 
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::coordToKeyChecked(double coordinate, unsigned depth, key_type& keyval) const {
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::coordToKeyChecked(double coordinate, unsigned depth, key_type& keyval) const {
 
       // scale to resolution and shift center for tree_max_val
       int scaled_coord =  ((int) floor(resolution_factor * coordinate)) + tree_max_val;
@@ -336,8 +364,8 @@ namespace octomap {
       return false;
     }
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::coordToKeyChecked(const point3d& point, OcTreeKey& key) const{
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::coordToKeyChecked(const point3d& point, OcTreeKey& key) const{
 
       for (unsigned int i=0;i<3;i++) {
         if (!coordToKeyChecked( point(i), key[i])) return false;
@@ -345,8 +373,8 @@ namespace octomap {
       return true;
     }
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::coordToKeyChecked(const point3d& point, unsigned depth, OcTreeKey& key) const{
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::coordToKeyChecked(const point3d& point, unsigned depth, OcTreeKey& key) const{
 
       for (unsigned int i=0;i<3;i++) {
         if (!coordToKeyChecked( point(i), depth, key[i])) return false;
@@ -354,8 +382,8 @@ namespace octomap {
       return true;
     }
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::coordToKeyChecked(double x, double y, double z, OcTreeKey& key) const{
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::coordToKeyChecked(double x, double y, double z, OcTreeKey& key) const{
 
       if (!(coordToKeyChecked(x, key[0])
             && coordToKeyChecked(y, key[1])
@@ -367,8 +395,8 @@ namespace octomap {
       }
     }
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::coordToKeyChecked(double x, double y, double z, unsigned depth, OcTreeKey& key) const{
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::coordToKeyChecked(double x, double y, double z, unsigned depth, OcTreeKey& key) const{
 
       if (!(coordToKeyChecked(x, depth, key[0])
             && coordToKeyChecked(y, depth, key[1])
@@ -380,8 +408,8 @@ namespace octomap {
       }
     }
 
-    template <class NODE,class I>
-    key_type OcTreeBaseImpl<NODE,I>::adjustKeyAtDepth(key_type key, unsigned int depth) const{
+    template <class NODE,class I,class A>
+    key_type OcTreeBaseImpl<NODE,I,A>::adjustKeyAtDepth(key_type key, unsigned int depth) const{
       unsigned int diff = tree_depth - depth;
 
       if(diff == 0)
@@ -390,8 +418,8 @@ namespace octomap {
         return (((key-tree_max_val) >> diff) << diff) + (1 << (diff-1)) + tree_max_val;
     }
 
-    template <class NODE,class I>
-    double OcTreeBaseImpl<NODE,I>::keyToCoord(key_type key, unsigned depth) const{
+    template <class NODE,class I,class A>
+    double OcTreeBaseImpl<NODE,I,A>::keyToCoord(key_type key, unsigned depth) const{
       assert(depth <= tree_depth);
 
       // root is centered on 0 = 0.0
@@ -404,8 +432,8 @@ namespace octomap {
       }
     }
 
-    template <class NODE,class I>
-    NODE* OcTreeBaseImpl<NODE,I>::search(const point3d& value, unsigned int depth) const {
+    template <class NODE,class I,class A>
+    NODE* OcTreeBaseImpl<NODE,I,A>::search(const point3d& value, unsigned int depth) const {
       OcTreeKey key;
       if (!coordToKeyChecked(value, key)){
         OCTOMAP_ERROR_STR("Error in search: ["<< value <<"] is out of OcTree bounds!");
@@ -417,8 +445,8 @@ namespace octomap {
 
     }
 
-    template <class NODE,class I>
-    NODE* OcTreeBaseImpl<NODE,I>::search(double x, double y, double z, unsigned int depth) const {
+    template <class NODE,class I,class A>
+    NODE* OcTreeBaseImpl<NODE,I,A>::search(double x, double y, double z, unsigned int depth) const {
       OcTreeKey key;
       if (!coordToKeyChecked(x, y, z, key)){
         OCTOMAP_ERROR_STR("Error in search: ["<< x <<" "<< y << " " << z << "] is out of OcTree bounds!");
@@ -430,8 +458,8 @@ namespace octomap {
     }
 
 
-    template <class NODE,class I>
-    NODE* OcTreeBaseImpl<NODE,I>::search (const OcTreeKey& key, unsigned int depth) const {
+    template <class NODE,class I,class A>
+    NODE* OcTreeBaseImpl<NODE,I,A>::search (const OcTreeKey& key, unsigned int depth) const {
       assert(depth <= tree_depth);
       if (root == NULL)
         return NULL;
@@ -470,9 +498,68 @@ namespace octomap {
       return curNode;
     }
 
+    template <class NODE,class I,class A>
+    NODE* OcTreeBaseImpl<NODE,I,A>::search (const OcTreeKey& key, SearchCursor& cursor, unsigned int depth) const {
+      assert(depth <= tree_depth);
+      if (root == NULL){
+        cursor.reset();
+        return NULL;
+      }
+
+      if (depth == 0)
+        depth = tree_depth;
+
+      OcTreeKey key_at_depth = key;
+      if (depth != tree_depth)
+        key_at_depth = adjustKeyAtDepth(key, depth);
+
+      unsigned int cur_depth = 0;
+      if (cursor.tree != this || cursor.node_deletions != node_deletions){
+        // no usable path, start at the root
+        cursor.tree = this;
+        cursor.node_deletions = node_deletions;
+        cursor.path[0] = root;
+      } else {
+        // both keys share their ancestors down to the highest differing bit
+        unsigned int diff = (key_at_depth[0] ^ cursor.key[0]) | (key_at_depth[1] ^ cursor.key[1]) | (key_at_depth[2] ^ cursor.key[2]);
+        cur_depth = tree_depth;
+        for (; diff != 0; diff >>= 1)
+          cur_depth--;
+        // neither reuse the path beyond the last search nor beyond the requested depth
+        cur_depth = std::min(std::min(cur_depth, cursor.depth), depth);
+      }
+      cursor.key = key_at_depth;
+
+      NODE* curNode = cursor.path[cur_depth];
+      for (; cur_depth < depth; ++cur_depth) {
+        unsigned int pos = computeChildIdx(key_at_depth, tree_depth-1-cur_depth);
+        if (nodeChildExists(curNode, pos)) {
+          curNode = getNodeChild(curNode, pos);
+          cursor.path[cur_depth+1] = curNode;
+        } else {
+          cursor.depth = cur_depth;
+          // a pruned leaf covers the key, otherwise the search failed
+          if (!nodeHasChildren(curNode))
+            return curNode;
+          else
+            return NULL;
+        }
+      }
+      cursor.depth = cur_depth;
+      return curNode;
+    }
+
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::truncateCursor(SearchCursor& cursor, unsigned int depth) const {
+      if (cursor.tree != this)
+        return;
+      cursor.depth = std::min(cursor.depth, depth);
+      cursor.node_deletions = node_deletions;
+    }
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::deleteNode(const point3d& value, unsigned int depth) {
+
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::deleteNode(const point3d& value, unsigned int depth) {
       OcTreeKey key;
       if (!coordToKeyChecked(value, key)){
         OCTOMAP_ERROR_STR("Error in deleteNode: ["<< value <<"] is out of OcTree bounds!");
@@ -484,8 +571,8 @@ namespace octomap {
 
     }
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::deleteNode(double x, double y, double z, unsigned int depth) {
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::deleteNode(double x, double y, double z, unsigned int depth) {
       OcTreeKey key;
       if (!coordToKeyChecked(x, y, z, key)){
         OCTOMAP_ERROR_STR("Error in deleteNode: ["<< x <<" "<< y << " " << z << "] is out of OcTree bounds!");
@@ -497,8 +584,8 @@ namespace octomap {
     }
 
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::deleteNode(const OcTreeKey& key, unsigned int depth) {
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::deleteNode(const OcTreeKey& key, unsigned int depth) {
       if (root == NULL)
         return true;
 
@@ -508,38 +595,59 @@ namespace octomap {
       return deleteNodeRecurs(root, 0, depth, key);
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::clear() {
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::clear() {
       if (this->root){
-        deleteNodeRecurs(root);
+        // an arena frees all nodes at once
+        if (!node_allocator.releaseAll()){
+          deleteNodeChildrenRecurs(root);
+          node_allocator.freeNode(root);
+        }
         this->tree_size = 0;
         this->root = NULL;
+        this->node_deletions++;
         // max extent of tree changed:
         this->size_changed = true;
       }
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::prune() {
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::prune() {
       if (root == NULL)
         return;
 
       for (unsigned int depth=tree_depth-1; depth > 0; --depth) {
         unsigned int num_pruned = 0;
+#ifdef _OPENMP
+        #pragma omp parallel
+        #pragma omp single
+#endif
         pruneRecurs(this->root, 0, depth, num_pruned);
         if (num_pruned == 0)
           break;
       }
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::expand() {
-      if (root)
-        expandRecurs(root,0, tree_depth);
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::expand() {
+      if (root == NULL)
+        return;
+
+      size_t num_created = 0;
+#ifdef _OPENMP
+      #pragma omp parallel
+      #pragma omp single
+#endif
+      expandRecurs(root, 0, tree_depth, node_allocator, num_created);
+
+      if (num_created > 0) {
+        tree_size += num_created;
+        size_changed = true;
+      }
     }
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::computeRayKeys(const point3d& origin,
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::computeRayKeys(const point3d& origin,
                                                 const point3d& end,
                                                 KeyRay& ray) const {
 
@@ -549,8 +657,8 @@ namespace octomap {
       ray.reset();
 
       OcTreeKey key_origin, key_end;
-      if ( !OcTreeBaseImpl<NODE,I>::coordToKeyChecked(origin, key_origin) ||
-           !OcTreeBaseImpl<NODE,I>::coordToKeyChecked(end, key_end) ) {
+      if ( !OcTreeBaseImpl<NODE,I,A>::coordToKeyChecked(origin, key_origin) ||
+           !OcTreeBaseImpl<NODE,I,A>::coordToKeyChecked(end, key_end) ) {
         OCTOMAP_WARNING_STR("coordinates ( "
                                     << origin << " -> " << end << ") out of bounds in computeRayKeys");
         return false;
@@ -647,8 +755,8 @@ namespace octomap {
       return true;
     }
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::computeRay(const point3d& origin, const point3d& end,
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::computeRay(const point3d& origin, const point3d& end,
                                             std::vector<point3d>& _ray) {
       _ray.clear();
       if (!computeRayKeys(origin, end, keyrays.at(0))) return false;
@@ -658,27 +766,25 @@ namespace octomap {
       return true;
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::deleteNodeRecurs(NODE* node){
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::deleteNodeChildrenRecurs(NODE* node){
       assert(node);
       // TODO: maintain tree size?
 
       if (node->children != NULL) {
         for (unsigned int i=0; i<8; i++) {
           if (node->children[i] != NULL){
-            this->deleteNodeRecurs(static_cast<NODE*>(node->children[i]));
+            this->deleteNodeChildrenRecurs(static_cast<NODE*>(node->children[i]));
+            node_allocator.freeChild(node->children, i);
           }
         }
-        delete[] node->children;
-        node->children = NULL;
+        freeNodeChildren(node);
       } // else: node has no children
-
-      delete node;
     }
 
 
-    template <class NODE,class I>
-    bool OcTreeBaseImpl<NODE,I>::deleteNodeRecurs(NODE* node, unsigned int depth, unsigned int max_depth, const OcTreeKey& key){
+    template <class NODE,class I,class A>
+    bool OcTreeBaseImpl<NODE,I,A>::deleteNodeRecurs(NODE* node, unsigned int depth, unsigned int max_depth, const OcTreeKey& key){
       if (depth >= max_depth) // on last level: delete child when going up
         return true;
 
@@ -705,8 +811,11 @@ namespace octomap {
         // TODO delete check depth, what happens to inner nodes with children?
         this->deleteNodeChild(node, pos);
 
-        if (!nodeHasChildren(node))
+        if (!nodeHasChildren(node)){
+          // release the child pointer array with the last child, the node may be deleted next
+          freeNodeChildren(node);
           return true;
+        }
         else{
           node->updateOccupancyChildren(); // TODO: occupancy?
         }
@@ -715,13 +824,29 @@ namespace octomap {
       return false;
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::pruneRecurs(NODE* node, unsigned int depth,
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::pruneRecurs(NODE* node, unsigned int depth,
                                              unsigned int max_depth, unsigned int& num_pruned) {
 
       assert(node);
 
       if (depth < max_depth) {
+#ifdef _OPENMP
+        if (depth < PARALLEL_TASK_DEPTH) {
+          // one task per child subtree
+          unsigned int child_pruned[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+          for (unsigned int i=0; i<8; i++) {
+            if (nodeChildExists(node, i)) {
+              #pragma omp task shared(child_pruned)
+              pruneRecurs(getNodeChild(node, i), depth+1, max_depth, child_pruned[i]);
+            }
+          }
+          #pragma omp taskwait
+          for (unsigned int i=0; i<8; i++)
+            num_pruned += child_pruned[i];
+          return;
+        }
+#endif
         for (unsigned int i=0; i<8; i++) {
           if (nodeChildExists(node, i)) {
             pruneRecurs(getNodeChild(node, i), depth+1, max_depth, num_pruned);
@@ -731,44 +856,80 @@ namespace octomap {
 
       else {
         // max level reached
+#ifdef _OPENMP
+        // pruning frees nodes and updates the tree size, only the test runs concurrently
+        if (isNodeCollapsible(node)) {
+          #pragma omp critical (octree_prune)
+          pruneNode(node);
+          num_pruned++;
+        }
+#else
         if (pruneNode(node)) {
           num_pruned++;
         }
+#endif
       }
     }
 
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::expandRecurs(NODE* node, unsigned int depth,
-                                              unsigned int max_depth) {
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::expandRecurs(NODE* node, unsigned int depth,
+                                              unsigned int max_depth, A& allocator, size_t& num_created) {
       if (depth >= max_depth)
         return;
 
       assert(node);
 
-      // current node has no children => can be expanded
+      // current node has no children => can be expanded (as expandNode(), but with the given allocator)
       if (!nodeHasChildren(node)){
-        expandNode(node);
+        if (node->children == NULL)
+          node->children = allocator.allocChildren();
+        for (unsigned int k=0; k<8; k++) {
+          NODE* newNode = allocator.allocChild(node->children, k);
+          node->children[k] = static_cast<AbstractOcTreeNode*>(newNode);
+          newNode->copyData(*node);
+        }
+        num_created += 8;
+      }
+
+#ifdef _OPENMP
+      if (depth < PARALLEL_TASK_DEPTH) {
+        // one task per child with an allocator of its own, merged when all are done
+        A child_allocator[8];
+        size_t child_created[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        for (unsigned int i=0; i<8; i++) {
+          if (nodeChildExists(node, i)) {
+            #pragma omp task shared(child_allocator, child_created)
+            expandRecurs(getNodeChild(node, i), depth+1, max_depth, child_allocator[i], child_created[i]);
+          }
+        }
+        #pragma omp taskwait
+        for (unsigned int i=0; i<8; i++) {
+          allocator.merge(child_allocator[i]);
+          num_created += child_created[i];
+        }
+        return;
       }
+#endif
       // recursively expand children
       for (unsigned int i=0; i<8; i++) {
         if (nodeChildExists(node, i)) { // TODO double check (node != NULL)
-          expandRecurs(getNodeChild(node, i), depth+1, max_depth);
+          expandRecurs(getNodeChild(node, i), depth+1, max_depth, allocator, num_created);
         }
       }
     }
 
 
-    template <class NODE,class I>
-    std::ostream& OcTreeBaseImpl<NODE,I>::writeData(std::ostream &s) const{
+    template <class NODE,class I,class A>
+    std::ostream& OcTreeBaseImpl<NODE,I,A>::writeData(std::ostream &s) const{
       if (root)
         writeNodesRecurs(root, s);
 
       return s;
     }
 
-    template <class NODE,class I>
-    std::ostream& OcTreeBaseImpl<NODE,I>::writeNodesRecurs(const NODE* node, std::ostream &s) const{
+    template <class NODE,class I,class A>
+    std::ostream& OcTreeBaseImpl<NODE,I,A>::writeNodesRecurs(const NODE* node, std::ostream &s) const{
       node->writeData(s);
 
       // 1 bit for each children; 0: empty, 1: allocated
@@ -797,8 +958,186 @@ namespace octomap {
       return s;
     }
 
-    template <class NODE,class I>
-    std::istream& OcTreeBaseImpl<NODE,I>::readData(std::istream &s) {
+    template <class NODE,class I,class A>
+    std::ostream& OcTreeBaseImpl<NODE,I,A>::writeChunkedData(std::ostream &s) const{
+      if (root == NULL)
+        return s;
+
+      // the nodes above the sections, encoded as in writeData()
+      uint32_t chunk_depth = CHUNK_DEPTH;
+      s.write((const char*)&chunk_depth, sizeof(chunk_depth));
+      std::vector<const NODE*> sections;
+      writeChunkTopRecurs(root, 0, s, sections);
+      uint32_t num_sections = (uint32_t) sections.size();
+      s.write((const char*)&num_sections, sizeof(num_sections));
+
+      // encode a batch of sections in parallel, then write them with their sizes in order
+      std::vector<std::string> buffers(CHUNK_BATCH);
+      std::vector<uint64_t> sizes(CHUNK_BATCH);
+      for (size_t first = 0; first < sections.size(); first += CHUNK_BATCH) {
+        int num = (int) std::min(CHUNK_BATCH, sections.size() - first);
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic)
+#endif
+        for (int i = 0; i < num; i++) {
+          SectionWriteBuf buf(buffers[i]);
+          std::ostream section(&buf);
+          writeNodesRecurs(sections[first + i], section);
+          sizes[i] = buf.size();
+        }
+        for (int i = 0; i < num; i++) {
+          s.write((const char*)&sizes[i], sizeof(sizes[i]));
+          s.write(buffers[i].data(), sizes[i]);
+        }
+      }
+      return s;
+    }
+
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::writeChunkTopRecurs(const NODE* node, unsigned int depth, std::ostream &s,
+                                                     std::vector<const NODE*>& sections) const{
+      node->writeData(s);
+
+      char children_char = 0;
+      for (unsigned int i=0; i<8; i++) {
+        if (nodeChildExists(node, i))
+          children_char |= (char) (1 << i);
+      }
+      s.write((char*)&children_char, sizeof(char));
+
+      for (unsigned int i=0; i<8; i++) {
+        if (nodeChildExists(node, i)) {
+          if (depth + 1 < CHUNK_DEPTH)
+            writeChunkTopRecurs(getNodeChild(node, i), depth + 1, s, sections);
+          else
+            sections.push_back(getNodeChild(node, i));
+        }
+      }
+    }
+
+    template <class NODE,class I,class A>
+    std::istream& OcTreeBaseImpl<NODE,I,A>::readChunkedData(std::istream &s) {
+      this->tree_size = 0;
+      size_changed = true;
+
+      // tree needs to be newly created or cleared externally
+      if (root) {
+        OCTOMAP_ERROR_STR("Trying to read into an existing tree.");
+        return s;
+      }
+
+      uint32_t chunk_depth = 0;
+      s.read((char*)&chunk_depth, sizeof(chunk_depth));
+      if (!s || chunk_depth == 0 || chunk_depth > tree_depth) {
+        OCTOMAP_ERROR_STR("Invalid section depth in chunked octree data");
+        return s;
+      }
+
+      root = node_allocator.allocNode();
+      tree_size = 1;
+      std::vector<NODE*> sections;
+      readChunkTopRecurs(root, 0, chunk_depth, s, sections);
+      uint32_t num_sections = 0;
+      s.read((char*)&num_sections, sizeof(num_sections));
+      bool valid = s.good() && num_sections == sections.size();
+
+      // read a batch of sections, then decode them in parallel, each into nodes of its own allocator
+      std::vector<std::vector<char> > buffers(CHUNK_BATCH);
+      for (size_t first = 0; valid && first < sections.size(); first += CHUNK_BATCH) {
+        int num = (int) std::min(CHUNK_BATCH, sections.size() - first);
+        for (int i = 0; valid && i < num; i++) {
+          uint64_t bytes = 0;
+          s.read((char*)&bytes, sizeof(bytes));
+          if (!s || bytes > (uint64_t) std::numeric_limits<std::streamsize>::max()) {
+            valid = false;
+            break;
+          }
+          buffers[i].resize(bytes);
+          if (bytes > 0)
+            s.read(&buffers[i][0], bytes);
+          valid = s.good();
+        }
+        if (!valid)
+          break;
+
+        std::vector<A> allocators(num);
+        std::vector<size_t> num_nodes(num, 0);
+        std::vector<char> section_valid(num, 0);
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic)
+#endif
+        for (int i = 0; i < num; i++) {
+          SectionBuf buf(buffers[i].empty() ? NULL : &buffers[i][0], buffers[i].size());
+          std::istream section(&buf);
+          readNodesRecurs(sections[first + i], chunk_depth, section, allocators[i], num_nodes[i]);
+          // the section has to be read completely
+          section_valid[i] = !section.fail() && buf.in_avail() == 0;
+        }
+        for (int i = 0; i < num; i++) {
+          node_allocator.merge(allocators[i]);
+          tree_size += num_nodes[i];
+          valid = valid && section_valid[i];
+        }
+      }
+
+      if (!valid) {
+        OCTOMAP_ERROR_STR("Corrupt chunked octree data, tree cleared.");
+        clear();
+        s.setstate(std::ios_base::failbit);
+      }
+      return s;
+    }
+
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::readChunkTopRecurs(NODE* node, unsigned int depth, unsigned int chunk_depth,
+                                                    std::istream &s, std::vector<NODE*>& sections) {
+      node->readData(s);
+
+      char children_char = 0;
+      s.read((char*)&children_char, sizeof(char));
+      if (!s)
+        return;
+
+      for (unsigned int i=0; i<8; i++) {
+        if (children_char & (1 << i)) {
+          NODE* newNode = createNodeChild(node, i);
+          if (depth + 1 < chunk_depth)
+            readChunkTopRecurs(newNode, depth + 1, chunk_depth, s, sections);
+          else
+            sections.push_back(newNode);
+        }
+      }
+    }
+
+    template <class NODE,class I,class A>
+    std::istream& OcTreeBaseImpl<NODE,I,A>::readNodesRecurs(NODE* node, unsigned int depth, std::istream &s,
+                                                         A& allocator, size_t& num_nodes) {
+      node->readData(s);
+
+      char children_char = 0;
+      s.read((char*)&children_char, sizeof(char));
+      if (!s || children_char == 0)
+        return s;
+      if (depth >= tree_depth) {
+        s.setstate(std::ios_base::failbit);
+        return s;
+      }
+
+      // as createNodeChild(), but with the given allocator
+      node->children = allocator.allocChildren();
+      for (unsigned int i=0; i<8; i++) {
+        if (children_char & (1 << i)) {
+          NODE* newNode = allocator.allocChild(node->children, i);
+          node->children[i] = static_cast<AbstractOcTreeNode*>(newNode);
+          num_nodes++;
+          readNodesRecurs(newNode, depth + 1, s, allocator, num_nodes);
+        }
+      }
+      return s;
+    }
+
+    template <class NODE,class I,class A>
+    std::istream& OcTreeBaseImpl<NODE,I,A>::readData(std::istream &s) {
 
       if (!s.good()){
         OCTOMAP_WARNING_STR(__FILE__ << ":" << __LINE__ << "Warning: Input filestream not \"good\"");
@@ -813,15 +1152,15 @@ namespace octomap {
         return s;
       }
 
-      root = new NODE();
+      root = node_allocator.allocNode();
       readNodesRecurs(root, s);
 
       tree_size = calcNumNodes();  // compute number of nodes
       return s;
     }
 
-    template <class NODE,class I>
-    std::istream& OcTreeBaseImpl<NODE,I>::readNodesRecurs(NODE* node, std::istream &s) {
+    template <class NODE,class I,class A>
+    std::istream& OcTreeBaseImpl<NODE,I,A>::readNodesRecurs(NODE* node, std::istream &s) {
 
       node->readData(s);
 
@@ -846,8 +1185,8 @@ namespace octomap {
 
 
 
-    template <class NODE,class I>
-    unsigned long long OcTreeBaseImpl<NODE,I>::memoryFullGrid() const{
+    template <class NODE,class I,class A>
+    unsigned long long OcTreeBaseImpl<NODE,I,A>::memoryFullGrid() const{
       if (root == NULL)
         return 0;
 
@@ -868,8 +1207,8 @@ namespace octomap {
     // non-const versions,
     // change min/max/size_changed members
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::getMetricSize(double& x, double& y, double& z){
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::getMetricSize(double& x, double& y, double& z){
 
       double minX, minY, minZ;
       double maxX, maxY, maxZ;
@@ -882,8 +1221,8 @@ namespace octomap {
       z = maxZ - minZ;
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::getMetricSize(double& x, double& y, double& z) const{
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::getMetricSize(double& x, double& y, double& z) const{
 
       double minX, minY, minZ;
       double maxX, maxY, maxZ;
@@ -896,8 +1235,8 @@ namespace octomap {
       z = maxZ - minZ;
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::calcMinMax() {
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::calcMinMax() {
       if (!size_changed)
         return;
 
@@ -914,7 +1253,7 @@ namespace octomap {
         min_value[i] = std::numeric_limits<double>::max();
       }
 
-      for(typename OcTreeBaseImpl<NODE,I>::leaf_iterator it = this->begin(),
+      for(typename OcTreeBaseImpl<NODE,I,A>::leaf_iterator it = this->begin(),
                   end=this->end(); it!= end; ++it)
       {
         double size = it.getSize();
@@ -938,16 +1277,16 @@ namespace octomap {
       size_changed = false;
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::getMetricMin(double& x, double& y, double& z){
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::getMetricMin(double& x, double& y, double& z){
       calcMinMax();
       x = min_value[0];
       y = min_value[1];
       z = min_value[2];
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::getMetricMax(double& x, double& y, double& z){
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::getMetricMax(double& x, double& y, double& z){
       calcMinMax();
       x = max_value[0];
       y = max_value[1];
@@ -956,8 +1295,8 @@ namespace octomap {
 
     // const versions
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::getMetricMin(double& mx, double& my, double& mz) const {
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::getMetricMin(double& mx, double& my, double& mz) const {
       mx = my = mz = std::numeric_limits<double>::max( );
       if (size_changed) {
         // empty tree
@@ -966,7 +1305,7 @@ namespace octomap {
           return;
         }
 
-        for(typename OcTreeBaseImpl<NODE,I>::leaf_iterator it = this->begin(),
+        for(typename OcTreeBaseImpl<NODE,I,A>::leaf_iterator it = this->begin(),
                     end=this->end(); it!= end; ++it) {
           double halfSize = it.getSize()/2.0;
           double x = it.getX() - halfSize;
@@ -984,8 +1323,8 @@ namespace octomap {
       }
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::getMetricMax(double& mx, double& my, double& mz) const {
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::getMetricMax(double& mx, double& my, double& mz) const {
       mx = my = mz = -std::numeric_limits<double>::max( );
       if (size_changed) {
         // empty tree
@@ -994,7 +1333,7 @@ namespace octomap {
           return;
         }
 
-        for(typename OcTreeBaseImpl<NODE,I>::leaf_iterator it = this->begin(),
+        for(typename OcTreeBaseImpl<NODE,I,A>::leaf_iterator it = this->begin(),
                     end=this->end(); it!= end; ++it) {
           double halfSize = it.getSize()/2.0;
           double x = it.getX() + halfSize;
@@ -1012,8 +1351,8 @@ namespace octomap {
       }
     }
 
-    template <class NODE,class I>
-    size_t OcTreeBaseImpl<NODE,I>::calcNumNodes() const {
+    template <class NODE,class I,class A>
+    size_t OcTreeBaseImpl<NODE,I,A>::calcNumNodes() const {
       size_t retval = 0; // root node
       if (root){
         retval++;
@@ -1022,8 +1361,8 @@ namespace octomap {
       return retval;
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::calcNumNodesRecurs(NODE* node, size_t& num_nodes) const {
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::calcNumNodesRecurs(NODE* node, size_t& num_nodes) const {
       assert (node);
       if (nodeHasChildren(node)) {
         for (unsigned int i=0; i<8; ++i) {
@@ -1035,15 +1374,15 @@ namespace octomap {
       }
     }
 
-    template <class NODE,class I>
-    size_t OcTreeBaseImpl<NODE,I>::memoryUsage() const{
+    template <class NODE,class I,class A>
+    size_t OcTreeBaseImpl<NODE,I,A>::memoryUsage() const{
       size_t num_leaf_nodes = this->getNumLeafNodes();
       size_t num_inner_nodes = tree_size - num_leaf_nodes;
-      return (sizeof(OcTreeBaseImpl<NODE,I>) + memoryUsageNode() * tree_size + num_inner_nodes * sizeof(NODE*[8]));
+      return (sizeof(OcTreeBaseImpl<NODE,I,A>) + memoryUsageNode() * tree_size + num_inner_nodes * sizeof(NODE*[8]));
     }
 
-    template <class NODE,class I>
-    void OcTreeBaseImpl<NODE,I>::getUnknownLeafCenters(point3d_list& node_centers, point3d pmin, point3d pmax, unsigned int depth) const {
+    template <class NODE,class I,class A>
+    void OcTreeBaseImpl<NODE,I,A>::getUnknownLeafCenters(point3d_list& node_centers, point3d pmin, point3d pmax, unsigned int depth) const {
 
       assert(depth <= tree_depth);
       if (depth == 0)
@@ -1082,8 +1421,8 @@ namespace octomap {
     }
 
 
-    template <class NODE,class I>
-    size_t OcTreeBaseImpl<NODE,I>::getNumLeafNodes() const {
+    template <class NODE,class I,class A>
+    size_t OcTreeBaseImpl<NODE,I,A>::getNumLeafNodes() const {
       if (root == NULL)
         return 0;
 
@@ -1091,8 +1430,8 @@ namespace octomap {
     }
 
 
-    template <class NODE,class I>
-    size_t OcTreeBaseImpl<NODE,I>::getNumLeafNodesRecurs(const NODE* parent) const {
+    template <class NODE,class I,class A>
+    size_t OcTreeBaseImpl<NODE,I,A>::getNumLeafNodesRecurs(const NODE* parent) const {
       assert(parent);
 
       if (!nodeHasChildren(parent)) // this is a leaf -> terminate
@@ -1108,8 +1447,8 @@ namespace octomap {
     }
 
 
-    template <class NODE,class I>
-    double OcTreeBaseImpl<NODE,I>::volume() {
+    template <class NODE,class I,class A>
+    double OcTreeBaseImpl<NODE,I,A>::volume() {
       double x,  y,  z;
       getMetricSize(x, y, z);
       return x*y*z;
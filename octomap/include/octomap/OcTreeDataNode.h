@@ -46,7 +46,7 @@ namespace octomap {
     };
 
     // forward declaration for friend in OcTreeDataNode
-    template<typename NODE,typename I> class OcTreeBaseImpl;
+    template<typename NODE,typename I,typename A> class OcTreeBaseImpl;
 
     /**
      * Basic node in the OcTree that can hold arbitrary data of type T in value.
@@ -61,7 +61,7 @@ namespace octomap {
      * See ColorOcTreeNode in ColorOcTree.h for an example.
      */
     template<typename T> class OcTreeDataNode: public AbstractOcTreeNode {
-        template<typename NODE, typename I>
+        template<typename NODE, typename I, typename A>
         friend class OcTreeBaseImpl;
 
     public:
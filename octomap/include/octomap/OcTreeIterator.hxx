@@ -52,7 +52,7 @@ public:
      * @param tree OcTreeBaseImpl on which the iterator is used on
      * @param depth Maximum depth to traverse the tree. 0 (default): unlimited
      */
-    iterator_base(OcTreeBaseImpl<NodeType,INTERFACE> const* ptree, uint8_t depth=0)
+    iterator_base(OcTreeBaseImpl<NodeType,INTERFACE,ALLOCATOR> const* ptree, uint8_t depth=0)
             : tree((ptree && ptree->root) ? ptree : NULL), maxDepth(depth)
     {
         if (ptree && maxDepth == 0)
@@ -155,7 +155,7 @@ public:
 
 
 protected:
-    OcTreeBaseImpl<NodeType,INTERFACE> const* tree; ///< Octree this iterator is working on
+    OcTreeBaseImpl<NodeType,INTERFACE,ALLOCATOR> const* tree; ///< Octree this iterator is working on
     uint8_t maxDepth; ///< Maximum depth for depth-limited queries
 
     /// Internal recursion stack. Apparently a stack of vector works fastest here.
@@ -213,7 +213,7 @@ public:
      * @param tree OcTreeBaseImpl on which the iterator is used on
      * @param depth Maximum depth to traverse the tree. 0 (default): unlimited
      */
-    tree_iterator(OcTreeBaseImpl<NodeType,INTERFACE> const* ptree, uint8_t depth=0) : iterator_base(ptree, depth) {};
+    tree_iterator(OcTreeBaseImpl<NodeType,INTERFACE,ALLOCATOR> const* ptree, uint8_t depth=0) : iterator_base(ptree, depth) {};
 
     /// postfix increment operator of iterator (it++)
     tree_iterator operator++(int){
@@ -270,7 +270,7 @@ public:
     * @param tree OcTreeBaseImpl on which the iterator is used on
     * @param depth Maximum depth to traverse the tree. 0 (default): unlimited
     */
-    leaf_iterator(OcTreeBaseImpl<NodeType, INTERFACE> const* ptree, uint8_t depth=0) : iterator_base(ptree, depth) {
+    leaf_iterator(OcTreeBaseImpl<NodeType,INTERFACE,ALLOCATOR> const* ptree, uint8_t depth=0) : iterator_base(ptree, depth) {
         // tree could be empty (= no stack)
         if (this->stack.size() > 0){
             // skip forward to next valid leaf node:
@@ -350,7 +350,7 @@ public:
     * @param max Maximum point3d of the axis-aligned boundingbox
     * @param depth Maximum depth to traverse the tree. 0 (default): unlimited
     */
-    leaf_bbx_iterator(OcTreeBaseImpl<NodeType,INTERFACE> const* ptree, const point3d& min, const point3d& max, uint8_t depth=0)
+    leaf_bbx_iterator(OcTreeBaseImpl<NodeType,INTERFACE,ALLOCATOR> const* ptree, const point3d& min, const point3d& max, uint8_t depth=0)
             : iterator_base(ptree, depth)
     {
         if (this->stack.size() > 0){
@@ -378,7 +378,7 @@ public:
     * @param max Maximum OcTreeKey to be included in the axis-aligned boundingbox
     * @param depth Maximum depth to traverse the tree. 0 (default): unlimited
     */
-    leaf_bbx_iterator(OcTreeBaseImpl<NodeType,INTERFACE> const* ptree, const OcTreeKey& min, const OcTreeKey& max, uint8_t depth=0)
+    leaf_bbx_iterator(OcTreeBaseImpl<NodeType,INTERFACE,ALLOCATOR> const* ptree, const OcTreeKey& min, const OcTreeKey& max, uint8_t depth=0)
             : iterator_base(ptree, depth), minKey(min), maxKey(max)
     {
         // tree could be empty (= no stack)
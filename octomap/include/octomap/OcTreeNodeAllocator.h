@@ -0,0 +1,270 @@
+/*
+* Copyright(c) 2016, Youngsun Kwon, Donghyuk Kim, and Sung-eui Yoon, KAIST
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met :
+*
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and / or other materials provided with the distribution.
+*     * Neither the name of SuperRay nor the names of its
+*       contributors may be used to endorse or promote products derived from
+*       this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#ifndef OCTOMAP_OCTREE_NODE_ALLOCATOR_H
+#define OCTOMAP_OCTREE_NODE_ALLOCATOR_H
+
+#include <new>
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+
+namespace octomap {
+
+    // forward declaration for NODE children array
+    class AbstractOcTreeNode;
+
+    /**
+     * Default node allocation policy of OcTreeBaseImpl: every node and every
+     * array of child pointers is a separate heap allocation.
+     *
+     * An allocation policy provides the nodes and the child pointer arrays of
+     * one tree. The tree calls freeChild() for every child of an array before
+     * freeChildren(), and gives a policy whose releaseAll() returns true the
+     * chance to free all nodes at once in clear().
+     *
+     * The parallel passes of the tree (e.g. expand()) allocate the nodes of
+     * each subtree from a default constructed policy of their own, which is
+     * merge()d into the policy of the tree afterwards.
+     *
+     * \tparam NODE Node class of the tree
+     */
+    template <class NODE>
+    class OcTreeHeapAllocator {
+
+    public:
+        /// @return a default constructed node without a parent (the root)
+        inline NODE* allocNode() { return new NODE(); }
+
+        /// Destructs and frees a node returned by allocNode()
+        inline void freeNode(NODE* node) { delete node; }
+
+        /// @return an array of 8 child pointers, all NULL
+        inline AbstractOcTreeNode** allocChildren() {
+            AbstractOcTreeNode** children = new AbstractOcTreeNode*[8];
+            for (unsigned int i = 0; i < 8; i++)
+                children[i] = NULL;
+            return children;
+        }
+
+        /// Frees a child pointer array whose children were all freed
+        inline void freeChildren(AbstractOcTreeNode** children) { delete[] children; }
+
+        /// @return a default constructed node for children[childIdx]
+        inline NODE* allocChild(AbstractOcTreeNode** /* children */, unsigned int /* childIdx */) { return new NODE(); }
+
+        /// Destructs and frees children[childIdx]
+        inline void freeChild(AbstractOcTreeNode** children, unsigned int childIdx) { delete static_cast<NODE*>(children[childIdx]); }
+
+        /// Frees all nodes at once if the policy can do so. @return false, the tree has to free its nodes one by one
+        inline bool releaseAll() { return false; }
+
+        /// Exchanges the memory of two trees (swapContent())
+        inline void swap(OcTreeHeapAllocator<NODE>& /* other */) {}
+
+        /// Takes over the nodes allocated by other, which stay valid
+        inline void merge(OcTreeHeapAllocator<NODE>& /* other */) {}
+
+        /// @return memory held by the allocator itself in bytes
+        inline size_t memoryUsage() const { return 0; }
+    };
+
+
+    /**
+     * Node arena owned by a tree, as allocation policy of OcTreeBaseImpl.
+     *
+     * The 8 children of a node are placed in one block together with the
+     * child pointer array of the node, so siblings are contiguous in memory
+     * and creating or pruning the children of a node is one allocation at most.
+     * Blocks and single nodes (the root) are taken from slabs of their own
+     * size and go to a free list of that size when freed, from which they are
+     * reused before a new slab is allocated.
+     *
+     * A block is allocated as soon as the first child of a node is created
+     * and holds the slots of all 8 children. Trees whose inner nodes mostly
+     * have few children therefore use more memory than with the heap policy.
+     *
+     * clear() releases all slabs at once without running the node destructors,
+     * so NODE must not own resources (the nodes of octomap only hold values).
+     *
+     * \tparam NODE Node class of the tree
+     */
+    template <class NODE>
+    class OcTreeNodeArena {
+
+    public:
+        OcTreeNodeArena() : node_pool(64), block_pool(1024) {}
+
+        inline NODE* allocNode() { return new (node_pool.allocate()) NODE(); }
+
+        inline void freeNode(NODE* node) {
+            node->~NODE();
+            node_pool.deallocate(reinterpret_cast<NodeSlot*>(node));
+        }
+
+        inline AbstractOcTreeNode** allocChildren() {
+            ChildBlock* block = block_pool.allocate();
+            for (unsigned int i = 0; i < 8; i++)
+                block->children[i] = NULL;
+            return block->children;
+        }
+
+        inline void freeChildren(AbstractOcTreeNode** children) {
+            block_pool.deallocate(reinterpret_cast<ChildBlock*>(children));
+        }
+
+        /// @return a default constructed node in the slot of children[childIdx]
+        inline NODE* allocChild(AbstractOcTreeNode** children, unsigned int childIdx) {
+            return new (&reinterpret_cast<ChildBlock*>(children)->nodes[childIdx]) NODE();
+        }
+
+        /// Destructs children[childIdx], its slot stays with the block
+        inline void freeChild(AbstractOcTreeNode** children, unsigned int childIdx) {
+            static_cast<NODE*>(children[childIdx])->~NODE();
+        }
+
+        /// Frees all slabs at once. @return true
+        inline bool releaseAll() {
+            node_pool.release();
+            block_pool.release();
+            return true;
+        }
+
+        inline void swap(OcTreeNodeArena<NODE>& other) {
+            node_pool.swap(other.node_pool);
+            block_pool.swap(other.block_pool);
+        }
+
+        /// Takes over the slabs of other, its nodes stay valid and other is left empty
+        inline void merge(OcTreeNodeArena<NODE>& other) {
+            node_pool.merge(other.node_pool);
+            block_pool.merge(other.block_pool);
+        }
+
+        /// @return memory of the slabs in bytes
+        inline size_t memoryUsage() const { return node_pool.memoryUsage() + block_pool.memoryUsage(); }
+
+    protected:
+        /// Storage of one node, aligned for the node as well as for the free list link
+        union NodeSlot {
+            NodeSlot* next;
+            char data[sizeof(NODE)];
+            double align_double;
+            long long align_long;
+        };
+
+        /// Child pointer array of a node followed by the slots of its children
+        struct ChildBlock {
+            AbstractOcTreeNode* children[8];
+            NodeSlot nodes[8];
+        };
+
+        /**
+         * Slabs of equally sized chunks with a free list. The link of a free
+         * chunk is stored in its first bytes.
+         */
+        template <class CHUNK>
+        class Pool {
+
+        public:
+            Pool(size_t slab_size) : free_chunks(NULL), slab_size(slab_size), next_chunk(slab_size) {}
+
+            ~Pool() { release(); }
+
+            inline CHUNK* allocate() {
+                if (free_chunks != NULL) {
+                    CHUNK* chunk = free_chunks;
+                    free_chunks = *reinterpret_cast<CHUNK**>(chunk);
+                    return chunk;
+                }
+                if (next_chunk == slab_size) {
+                    slabs.push_back(new CHUNK[slab_size]);
+                    next_chunk = 0;
+                }
+                return &slabs.back()[next_chunk++];
+            }
+
+            inline void deallocate(CHUNK* chunk) {
+                *reinterpret_cast<CHUNK**>(chunk) = free_chunks;
+                free_chunks = chunk;
+            }
+
+            void release() {
+                for (size_t i = 0; i < slabs.size(); i++)
+                    delete[] slabs[i];
+                std::vector<CHUNK*>().swap(slabs);
+                free_chunks = NULL;
+                next_chunk = slab_size;
+            }
+
+            void swap(Pool<CHUNK>& other) {
+                slabs.swap(other.slabs);
+                std::swap(free_chunks, other.free_chunks);
+                std::swap(slab_size, other.slab_size);
+                std::swap(next_chunk, other.next_chunk);
+            }
+
+            /// Moves the slabs of other to this pool, free and unused chunks of other go to the free list
+            void merge(Pool<CHUNK>& other) {
+                for (; other.next_chunk < other.slab_size; other.next_chunk++)
+                    deallocate(&other.slabs.back()[other.next_chunk]);
+                while (other.free_chunks != NULL) {
+                    CHUNK* chunk = other.free_chunks;
+                    other.free_chunks = *reinterpret_cast<CHUNK**>(chunk);
+                    deallocate(chunk);
+                }
+                // keep the last slab of this pool last, its unused chunks are still handed out
+                slabs.insert(slabs.empty() ? slabs.end() : slabs.end() - 1, other.slabs.begin(), other.slabs.end());
+                other.slabs.clear();
+            }
+
+            size_t memoryUsage() const { return slabs.size() * slab_size * sizeof(CHUNK) + slabs.capacity() * sizeof(CHUNK*); }
+
+        protected:
+            std::vector<CHUNK*> slabs;
+            CHUNK* free_chunks;
+            size_t slab_size;
+            size_t next_chunk;  ///< next unused chunk of the last slab
+
+        private:
+            Pool(const Pool<CHUNK>&);
+            Pool<CHUNK>& operator=(const Pool<CHUNK>&);
+        };
+
+        Pool<NodeSlot> node_pool;
+        Pool<ChildBlock> block_pool;
+
+    private:
+        OcTreeNodeArena(const OcTreeNodeArena<NODE>&);
+        OcTreeNodeArena<NODE>& operator=(const OcTreeNodeArena<NODE>&);
+    };
+
+} // end namespace
+
+#endif
@@ -75,7 +75,7 @@ namespace octomap {
 
 
     // tree definition
-    class OcTreeStamped : public OccupancyOcTreeBase <OcTreeNodeStamped> {
+    class OcTreeStamped : public OccupancyOcTreeBase <OcTreeNodeStamped, OcTreeNodeArena<OcTreeNodeStamped> > {
 
     public:
         /// Default constructor, sets resolution of leafs
@@ -64,17 +64,21 @@ namespace octomap {
      *
      * \tparam NODE Node class to be used in tree (usually derived from
      *    OcTreeDataNode)
+     * \tparam ALLOCATOR Allocation policy of the nodes, OcTreeHeapAllocator
+     *    (default) or OcTreeNodeArena
      */
-    template <class NODE>
-    class OccupancyOcTreeBase : public OcTreeBaseImpl<NODE,AbstractOccupancyOcTree> {
+    template <class NODE,class ALLOCATOR = OcTreeHeapAllocator<NODE> >
+    class OccupancyOcTreeBase : public OcTreeBaseImpl<NODE,AbstractOccupancyOcTree,ALLOCATOR> {
 
     public:
+        typedef typename OcTreeBaseImpl<NODE,AbstractOccupancyOcTree,ALLOCATOR>::SearchCursor SearchCursor;
+
         /// Default constructor, sets resolution of leafs
         OccupancyOcTreeBase(double resolution);
         virtual ~OccupancyOcTreeBase();
 
         /// Copy constructor
-        OccupancyOcTreeBase(const OccupancyOcTreeBase<NODE>& rhs);
+        OccupancyOcTreeBase(const OccupancyOcTreeBase<NODE,ALLOCATOR>& rhs);
 
         /**
         * Integrate a Pointcloud (in global reference frame), parallelized with OpenMP.
@@ -258,6 +262,29 @@ namespace octomap {
          */
         virtual NODE* updateNode(double x, double y, double z, bool occupied, bool lazy_eval = false);
 
+        /**
+         * Same as updateNode(key, log_odds_update, lazy_eval), but the node is searched through
+         * cursor and the update starts at the deepest existing node of its path instead of the
+         * root. Use one cursor for a sequence of nearby keys, e.g. the keys of a ray.
+         */
+        NODE* updateNode(const OcTreeKey& key, float log_odds_update, SearchCursor& cursor, bool lazy_eval = false);
+
+        /// Same as updateNode(key, occupied, lazy_eval), searching the node through cursor
+        NODE* updateNode(const OcTreeKey& key, bool occupied, SearchCursor& cursor, bool lazy_eval = false);
+
+        /**
+         * Integrate the accumulated free and occupied updates of a set of voxels in a single pass.
+         * The voxels are visited in the order of the tree traversal, and each voxel is updated
+         * by the free updates first and then by the occupied updates in one walk from the root.
+         * The result is the same as calling updateNode() with the weighted log_odds of all free
+         * updates, followed by updateNode() with the ones of all occupied updates.
+         *
+         * @param updates weights of the free and the occupied updates per key at the lowest octree level
+         * @param lazy_eval whether update of inner nodes is omitted after the update (default: false).
+         *   This speeds up the insertion, but you need to call updateInnerOccupancy() when done.
+         */
+        void updateNodes(const KeyUpdateMap& updates, bool lazy_eval = false);
+
 
         /**
          * Creates the maximum likelihood map by calling toMaxLikelihood on all
@@ -291,6 +318,11 @@ namespace octomap {
          * was hit by the raycast. If the raycast returns false you can search() the node at 'end' and
          * see whether it's unknown space.
          *
+         * The octree is only searched when the ray leaves the block of the last search:
+         * a pruned free leaf, or an unknown subtree if unknown cells are ignored. The ray
+         * jumps across such a block at once, so that long rays through open space cost
+         * one search per block instead of one per voxel. The voxels reached are the same
+         * as when stepping voxel by voxel.
          *
          * @param[in] origin starting coordinate of ray
          * @param[in] direction A vector pointing in the direction of the raycast (NOT a point in space). Does not need to be normalized.
@@ -302,6 +334,27 @@ namespace octomap {
         virtual bool castRay(const point3d& origin, const point3d& direction, point3d& end,
                              bool ignoreUnknownCells=false, double maxRange=-1.0) const;
 
+        /// Performs raycasting as castRay() above, searching the cells through cursor. Rays cast
+        /// one after another from nearby origins share the upper part of their search paths then.
+        bool castRay(const point3d& origin, const point3d& direction, point3d& end, SearchCursor& cursor,
+                     bool ignoreUnknownCells=false, double maxRange=-1.0) const;
+
+        /**
+         * Performs castRay() for a batch of rays, in parallel with OpenMP. Each thread
+         * searches the cells of its rays through one SearchCursor.
+         *
+         * @param[in] origins starting coordinates of the rays
+         * @param[in] directions directions of the rays, one per origin (need not be normalized)
+         * @param[out] ends the ends of the rays as castRay() returns them
+         * @param[out] distances distance from the origin to the end of each ray that hit an occupied cell, -1 otherwise
+         * @param[in] ignoreUnknownCells whether unknown cells are ignored (= treated as free), see castRay()
+         * @param[in] maxRange Maximum range after which the raycast is aborted (<= 0: no limit, default)
+         * @return number of rays that hit an occupied cell
+         */
+        size_t castRays(const std::vector<point3d>& origins, const std::vector<point3d>& directions,
+                        std::vector<point3d>& ends, std::vector<double>& distances,
+                        bool ignoreUnknownCells=false, double maxRange=-1.0) const;
+
         /**
          * Retrieves the entry point of a ray into a voxel. This is the closest intersection point of the ray
          * originating from origin and a plane of the axis aligned cube.
@@ -353,7 +406,8 @@ namespace octomap {
         void enableChangeDetection(bool enable) { use_change_detection = enable; }
         bool isChangeDetectionEnabled() const { return use_change_detection; }
         /// Reset the set of changed keys. Call this after you obtained all changed nodes.
-        void resetChangeDetection() { changed_keys.clear(); }
+        /// The buckets are freed as well, since iterating the map takes time linear in their number.
+        void resetChangeDetection() { KeyBoolMap().swap(changed_keys); }
 
         /**
          * Iterator to traverse all keys of changed nodes.
@@ -368,6 +422,76 @@ namespace octomap {
         /// Number of changes since last reset.
         size_t numChangesDetected() const { return changed_keys.size(); }
 
+        //-- delta export of the changes:
+        /// @return version of the map, incremented by writeDelta() and set by applyDelta()
+        uint64_t getMapVersion() const { return map_version; }
+        /// Sets the version of the map, e.g. of a copy that was transferred as a whole before applying deltas
+        void setMapVersion(uint64_t version) { map_version = version; }
+
+        /**
+         * Writes the nodes of the changed keys as a delta from the current map version
+         * to the next one, then resets the change detection and increments the map version.
+         * The delta contains the nodes in Morton order, each as leaf update or, if the key
+         * lies in a pruned node, as replacement of the whole subtree of that node. Keys that
+         * are no longer in the tree are deleted. Only changes in the occupancy are detected
+         * (see enableChangeDetection()), the log-odds of nodes that kept their occupancy are
+         * not transferred.
+         */
+        std::ostream& writeDelta(std::ostream &s);
+
+        /**
+         * Applies a delta written by writeDelta() of a tree of the same type and resolution
+         * and sets the map version to the version of the delta.
+         * @return false if the delta is corrupt or truncated, of another tree type or resolution,
+         * or not based on the current map version, the tree is not modified then
+         */
+        bool applyDelta(std::istream &s);
+
+        //-- frontier tracking for exploration:
+        /// Connected set of frontier cells, see getFrontierClusters()
+        struct FrontierCluster {
+          std::vector<OcTreeKey> keys; ///< keys of the frontier cells (lowest tree level)
+          point3d centroid;            ///< mean of the cell centers
+          point3d bbx_min;             ///< minimum of the cell centers
+          point3d bbx_max;             ///< maximum of the cell centers
+        };
+
+        /**
+         * Maintains an index of the frontier cells: known free cells at the lowest tree
+         * level with at least one unknown face neighbor (default: off). The updates of
+         * leaf nodes record the cells that became known or changed their occupancy, as
+         * for change detection but independent of it, and updateFrontiers() checks only
+         * these cells and the neighbors of the new ones. The scan insertions of
+         * SuperRayOcTree and CullingRegionOcTree call updateFrontiers() when they are done.
+         * Enabling builds the index of the current map with rebuildFrontiers().
+         */
+        void enableFrontierTracking(bool enable);
+        bool isFrontierTrackingEnabled() const { return use_frontier_tracking; }
+
+        /// Checks the cells changed since the last call and updates the frontier index
+        void updateFrontiers();
+
+        /// Builds the frontier index from the whole map. Needed after changes which are not
+        /// recorded: deleteNode(), clear() or applyDelta(). Reading a map rebuilds the index.
+        void rebuildFrontiers();
+
+        /// @return keys of all frontier cells, as of the last updateFrontiers()
+        const KeySet& getFrontiers() const { return frontier_keys; }
+
+        /// @return number of frontier cells, as of the last updateFrontiers()
+        size_t numFrontiers() const { return frontier_keys.size(); }
+
+        /// Appends the centers of all frontier cells to node_centers
+        void getFrontierCenters(point3d_list& node_centers) const;
+
+        /**
+         * Groups the frontier cells into clusters of 26-connected cells. The cost depends
+         * on the number of frontier cells only, not on the size of the map.
+         * @param[out] clusters the clusters with at least min_cluster_size cells, largest first
+         * @param[in] min_cluster_size smaller clusters (e.g. single cells from sensor noise) are dropped
+         */
+        void getFrontierClusters(std::vector<FrontierCluster>& clusters, size_t min_cluster_size = 1) const;
+
 
         /**
          * Helper for insertPointCloud(). Computes all octree nodes affected by the point cloud
@@ -403,6 +527,34 @@ namespace octomap {
                                    KeySet& occupied_cells,
                                    double maxrange);
 
+        /**
+         * Helper for insertPointCloud(). Computes all octree nodes affected by the point cloud
+         * integration at once, as computeUpdate() above, into a single accumulator to be
+         * integrated by updateNodes(). Each affected node is updated once, either as free
+         * or as occupied, and occupied nodes have a preference over free ones.
+         *
+         * @param scan point cloud measurement to be integrated
+         * @param origin origin of the sensor for ray casting
+         * @param updates weights of the updates per key, 1 for either the free or the occupied update
+         * @param maxrange maximum range for raycasting (-1: unlimited)
+         */
+        void computeUpdate(const Pointcloud& scan, const octomap::point3d& origin,
+                           KeyUpdateMap& updates,
+                           double maxrange);
+
+        /**
+         * Helper for insertPointCloud(). Discretizes the scan with the octree grid first
+         * and then computes the updates as computeUpdate() above.
+         *
+         * @param scan point cloud measurement to be integrated
+         * @param origin origin of the sensor for ray casting
+         * @param updates weights of the updates per key, 1 for either the free or the occupied update
+         * @param maxrange maximum range for raycasting (-1: unlimited)
+         */
+        void computeDiscreteUpdate(const Pointcloud& scan, const octomap::point3d& origin,
+                                   KeyUpdateMap& updates,
+                                   double maxrange);
+
 
         // -- I/O  -----------------------------------------
 
@@ -467,6 +619,13 @@ namespace octomap {
         /// This usually requires a re-implementation of some core tree-traversal functions as well!
         OccupancyOcTreeBase(double resolution, unsigned int tree_depth, unsigned int tree_max_val);
 
+        /// Orders the accumulated updates of updateNodes() along the traversal of the tree
+        struct UpdateTraversalLess{
+            bool operator()(const std::pair<OcTreeKey, KeyUpdateWeights>& a, const std::pair<OcTreeKey, KeyUpdateWeights>& b) const{
+                return OcTreeKey::KeyTraversalLess()(a.first, b.first);
+            }
+        };
+
         /**
          * Traces a ray from origin to end and updates all voxels on the
          *  way as free.  The volume containing "end" is not updated.
@@ -479,14 +638,58 @@ namespace octomap {
         NODE* updateNodeRecurs(NODE* node, bool node_just_created, const OcTreeKey& key,
                                unsigned int depth, const float& log_odds_update, bool lazy_eval = false);
 
+        NODE* updateNodeRecurs(NODE* node, bool node_just_created, const OcTreeKey& key, unsigned int depth,
+                               const float& miss_log_odds_update, const float& hit_log_odds_update, bool lazy_eval = false);
+
+        /// Completes an update that started at depth of the cursor path: prunes or updates the
+        /// ancestors of that node as updateNodeRecurs() does (unless lazy_eval) and keeps the cursor valid.
+        /// @return retval, or the highest ancestor that was pruned
+        NODE* updateCursorAncestors(SearchCursor& cursor, unsigned int depth, NODE* retval, bool lazy_eval);
+
         NODE* setNodeValueRecurs(NODE* node, bool node_just_created, const OcTreeKey& key,
                                  unsigned int depth, const float& log_odds_value, bool lazy_eval = false);
 
+        /// recursive call of applyDelta(): replaces the node at delta_depth on the way to key by value,
+        /// prunes or updates its ancestors on the way back
+        void applyDeltaRecurs(NODE* node, bool node_just_created, const OcTreeKey& key, unsigned int depth,
+                              unsigned int delta_depth, const NODE& value);
+
         void updateInnerOccupancyRecurs(NODE* node, unsigned int depth);
 
+        /// Records a leaf key that was created (node_just_created) or changed its occupancy
+        /// for change detection and frontier tracking
+        void trackChange(const OcTreeKey& key, bool node_just_created);
+
+        /// @return true if key is a known free cell with an unknown face neighbor
+        bool isFrontier(const OcTreeKey& key, SearchCursor& cursor) const;
+
+        /// Orders frontier clusters by decreasing size
+        struct FrontierClusterLarger {
+          bool operator()(const FrontierCluster& a, const FrontierCluster& b) const {
+            return a.keys.size() > b.keys.size();
+          }
+        };
+
+        /// @return log2 of the width (in voxels) of the block that castRay() may cross without
+        /// searching, given the result node of the last search through cursor (NULL: unknown)
+        unsigned int rayBlockLevel(const NODE* node, const SearchCursor& cursor) const;
+
+        /// @return true if the centers of all voxels in the block of key at level are within maxRange of origin
+        bool rayBlockInRange(const point3d& origin, const OcTreeKey& key, unsigned int level, double maxrange_sq) const;
+
+        /// Advances the traversal state of castRay() to the last voxel the ray crosses
+        /// in the block of key at level (2^level voxels wide)
+        static void skipRayBlock(OcTreeKey& key, const int step[3], double tMax[3], const double tDelta[3],
+                                 unsigned int level);
+
         void toMaxLikelihoodRecurs(NODE* node, unsigned int depth, unsigned int max_depth);
 
 
+        /// Identifies the data of writeDelta()
+        static const uint32_t DELTA_MAGIC = 0x544c4444; // "DDLT"
+        /// Flag in the depth byte of a delta entry: the key is no longer in the tree
+        static const unsigned char DELTA_DELETED = 0x80;
+
     protected:
         bool use_bbx_limit;  ///< use bounding box for queries (needs to be set)?
         point3d bbx_min;
@@ -497,6 +700,15 @@ namespace octomap {
         bool use_change_detection;
         /// Set of leaf keys (lowest level) which changed since last resetChangeDetection
         KeyBoolMap changed_keys;
+        /// Version of the map for the deltas of writeDelta() and applyDelta()
+        uint64_t map_version;
+
+        bool use_frontier_tracking;
+        /// Keys of the frontier cells
+        KeySet frontier_keys;
+        /// Keys changed since the last updateFrontiers(), true if the node was created. A plain
+        /// log (duplicates are removed by updateFrontiers()) does not allocate per change.
+        std::vector<std::pair<OcTreeKey, bool> > frontier_updates;
 
 
     };
@@ -33,35 +33,37 @@
 
 #include <bitset>
 #include <algorithm>
+#include <sstream>
 
 #include <octomap/MCTables.h>
 
 namespace octomap {
 
-    template <class NODE>
-    OccupancyOcTreeBase<NODE>::OccupancyOcTreeBase(double in_resolution)
-            : OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>(in_resolution), use_bbx_limit(false), use_change_detection(false)
+    template <class NODE,class A>
+    OccupancyOcTreeBase<NODE,A>::OccupancyOcTreeBase(double in_resolution)
+            : OcTreeBaseImpl<NODE,AbstractOccupancyOcTree,A>(in_resolution), use_bbx_limit(false), use_change_detection(false), map_version(0), use_frontier_tracking(false)
     {
 
     }
 
-    template <class NODE>
-    OccupancyOcTreeBase<NODE>::OccupancyOcTreeBase(double in_resolution, unsigned int in_tree_depth, unsigned int in_tree_max_val)
-            : OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>(in_resolution, in_tree_depth, in_tree_max_val), use_bbx_limit(false), use_change_detection(false)
+    template <class NODE,class A>
+    OccupancyOcTreeBase<NODE,A>::OccupancyOcTreeBase(double in_resolution, unsigned int in_tree_depth, unsigned int in_tree_max_val)
+            : OcTreeBaseImpl<NODE,AbstractOccupancyOcTree,A>(in_resolution, in_tree_depth, in_tree_max_val), use_bbx_limit(false), use_change_detection(false), map_version(0), use_frontier_tracking(false)
     {
 
     }
 
-    template <class NODE>
-    OccupancyOcTreeBase<NODE>::~OccupancyOcTreeBase(){
+    template <class NODE,class A>
+    OccupancyOcTreeBase<NODE,A>::~OccupancyOcTreeBase(){
     }
 
-    template <class NODE>
-    OccupancyOcTreeBase<NODE>::OccupancyOcTreeBase(const OccupancyOcTreeBase<NODE>& rhs) :
-            OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>(rhs), use_bbx_limit(rhs.use_bbx_limit),
+    template <class NODE,class A>
+    OccupancyOcTreeBase<NODE,A>::OccupancyOcTreeBase(const OccupancyOcTreeBase<NODE,A>& rhs) :
+            OcTreeBaseImpl<NODE,AbstractOccupancyOcTree,A>(rhs), use_bbx_limit(rhs.use_bbx_limit),
             bbx_min(rhs.bbx_min), bbx_max(rhs.bbx_max),
             bbx_min_key(rhs.bbx_min_key), bbx_max_key(rhs.bbx_max_key),
-            use_change_detection(rhs.use_change_detection), changed_keys(rhs.changed_keys)
+            use_change_detection(rhs.use_change_detection), changed_keys(rhs.changed_keys), map_version(rhs.map_version),
+            use_frontier_tracking(rhs.use_frontier_tracking), frontier_keys(rhs.frontier_keys), frontier_updates(rhs.frontier_updates)
     {
       this->clamping_thres_min = rhs.clamping_thres_min;
       this->clamping_thres_max = rhs.clamping_thres_max;
@@ -72,8 +74,8 @@ namespace octomap {
 
     }
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::insertPointCloud(const ScanNode& scan, double maxrange, bool lazy_eval, bool discretize) {
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::insertPointCloud(const ScanNode& scan, double maxrange, bool lazy_eval, bool discretize) {
       // performs transformation to data and sensor origin first
       Pointcloud& cloud = *(scan.scan);
       pose6d frame_origin = scan.pose;
@@ -82,27 +84,22 @@ namespace octomap {
     }
 
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::insertPointCloud(const Pointcloud& scan, const octomap::point3d& sensor_origin,
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::insertPointCloud(const Pointcloud& scan, const octomap::point3d& sensor_origin,
                                                      double maxrange, bool lazy_eval, bool discretize) {
 
-      KeySet free_cells, occupied_cells;
+      KeyUpdateMap updates;
       if (discretize)
-        computeDiscreteUpdate(scan, sensor_origin, free_cells, occupied_cells, maxrange);
+        computeDiscreteUpdate(scan, sensor_origin, updates, maxrange);
       else
-        computeUpdate(scan, sensor_origin, free_cells, occupied_cells, maxrange);
+        computeUpdate(scan, sensor_origin, updates, maxrange);
 
       // insert data into tree  -----------------------
-      for (KeySet::iterator it = free_cells.begin(); it != free_cells.end(); ++it) {
-        updateNode(*it, false, lazy_eval);
-      }
-      for (KeySet::iterator it = occupied_cells.begin(); it != occupied_cells.end(); ++it) {
-        updateNode(*it, true, lazy_eval);
-      }
+      updateNodes(updates, lazy_eval);
     }
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::insertPointCloud(const Pointcloud& pc, const point3d& sensor_origin, const pose6d& frame_origin,
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::insertPointCloud(const Pointcloud& pc, const point3d& sensor_origin, const pose6d& frame_origin,
                                                      double maxrange, bool lazy_eval, bool discretize) {
       // performs transformation to data and sensor origin first
       Pointcloud transformed_scan (pc);
@@ -112,8 +109,8 @@ namespace octomap {
     }
 
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::insertPointCloudRays(const Pointcloud& pc, const point3d& origin, double maxrange, bool lazy_eval) {
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::insertPointCloudRays(const Pointcloud& pc, const point3d& origin, double maxrange, bool lazy_eval) {
       if (pc.size() < 1)
         return;
 
@@ -134,8 +131,9 @@ namespace octomap {
 #pragma omp critical
 #endif
           {
+            SearchCursor cursor;
             for(KeyRay::iterator it=keyray->begin(); it != keyray->end(); it++) {
-              updateNode(*it, false, lazy_eval); // insert freespace measurement
+              updateNode(*it, false, cursor, lazy_eval); // insert freespace measurement
             }
             updateNode(p, true, lazy_eval); // update endpoint to be occupied
           }
@@ -144,10 +142,42 @@ namespace octomap {
       }
     }
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::computeDiscreteUpdate(const Pointcloud& scan, const octomap::point3d& origin,
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::computeDiscreteUpdate(const Pointcloud& scan, const octomap::point3d& origin,
                                                           KeySet& free_cells, KeySet& occupied_cells,
                                                           double maxrange)
+    {
+      KeyUpdateMap updates;
+      computeDiscreteUpdate(scan, origin, updates, maxrange);
+
+      for (KeyUpdateMap::iterator it = updates.begin(); it != updates.end(); ++it) {
+        if (it->second.hit > 0)
+          occupied_cells.insert(it->first);
+        else
+          free_cells.insert(it->first);
+      }
+    }
+
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::computeUpdate(const Pointcloud& scan, const octomap::point3d& origin,
+                                                  KeySet& free_cells, KeySet& occupied_cells,
+                                                  double maxrange)
+    {
+      KeyUpdateMap updates;
+      computeUpdate(scan, origin, updates, maxrange);
+
+      for (KeyUpdateMap::iterator it = updates.begin(); it != updates.end(); ++it) {
+        if (it->second.hit > 0)
+          occupied_cells.insert(it->first);
+        else
+          free_cells.insert(it->first);
+      }
+    }
+
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::computeDiscreteUpdate(const Pointcloud& scan, const octomap::point3d& origin,
+                                                          KeyUpdateMap& updates,
+                                                          double maxrange)
     {
       Pointcloud discretePC;
       discretePC.reserve(scan.size());
@@ -161,13 +191,13 @@ namespace octomap {
         }
       }
 
-      computeUpdate(discretePC, origin, free_cells, occupied_cells, maxrange);
+      computeUpdate(discretePC, origin, updates, maxrange);
     }
 
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::computeUpdate(const Pointcloud& scan, const octomap::point3d& origin,
-                                                  KeySet& free_cells, KeySet& occupied_cells,
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::computeUpdate(const Pointcloud& scan, const octomap::point3d& origin,
+                                                  KeyUpdateMap& updates,
                                                   double maxrange)
     {
 
@@ -191,20 +221,21 @@ namespace octomap {
             // free cells
             if (this->computeRayKeys(origin, p, *keyray)){
 #ifdef _OPENMP
-#pragma omp critical (free_insert)
+#pragma omp critical (update_insert)
 #endif
               {
-                free_cells.insert(keyray->begin(), keyray->end());
+                for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); ++it)
+                  updates[*it].free = 1;
               }
             }
             // occupied endpoint
             OcTreeKey key;
             if (this->coordToKeyChecked(p, key)){
 #ifdef _OPENMP
-#pragma omp critical (occupied_insert)
+#pragma omp critical (update_insert)
 #endif
               {
-                occupied_cells.insert(key);
+                updates[key].hit = 1;
               }
             }
           } else { // user set a maxrange and length is above
@@ -212,10 +243,11 @@ namespace octomap {
             point3d new_end = origin + direction * (float) maxrange;
             if (this->computeRayKeys(origin, new_end, *keyray)){
 #ifdef _OPENMP
-#pragma omp critical (free_insert)
+#pragma omp critical (update_insert)
 #endif
               {
-                free_cells.insert(keyray->begin(), keyray->end());
+                for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); ++it)
+                  updates[*it].free = 1;
               }
             }
           } // end if maxrange
@@ -227,10 +259,10 @@ namespace octomap {
             OcTreeKey key;
             if (this->coordToKeyChecked(p, key)){
 #ifdef _OPENMP
-#pragma omp critical (occupied_insert)
+#pragma omp critical (update_insert)
 #endif
               {
-                occupied_cells.insert(key);
+                updates[key].hit = 1;
               }
             }
 
@@ -239,10 +271,10 @@ namespace octomap {
               for(KeyRay::reverse_iterator rit=keyray->rbegin(); rit != keyray->rend(); rit++) {
                 if (inBBX(*rit)) {
 #ifdef _OPENMP
-#pragma omp critical (free_insert)
+#pragma omp critical (update_insert)
 #endif
                   {
-                    free_cells.insert(*rit);
+                    updates[*rit].free = 1;
                   }
                 }
                 else break;
@@ -253,24 +285,21 @@ namespace octomap {
 
       } // end for all points, end of parallel OMP loop
 
-      // prefer occupied cells over free ones (and make sets disjunct)
-      for(KeySet::iterator it = free_cells.begin(), end=free_cells.end(); it!= end; ){
-        if (occupied_cells.find(*it) != occupied_cells.end()){
-          it = free_cells.erase(it);
-        } else {
-          ++it;
-        }
+      // prefer occupied cells over free ones
+      for (KeyUpdateMap::iterator it = updates.begin(); it != updates.end(); ++it) {
+        if (it->second.hit > 0)
+          it->second.free = 0;
       }
     }
 
-    template <class NODE>
-    NODE* OccupancyOcTreeBase<NODE>::setNodeValue(const OcTreeKey& key, float log_odds_value, bool lazy_eval) {
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::setNodeValue(const OcTreeKey& key, float log_odds_value, bool lazy_eval) {
       // clamp log odds within range:
       log_odds_value = std::min(std::max(log_odds_value, this->clamping_thres_min), this->clamping_thres_max);
 
       bool createdRoot = false;
       if (this->root == NULL){
-        this->root = new NODE();
+        this->root = this->node_allocator.allocNode();
         this->tree_size++;
         createdRoot = true;
       }
@@ -278,8 +307,8 @@ namespace octomap {
       return setNodeValueRecurs(this->root, createdRoot, key, 0, log_odds_value, lazy_eval);
     }
 
-    template <class NODE>
-    NODE* OccupancyOcTreeBase<NODE>::setNodeValue(const point3d& value, float log_odds_value, bool lazy_eval) {
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::setNodeValue(const point3d& value, float log_odds_value, bool lazy_eval) {
       OcTreeKey key;
       if (!this->coordToKeyChecked(value, key))
         return NULL;
@@ -287,8 +316,8 @@ namespace octomap {
       return setNodeValue(key, log_odds_value, lazy_eval);
     }
 
-    template <class NODE>
-    NODE* OccupancyOcTreeBase<NODE>::setNodeValue(double x, double y, double z, float log_odds_value, bool lazy_eval) {
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::setNodeValue(double x, double y, double z, float log_odds_value, bool lazy_eval) {
       OcTreeKey key;
       if (!this->coordToKeyChecked(x, y, z, key))
         return NULL;
@@ -297,8 +326,8 @@ namespace octomap {
     }
 
 
-    template <class NODE>
-    NODE* OccupancyOcTreeBase<NODE>::updateNode(const OcTreeKey& key, float log_odds_update, bool lazy_eval) {
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::updateNode(const OcTreeKey& key, float log_odds_update, bool lazy_eval) {
       // early abort (no change will happen).
       // may cause an overhead in some configuration, but more often helps
       NODE* leaf = this->search(key);
@@ -312,7 +341,7 @@ namespace octomap {
 
       bool createdRoot = false;
       if (this->root == NULL){
-        this->root = new NODE();
+        this->root = this->node_allocator.allocNode();
         this->tree_size++;
         createdRoot = true;
       }
@@ -320,8 +349,91 @@ namespace octomap {
       return updateNodeRecurs(this->root, createdRoot, key, 0, log_odds_update, lazy_eval);
     }
 
-    template <class NODE>
-    NODE* OccupancyOcTreeBase<NODE>::updateNode(const point3d& value, float log_odds_update, bool lazy_eval) {
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::updateNode(const OcTreeKey& key, float log_odds_update, SearchCursor& cursor, bool lazy_eval) {
+      // early abort (no change will happen), as in updateNode()
+      NODE* leaf = this->search(key, cursor);
+      if (leaf
+          && ((log_odds_update >= 0 && leaf->getLogOdds() >= this->clamping_thres_max)
+              || ( log_odds_update <= 0 && leaf->getLogOdds() <= this->clamping_thres_min)))
+      {
+        return leaf;
+      }
+
+      // empty tree, the cursor was reset by the search
+      if (this->root == NULL)
+        return updateNode(key, log_odds_update, lazy_eval);
+
+      // continue at the deepest existing node on the way to key
+      unsigned int depth = cursor.getDepth();
+      NODE* retval = updateNodeRecurs(cursor.getNode(depth), false, key, depth, log_odds_update, lazy_eval);
+      return updateCursorAncestors(cursor, depth, retval, lazy_eval);
+    }
+
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::updateNode(const OcTreeKey& key, bool occupied, SearchCursor& cursor, bool lazy_eval) {
+      float logOdds = this->prob_miss_log;
+      if (occupied)
+        logOdds = this->prob_hit_log;
+
+      return updateNode(key, logOdds, cursor, lazy_eval);
+    }
+
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::updateCursorAncestors(SearchCursor& cursor, unsigned int depth, NODE* retval, bool lazy_eval) {
+      unsigned int valid_depth = depth;
+      if (!lazy_eval) {
+        // bottom-up, as on the way back of updateNodeRecurs()
+        for (unsigned int d = depth; d-- > 0; ) {
+          NODE* node = cursor.getNode(d);
+          if (this->pruneNode(node)){
+            retval = node;
+            valid_depth = d;
+          } else {
+            node->updateOccupancyChildren();
+          }
+        }
+      }
+      // pruning deleted nodes below valid_depth only
+      this->truncateCursor(cursor, valid_depth);
+      return retval;
+    }
+
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::updateNodes(const KeyUpdateMap& updates, bool lazy_eval) {
+      // visit the keys in the order of the tree traversal
+      std::vector<std::pair<OcTreeKey, KeyUpdateWeights> > sorted_updates(updates.begin(), updates.end());
+      std::sort(sorted_updates.begin(), sorted_updates.end(), UpdateTraversalLess());
+
+      // consecutive keys share most of their path
+      SearchCursor cursor;
+      for (size_t i = 0; i < sorted_updates.size(); i++) {
+        const OcTreeKey& key = sorted_updates[i].first;
+        const float miss_log_odds_update = sorted_updates[i].second.free * this->prob_miss_log;
+        const float hit_log_odds_update = sorted_updates[i].second.hit * this->prob_hit_log;
+
+        // early abort (no change will happen), as in updateNode()
+        NODE* leaf = this->search(key, cursor);
+        if (leaf
+            && (sorted_updates[i].second.free == 0 || leaf->getLogOdds() <= this->clamping_thres_min)
+            && (sorted_updates[i].second.hit == 0 || leaf->getLogOdds() >= this->clamping_thres_max))
+          continue;
+
+        if (this->root == NULL){
+          this->root = this->node_allocator.allocNode();
+          this->tree_size++;
+          updateNodeRecurs(this->root, true, key, 0, miss_log_odds_update, hit_log_odds_update, lazy_eval);
+          continue;
+        }
+
+        unsigned int depth = cursor.getDepth();
+        NODE* retval = updateNodeRecurs(cursor.getNode(depth), false, key, depth, miss_log_odds_update, hit_log_odds_update, lazy_eval);
+        updateCursorAncestors(cursor, depth, retval, lazy_eval);
+      }
+    }
+
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::updateNode(const point3d& value, float log_odds_update, bool lazy_eval) {
       OcTreeKey key;
       if (!this->coordToKeyChecked(value, key))
         return NULL;
@@ -329,8 +441,8 @@ namespace octomap {
       return updateNode(key, log_odds_update, lazy_eval);
     }
 
-    template <class NODE>
-    NODE* OccupancyOcTreeBase<NODE>::updateNode(double x, double y, double z, float log_odds_update, bool lazy_eval) {
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::updateNode(double x, double y, double z, float log_odds_update, bool lazy_eval) {
       OcTreeKey key;
       if (!this->coordToKeyChecked(x, y, z, key))
         return NULL;
@@ -338,8 +450,8 @@ namespace octomap {
       return updateNode(key, log_odds_update, lazy_eval);
     }
 
-    template <class NODE>
-    NODE* OccupancyOcTreeBase<NODE>::updateNode(const OcTreeKey& key, bool occupied, bool lazy_eval) {
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::updateNode(const OcTreeKey& key, bool occupied, bool lazy_eval) {
       float logOdds = this->prob_miss_log;
       if (occupied)
         logOdds = this->prob_hit_log;
@@ -347,24 +459,24 @@ namespace octomap {
       return updateNode(key, logOdds, lazy_eval);
     }
 
-    template <class NODE>
-    NODE* OccupancyOcTreeBase<NODE>::updateNode(const point3d& value, bool occupied, bool lazy_eval) {
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::updateNode(const point3d& value, bool occupied, bool lazy_eval) {
       OcTreeKey key;
       if (!this->coordToKeyChecked(value, key))
         return NULL;
       return updateNode(key, occupied, lazy_eval);
     }
 
-    template <class NODE>
-    NODE* OccupancyOcTreeBase<NODE>::updateNode(double x, double y, double z, bool occupied, bool lazy_eval) {
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::updateNode(double x, double y, double z, bool occupied, bool lazy_eval) {
       OcTreeKey key;
       if (!this->coordToKeyChecked(x, y, z, key))
         return NULL;
       return updateNode(key, occupied, lazy_eval);
     }
 
-    template <class NODE>
-    NODE* OccupancyOcTreeBase<NODE>::updateNodeRecurs(NODE* node, bool node_just_created, const OcTreeKey& key,
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::updateNodeRecurs(NODE* node, bool node_just_created, const OcTreeKey& key,
                                                       unsigned int depth, const float& log_odds_update, bool lazy_eval) {
       bool created_node = false;
 
@@ -406,19 +518,12 @@ namespace octomap {
 
         // at last level, update node, end of recursion
       else {
-        if (use_change_detection) {
+        if (use_change_detection || use_frontier_tracking) {
           bool occBefore = this->isNodeOccupied(node);
           updateNodeLogOdds(node, log_odds_update);
 
-          if (node_just_created){  // new node
-            changed_keys.insert(std::pair<OcTreeKey,bool>(key, true));
-          } else if (occBefore != this->isNodeOccupied(node)) {  // occupancy changed, track it
-            KeyBoolMap::iterator it = changed_keys.find(key);
-            if (it == changed_keys.end())
-              changed_keys.insert(std::pair<OcTreeKey,bool>(key, false));
-            else if (it->second == false)
-              changed_keys.erase(it);
-          }
+          if (node_just_created || occBefore != this->isNodeOccupied(node))
+            trackChange(key, node_just_created);
         } else {
           updateNodeLogOdds(node, log_odds_update);
         }
@@ -426,9 +531,73 @@ namespace octomap {
       }
     }
 
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::updateNodeRecurs(NODE* node, bool node_just_created, const OcTreeKey& key, unsigned int depth,
+                                                      const float& miss_log_odds_update, const float& hit_log_odds_update, bool lazy_eval) {
+      bool created_node = false;
+
+      assert(node);
+
+      // follow down to last level
+      if (depth < this->tree_depth) {
+        unsigned int pos = computeChildIdx(key, this->tree_depth -1 - depth);
+        if (!this->nodeChildExists(node, pos)) {
+          // child does not exist, but maybe it's a pruned node?
+          if (!this->nodeHasChildren(node) && !node_just_created ) {
+            // current node does not have children AND it is not a new node
+            // -> expand pruned node
+            this->expandNode(node);
+          }
+          else {
+            // not a pruned node, create requested child
+            this->createNodeChild(node, pos);
+            created_node = true;
+          }
+        }
+
+        if (lazy_eval)
+          return updateNodeRecurs(this->getNodeChild(node, pos), created_node, key, depth+1, miss_log_odds_update, hit_log_odds_update, lazy_eval);
+        else {
+          NODE* retval = updateNodeRecurs(this->getNodeChild(node, pos), created_node, key, depth+1, miss_log_odds_update, hit_log_odds_update, lazy_eval);
+          // prune node if possible, otherwise set own probability
+          if (this->pruneNode(node)){
+            // return pointer to current parent (pruned), the just updated node no longer exists
+            retval = node;
+          } else{
+            node->updateOccupancyChildren();
+          }
+
+          return retval;
+        }
+      }
+
+        // at last level, update node by the miss and then by the hit, end of recursion
+      else {
+        const float log_odds_updates[2] = {miss_log_odds_update, hit_log_odds_update};
+        for (int i = 0; i < 2; i++) {
+          // no change: no update or node already at threshold
+          if (log_odds_updates[i] == 0
+              || (log_odds_updates[i] > 0 && node->getLogOdds() >= this->clamping_thres_max)
+              || (log_odds_updates[i] < 0 && node->getLogOdds() <= this->clamping_thres_min))
+            continue;
+
+          if (use_change_detection || use_frontier_tracking) {
+            bool occBefore = this->isNodeOccupied(node);
+            updateNodeLogOdds(node, log_odds_updates[i]);
+
+            if (node_just_created || occBefore != this->isNodeOccupied(node))
+              trackChange(key, node_just_created);
+          } else {
+            updateNodeLogOdds(node, log_odds_updates[i]);
+          }
+        }
+        return node;
+      }
+    }
+
     // TODO: mostly copy of updateNodeRecurs => merge code or general tree modifier / traversal
-    template <class NODE>
-    NODE* OccupancyOcTreeBase<NODE>::setNodeValueRecurs(NODE* node, bool node_just_created, const OcTreeKey& key,
+    template <class NODE,class A>
+    NODE* OccupancyOcTreeBase<NODE,A>::setNodeValueRecurs(NODE* node, bool node_just_created, const OcTreeKey& key,
                                                         unsigned int depth, const float& log_odds_value, bool lazy_eval) {
       bool created_node = false;
 
@@ -470,19 +639,12 @@ namespace octomap {
 
         // at last level, update node, end of recursion
       else {
-        if (use_change_detection) {
+        if (use_change_detection || use_frontier_tracking) {
           bool occBefore = this->isNodeOccupied(node);
           node->setLogOdds(log_odds_value);
 
-          if (node_just_created){  // new node
-            changed_keys.insert(std::pair<OcTreeKey,bool>(key, true));
-          } else if (occBefore != this->isNodeOccupied(node)) {  // occupancy changed, track it
-            KeyBoolMap::iterator it = changed_keys.find(key);
-            if (it == changed_keys.end())
-              changed_keys.insert(std::pair<OcTreeKey,bool>(key, false));
-            else if (it->second == false)
-              changed_keys.erase(it);
-          }
+          if (node_just_created || occBefore != this->isNodeOccupied(node))
+            trackChange(key, node_just_created);
         } else {
           node->setLogOdds(log_odds_value);
         }
@@ -490,20 +652,433 @@ namespace octomap {
       }
     }
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::updateInnerOccupancy(){
-      if (this->root)
+    template <class NODE,class A>
+    std::ostream& OccupancyOcTreeBase<NODE,A>::writeDelta(std::ostream &s){
+      if (!use_change_detection)
+        OCTOMAP_WARNING_STR("Writing a delta without change detection enabled");
+
+      // the changed keys in Morton order, which is the depth-first order of the tree
+      std::vector<uint64_t> codes;
+      codes.reserve(changed_keys.size());
+      for (KeyBoolMap::const_iterator it = changed_keys.begin(); it != changed_keys.end(); ++it)
+        codes.push_back(it->first.mortonCode());
+      std::sort(codes.begin(), codes.end());
+
+      // entry: gap to the Morton code of the previous node (varint), depth and flags, node data
+      std::ostringstream entries;
+      uint64_t num_entries = 0;
+      uint64_t prev_code = 0;
+      SearchCursor cursor;
+      for (size_t i = 0; i < codes.size(); i++) {
+        const NODE* node = this->search(OcTreeKey::fromMortonCode(codes[i]), cursor);
+        unsigned int depth = this->tree_depth;
+        uint64_t code = codes[i];
+        if (node) {
+          // the node covering the key, all keys in a pruned node share its entry
+          depth = cursor.getDepth();
+          code &= ~((uint64_t(1) << (3 * (this->tree_depth - depth))) - 1);
+          if (num_entries > 0 && code == prev_code)
+            continue;
+        }
+
+        uint64_t gap = code - prev_code;
+        do {
+          unsigned char byte = (unsigned char) (gap & 0x7f);
+          gap >>= 7;
+          if (gap != 0)
+            byte |= 0x80;
+          entries.put((char) byte);
+        } while (gap != 0);
+        entries.put((char) (node ? depth : (depth | DELTA_DELETED)));
+        if (node)
+          node->writeData(entries);
+
+        prev_code = code;
+        num_entries++;
+      }
+
+      uint32_t magic = DELTA_MAGIC;
+      s.write((const char*)&magic, sizeof(magic));
+      std::string id = this->getTreeType();
+      unsigned char id_length = (unsigned char) id.size();
+      s.write((const char*)&id_length, sizeof(id_length));
+      s.write(id.data(), id_length);
+      double res = this->resolution;
+      s.write((const char*)&res, sizeof(res));
+      uint64_t base_version = map_version;
+      uint64_t version = map_version + 1;
+      s.write((const char*)&base_version, sizeof(base_version));
+      s.write((const char*)&version, sizeof(version));
+      s.write((const char*)&num_entries, sizeof(num_entries));
+      std::string data = entries.str();
+      s.write(data.data(), data.size());
+
+      resetChangeDetection();
+      map_version = version;
+      return s;
+    }
+
+    template <class NODE,class A>
+    bool OccupancyOcTreeBase<NODE,A>::applyDelta(std::istream &s){
+      uint32_t magic = 0;
+      unsigned char id_length = 0;
+      s.read((char*)&magic, sizeof(magic));
+      s.read((char*)&id_length, sizeof(id_length));
+      std::string id(id_length, ' ');
+      if (id_length > 0)
+        s.read(&id[0], id_length);
+      double res = 0.0;
+      uint64_t base_version = 0, version = 0, num_entries = 0;
+      s.read((char*)&res, sizeof(res));
+      s.read((char*)&base_version, sizeof(base_version));
+      s.read((char*)&version, sizeof(version));
+      s.read((char*)&num_entries, sizeof(num_entries));
+      if (!s || magic != DELTA_MAGIC) {
+        OCTOMAP_ERROR_STR("Invalid delta header, delta not applied.");
+        return false;
+      }
+      if (id != this->getTreeType() || res != this->resolution) {
+        OCTOMAP_ERROR_STR("Delta of a " << id << " with resolution " << res << " does not match this tree, delta not applied.");
+        return false;
+      }
+      if (base_version != map_version) {
+        OCTOMAP_ERROR_STR("Delta from map version " << base_version << " does not apply to map version " << map_version << ".");
+        return false;
+      }
+
+      // read all entries before modifying the tree
+      const uint64_t end_code = uint64_t(1) << (3 * this->tree_depth);
+      std::vector<uint64_t> codes;
+      std::vector<unsigned char> flags;
+      std::vector<NODE> values;
+      uint64_t code = 0;
+      bool valid = true;
+      for (uint64_t i = 0; valid && i < num_entries; i++) {
+        uint64_t gap = 0;
+        for (unsigned int shift = 0; ; shift += 7) {
+          int byte = s.get();
+          valid = (byte != EOF && shift < 64);
+          if (!valid)
+            break;
+          gap |= (uint64_t) (byte & 0x7f) << shift;
+          if (!(byte & 0x80))
+            break;
+        }
+        // the nodes are strictly ascending in Morton order
+        valid = valid && (i == 0 || gap > 0) && gap < end_code - code;
+        code += gap;
+
+        int entry_flags = s.get();
+        unsigned int depth = entry_flags & ~DELTA_DELETED;
+        bool deleted = (entry_flags & DELTA_DELETED) != 0;
+        valid = valid && entry_flags != EOF && depth <= this->tree_depth && (!deleted || depth == this->tree_depth);
+
+        NODE value;
+        if (valid && !deleted)
+          value.readData(s);
+        valid = valid && s.good();
+
+        codes.push_back(code);
+        flags.push_back((unsigned char) entry_flags);
+        values.push_back(value);
+      }
+      if (!valid) {
+        OCTOMAP_ERROR_STR("Corrupt delta data, delta not applied.");
+        return false;
+      }
+
+      for (size_t i = 0; i < codes.size(); i++) {
+        OcTreeKey key = OcTreeKey::fromMortonCode(codes[i]);
+        if (flags[i] & DELTA_DELETED) {
+          this->deleteNode(key, this->tree_depth);
+          continue;
+        }
+
+        bool created_root = false;
+        if (this->root == NULL) {
+          this->root = this->node_allocator.allocNode();
+          this->tree_size++;
+          created_root = true;
+        }
+        applyDeltaRecurs(this->root, created_root, key, 0, flags[i], values[i]);
+      }
+      map_version = version;
+      return true;
+    }
+
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::applyDeltaRecurs(NODE* node, bool node_just_created, const OcTreeKey& key, unsigned int depth,
+                                                     unsigned int delta_depth, const NODE& value) {
+      assert(node);
+
+      // follow down to the depth of the delta node
+      if (depth < delta_depth) {
+        bool created_node = false;
+        unsigned int pos = computeChildIdx(key, this->tree_depth -1 - depth);
+        if (!this->nodeChildExists(node, pos)) {
+          // child does not exist, but maybe it's a pruned node?
+          if (!this->nodeHasChildren(node) && !node_just_created ) {
+            // current node does not have children AND it is not a new node
+            // -> expand pruned node
+            this->expandNode(node);
+          }
+          else {
+            // not a pruned node, create requested child
+            this->createNodeChild(node, pos);
+            created_node = true;
+          }
+        }
+
+        applyDeltaRecurs(this->getNodeChild(node, pos), created_node, key, depth+1, delta_depth, value);
+        // prune node if possible, otherwise set own probability
+        if (!this->pruneNode(node))
+          node->updateOccupancyChildren();
+      }
+
+        // the node of the delta replaces the whole subtree
+      else {
+        if (this->nodeHasChildren(node)) {
+          size_t num_nodes = 0;
+          this->calcNumNodesRecurs(node, num_nodes);
+          this->deleteNodeChildrenRecurs(node);
+          this->tree_size -= num_nodes;
+          this->size_changed = true;
+        }
+        node->copyData(value);
+      }
+    }
+
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::trackChange(const OcTreeKey& key, bool node_just_created) {
+      if (use_change_detection) {
+        if (node_just_created){  // new node
+          changed_keys.insert(std::pair<OcTreeKey,bool>(key, true));
+        } else {  // occupancy changed, track it
+          KeyBoolMap::iterator it = changed_keys.find(key);
+          if (it == changed_keys.end())
+            changed_keys.insert(std::pair<OcTreeKey,bool>(key, false));
+          else if (it->second == false)
+            changed_keys.erase(it);
+        }
+      }
+      if (use_frontier_tracking) {
+        frontier_updates.push_back(std::pair<OcTreeKey,bool>(key, node_just_created));
+      }
+    }
+
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::enableFrontierTracking(bool enable) {
+      if (enable == use_frontier_tracking)
+        return;
+      use_frontier_tracking = enable;
+      if (enable)
+        rebuildFrontiers();
+      else {
+        KeySet().swap(frontier_keys);
+        std::vector<std::pair<OcTreeKey,bool> >().swap(frontier_updates);
+      }
+    }
+
+    template <class NODE,class A>
+    bool OccupancyOcTreeBase<NODE,A>::isFrontier(const OcTreeKey& key, SearchCursor& cursor) const {
+      NODE* node = this->search(key, cursor);
+      if (node == NULL || this->isNodeOccupied(node))
+        return false;
+
+      const key_type max_key = (key_type) (2 * this->tree_max_val - 1);
+      OcTreeKey neighbor = key;
+      for (unsigned int i = 0; i < 3; ++i) {
+        if (key[i] > 0) {
+          neighbor[i] = key[i] - 1;
+          if (this->search(neighbor, cursor) == NULL)
+            return true;
+        }
+        if (key[i] < max_key) {
+          neighbor[i] = key[i] + 1;
+          if (this->search(neighbor, cursor) == NULL)
+            return true;
+        }
+        neighbor[i] = key[i];
+      }
+      return false;
+    }
+
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::updateFrontiers() {
+      if (frontier_updates.empty())
+        return;
+
+      // A cell that became known can only stop its face neighbors from being frontiers,
+      // a cell that changed its occupancy can only change its own state
+      const key_type max_key = (key_type) (2 * this->tree_max_val - 1);
+      std::vector<OcTreeKey> candidates;
+      candidates.reserve(2 * frontier_updates.size());
+      for (std::vector<std::pair<OcTreeKey,bool> >::const_iterator it = frontier_updates.begin(); it != frontier_updates.end(); ++it) {
+        candidates.push_back(it->first);
+        if (!it->second)
+          continue;
+        for (unsigned int i = 0; i < 3; ++i) {
+          OcTreeKey neighbor = it->first;
+          if (neighbor[i] > 0) {
+            neighbor[i]--;
+            if (frontier_keys.count(neighbor))
+              candidates.push_back(neighbor);
+            neighbor[i]++;
+          }
+          if (neighbor[i] < max_key) {
+            neighbor[i]++;
+            if (frontier_keys.count(neighbor))
+              candidates.push_back(neighbor);
+          }
+        }
+      }
+      frontier_updates.clear();
+
+      // check the cells along the tree traversal, so that consecutive searches share their paths
+      std::sort(candidates.begin(), candidates.end(), OcTreeKey::KeyTraversalLess());
+      candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+      SearchCursor cursor;
+      for (size_t i = 0; i < candidates.size(); ++i) {
+        if (isFrontier(candidates[i], cursor))
+          frontier_keys.insert(candidates[i]);
+        else
+          frontier_keys.erase(candidates[i]);
+      }
+    }
+
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::rebuildFrontiers() {
+      KeySet().swap(frontier_keys);
+      frontier_updates.clear();
+      if (this->root == NULL)
+        return;
+
+      // Only the cells on the faces of a free leaf can border unknown space, each through
+      // its neighbor on the outer side of the face
+      const int max_key = 2 * this->tree_max_val - 1;
+      SearchCursor cursor;
+      for (typename OcTreeBaseImpl<NODE,AbstractOccupancyOcTree,A>::leaf_iterator it = this->begin_leafs(),
+           end = this->end_leafs(); it != end; ++it) {
+        if (this->isNodeOccupied(*it))
+          continue;
+
+        const OcTreeKey base = it.getIndexKey();
+        const int width = 1 << (this->tree_depth - it.getDepth());
+        for (unsigned int i = 0; i < 3; ++i) {
+          const unsigned int u = (i + 1) % 3;
+          const unsigned int v = (i + 2) % 3;
+          for (int side = -1; side <= 1; side += 2) {
+            const int face = (side < 0) ? base[i] : base[i] + width - 1;
+            if (face + side < 0 || face + side > max_key)
+              continue;
+
+            OcTreeKey key(base), neighbor(base);
+            key[i] = (key_type) face;
+            neighbor[i] = (key_type) (face + side);
+            for (int a = 0; a < width; ++a) {
+              key[u] = neighbor[u] = (key_type) (base[u] + a);
+              for (int b = 0; b < width; ++b) {
+                key[v] = neighbor[v] = (key_type) (base[v] + b);
+                if (this->search(neighbor, cursor) == NULL)
+                  frontier_keys.insert(key);
+              }
+            }
+          }
+        }
+      }
+    }
+
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::getFrontierCenters(point3d_list& node_centers) const {
+      for (KeySet::const_iterator it = frontier_keys.begin(); it != frontier_keys.end(); ++it)
+        node_centers.push_back(this->keyToCoord(*it));
+    }
+
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::getFrontierClusters(std::vector<FrontierCluster>& clusters, size_t min_cluster_size) const {
+      clusters.clear();
+
+      // flood fill over the 26-neighborhood, the cells are removed from unvisited when reached
+      KeySet unvisited(frontier_keys);
+      std::vector<OcTreeKey> keys;
+      const int max_key = 2 * this->tree_max_val - 1;
+      for (KeySet::const_iterator it = frontier_keys.begin(); it != frontier_keys.end(); ++it) {
+        if (unvisited.erase(*it) == 0)
+          continue;
+
+        // the keys of the cluster serve as queue
+        keys.assign(1, *it);
+        for (size_t k = 0; k < keys.size(); ++k) {
+          const OcTreeKey current = keys[k];
+          for (int dx = -1; dx <= 1; ++dx) {
+            for (int dy = -1; dy <= 1; ++dy) {
+              for (int dz = -1; dz <= 1; ++dz) {
+                int x = current[0] + dx, y = current[1] + dy, z = current[2] + dz;
+                if (x < 0 || y < 0 || z < 0 || x > max_key || y > max_key || z > max_key)
+                  continue;
+                OcTreeKey neighbor((key_type) x, (key_type) y, (key_type) z);
+                if (unvisited.erase(neighbor) != 0)
+                  keys.push_back(neighbor);
+              }
+            }
+          }
+        }
+        if (keys.size() < min_cluster_size)
+          continue;
+
+        clusters.push_back(FrontierCluster());
+        FrontierCluster& cluster = clusters.back();
+        cluster.keys.swap(keys);
+        double sum[3] = {0.0, 0.0, 0.0};
+        cluster.bbx_min = cluster.bbx_max = this->keyToCoord(cluster.keys[0]);
+        for (size_t k = 0; k < cluster.keys.size(); ++k) {
+          point3d center = this->keyToCoord(cluster.keys[k]);
+          for (unsigned int i = 0; i < 3; ++i) {
+            sum[i] += center(i);
+            cluster.bbx_min(i) = std::min(cluster.bbx_min(i), center(i));
+            cluster.bbx_max(i) = std::max(cluster.bbx_max(i), center(i));
+          }
+        }
+        cluster.centroid = point3d((float) (sum[0] / cluster.keys.size()), (float) (sum[1] / cluster.keys.size()),
+                                   (float) (sum[2] / cluster.keys.size()));
+      }
+
+      std::sort(clusters.begin(), clusters.end(), FrontierClusterLarger());
+    }
+
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::updateInnerOccupancy(){
+      if (this->root) {
+#ifdef _OPENMP
+        #pragma omp parallel
+        #pragma omp single
+#endif
         this->updateInnerOccupancyRecurs(this->root, 0);
+      }
     }
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::updateInnerOccupancyRecurs(NODE* node, unsigned int depth){
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::updateInnerOccupancyRecurs(NODE* node, unsigned int depth){
       assert(node);
 
       // only recurse and update for inner nodes:
       if (this->nodeHasChildren(node)){
         // return early for last level:
         if (depth < this->tree_depth){
+#ifdef _OPENMP
+          // the subtrees of the upper levels are updated in parallel tasks
+          if (depth < this->PARALLEL_TASK_DEPTH) {
+            for (unsigned int i=0; i<8; i++) {
+              if (this->nodeChildExists(node, i)) {
+                #pragma omp task
+                updateInnerOccupancyRecurs(this->getNodeChild(node, i), depth+1);
+              }
+            }
+            #pragma omp taskwait
+            node->updateOccupancyChildren();
+            return;
+          }
+#endif
           for (unsigned int i=0; i<8; i++) {
             if (this->nodeChildExists(node, i)) {
               updateInnerOccupancyRecurs(this->getNodeChild(node, i), depth+1);
@@ -514,8 +1089,8 @@ namespace octomap {
       }
     }
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::toMaxLikelihood() {
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::toMaxLikelihood() {
       if (this->root == NULL)
         return;
 
@@ -528,8 +1103,8 @@ namespace octomap {
       nodeToMaxLikelihood(this->root);
     }
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::toMaxLikelihoodRecurs(NODE* node, unsigned int depth,
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::toMaxLikelihoodRecurs(NODE* node, unsigned int depth,
                                                           unsigned int max_depth) {
 
       assert(node);
@@ -547,13 +1122,13 @@ namespace octomap {
       }
     }
 
-    template <class NODE>
-    bool OccupancyOcTreeBase<NODE>::getNormals(const point3d& point, std::vector<point3d>& normals,
+    template <class NODE,class A>
+    bool OccupancyOcTreeBase<NODE,A>::getNormals(const point3d& point, std::vector<point3d>& normals,
                                                bool unknownStatus) const {
       normals.clear();
 
       OcTreeKey init_key;
-      if ( !OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::coordToKeyChecked(point, init_key) ) {
+      if ( !OcTreeBaseImpl<NODE,AbstractOccupancyOcTree,A>::coordToKeyChecked(point, init_key) ) {
         OCTOMAP_WARNING_STR("Voxel out of bounds");
         return false;
       }
@@ -564,6 +1139,7 @@ namespace octomap {
 
       OcTreeKey current_key;
       NODE* current_node;
+      SearchCursor cursor; // the neighbours mostly share their path
 
       // There is 8 neighbouring sets
       // The current cube can be at any of the 8 vertex
@@ -582,7 +1158,7 @@ namespace octomap {
               current_key[0] = init_key[0] + x_index[l][i];
               current_key[1] = init_key[1] + y_index[l][i];
               current_key[2] = init_key[2] + z_index[m][j];
-              current_node = this->search(current_key);
+              current_node = this->search(current_key, cursor);
 
               if(current_node){
                 vertex_values[k] = this->isNodeOccupied(current_node);
@@ -635,20 +1211,27 @@ namespace octomap {
       return true;
     }
 
-    template <class NODE>
-    bool OccupancyOcTreeBase<NODE>::castRay(const point3d& origin, const point3d& directionP, point3d& end,
+    template <class NODE,class A>
+    bool OccupancyOcTreeBase<NODE,A>::castRay(const point3d& origin, const point3d& directionP, point3d& end,
                                             bool ignoreUnknown, double maxRange) const {
+      SearchCursor cursor;
+      return castRay(origin, directionP, end, cursor, ignoreUnknown, maxRange);
+    }
+
+    template <class NODE,class A>
+    bool OccupancyOcTreeBase<NODE,A>::castRay(const point3d& origin, const point3d& directionP, point3d& end,
+                                            SearchCursor& cursor, bool ignoreUnknown, double maxRange) const {
 
       /// ----------  see OcTreeBase::computeRayKeys  -----------
 
       // Initialization phase -------------------------------------------------------
       OcTreeKey current_key;
-      if ( !OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::coordToKeyChecked(origin, current_key) ) {
+      if ( !OcTreeBaseImpl<NODE,AbstractOccupancyOcTree,A>::coordToKeyChecked(origin, current_key) ) {
         OCTOMAP_WARNING_STR("Coordinates out of bounds during ray casting");
         return false;
       }
 
-      NODE* startingNode = this->search(current_key);
+      NODE* startingNode = this->search(current_key, cursor);
       if (startingNode){
         if (this->isNodeOccupied(startingNode)){
           // Occupied node found at origin
@@ -697,6 +1280,16 @@ namespace octomap {
       // for speedup:
       double maxrange_sq = maxRange *maxRange;
 
+      // The voxels in the block of a pruned free leaf, or of an unknown subtree if
+      // unknown cells are ignored, need no search: the ray jumps to the last of them
+      // it crosses, or steps through them without searching if the block reaches
+      // beyond maxRange. Keys in the block share the bits of block_key in block_mask.
+      OcTreeKey block_key = current_key;
+      unsigned int block_level = rayBlockLevel(startingNode, cursor);
+      unsigned int block_mask = ~((1u << block_level) - 1);
+      if (block_level > 0 && (!max_range_set || rayBlockInRange(origin, block_key, block_level, maxrange_sq)))
+        skipRayBlock(current_key, step, tMax, tDelta, block_level);
+
       // Incremental phase  ---------------------------------------------------------
 
       bool done = false;
@@ -743,7 +1336,11 @@ namespace octomap {
 
         }
 
-        NODE* currentNode = this->search(current_key);
+        // still inside the current free or unknown block
+        if ((((current_key[0] ^ block_key[0]) | (current_key[1] ^ block_key[1]) | (current_key[2] ^ block_key[2])) & block_mask) == 0)
+          continue;
+
+        NODE* currentNode = this->search(current_key, cursor);
         if (currentNode){
           if (this->isNodeOccupied(currentNode)) {
             done = true;
@@ -753,13 +1350,115 @@ namespace octomap {
         } else if (!ignoreUnknown){ // no node found, this usually means we are in "unknown" areas
           return false;
         }
+        block_key = current_key;
+        block_level = rayBlockLevel(currentNode, cursor);
+        block_mask = ~((1u << block_level) - 1);
+        if (block_level > 0 && (!max_range_set || rayBlockInRange(origin, block_key, block_level, maxrange_sq)))
+          skipRayBlock(current_key, step, tMax, tDelta, block_level);
       } // end while
 
       return true;
     }
 
-    template <class NODE>
-    bool OccupancyOcTreeBase<NODE>::getRayIntersection (const point3d& origin, const point3d& direction, const point3d& center,
+    template <class NODE,class A>
+    unsigned int OccupancyOcTreeBase<NODE,A>::rayBlockLevel(const NODE* node, const SearchCursor& cursor) const {
+      if (this->root == NULL)
+        return this->tree_depth;
+      // a found node is a leaf at the cursor depth, a missing one is the child below it
+      if (node)
+        return this->tree_depth - cursor.getDepth();
+      else
+        return this->tree_depth - cursor.getDepth() - 1;
+    }
+
+    template <class NODE,class A>
+    bool OccupancyOcTreeBase<NODE,A>::rayBlockInRange(const point3d& origin, const OcTreeKey& key, unsigned int level,
+                                                    double maxrange_sq) const {
+      // castRay() tests the voxel centers, the farthest one from origin is in a corner of the block
+      const unsigned int block_max = (1u << level) - 1;
+      double dist_from_origin_sq(0.0);
+      for (unsigned int j = 0; j < 3; j++) {
+        float low = float(this->keyToCoord((key_type) (key[j] & ~block_max))) - origin(j);
+        float high = float(this->keyToCoord((key_type) (key[j] | block_max))) - origin(j);
+        dist_from_origin_sq += std::max(low * low, high * high);
+      }
+      return dist_from_origin_sq <= maxrange_sq;
+    }
+
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::skipRayBlock(OcTreeKey& key, const int step[3], double tMax[3], const double tDelta[3],
+                                                 unsigned int level) {
+      const unsigned int block_max = (1u << level) - 1;
+
+      // The ray leaves the block in the dimension whose boundary after the last voxel
+      // of the block it crosses first. castRay() picks the smallest tMax and the higher
+      // dimension on ties, and sums up tMax step by step, so it is summed up here as
+      // well to reach the same voxels.
+      double tExit[3];
+      unsigned int exit_dim = 3;
+      for (unsigned int i = 0; i < 3; ++i) {
+        if (step[i] == 0)
+          continue;
+        unsigned int steps = (step[i] > 0) ? block_max - (key[i] & block_max) : (key[i] & block_max);
+        tExit[i] = tMax[i];
+        for (unsigned int s = 0; s < steps; ++s)
+          tExit[i] += tDelta[i];
+        if (exit_dim == 3 || tExit[i] <= tExit[exit_dim])
+          exit_dim = i;
+      }
+
+      // the other dimensions advance as far as they get before that crossing
+      for (unsigned int i = 0; i < 3; ++i) {
+        if (step[i] == 0)
+          continue;
+        if (i == exit_dim) {
+          key[i] = (key_type) ((step[i] > 0) ? (key[i] | block_max) : (key[i] & ~block_max));
+          tMax[i] = tExit[i];
+        }
+        else {
+          while (tMax[i] < tExit[exit_dim] || (tMax[i] == tExit[exit_dim] && i > exit_dim)) {
+            key[i] += step[i];
+            tMax[i] += tDelta[i];
+          }
+        }
+      }
+    }
+
+    template <class NODE,class A>
+    size_t OccupancyOcTreeBase<NODE,A>::castRays(const std::vector<point3d>& origins, const std::vector<point3d>& directions,
+                                                std::vector<point3d>& ends, std::vector<double>& distances,
+                                                bool ignoreUnknown, double maxRange) const {
+      if (origins.size() != directions.size()) {
+        OCTOMAP_ERROR("castRays: %zu origins, but %zu directions given\n", origins.size(), directions.size());
+        return 0;
+      }
+      ends.resize(origins.size());
+      distances.resize(origins.size());
+
+      size_t num_hits = 0;
+#ifdef _OPENMP
+      #pragma omp parallel reduction(+ : num_hits)
+#endif
+      {
+        // the rays of a thread come in chunks of neighbours, which share most of their search paths
+        SearchCursor cursor;
+#ifdef _OPENMP
+        #pragma omp for schedule(dynamic, 64)
+#endif
+        for (int i = 0; i < (int)origins.size(); ++i) {
+          if (castRay(origins[i], directions[i], ends[i], cursor, ignoreUnknown, maxRange)) {
+            distances[i] = (ends[i] - origins[i]).norm();
+            num_hits++;
+          }
+          else
+            distances[i] = -1.0;
+        }
+      }
+      return num_hits;
+    }
+
+    template <class NODE,class A>
+    bool OccupancyOcTreeBase<NODE,A>::getRayIntersection (const point3d& origin, const point3d& direction, const point3d& center,
                                                         point3d& intersection, double delta/*=0.0*/) const {
       // We only need three normals for the six planes
       octomap::point3d normalX(1, 0, 0);
@@ -847,22 +1546,23 @@ namespace octomap {
     }
 
 
-    template <class NODE> inline bool
-    OccupancyOcTreeBase<NODE>::integrateMissOnRay(const point3d& origin, const point3d& end, bool lazy_eval) {
+    template <class NODE,class A> inline bool
+    OccupancyOcTreeBase<NODE,A>::integrateMissOnRay(const point3d& origin, const point3d& end, bool lazy_eval) {
 
       if (!this->computeRayKeys(origin, end, this->keyrays.at(0))) {
         return false;
       }
 
+      SearchCursor cursor;
       for(KeyRay::iterator it=this->keyrays[0].begin(); it != this->keyrays[0].end(); it++) {
-        updateNode(*it, false, lazy_eval); // insert freespace measurement
+        updateNode(*it, false, cursor, lazy_eval); // insert freespace measurement
       }
 
       return true;
     }
 
-    template <class NODE> bool
-    OccupancyOcTreeBase<NODE>::insertRay(const point3d& origin, const point3d& end, double maxrange, bool lazy_eval)
+    template <class NODE,class A> bool
+    OccupancyOcTreeBase<NODE,A>::insertRay(const point3d& origin, const point3d& end, double maxrange, bool lazy_eval)
     {
       // cut ray at maxrange
       if ((maxrange > 0) && ((end - origin).norm () > maxrange))
@@ -881,16 +1581,16 @@ namespace octomap {
       }
     }
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::setBBXMin (point3d& min) {
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::setBBXMin (point3d& min) {
       bbx_min = min;
       if (!this->coordToKeyChecked(bbx_min, bbx_min_key)) {
         OCTOMAP_ERROR("ERROR while generating bbx min key.\n");
       }
     }
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::setBBXMax (point3d& max) {
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::setBBXMax (point3d& max) {
       bbx_max = max;
       if (!this->coordToKeyChecked(bbx_max, bbx_max_key)) {
         OCTOMAP_ERROR("ERROR while generating bbx max key.\n");
@@ -898,28 +1598,28 @@ namespace octomap {
     }
 
 
-    template <class NODE>
-    bool OccupancyOcTreeBase<NODE>::inBBX(const point3d& p) const {
+    template <class NODE,class A>
+    bool OccupancyOcTreeBase<NODE,A>::inBBX(const point3d& p) const {
       return ((p.x() >= bbx_min.x()) && (p.y() >= bbx_min.y()) && (p.z() >= bbx_min.z()) &&
               (p.x() <= bbx_max.x()) && (p.y() <= bbx_max.y()) && (p.z() <= bbx_max.z()) );
     }
 
 
-    template <class NODE>
-    bool OccupancyOcTreeBase<NODE>::inBBX(const OcTreeKey& key) const {
+    template <class NODE,class A>
+    bool OccupancyOcTreeBase<NODE,A>::inBBX(const OcTreeKey& key) const {
       return ((key[0] >= bbx_min_key[0]) && (key[1] >= bbx_min_key[1]) && (key[2] >= bbx_min_key[2]) &&
               (key[0] <= bbx_max_key[0]) && (key[1] <= bbx_max_key[1]) && (key[2] <= bbx_max_key[2]) );
     }
 
-    template <class NODE>
-    point3d OccupancyOcTreeBase<NODE>::getBBXBounds () const {
+    template <class NODE,class A>
+    point3d OccupancyOcTreeBase<NODE,A>::getBBXBounds () const {
       octomap::point3d obj_bounds = (bbx_max - bbx_min);
       obj_bounds /= 2.;
       return obj_bounds;
     }
 
-    template <class NODE>
-    point3d OccupancyOcTreeBase<NODE>::getBBXCenter () const {
+    template <class NODE,class A>
+    point3d OccupancyOcTreeBase<NODE,A>::getBBXCenter () const {
       octomap::point3d obj_bounds = (bbx_max - bbx_min);
       obj_bounds /= 2.;
       return bbx_min + obj_bounds;
@@ -927,31 +1627,33 @@ namespace octomap {
 
     // -- I/O  -----------------------------------------
 
-    template <class NODE>
-    std::istream& OccupancyOcTreeBase<NODE>::readBinaryData(std::istream &s){
+    template <class NODE,class A>
+    std::istream& OccupancyOcTreeBase<NODE,A>::readBinaryData(std::istream &s){
       // tree needs to be newly created or cleared externally
       if (this->root) {
         OCTOMAP_ERROR_STR("Trying to read into an existing tree.");
         return s;
       }
 
-      this->root = new NODE();
+      this->root = this->node_allocator.allocNode();
       this->readBinaryNode(s, this->root);
       this->size_changed = true;
-      this->tree_size = OcTreeBaseImpl<NODE,AbstractOccupancyOcTree>::calcNumNodes();  // compute number of nodes
+      this->tree_size = OcTreeBaseImpl<NODE,AbstractOccupancyOcTree,A>::calcNumNodes();  // compute number of nodes
+      if (use_frontier_tracking)
+        rebuildFrontiers();
       return s;
     }
 
-    template <class NODE>
-    std::ostream& OccupancyOcTreeBase<NODE>::writeBinaryData(std::ostream &s) const{
+    template <class NODE,class A>
+    std::ostream& OccupancyOcTreeBase<NODE,A>::writeBinaryData(std::ostream &s) const{
       OCTOMAP_DEBUG("Writing %zu nodes to output stream...", this->size());
       if (this->root)
         this->writeBinaryNode(s, this->root);
       return s;
     }
 
-    template <class NODE>
-    std::istream& OccupancyOcTreeBase<NODE>::readBinaryNode(std::istream &s, NODE* node){
+    template <class NODE,class A>
+    std::istream& OccupancyOcTreeBase<NODE,A>::readBinaryNode(std::istream &s, NODE* node){
 
       assert(node);
 
@@ -1021,8 +1723,8 @@ namespace octomap {
       return s;
     }
 
-    template <class NODE>
-    std::ostream& OccupancyOcTreeBase<NODE>::writeBinaryNode(std::ostream &s, const NODE* node) const{
+    template <class NODE,class A>
+    std::ostream& OccupancyOcTreeBase<NODE,A>::writeBinaryNode(std::ostream &s, const NODE* node) const{
 
       assert(node);
 
@@ -1087,8 +1789,8 @@ namespace octomap {
 
     //-- Occupancy queries on nodes:
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::updateNodeLogOdds(NODE* occupancyNode, const float& update) const {
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::updateNodeLogOdds(NODE* occupancyNode, const float& update) const {
       occupancyNode->addValue(update);
       if (occupancyNode->getLogOdds() < this->clamping_thres_min) {
         occupancyNode->setLogOdds(this->clamping_thres_min);
@@ -1099,26 +1801,26 @@ namespace octomap {
       }
     }
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::integrateHit(NODE* occupancyNode) const {
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::integrateHit(NODE* occupancyNode) const {
       updateNodeLogOdds(occupancyNode, this->prob_hit_log);
     }
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::integrateMiss(NODE* occupancyNode) const {
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::integrateMiss(NODE* occupancyNode) const {
       updateNodeLogOdds(occupancyNode, this->prob_miss_log);
     }
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::nodeToMaxLikelihood(NODE* occupancyNode) const{
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::nodeToMaxLikelihood(NODE* occupancyNode) const{
       if (this->isNodeOccupied(occupancyNode))
         occupancyNode->setLogOdds(this->clamping_thres_max);
       else
         occupancyNode->setLogOdds(this->clamping_thres_min);
     }
 
-    template <class NODE>
-    void OccupancyOcTreeBase<NODE>::nodeToMaxLikelihood(NODE& occupancyNode) const{
+    template <class NODE,class A>
+    void OccupancyOcTreeBase<NODE,A>::nodeToMaxLikelihood(NODE& occupancyNode) const{
       if (this->isNodeOccupied(occupancyNode))
         occupancyNode.setLogOdds(this->clamping_thres_max);
       else
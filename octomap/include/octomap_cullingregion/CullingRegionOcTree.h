@@ -30,11 +30,13 @@
 #ifndef OCTOMAP_CULLINGREGION_OCTREE_H
 #define OCTOMAP_CULLINGREGION_OCTREE_H
 
+#include <cstring>
+
 #include <octomap/octomap.h>
 #include <octomap_superray/SuperRayGenerator.h>
 
 namespace octomap{
-    class CullingRegionOcTree : public OccupancyOcTreeBase<OcTreeNode> {
+    class CullingRegionOcTree : public OccupancyOcTreeBase<OcTreeNode, OcTreeNodeArena<OcTreeNode> > {
     public:
         /// Default constructor, sets resolution of leafs
         CullingRegionOcTree(double resolution);
@@ -79,6 +81,36 @@ namespace octomap{
 		 */
         virtual void insertSuperRayCloudRays(const Pointcloud& scan, const point3d& origin, const int threshold);
 
+        /**
+         * Enable or disable the static-origin mode for sensors fixed at one place (default: disabled).
+         * In this mode, the traversal of every ray is cached per exact end point, so that end points
+         * repeated by later scans from the same origin skip the ray traversal. The part of a cached ray
+         * in front of the culling region is recomputed only when the culling region changes, so the
+         * map is the same as without this mode. The whole cache is cleared when the origin moves, and
+         * the traversals unused by the last scan are dropped once the cache is full (see setRayCacheLimit()).
+         */
+        void enableStaticOrigin(bool enable);
+        bool isStaticOriginEnabled() const { return use_static_origin; }
+
+        /// Clear the traversals cached in the static-origin mode
+        void clearRayCache();
+
+        /// \return Number of the end points whose traversals are cached in the static-origin mode
+        size_t getRayCacheSize() const { return ray_cache.size(); }
+
+        /// Set the maximum number of the traversals cached in the static-origin mode (default: 2^17)
+        void setRayCacheLimit(size_t max_rays) { max_cached_rays = max_rays; }
+        size_t getRayCacheLimit() const { return max_cached_rays; }
+
+        /**
+         * Enable or disable the reuse of the culling region for moving sensors (default: disabled).
+         * When enabled, the culling region of an update is translated from the one of the previous update
+         * instead of being propagated from scratch (see buildCullingRegion()). The result is identical.
+         * @note The map must be updated only through the insert functions of this class while the reuse is enabled.
+         */
+        void enableCullingRegionReuse(bool enable);
+        bool isCullingRegionReuseEnabled() const { return use_cullingregion_reuse; }
+
     protected:
         /**
 		 * Build a culling region by utilizing the occupancy information updated to the map.
@@ -90,6 +122,24 @@ namespace octomap{
 		 */
         KeySet buildCullingRegion(const point3d& origin, const int max_propagation);
 
+        /**
+         * Build a culling region by translating the culling region built for a previous origin.
+         * A cell is in the culling region if and only if all cells in the box between the cell and the origin
+         * are fully free. The cells of the previous culling region are hence fully free, and the ones
+         * whose box contains the new origin stay in the region as they are. Only the other previous cells
+         * are re-checked against their neighbors, and only the shell of new candidates around them is
+         * searched in the map.
+         *
+         * @param origin measurement origin in global reference frame
+         * @param max_propagation maximum level of propagation; Manhattan distance from the origin cell
+         * @param prev_cullingregion culling region of the previous origin, without the cells updated as occupied since then
+         * @param prev_originKey key of the previous origin cell
+         * @param prev_unchanged whether none of the cells in the previous culling region has been updated as occupied since then
+         * @return culling region limited by the maximum level of the propagation
+         */
+        KeySet buildCullingRegion(const point3d& origin, const int max_propagation,
+                                  const KeySet& prev_cullingregion, const OcTreeKey& prev_originKey, const bool prev_unchanged);
+
         /**
 		 * Build a culling region by utilizing the occupancy information updated to the map.
          *
@@ -121,6 +171,38 @@ namespace octomap{
          */
         bool computeInverseRayKeys(const point3d& origin, const point3d& end, KeyRay& ray, KeySet& cullingregion);
 
+        /**
+         * Batch and update the rays ending at the given points by utilizing the traversals cached
+         * in the static-origin mode. The traversals of new end points are computed and cached.
+         *
+         * @param rays end points of the rays with their weights (1 for a point, the weight of a super ray)
+         * @param origin measurement origin in global reference frame
+         * @param cullingregion culling region built for the origin
+         */
+        void insertCachedRays(const std::vector<std::pair<point3d, int> >& rays, const point3d& origin, const KeySet& cullingregion);
+
+        /// @return hash of the keys of a culling region, independent of their order
+        static uint64_t hashCullingRegion(const KeySet& cullingregion);
+
+        /// Merge the per-thread batch tables (see mergeBatches()) and update the occupancies of the batched cells in a single pass
+        void updateBatches(std::vector<KeyUpdateMap>& batches, const unsigned int num_shards);
+
+
+        /**
+         * Merge the per-thread batch tables into the tables of the first thread.
+         * The tables are laid out as [thread * num_shards + shard], and each shard holds a disjoint key range
+         * (see computeBatchShard()), so that the shards are merged in parallel without any locking.
+         *
+         * @param batches per-thread batch tables, the merged results are stored in batches[0 .. num_shards-1]
+         * @param num_shards number of the key-range shards per thread
+         */
+        void mergeBatches(std::vector<KeyUpdateMap>& batches, const unsigned int num_shards);
+
+        /// @return index of the key-range shard containing the key, partitioned along the first axis
+        inline unsigned int computeBatchShard(const OcTreeKey& key, const unsigned int num_shards) const {
+            return (unsigned int)(((size_t)key[0] * num_shards) / (2 * tree_max_val));
+        }
+
 
         /**
          * Static member object which ensures that this OcTree's prototype
@@ -146,6 +228,45 @@ namespace octomap{
         };
         /// static member to ensure static initialization (only once)
         static StaticMemberInitializer cullingregionOcTreeMemberInit;
+
+        /// Traversal of a ray cached in the static-origin mode
+        struct CachedRay {
+            CachedRay() : valid(false), length(0), version(0), frame(0) {}
+
+            bool valid;                     ///< whether the ray lies inside the tree
+            std::vector<OcTreeKey> keys;    ///< keys traversed from the end point towards the origin, without culling
+            size_t length;                  ///< number of the keys in front of the culling region
+            unsigned int version;           ///< version of the culling region for which length is valid
+            unsigned int frame;             ///< last update that used the traversal
+        };
+
+        /// Hash of the exact coordinates of an end point
+        struct PointHash {
+            size_t operator()(const point3d& p) const {
+                size_t hash = 0;
+                for (unsigned int i = 0; i < 3; i++) {
+                    float value = p(i) + 0.0f;  // -0 and +0 are equal
+                    uint32_t bits;
+                    memcpy(&bits, &value, sizeof(bits));
+                    hash = hash * 1000003u + bits;
+                }
+                return hash;
+            }
+        };
+        typedef unordered_ns::unordered_map<point3d, CachedRay, PointHash> RayCache;
+
+        bool use_static_origin;
+        point3d cached_origin;              ///< origin of the cached traversals
+        uint64_t cullingregion_hash;        ///< hash of the culling region of the cached culling boundaries
+        unsigned int cullingregion_version; ///< incremented whenever the culling region changes
+        unsigned int cache_frame;           ///< incremented by every update in the static-origin mode
+        size_t max_cached_rays;
+        RayCache ray_cache;
+
+        bool use_cullingregion_reuse;
+        KeySet reusable_cullingregion;      ///< culling region of the previous update, without the cells updated as occupied
+        OcTreeKey reusable_originKey;       ///< origin cell of the previous update
+        bool reusable_unchanged;            ///< whether no cell of the previous culling region has been updated as occupied
     };
 }
 
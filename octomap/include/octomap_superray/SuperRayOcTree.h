@@ -34,7 +34,7 @@
 #include <octomap_superray/SuperRayGenerator.h>
 
 namespace octomap{
-	class SuperRayOcTree : public OccupancyOcTreeBase<OcTreeNode> {
+	class SuperRayOcTree : public OccupancyOcTreeBase<OcTreeNode, OcTreeNodeArena<OcTreeNode> > {
 	public:
 		/// Default constructor, sets resolution of leafs
 		SuperRayOcTree(double resolution);
@@ -116,6 +116,79 @@ namespace octomap {
       return tree;
     }
 
+    bool AbstractOcTree::writeChunked(const std::string& filename) const{
+      std::ofstream file(filename.c_str(), std::ios_base::out | std::ios_base::binary);
+
+      if (!file.is_open()){
+        OCTOMAP_ERROR_STR("Filestream to "<< filename << " not open, nothing written.");
+        return false;
+      }
+
+      return writeChunked(file);
+    }
+
+    bool AbstractOcTree::writeChunked(std::ostream &s) const{
+      s << chunkedFileHeader <<"\n# (feel free to add / change comments, but leave the first line as it is!)\n#\n";
+      s << "id " << getTreeType() << std::endl;
+      s << "size "<< size() << std::endl;
+      s << "res " << getResolution() << std::endl;
+      s << "data" << std::endl;
+
+      writeChunkedData(s);
+
+      if (!s.good()){
+        OCTOMAP_WARNING_STR("Output stream not \"good\" after writing tree");
+        return false;
+      }
+      return true;
+    }
+
+    AbstractOcTree* AbstractOcTree::readChunked(const std::string& filename){
+      std::ifstream file(filename.c_str(), std::ios_base::in |std::ios_base::binary);
+
+      if (!file.is_open()){
+        OCTOMAP_ERROR_STR("Filestream to "<< filename << " not open, nothing read.");
+        return NULL;
+      } else {
+        return readChunked(file);
+      }
+    }
+
+    AbstractOcTree* AbstractOcTree::readChunked(std::istream &s){
+
+      // check if first line valid:
+      std::string line;
+      std::getline(s, line);
+      if (line.compare(0,chunkedFileHeader.length(), chunkedFileHeader) !=0){
+        OCTOMAP_ERROR_STR("First line of OcTree chunked file header does not start with \""<< chunkedFileHeader);
+        return NULL;
+      }
+
+      std::string id;
+      unsigned size;
+      double res;
+      if (!AbstractOcTree::readHeader(s, id, size, res))
+        return NULL;
+
+      OCTOMAP_DEBUG_STR("Reading octree type "<< id);
+
+      AbstractOcTree* tree = createTree(id, res);
+
+      if (tree){
+        if (size > 0)
+          tree->readChunkedData(s);
+
+        if (size != tree->size()){
+          OCTOMAP_ERROR("Tree size mismatch: # read nodes (%zu) != # expected nodes (%d)\n", tree->size(), size);
+          delete tree;
+          return NULL;
+        }
+        OCTOMAP_DEBUG_STR("Done ("<< tree->size() << " nodes)");
+      }
+
+      return tree;
+    }
+
     bool AbstractOcTree::readHeader(std::istream& s, std::string& id, unsigned& size, double& res){
       id = "";
       size = 0;
@@ -208,4 +281,5 @@ namespace octomap {
 
 
     const std::string AbstractOcTree::fileHeader = "# Octomap OcTree file";
+    const std::string AbstractOcTree::chunkedFileHeader = "# Octomap OcTree chunked file";
 }
@@ -89,7 +89,7 @@ namespace octomap {
 
     // tree implementation  --------------------------------------
     ColorOcTree::ColorOcTree(double in_resolution)
-            : OccupancyOcTreeBase<ColorOcTreeNode>(in_resolution) {
+            : OccupancyOcTreeBase<ColorOcTreeNode, OcTreeNodeArena<ColorOcTreeNode> >(in_resolution) {
       colorOcTreeMemberInit.ensureLinking();
     };
 
@@ -118,8 +118,7 @@ namespace octomap {
       for (unsigned int i=0;i<8;i++) {
         deleteNodeChild(node, i);
       }
-      delete[] node->children;
-      node->children = NULL;
+      freeNodeChildren(node);
 
       return true;
     }
@@ -186,7 +185,13 @@ namespace octomap {
 
 
     void ColorOcTree::updateInnerOccupancy() {
-      this->updateInnerOccupancyRecurs(this->root, 0);
+      if (this->root) {
+#ifdef _OPENMP
+        #pragma omp parallel
+        #pragma omp single
+#endif
+        this->updateInnerOccupancyRecurs(this->root, 0);
+      }
     }
 
     void ColorOcTree::updateInnerOccupancyRecurs(ColorOcTreeNode* node, unsigned int depth) {
@@ -194,6 +199,21 @@ namespace octomap {
       if (nodeHasChildren(node)){
         // return early for last level:
         if (depth < this->tree_depth){
+#ifdef _OPENMP
+          // the subtrees of the upper levels are updated in parallel tasks
+          if (depth < PARALLEL_TASK_DEPTH) {
+            for (unsigned int i=0; i<8; i++) {
+              if (nodeChildExists(node, i)) {
+                #pragma omp task
+                updateInnerOccupancyRecurs(getNodeChild(node, i), depth+1);
+              }
+            }
+            #pragma omp taskwait
+            node->updateOccupancyChildren();
+            node->updateColorChildren();
+            return;
+          }
+#endif
           for (unsigned int i=0; i<8; i++) {
             if (nodeChildExists(node, i)) {
               updateInnerOccupancyRecurs(getNodeChild(node, i), depth+1);
@@ -28,15 +28,16 @@
 */
 
 #include <octomap_cullingregion/CullingRegionOcTree.h>
+#include <deque>
 
 namespace octomap{
     CullingRegionOcTree::CullingRegionOcTree(double in_resolution)
-            : OccupancyOcTreeBase<OcTreeNode>(in_resolution) {
+            : OccupancyOcTreeBase<OcTreeNode, OcTreeNodeArena<OcTreeNode> >(in_resolution), use_static_origin(false), cullingregion_hash(0), cullingregion_version(0), cache_frame(0), max_cached_rays(1 << 17), use_cullingregion_reuse(false) {
         cullingregionOcTreeMemberInit.ensureLinking();
     };
 
     CullingRegionOcTree::CullingRegionOcTree(std::string _filename)
-            : OccupancyOcTreeBase<OcTreeNode>(0.1)  { // resolution will be set according to tree file
+            : OccupancyOcTreeBase<OcTreeNode, OcTreeNodeArena<OcTreeNode> >(0.1), use_static_origin(false), cullingregion_hash(0), cullingregion_version(0), cache_frame(0), max_cached_rays(1 << 17), use_cullingregion_reuse(false)  { // resolution will be set according to tree file
         readBinary(_filename);
     }
 
@@ -50,8 +51,18 @@ namespace octomap{
         // Build a culling region
         KeySet cullingregion = buildCullingRegion(pc, origin);
 
-        // Batch a set of the updates
-        KeyIntMap free_cells, occupied_cells;
+        if (use_static_origin) {
+            std::vector<std::pair<point3d, int> > rays;
+            rays.reserve(pc.size());
+            for (int i = 0; i < (int)pc.size(); ++i)
+                rays.push_back(std::make_pair(pc[i], 1));
+            insertCachedRays(rays, origin, cullingregion);
+            return;
+        }
+
+        // Batch a set of the updates into the per-thread tables, sharded by key range
+        const unsigned int num_shards = (unsigned int)this->keyrays.size();
+        std::vector<KeyUpdateMap> batches(num_shards * num_shards);
 #ifdef _OPENMP
         omp_set_num_threads(this->keyrays.size());
 #pragma omp parallel for
@@ -63,44 +74,21 @@ namespace octomap{
             threadIdx = omp_get_thread_num();
 #endif
             KeyRay* keyray = &(this->keyrays.at(threadIdx));
+            KeyUpdateMap* shards = &(batches[threadIdx * num_shards]);
 
             if (this->computeInverseRayKeys(p, origin, *keyray, cullingregion)){
-#ifdef _OPENMP
-#pragma omp critical (free_batch)
-#endif
-                {
-                    // Batch the cells to be updated into the free states
-                    for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); ++it){
-                        const KeyIntMap::iterator& cell = free_cells.find(*it);
-                        if (cell == free_cells.end())
-                            free_cells.insert(std::pair<OcTreeKey, int>(*it, 1));
-                        else
-                            cell->second = cell->second + 1;
-                    }
-                }
+                // Batch the cells to be updated into the free states
+                for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); ++it)
+                    shards[computeBatchShard(*it, num_shards)][*it].free += 1;
 
-#ifdef _OPENMP
-#pragma omp critical (hit_batch)
-#endif
-                {
-                    // Batch the cells to be updated into the occupied states
-                    OcTreeKey key = coordToKey(p);
-                    const KeyIntMap::iterator& cell = occupied_cells.find(key);
-                    if (cell == occupied_cells.end())
-                        occupied_cells.insert(std::pair<OcTreeKey, int>(key, 1));
-                    else
-                        cell->second = cell->second + 1;
-                }
+                // Batch the cells to be updated into the occupied states
+                OcTreeKey key = coordToKey(p);
+                shards[computeBatchShard(key, num_shards)][key].hit += 1;
             }
         }
 
         // Update the occupancies of the batched cells
-        for (KeyIntMap::iterator it = free_cells.begin(); it != free_cells.end(); ++it) {
-            updateNode(it->first, it->second * prob_miss_log);
-        }
-        for (KeyIntMap::iterator it = occupied_cells.begin(); it != occupied_cells.end(); ++it) {
-            updateNode(it->first, it->second * prob_hit_log);
-        }
+        updateBatches(batches, num_shards);
     }
 
     void CullingRegionOcTree::insertSuperRayCloudRays(const Pointcloud& pc, const point3d& origin, const int threshold)
@@ -116,66 +104,263 @@ namespace octomap{
         // Build a culling region
         KeySet cullingregion = buildCullingRegion(srcloud, origin);
 
-        // Batch a set of the updates
-        KeyIntMap free_cells, occupied_cells;
+        if (use_static_origin) {
+            std::vector<std::pair<point3d, int> > rays;
+            rays.reserve(srcloud.size());
+            for (int i = 0; i < (int)srcloud.size(); ++i)
+                rays.push_back(std::make_pair(srcloud[i].p, srcloud[i].w));
+            insertCachedRays(rays, origin, cullingregion);
+            return;
+        }
+
+        // Batch a set of the updates into the per-thread tables, sharded by key range
+        const unsigned int num_shards = (unsigned int)this->keyrays.size();
+        std::vector<KeyUpdateMap> batches(num_shards * num_shards);
 #ifdef _OPENMP
         omp_set_num_threads(this->keyrays.size());
 	#pragma omp parallel for
 #endif
         for (int i = 0; i < (int)srcloud.size(); ++i) {
             const point3d& p = srcloud[i].p;
+            const int w = srcloud[i].w;
             unsigned threadIdx = 0;
 #ifdef _OPENMP
             threadIdx = omp_get_thread_num();
 #endif
             KeyRay* keyray = &(this->keyrays.at(threadIdx));
+            KeyUpdateMap* shards = &(batches[threadIdx * num_shards]);
 
             if (this->computeInverseRayKeys(p, origin, *keyray, cullingregion)){
+                // Batch the cells to be updated into the free states
+                for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); ++it)
+                    shards[computeBatchShard(*it, num_shards)][*it].free += w;
+
+                // Batch the cells to be updated into the occupied states
+                OcTreeKey key = coordToKey(p);
+                shards[computeBatchShard(key, num_shards)][key].hit += w;
+            }
+        }
+
+        // Update the occupancies of the batched cells
+        updateBatches(batches, num_shards);
+    }
+
+    void CullingRegionOcTree::enableStaticOrigin(bool enable)
+    {
+        use_static_origin = enable;
+        if (!use_static_origin)
+            clearRayCache();
+    }
+
+    void CullingRegionOcTree::clearRayCache()
+    {
+        ray_cache.clear();
+        cullingregion_hash = 0;
+        cullingregion_version = 0;
+    }
+
+    void CullingRegionOcTree::enableCullingRegionReuse(bool enable)
+    {
+        use_cullingregion_reuse = enable;
+        reusable_cullingregion.clear();
+    }
+
+    void CullingRegionOcTree::insertCachedRays(const std::vector<std::pair<point3d, int> >& rays, const point3d& origin, const KeySet& cullingregion)
+    {
+        OcTreeKey key_origin;
+        if (!coordToKeyChecked(origin, key_origin)) {
+            OCTOMAP_WARNING_STR("origin ( " << origin << ") out of bounds in insertCachedRays");
+            return;
+        }
+
+        // The cached traversals are valid only for the same origin
+        if (ray_cache.size() > 0 && !(origin == cached_origin))
+            clearRayCache();
+        cached_origin = origin;
+
+        // The culling boundaries of the cached traversals are valid only for the same culling region
+        uint64_t region_hash = hashCullingRegion(cullingregion);
+        if (cullingregion_version == 0 || region_hash != cullingregion_hash) {
+            cullingregion_hash = region_hash;
+            cullingregion_version++;
+        }
+        cache_frame++;
+
+        // Look up the traversals of the end points. New ones are traced and bounded before the batching,
+        // those beyond the limit of the cache go to scratch entries that are not kept.
+        std::vector<CachedRay*> cached_rays(rays.size());
+        std::deque<CachedRay> scratch;
+        std::vector<int> untraced;
+        std::vector<CachedRay*> unbounded;
+        for (size_t i = 0; i < rays.size(); i++) {
+            RayCache::iterator it = ray_cache.find(rays[i].first);
+            CachedRay* ray;
+            if (it != ray_cache.end()) {
+                ray = &(it->second);
+            }
+            else {
+                if (ray_cache.size() < max_cached_rays)
+                    ray = &(ray_cache[rays[i].first]);
+                else {
+                    scratch.push_back(CachedRay());
+                    ray = &(scratch.back());
+                }
+                untraced.push_back((int)i);
+            }
+            if (ray->version != cullingregion_version) {
+                ray->version = cullingregion_version;
+                unbounded.push_back(ray);
+            }
+            ray->frame = cache_frame;
+            cached_rays[i] = ray;
+        }
+
+        // Trace the complete rays of the new end points
+        KeySet unculled;
 #ifdef _OPENMP
-#pragma omp critical (free_batch)
+        omp_set_num_threads(this->keyrays.size());
+#pragma omp parallel for
 #endif
-                {
-                    // Batch the cells to be updated into the free states
-                    for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); ++it){
-                        const KeyIntMap::iterator& cell = free_cells.find(*it);
-                        if (cell == free_cells.end())
-                            free_cells.insert(std::pair<OcTreeKey, int>(*it, srcloud[i].w));
-                        else
-                            cell->second = cell->second + srcloud[i].w;
-                    }
-                }
+        for (int i = 0; i < (int)untraced.size(); ++i) {
+            unsigned threadIdx = 0;
+#ifdef _OPENMP
+            threadIdx = omp_get_thread_num();
+#endif
+            KeyRay* keyray = &(this->keyrays.at(threadIdx));
+            CachedRay& ray = *(cached_rays[untraced[i]]);
+            ray.valid = this->computeInverseRayKeys(rays[untraced[i]].first, origin, *keyray, unculled);
+            ray.keys.assign(keyray->begin(), keyray->end());
+        }
 
+        // Find the culling boundaries on the rays only when the culling region changed
 #ifdef _OPENMP
-#pragma omp critical (hit_batch)
+#pragma omp parallel for
 #endif
-                {
-                    // Batch the cells to be updated into the occupied states
-                    OcTreeKey key = coordToKey(p);
-                    const KeyIntMap::iterator& cell = occupied_cells.find(key);
-                    if (cell == occupied_cells.end())
-                        occupied_cells.insert(std::pair<OcTreeKey, int>(key, srcloud[i].w));
-                    else
-                        cell->second = cell->second + srcloud[i].w;
-                }
-            }
+        for (int i = 0; i < (int)unbounded.size(); ++i) {
+            CachedRay& ray = *(unbounded[i]);
+            ray.length = 0;
+            while (ray.length < ray.keys.size() && cullingregion.find(ray.keys[ray.length]) == cullingregion.end())
+                ray.length++;
+        }
+
+        // Batch a set of the updates into the per-thread tables, sharded by key range
+        const unsigned int num_shards = (unsigned int)this->keyrays.size();
+        std::vector<KeyUpdateMap> batches(num_shards * num_shards);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int i = 0; i < (int)rays.size(); ++i) {
+            const CachedRay& ray = *(cached_rays[i]);
+            if (!ray.valid)
+                continue;
+            const int w = rays[i].second;
+            unsigned threadIdx = 0;
+#ifdef _OPENMP
+            threadIdx = omp_get_thread_num();
+#endif
+            KeyUpdateMap* shards = &(batches[threadIdx * num_shards]);
+
+            // Batch the cells to be updated into the free states
+            for (size_t j = 0; j < ray.length; j++)
+                shards[computeBatchShard(ray.keys[j], num_shards)][ray.keys[j]].free += w;
+
+            // Batch the cells to be updated into the occupied states
+            OcTreeKey key = coordToKey(rays[i].first);
+            shards[computeBatchShard(key, num_shards)][key].hit += w;
         }
 
         // Update the occupancies of the batched cells
-        for (KeyIntMap::iterator it = free_cells.begin(); it != free_cells.end(); ++it) {
-            updateNode(it->first, it->second * prob_miss_log);
+        updateBatches(batches, num_shards);
+
+        // Drop the traversals unused by this update once the cache is full
+        if (ray_cache.size() >= max_cached_rays) {
+            for (RayCache::iterator it = ray_cache.begin(); it != ray_cache.end(); ) {
+                if (it->second.frame != cache_frame)
+                    ray_cache.erase(it++);
+                else
+                    ++it;
+            }
         }
-        for (KeyIntMap::iterator it = occupied_cells.begin(); it != occupied_cells.end(); ++it) {
-            updateNode(it->first, it->second * prob_hit_log);
+    }
+
+    uint64_t CullingRegionOcTree::hashCullingRegion(const KeySet& cullingregion)
+    {
+        // Sum of the mixed keys, so that the order of the set does not matter
+        uint64_t hash = cullingregion.size();
+        for (KeySet::const_iterator it = cullingregion.begin(); it != cullingregion.end(); ++it) {
+            uint64_t k = ((uint64_t)(*it)[0] << 32) | ((uint64_t)(*it)[1] << 16) | (uint64_t)(*it)[2];
+            k *= 0x9E3779B97F4A7C15ULL;
+            k ^= k >> 29;
+            k *= 0xBF58476D1CE4E5B9ULL;
+            k ^= k >> 32;
+            hash += k;
+        }
+        return hash;
+    }
+
+    void CullingRegionOcTree::updateBatches(std::vector<KeyUpdateMap>& batches, const unsigned int num_shards)
+    {
+        mergeBatches(batches, num_shards);
+
+        for (unsigned int shard = 0; shard < num_shards; shard++)
+            updateNodes(batches[shard]);
+
+        // The cells updated as occupied are no longer known to be fully free
+        if (use_cullingregion_reuse) {
+            for (unsigned int shard = 0; shard < num_shards; shard++) {
+                for (KeyUpdateMap::iterator it = batches[shard].begin(); it != batches[shard].end(); ++it) {
+                    if (it->second.hit > 0)
+                        reusable_unchanged &= (reusable_cullingregion.erase(it->first) == 0);
+                }
+            }
+        }
+
+        if (isFrontierTrackingEnabled())
+            updateFrontiers();
+    }
+
+    void CullingRegionOcTree::mergeBatches(std::vector<KeyUpdateMap>& batches, const unsigned int num_shards)
+    {
+        const unsigned int num_tables = (unsigned int)batches.size() / num_shards;
+
+        // Each shard covers a disjoint key range, so that the shards are merged independently
+#ifdef _OPENMP
+        omp_set_num_threads(num_shards);
+#pragma omp parallel for
+#endif
+        for (int shard = 0; shard < (int)num_shards; ++shard) {
+            KeyUpdateMap& merged = batches[shard];
+            for (unsigned int table = 1; table < num_tables; table++) {
+                KeyUpdateMap& local = batches[table * num_shards + shard];
+                if (merged.size() < local.size())
+                    merged.swap(local);
+                for (KeyUpdateMap::iterator it = local.begin(); it != local.end(); ++it) {
+                    KeyUpdateWeights& weights = merged[it->first];
+                    weights.free += it->second.free;
+                    weights.hit += it->second.hit;
+                }
+                local.clear();
+            }
         }
     }
 
     KeySet CullingRegionOcTree::buildCullingRegion(const point3d& origin, const int max_propagation)
     {
+        if (use_cullingregion_reuse && reusable_cullingregion.size() > 0) {
+            // Translate the culling region of the previous update to the new origin
+            KeySet cullingregion = buildCullingRegion(origin, max_propagation, reusable_cullingregion, reusable_originKey, reusable_unchanged);
+            reusable_cullingregion = cullingregion;
+            reusable_originKey = coordToKey(origin);
+            reusable_unchanged = true;
+            return cullingregion;
+        }
+
         KeySet cullingregion;
 
         OcTreeKey originKey = coordToKey(origin);
 
         KeySet* cur_candidates = new KeySet;
+        SearchCursor cursor;    // the candidates of a level lie close together
         cur_candidates->insert(originKey);
 
         for(int cur_level = 0; cur_level <= max_propagation; cur_level++){
@@ -186,7 +371,7 @@ namespace octomap{
 
                 // The first condition: does the cell have a fully free state?
                 int step[3] = {0, 0, 0};
-                OcTreeNode* node = search(key);
+                OcTreeNode* node = search(key, cursor);
                 if (!node || node->getLogOdds() > clamping_thres_min)
                     continue;
 
@@ -244,6 +429,99 @@ namespace octomap{
 
         delete cur_candidates;
 
+        // Keep the culling region for the next update
+        if (use_cullingregion_reuse) {
+            reusable_cullingregion = cullingregion;
+            reusable_originKey = originKey;
+            reusable_unchanged = true;
+        }
+
+        return cullingregion;
+    }
+
+    KeySet CullingRegionOcTree::buildCullingRegion(const point3d& origin, const int max_propagation,
+                                          const KeySet& prev_cullingregion, const OcTreeKey& prev_originKey, const bool prev_unchanged)
+    {
+        OcTreeKey originKey = coordToKey(origin);
+
+        // Sort the cells of the previous culling region into the levels of propagation from the new origin
+        std::vector<std::vector<OcTreeKey> > levels(max_propagation + 1);
+        for (KeySet::const_iterator it = prev_cullingregion.begin(); it != prev_cullingregion.end(); ++it) {
+            int level = 0;
+            for (int axis = 0; axis < 3; axis++)
+                level += abs((int)(*it)[axis] - (int)originKey[axis]);
+            if (level <= max_propagation)
+                levels[level].push_back(*it);
+        }
+        std::vector<size_t> num_prev_cells(max_propagation + 1);
+        for (int level = 0; level <= max_propagation; level++)
+            num_prev_cells[level] = levels[level].size();
+        if (prev_cullingregion.find(originKey) == prev_cullingregion.end())
+            levels[0].push_back(originKey);
+
+        KeySet cullingregion;
+        KeySet shell;   // new candidates out of the previous culling region
+        SearchCursor cursor;    // the candidates of a level lie close together
+        for (int cur_level = 0; cur_level <= max_propagation; cur_level++) {
+            for (size_t i = 0; i < levels[cur_level].size(); i++) {
+                const OcTreeKey key = levels[cur_level][i];
+                const bool prev_cell = (i < num_prev_cells[cur_level]);
+
+                // The first condition: does the cell have a fully free state?
+                // (the cells in the previous culling region are known to be fully free)
+                if (!prev_cell) {
+                    OcTreeNode* node = search(key, cursor);
+                    if (!node || node->getLogOdds() > clamping_thres_min)
+                        continue;
+                }
+
+                // The second condition: are all the neighbor cells in the culling region?
+                // All cells between the cell and its previous origin are fully free, so that the condition holds
+                // for the new origin in between without any check, unless some of them have been updated since.
+                int step[3] = {0, 0, 0};
+                bool in_between = prev_cell && prev_unchanged;
+                for (int axis = 0; axis < 3; axis++) {
+                    if (key[axis] > originKey[axis])		step[axis] = -1;
+                    else if (key[axis] < originKey[axis])	step[axis] = 1;
+
+                    if (originKey[axis] < std::min(key[axis], prev_originKey[axis]) || originKey[axis] > std::max(key[axis], prev_originKey[axis]))
+                        in_between = false;
+                }
+
+                bool insertion = true;
+                for (int axis = 0; !in_between && axis < 3; axis++) {
+                    if (step[axis] != 0) {
+                        OcTreeKey checkKey = key;
+                        checkKey[axis] += step[axis];
+                        if (cullingregion.find(checkKey) == cullingregion.end()) {
+                            insertion = false;
+                            break;
+                        }
+                    }
+                }
+
+                // Insert the cell into the culling region
+                if (!insertion)
+                    continue;
+                cullingregion.insert(key);
+
+                // Find the new candidates in the next level, out of the previous culling region
+                if (cur_level != max_propagation) {
+                    for (int axis = 0; axis < 3; axis++) {
+                        for (int dir = -1; dir <= 1; dir += 2) {
+                            if (step[axis] != 0 && dir != -step[axis])
+                                continue;
+
+                            OcTreeKey candidate = key;
+                            candidate[axis] += dir;
+                            if (prev_cullingregion.find(candidate) == prev_cullingregion.end() && shell.insert(candidate).second)
+                                levels[cur_level + 1].push_back(candidate);
+                        }
+                    }
+                }
+            }
+        }
+
         return cullingregion;
     }
 
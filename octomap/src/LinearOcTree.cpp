@@ -0,0 +1,816 @@
+/*
+* Copyright(c) 2016, Youngsun Kwon, Donghyuk Kim, and Sung-eui Yoon, KAIST
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met :
+*
+*     * Redistributions of source code must retain the above copyright notice, this
+*       list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright notice,
+*       this list of conditions and the following disclaimer in the documentation
+*       and / or other materials provided with the distribution.
+*     * Neither the name of SuperRay nor the names of its
+*       contributors may be used to endorse or promote products derived from
+*       this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+#include <octomap/LinearOcTree.h>
+
+#include <cstring>
+#include <streambuf>
+#include <istream>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace octomap {
+
+    namespace {
+
+        /// Orders nodes and sort keys by LinearOcTreeNode::getSortKey()
+        struct SortKeyLess {
+            bool operator()(const LinearOcTreeNode& a, const LinearOcTreeNode& b) const { return a.getSortKey() < b.getSortKey(); }
+            bool operator()(const LinearOcTreeNode& a, uint64_t b) const { return a.getSortKey() < b; }
+            bool operator()(uint64_t a, const LinearOcTreeNode& b) const { return a < b.getSortKey(); }
+        };
+
+        /// @return sort key above the keys of all nodes with Morton code code
+        inline uint64_t lastSortKey(uint64_t code) { return (code << 16) | 0xFFFF; }
+
+        /// @return the first node of [first, last) with a sort key above sort_key, by an
+        /// exponential search from first for targets close to first
+        const LinearOcTreeNode* gallopUpperBound(const LinearOcTreeNode* first, const LinearOcTreeNode* last, uint64_t sort_key) {
+            size_t step = 1;
+            while (first + step < last && (first + step)->getSortKey() <= sort_key) {
+                first += step;
+                step *= 2;
+            }
+            return std::upper_bound(first, std::min(first + step, last), sort_key, SortKeyLess());
+        }
+
+        /**
+         * Node data of the .ot format (see OcTreeBaseImpl::writeData()) of a
+         * LinearOcTree, generated in depth-first order while it is read, so
+         * that no buffer of the whole map is needed. Every node is its value
+         * followed by the bit mask of its children.
+         */
+        class NodeDataBuf : public std::streambuf {
+
+        public:
+            NodeDataBuf(const LinearOcTree::ConstArray<LinearOcTreeNode>& leaves, const LinearOcTree::ConstArray<LinearOcTreeNode>& inner_nodes)
+                : leaf(leaves.begin()), leaf_end(leaves.end()), inner(inner_nodes.begin()), inner_end(inner_nodes.end()) {
+                setg(buffer, buffer, buffer);
+            }
+
+        protected:
+            int_type underflow() {
+                const size_t node_bytes = sizeof(float) + 1;
+                char* p = buffer;
+                while (p + node_bytes <= buffer + sizeof(buffer) && (leaf != leaf_end || inner != inner_end)) {
+                    const LinearOcTreeNode* node;
+                    if (inner != inner_end && (leaf == leaf_end || inner->getSortKey() < leaf->getSortKey()))
+                        node = &*(inner++);
+                    else
+                        node = &*(leaf++);
+                    float value = node->getLogOdds();
+                    memcpy(p, &value, sizeof(float));
+                    p[sizeof(float)] = (char) node->getChildMask();
+                    p += node_bytes;
+                }
+                if (p == buffer)
+                    return traits_type::eof();
+                setg(buffer, buffer, p);
+                return traits_type::to_int_type(*gptr());
+            }
+
+            const LinearOcTreeNode* leaf;
+            const LinearOcTreeNode* leaf_end;
+            const LinearOcTreeNode* inner;
+            const LinearOcTreeNode* inner_end;
+            char buffer[5 * 4096];
+        };
+
+        /**
+         * Header of the files of LinearOcTree::writeFile(), followed by the
+         * leaves, the inner nodes, the leaf index and the inner node index,
+         * each at an offset aligned to FILE_ALIGNMENT.
+         */
+        struct FileHeader {
+            char magic[8];
+            uint32_t byte_order;     ///< FILE_BYTE_ORDER as written by the host
+            uint32_t version;
+            uint32_t tree_depth;
+            float occ_prob_thres_log;
+            double resolution;
+            uint64_t num_leaves;
+            uint64_t num_inner_nodes;
+            uint64_t leaves_offset;
+            uint64_t inner_nodes_offset;
+            uint64_t leaf_index_offset;
+            uint64_t inner_index_offset;
+            uint64_t reserved[2];
+        };
+
+        const char FILE_MAGIC[8] = "LINOCT";
+        const uint32_t FILE_BYTE_ORDER = 0x01020304;
+        const uint32_t FILE_VERSION = 1;
+        const uint64_t FILE_ALIGNMENT = 64;
+
+        inline uint64_t alignOffset(uint64_t offset) { return (offset + FILE_ALIGNMENT - 1) & ~(FILE_ALIGNMENT - 1); }
+
+        inline uint64_t indexSize(uint64_t num_nodes) { return (num_nodes + LinearOcTree::INDEX_STRIDE - 1) / LinearOcTree::INDEX_STRIDE; }
+
+        /// @return true if num elements of size bytes at offset lie in a file of file_size bytes
+        inline bool validSection(uint64_t offset, uint64_t num, uint64_t size, uint64_t file_size) {
+            return offset % FILE_ALIGNMENT == 0 && offset <= file_size && num <= (file_size - offset) / size;
+        }
+
+        bool validHeader(const FileHeader& header, uint64_t file_size) {
+            return memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0
+                && header.byte_order == FILE_BYTE_ORDER && header.version == FILE_VERSION && header.tree_depth == 16
+                && header.resolution > 0.0
+                && validSection(header.leaves_offset, header.num_leaves, sizeof(LinearOcTreeNode), file_size)
+                && validSection(header.inner_nodes_offset, header.num_inner_nodes, sizeof(LinearOcTreeNode), file_size)
+                && validSection(header.leaf_index_offset, indexSize(header.num_leaves), sizeof(uint64_t), file_size)
+                && validSection(header.inner_index_offset, indexSize(header.num_inner_nodes), sizeof(uint64_t), file_size);
+        }
+
+        /// pads s with zeros from pos to offset and writes bytes of data there
+        void writeSection(std::ostream& s, uint64_t& pos, uint64_t offset, const void* data, uint64_t bytes) {
+            static const char zeros[FILE_ALIGNMENT] = {0};
+            s.write(zeros, offset - pos);
+            s.write((const char*) data, bytes);
+            pos = offset + bytes;
+        }
+
+        /// reads num elements at offset of s into v
+        template <class T>
+        bool readSection(std::istream& s, uint64_t offset, uint64_t num, std::vector<T>& v) {
+            v.resize(num);
+            if (num > 0)
+                s.seekg(offset).read((char*) &v[0], num * sizeof(T));
+            return s.good();
+        }
+
+        /**
+         * Computes the smallest Morton code >= code of a key inside the box
+         * given by the codes of its min and max keys (BIGMIN, Tropf and Herzog 1981).
+         * @return false if there is no such code
+         */
+        bool nextCodeInBox(uint64_t code, uint64_t min_code, uint64_t max_code, uint64_t& next) {
+            if (code > max_code)
+                return false;
+
+            const uint64_t axis_bits = 0x249249249249ULL;
+            bool found = false;
+            for (int bit = 47; bit >= 0; bit--) {
+                uint64_t b = ((uint64_t)1) << bit;
+                // bits of the same axis below bit
+                uint64_t below = (axis_bits << (bit % 3)) & (b - 1);
+                unsigned int pattern = (((code & b) != 0) << 2) | (((min_code & b) != 0) << 1) | ((max_code & b) != 0);
+                switch (pattern) {
+                    case 1: // 0 0 1: the box is split, code lies in the lower half
+                        next = (min_code & ~below) | b;
+                        found = true;
+                        max_code = (max_code & ~b) | below;
+                        break;
+                    case 3: // 0 1 1: code lies below the box
+                        next = min_code;
+                        return true;
+                    case 4: // 1 0 0: code lies above the box
+                        return found;
+                    case 5: // 1 0 1: the box is split, code lies in the upper half
+                        min_code = (min_code & ~below) | b;
+                        break;
+                    case 2:
+                    case 6: // min above max
+                        return found;
+                    default: // 0 0 0, 1 1 1
+                        break;
+                }
+            }
+            next = code;
+            return true;
+        }
+    }
+
+
+    LinearOcTree::LinearOcTree(double in_resolution)
+        : mapped_data(NULL), mapped_size(0), tree_depth(16), tree_max_val(32768), occ_prob_thres_log(0.0f) {
+        setResolution(in_resolution);
+    }
+
+    LinearOcTree::~LinearOcTree() {
+        unmapFile();
+    }
+
+    LinearOcTree::LinearOcTree(const LinearOcTree& rhs)
+        : mapped_data(NULL), mapped_size(0), tree_depth(rhs.tree_depth), tree_max_val(rhs.tree_max_val) {
+        *this = rhs;
+    }
+
+    LinearOcTree& LinearOcTree::operator=(const LinearOcTree& rhs) {
+        if (this == &rhs)
+            return *this;
+
+        clear();
+        setResolution(rhs.resolution);
+        occ_prob_thres_log = rhs.occ_prob_thres_log;
+        leaf_storage.assign(rhs.leaves.begin(), rhs.leaves.end());
+        inner_storage.assign(rhs.inner_nodes.begin(), rhs.inner_nodes.end());
+        leaf_index_storage.assign(rhs.leaf_index.begin(), rhs.leaf_index.end());
+        inner_index_storage.assign(rhs.inner_index.begin(), rhs.inner_index.end());
+        useStorage();
+        return *this;
+    }
+
+    void LinearOcTree::clear() {
+        unmapFile();
+        std::vector<LinearOcTreeNode>().swap(leaf_storage);
+        std::vector<LinearOcTreeNode>().swap(inner_storage);
+        std::vector<uint64_t>().swap(leaf_index_storage);
+        std::vector<uint64_t>().swap(inner_index_storage);
+        useStorage();
+    }
+
+    void LinearOcTree::useStorage() {
+        leaves = ConstArray<LinearOcTreeNode>(leaf_storage.empty() ? NULL : &leaf_storage[0], leaf_storage.size());
+        inner_nodes = ConstArray<LinearOcTreeNode>(inner_storage.empty() ? NULL : &inner_storage[0], inner_storage.size());
+        leaf_index = ConstArray<uint64_t>(leaf_index_storage.empty() ? NULL : &leaf_index_storage[0], leaf_index_storage.size());
+        inner_index = ConstArray<uint64_t>(inner_index_storage.empty() ? NULL : &inner_index_storage[0], inner_index_storage.size());
+    }
+
+    size_t LinearOcTree::memoryUsage() const {
+        return sizeof(LinearOcTree) + (leaf_storage.capacity() + inner_storage.capacity()) * sizeof(LinearOcTreeNode)
+            + (leaf_index_storage.capacity() + inner_index_storage.capacity()) * sizeof(uint64_t);
+    }
+
+    bool LinearOcTree::writeFile(const std::string& filename) const {
+        std::ofstream file(filename.c_str(), std::ios_base::out | std::ios_base::binary);
+        if (!file.is_open()) {
+            OCTOMAP_ERROR_STR("Filestream to " << filename << " not open, nothing written.");
+            return false;
+        }
+
+        FileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.byte_order = FILE_BYTE_ORDER;
+        header.version = FILE_VERSION;
+        header.tree_depth = tree_depth;
+        header.occ_prob_thres_log = occ_prob_thres_log;
+        header.resolution = resolution;
+        header.num_leaves = leaves.size();
+        header.num_inner_nodes = inner_nodes.size();
+        header.leaves_offset = alignOffset(sizeof(FileHeader));
+        header.inner_nodes_offset = alignOffset(header.leaves_offset + leaves.size() * sizeof(LinearOcTreeNode));
+        header.leaf_index_offset = alignOffset(header.inner_nodes_offset + inner_nodes.size() * sizeof(LinearOcTreeNode));
+        header.inner_index_offset = alignOffset(header.leaf_index_offset + leaf_index.size() * sizeof(uint64_t));
+
+        uint64_t pos = 0;
+        writeSection(file, pos, 0, &header, sizeof(header));
+        writeSection(file, pos, header.leaves_offset, leaves.begin(), leaves.size() * sizeof(LinearOcTreeNode));
+        writeSection(file, pos, header.inner_nodes_offset, inner_nodes.begin(), inner_nodes.size() * sizeof(LinearOcTreeNode));
+        writeSection(file, pos, header.leaf_index_offset, leaf_index.begin(), leaf_index.size() * sizeof(uint64_t));
+        writeSection(file, pos, header.inner_index_offset, inner_index.begin(), inner_index.size() * sizeof(uint64_t));
+        file.close();
+        return file.good();
+    }
+
+    bool LinearOcTree::mapFile(const std::string& filename) {
+        clear();
+
+#ifdef _WIN32
+        // no mapping: read the arrays into the vectors of the tree
+        std::ifstream file(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+        if (!file.is_open()) {
+            OCTOMAP_ERROR_STR("Filestream to " << filename << " not open, nothing read.");
+            return false;
+        }
+        file.seekg(0, std::ios_base::end);
+        uint64_t file_size = (uint64_t) file.tellg();
+        file.seekg(0);
+        FileHeader header;
+        if (file_size < sizeof(header) || !file.read((char*) &header, sizeof(header)) || !validHeader(header, file_size)) {
+            OCTOMAP_ERROR_STR(filename << " is not a LinearOcTree file of this host.");
+            return false;
+        }
+        if (!readSection(file, header.leaves_offset, header.num_leaves, leaf_storage)
+            || !readSection(file, header.inner_nodes_offset, header.num_inner_nodes, inner_storage)
+            || !readSection(file, header.leaf_index_offset, indexSize(header.num_leaves), leaf_index_storage)
+            || !readSection(file, header.inner_index_offset, indexSize(header.num_inner_nodes), inner_index_storage)) {
+            OCTOMAP_ERROR_STR("Error reading " << filename << ".");
+            clear();
+            return false;
+        }
+        useStorage();
+#else
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            OCTOMAP_ERROR_STR("Filestream to " << filename << " not open, nothing read.");
+            return false;
+        }
+        struct stat st;
+        void* data = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && (uint64_t) st.st_size >= sizeof(FileHeader))
+            data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);  // the mapping keeps the file open
+        if (data == MAP_FAILED) {
+            OCTOMAP_ERROR_STR("Could not map " << filename << ".");
+            return false;
+        }
+        mapped_data = data;
+        mapped_size = st.st_size;
+
+        FileHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (!validHeader(header, mapped_size)) {
+            OCTOMAP_ERROR_STR(filename << " is not a LinearOcTree file of this host.");
+            unmapFile();
+            return false;
+        }
+        const char* base = (const char*) data;
+        leaves = ConstArray<LinearOcTreeNode>((const LinearOcTreeNode*) (base + header.leaves_offset), header.num_leaves);
+        inner_nodes = ConstArray<LinearOcTreeNode>((const LinearOcTreeNode*) (base + header.inner_nodes_offset), header.num_inner_nodes);
+        leaf_index = ConstArray<uint64_t>((const uint64_t*) (base + header.leaf_index_offset), indexSize(header.num_leaves));
+        inner_index = ConstArray<uint64_t>((const uint64_t*) (base + header.inner_index_offset), indexSize(header.num_inner_nodes));
+#endif
+
+        setResolution(header.resolution);
+        occ_prob_thres_log = header.occ_prob_thres_log;
+        return true;
+    }
+
+    void LinearOcTree::unmapFile() {
+        if (mapped_data == NULL)
+            return;
+#ifndef _WIN32
+        munmap(mapped_data, mapped_size);
+#endif
+        mapped_data = NULL;
+        mapped_size = 0;
+        useStorage();
+    }
+
+    void LinearOcTree::setResolution(double r) {
+        resolution = r;
+        resolution_factor = 1. / resolution;
+
+        sizeLookupTable.resize(tree_depth + 1);
+        for (unsigned i = 0; i <= tree_depth; ++i)
+            sizeLookupTable[i] = resolution * double(1 << (tree_depth - i));
+    }
+
+    void LinearOcTree::toOcTree(AbstractOcTree& tree) const {
+        tree.clear();
+        tree.setResolution(resolution);
+        if (leaves.empty())
+            return;
+
+        NodeDataBuf buf(leaves, inner_nodes);
+        std::istream s(&buf);
+        tree.readData(s);
+    }
+
+    bool LinearOcTree::coordToKeyChecked(const point3d& coord, OcTreeKey& key) const {
+        for (unsigned int i = 0; i < 3; i++) {
+            int scaled_coord = ((int) floor(resolution_factor * coord(i))) + tree_max_val;
+            if ((scaled_coord < 0) || (((unsigned int) scaled_coord) >= (2 * tree_max_val)))
+                return false;
+            key[i] = scaled_coord;
+        }
+        return true;
+    }
+
+    double LinearOcTree::keyToCoord(key_type key, unsigned depth) const {
+        assert(depth <= tree_depth);
+
+        // root is centered on 0 = 0.0
+        if (depth == 0)
+            return 0.0;
+        else if (depth == tree_depth)
+            return keyToCoord(key);
+        else
+            return (floor((double(key) - double(tree_max_val)) / double(1 << (tree_depth - depth))) + 0.5) * getNodeSize(depth);
+    }
+
+    OcTreeKey LinearOcTree::nodeKey(const LinearOcTreeNode& node) const {
+        OcTreeKey key = OcTreeKey::fromMortonCode(node.getCode());
+        unsigned int diff = tree_depth - node.getDepth();
+        if (diff > 0) {
+            for (unsigned int i = 0; i < 3; i++)
+                key[i] += 1 << (diff - 1);
+        }
+        return key;
+    }
+
+    const LinearOcTreeNode* LinearOcTree::upperBound(const ConstArray<LinearOcTreeNode>& nodes, const ConstArray<uint64_t>& index,
+                                                     uint64_t sort_key) {
+        if (nodes.empty())
+            return NULL;
+
+        // nodes[(block - 1) * INDEX_STRIDE] <= sort_key < nodes[block * INDEX_STRIDE]
+        size_t block = std::upper_bound(index.begin(), index.end(), sort_key) - index.begin();
+        if (block == 0)
+            return &nodes[0];
+        const LinearOcTreeNode* first = &nodes[0] + (block - 1) * INDEX_STRIDE;
+        const LinearOcTreeNode* last = &nodes[0] + std::min(nodes.size(), block * INDEX_STRIDE);
+        return std::upper_bound(first, last, sort_key, SortKeyLess());
+    }
+
+    const LinearOcTreeNode* LinearOcTree::findLeaf(uint64_t code) const {
+        const LinearOcTreeNode* it = upperBound(leaves, leaf_index, lastSortKey(code));
+        if (it == NULL || it == &leaves[0])
+            return NULL;
+        --it;
+        if (code - it->getCode() > codeMask(it->getDepth()))
+            return NULL;
+        return it;
+    }
+
+    const LinearOcTreeNode* LinearOcTree::findInnerNode(uint64_t code, unsigned int depth) const {
+        if (inner_nodes.empty())
+            return NULL;
+        // the node is the last one with a sort key up to its code and depth, whatever its flags and child mask
+        const LinearOcTreeNode* it = upperBound(inner_nodes, inner_index, LinearOcTreeNode::sortKey(code, depth) | 0x7FF);
+        if (it == &inner_nodes[0])
+            return NULL;
+        --it;
+        if (it->getCode() != code || it->getDepth() != depth)
+            return NULL;
+        return it;
+    }
+
+    const LinearOcTreeNode* LinearOcTree::search(const OcTreeKey& key, unsigned int depth) const {
+        assert(depth <= tree_depth);
+        if (leaves.empty())
+            return NULL;
+
+        if (depth == 0)
+            depth = tree_depth;
+
+        uint64_t code = key.mortonCode();
+        const LinearOcTreeNode* leaf = findLeaf(code);
+        if (leaf != NULL && leaf->getDepth() <= depth)
+            return leaf;
+        if (depth == tree_depth)
+            return NULL;
+
+        // the node at depth is an inner node (or the key is unknown)
+        return findInnerNode(code & ~codeMask(depth), depth);
+    }
+
+    const LinearOcTreeNode* LinearOcTree::search(const point3d& value, unsigned int depth) const {
+        OcTreeKey key;
+        if (!coordToKeyChecked(value, key)) {
+            OCTOMAP_ERROR_STR("Error in search: [" << value << "] is out of OcTree bounds!");
+            return NULL;
+        }
+        return search(key, depth);
+    }
+
+    const LinearOcTreeNode* LinearOcTree::search(double x, double y, double z, unsigned int depth) const {
+        return search(point3d(float(x), float(y), float(z)), depth);
+    }
+
+    void LinearOcTree::findRayCube(const OcTreeKey& key, unsigned int& shift, int& state) const {
+        uint64_t code = key.mortonCode();
+        const LinearOcTreeNode* first = leaves.empty() ? NULL : &leaves[0];
+        const LinearOcTreeNode* last = leaves.empty() ? NULL : &leaves[0] + leaves.size();
+        const LinearOcTreeNode* next = upperBound(leaves, leaf_index, lastSortKey(code));
+        uint64_t prev_end = 0;
+        if (next != first) {
+            const LinearOcTreeNode* leaf = next - 1;
+            unsigned int depth = leaf->getDepth();
+            if (code - leaf->getCode() <= codeMask(depth)) {
+                if (isNodeOccupied(*leaf)) {
+                    state = 1;
+                    shift = tree_depth - depth;
+                    return;
+                }
+
+                // free leaf: find the largest completely known free subtree on its
+                // path, all nodes below such a subtree are completely known and free too
+                state = 0;
+                unsigned int lo = 0, hi = depth;
+                while (lo < hi) {
+                    unsigned int mid = (lo + hi) / 2;
+                    const LinearOcTreeNode* node = findInnerNode(code & ~codeMask(mid), mid);
+                    if (node != NULL && node->isComplete() && !isNodeOccupied(node))
+                        hi = mid;
+                    else
+                        lo = mid + 1;
+                }
+                shift = tree_depth - lo;
+                return;
+            }
+            prev_end = leaf->getCode() + codeMask(depth) + 1;
+        }
+
+        // unknown cell: grow the cube while it does not reach into a leaf
+        state = -1;
+        uint64_t next_begin = (next == last) ? (((uint64_t)1) << (3 * tree_depth)) : next->getCode();
+        shift = 0;
+        while (shift < tree_depth) {
+            uint64_t mask = (((uint64_t)1) << (3 * (shift + 1))) - 1;
+            uint64_t begin = code & ~mask;
+            if (begin < prev_end || begin + mask >= next_begin)
+                break;
+            shift++;
+        }
+    }
+
+    bool LinearOcTree::castRay(const point3d& origin, const point3d& directionP, point3d& end,
+                               bool ignoreUnknown, double maxRange) const {
+
+        // Initialization phase -------------------------------------------------------
+        OcTreeKey current_key;
+        if (!coordToKeyChecked(origin, current_key)) {
+            OCTOMAP_WARNING_STR("Coordinates out of bounds during ray casting");
+            return false;
+        }
+
+        // cells sharing the bits of cube_key above shift have the same state
+        OcTreeKey cube_key = current_key;
+        unsigned int shift;
+        int state;
+        findRayCube(current_key, shift, state);
+        if (state > 0) {
+            // Occupied node found at origin
+            // (need to convert from key, since origin does not need to be a voxel center)
+            end = keyToCoord(current_key);
+            return true;
+        } else if (state < 0 && !ignoreUnknown) {
+            end = keyToCoord(current_key);
+            return false;
+        }
+
+        point3d direction = directionP.normalized();
+        bool max_range_set = (maxRange > 0.0);
+
+        int step[3];
+        double tMax[3];
+        double tDelta[3];
+
+        for (unsigned int i = 0; i < 3; ++i) {
+            // compute step direction
+            if (direction(i) > 0.0) step[i] = 1;
+            else if (direction(i) < 0.0) step[i] = -1;
+            else step[i] = 0;
+
+            // compute tMax, tDelta
+            if (step[i] != 0) {
+                // corner point of voxel (in direction of ray)
+                double voxelBorder = keyToCoord(current_key[i]);
+                voxelBorder += double(step[i] * resolution * 0.5);
+
+                tMax[i] = (voxelBorder - origin(i)) / direction(i);
+                tDelta[i] = resolution / fabs(direction(i));
+            }
+            else {
+                tMax[i] = std::numeric_limits<double>::max();
+                tDelta[i] = std::numeric_limits<double>::max();
+            }
+        }
+
+        if (step[0] == 0 && step[1] == 0 && step[2] == 0) {
+            OCTOMAP_ERROR("Raycasting in direction (0,0,0) is not possible!");
+            return false;
+        }
+
+        // for speedup:
+        double maxrange_sq = maxRange * maxRange;
+
+        // Incremental phase  ---------------------------------------------------------
+
+        while (true) {
+            unsigned int dim;
+
+            // find minimum tMax:
+            if (tMax[0] < tMax[1]) {
+                if (tMax[0] < tMax[2]) dim = 0;
+                else                   dim = 2;
+            }
+            else {
+                if (tMax[1] < tMax[2]) dim = 1;
+                else                   dim = 2;
+            }
+
+            // check for overflow:
+            if ((step[dim] < 0 && current_key[dim] == 0)
+                || (step[dim] > 0 && current_key[dim] == 2 * tree_max_val - 1))
+            {
+                OCTOMAP_WARNING("Coordinate hit bounds in dim %d, aborting raycast\n", dim);
+                // return border point nevertheless:
+                end = keyToCoord(current_key);
+                return false;
+            }
+
+            // advance in direction "dim"
+            current_key[dim] += step[dim];
+            tMax[dim] += tDelta[dim];
+
+            // generate world coords from key
+            end = keyToCoord(current_key);
+
+            // check for maxrange:
+            if (max_range_set) {
+                double dist_from_origin_sq(0.0);
+                for (unsigned int j = 0; j < 3; j++) {
+                    dist_from_origin_sq += ((end(j) - origin(j)) * (end(j) - origin(j)));
+                }
+                if (dist_from_origin_sq > maxrange_sq)
+                    return false;
+            }
+
+            // left the cube of the previous cell?
+            if (((current_key[0] ^ cube_key[0]) | (current_key[1] ^ cube_key[1]) | (current_key[2] ^ cube_key[2])) >> shift) {
+                cube_key = current_key;
+                findRayCube(current_key, shift, state);
+            }
+
+            if (state > 0)
+                return true;
+            else if (state < 0 && !ignoreUnknown) // no node found, this usually means we are in "unknown" areas
+                return false;
+            // otherwise: node is free and valid, raycasting continues
+        }
+    }
+
+    void LinearOcTree::buildInnerNodes() {
+        std::sort(leaf_storage.begin(), leaf_storage.end(), SortKeyLess());
+        inner_storage.clear();
+
+        // inner nodes on the path to the current leaf, from the root down
+        struct OpenNode {
+            uint64_t code;
+            float max_value;
+            unsigned int child_mask;
+            unsigned int num_complete;
+        } open[16];
+        unsigned int num_open = 0;
+
+        for (std::vector<LinearOcTreeNode>::const_iterator leaf = leaf_storage.begin(); leaf != leaf_storage.end(); ++leaf) {
+            uint64_t code = leaf->getCode();
+            unsigned int depth = leaf->getDepth();
+
+            // close the open nodes that are no ancestors of the leaf, children first
+            unsigned int common = 0;
+            while (common < num_open && common < depth && open[common].code == (code & ~codeMask(common)))
+                common++;
+            while (num_open > common) {
+                num_open--;
+                const OpenNode& node = open[num_open];
+                bool complete = (node.num_complete == 8);
+                inner_storage.push_back(LinearOcTreeNode(node.code, num_open, node.max_value, node.child_mask, complete));
+                if (num_open > 0) {
+                    OpenNode& parent = open[num_open - 1];
+                    parent.child_mask |= 1 << ((node.code >> (3 * (tree_depth - num_open))) & 7);
+                    parent.max_value = std::max(parent.max_value, node.max_value);
+                    parent.num_complete += complete ? 1 : 0;
+                }
+            }
+
+            // open the missing ancestors
+            while (num_open < depth) {
+                OpenNode& node = open[num_open];
+                node.code = code & ~codeMask(num_open);
+                node.max_value = -std::numeric_limits<float>::max();
+                node.child_mask = 0;
+                node.num_complete = 0;
+                num_open++;
+            }
+
+            if (depth > 0) {
+                OpenNode& parent = open[depth - 1];
+                parent.child_mask |= 1 << ((code >> (3 * (tree_depth - depth))) & 7);
+                parent.max_value = std::max(parent.max_value, leaf->getLogOdds());
+                parent.num_complete++;
+            }
+        }
+
+        while (num_open > 0) {
+            num_open--;
+            const OpenNode& node = open[num_open];
+            bool complete = (node.num_complete == 8);
+            inner_storage.push_back(LinearOcTreeNode(node.code, num_open, node.max_value, node.child_mask, complete));
+            if (num_open > 0) {
+                OpenNode& parent = open[num_open - 1];
+                parent.child_mask |= 1 << ((node.code >> (3 * (tree_depth - num_open))) & 7);
+                parent.max_value = std::max(parent.max_value, node.max_value);
+                parent.num_complete += complete ? 1 : 0;
+            }
+        }
+
+        // the nodes were closed children first, sort them into depth-first order
+        std::sort(inner_storage.begin(), inner_storage.end(), SortKeyLess());
+        std::vector<LinearOcTreeNode>(inner_storage).swap(inner_storage);
+
+        leaf_index_storage.clear();
+        for (size_t i = 0; i < leaf_storage.size(); i += INDEX_STRIDE)
+            leaf_index_storage.push_back(leaf_storage[i].getSortKey());
+        inner_index_storage.clear();
+        for (size_t i = 0; i < inner_storage.size(); i += INDEX_STRIDE)
+            inner_index_storage.push_back(inner_storage[i].getSortKey());
+        useStorage();
+    }
+
+
+    LinearOcTree::leaf_bbx_iterator::leaf_bbx_iterator(const LinearOcTree* ptree, const OcTreeKey& min, const OcTreeKey& max)
+        : leaf_iterator(ptree, NULL), min_key(min), max_key(max), min_code(min.mortonCode()), max_code(max.mortonCode()), run_end(0) {
+        if (tree->leaves.empty())
+            return;
+        if (min[0] > max[0] || min[1] > max[1] || min[2] > max[2]) {
+            node = &tree->leaves[0] + tree->leaves.size();
+            return;
+        }
+
+        // start at the last leaf not above min_code, all leaves before it end below min_code
+        const LinearOcTreeNode* it = upperBound(tree->leaves, tree->leaf_index, lastSortKey(min_code));
+        if (it != &tree->leaves[0])
+            --it;
+        seek(it, min_code);
+    }
+
+    LinearOcTree::leaf_bbx_iterator& LinearOcTree::leaf_bbx_iterator::operator++() {
+        const LinearOcTreeNode* last = &tree->leaves[0] + tree->leaves.size();
+        if (node + 1 != last && (node + 1)->getCode() < run_end) {
+            ++node;
+            return *this;
+        }
+
+        uint64_t code = node->getCode() + tree->codeMask(node->getDepth()) + 1;
+        OcTreeKey key = OcTreeKey::fromMortonCode(code);
+        bool inside = code <= max_code && key[0] >= min_key[0] && key[0] <= max_key[0] && key[1] >= min_key[1] && key[1] <= max_key[1]
+            && key[2] >= min_key[2] && key[2] <= max_key[2];
+        if (!inside && !nextCodeInBox(code, min_code, max_code, code))
+            node = last;
+        else
+            seek(node + 1, code);
+        return *this;
+    }
+
+    uint64_t LinearOcTree::leaf_bbx_iterator::runEnd(uint64_t code) const {
+        OcTreeKey key = OcTreeKey::fromMortonCode(code);
+        unsigned int level = 0;
+        for (; level < tree->tree_depth; level++) {
+            // the cube of the next level starts at code and ends inside the box
+            unsigned int size = 2u << level;
+            if ((code & ((((uint64_t)1) << (3 * (level + 1))) - 1)) != 0
+                || key[0] + size - 1 > max_key[0] || key[1] + size - 1 > max_key[1] || key[2] + size - 1 > max_key[2])
+                break;
+        }
+        return code + (((uint64_t)1) << (3 * level));
+    }
+
+    void LinearOcTree::leaf_bbx_iterator::seek(const LinearOcTreeNode* it, uint64_t code) {
+        const LinearOcTreeNode* last = &tree->leaves[0] + tree->leaves.size();
+
+        // code is inside the box, the first leaf ending above it may intersect the box
+        while (it != last) {
+            // leaves before it end below code, search unless it ends above code as well
+            if (it->getCode() < code && code - it->getCode() > tree->codeMask(it->getDepth())) {
+                const LinearOcTreeNode* prev = gallopUpperBound(it, last, lastSortKey(code)) - 1;
+                it = (code - prev->getCode() <= tree->codeMask(prev->getDepth())) ? prev : prev + 1;
+                if (it == last)
+                    break;
+            }
+
+            OcTreeKey key = OcTreeKey::fromMortonCode(it->getCode());
+            unsigned int size = 1u << (tree->tree_depth - it->getDepth());
+            if (key[0] <= max_key[0] && key[0] + size > min_key[0]
+                && key[1] <= max_key[1] && key[1] + size > min_key[1]
+                && key[2] <= max_key[2] && key[2] + size > min_key[2]) {
+                node = it;
+                // leaves up to the end of the cube at code are in the box as well (there is none between code and it)
+                run_end = runEnd(code);
+                return;
+            }
+
+            // all cells of the leaf are outside of the box
+            if (!nextCodeInBox(it->getCode() + tree->codeMask(it->getDepth()) + 1, min_code, max_code, code))
+                break;
+            ++it;
+        }
+        node = last;
+    }
+
+} // end namespace
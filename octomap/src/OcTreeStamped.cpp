@@ -36,7 +36,7 @@
 namespace octomap {
 
     OcTreeStamped::OcTreeStamped(double in_resolution)
-            : OccupancyOcTreeBase<OcTreeNodeStamped>(in_resolution) {
+            : OccupancyOcTreeBase<OcTreeNodeStamped, OcTreeNodeArena<OcTreeNodeStamped> >(in_resolution) {
         ocTreeStampedMemberInit.ensureLinking();
     }
 
@@ -59,12 +59,12 @@ namespace octomap {
     }
 
     void OcTreeStamped::updateNodeLogOdds(OcTreeNodeStamped* node, const float& update) const {
-        OccupancyOcTreeBase<OcTreeNodeStamped>::updateNodeLogOdds(node, update);
+        OccupancyOcTreeBase<OcTreeNodeStamped, OcTreeNodeArena<OcTreeNodeStamped> >::updateNodeLogOdds(node, update);
         node->updateTimestamp();
     }
 
     void OcTreeStamped::integrateMissNoTime(OcTreeNodeStamped* node) const{
-        OccupancyOcTreeBase<OcTreeNodeStamped>::updateNodeLogOdds(node, prob_miss_log);
+        OccupancyOcTreeBase<OcTreeNodeStamped, OcTreeNodeArena<OcTreeNodeStamped> >::updateNodeLogOdds(node, prob_miss_log);
     }
 
     OcTreeStamped::StaticMemberInitializer OcTreeStamped::ocTreeStampedMemberInit;
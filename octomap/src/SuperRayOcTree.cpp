@@ -31,12 +31,12 @@
 
 namespace octomap{
 	SuperRayOcTree::SuperRayOcTree(double in_resolution)
-	: OccupancyOcTreeBase<OcTreeNode>(in_resolution) {
+	: OccupancyOcTreeBase<OcTreeNode, OcTreeNodeArena<OcTreeNode> >(in_resolution) {
 		superrayOcTreeMemberInit.ensureLinking();
 	};
 
 	SuperRayOcTree::SuperRayOcTree(std::string _filename)
-	: OccupancyOcTreeBase<OcTreeNode>(0.1)  { // resolution will be set according to tree file
+	: OccupancyOcTreeBase<OcTreeNode, OcTreeNodeArena<OcTreeNode> >(0.1)  { // resolution will be set according to tree file
 		readBinary(_filename);
 	}
 
@@ -75,6 +75,9 @@ namespace octomap{
 		for (int i = 0; i < (int)pc.size(); ++i){
 			updateNode(pc[i], true); // update endpoint to be occupied
 		}
+
+		if (isFrontierTrackingEnabled())
+			updateFrontiers();
 	}
 
 	void SuperRayOcTree::insertSuperRayCloudRays(const Pointcloud& scan, const point3d& origin, const int threshold)
@@ -110,8 +113,9 @@ namespace octomap{
 	#pragma omp critical
 	#endif
 				{
+					SearchCursor cursor;
 					for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); it++) {
-						updateNode(*it, missprob, false);
+						updateNode(*it, missprob, cursor, false);
 					}
 				}
 			}
@@ -120,5 +124,8 @@ namespace octomap{
 		for (int i = 0; i < (int)superray.size(); ++i){
 			updateNode(superray[i].p, prob_hit_log * superray[i].w, false);
 		}
+
+		if (isFrontierTrackingEnabled())
+			updateFrontiers();
 	}
 }
\ No newline at end of file
@@ -75,6 +75,8 @@ namespace quadmap {
 		/// Copy constructor
 		OccupancyQuadTreeBase(const OccupancyQuadTreeBase<NODE>& rhs);
 
+		typedef typename QuadTreeBaseImpl<NODE, AbstractOccupancyQuadTree>::SearchCursor SearchCursor;
+
 		/**
 		* Integrate a Pointcloud (in global reference frame), parallelized with OpenMP.
 		* Special care is taken that each pixel
@@ -287,6 +289,10 @@ namespace quadmap {
 		 * was hit by the raycast. If the raycast returns false you can search() the node at 'end' and
 		 * see whether it's unknown space.
 		 *
+		 * The quadtree is only searched when the ray leaves the block of the last search:
+		 * a pruned free leaf, or an unknown subtree if unknown cells are ignored. The ray
+		 * jumps across such a block at once, the pixels reached are the same as when
+		 * stepping pixel by pixel.
 		 *
 		 * @param[in] origin starting coordinate of ray
 		 * @param[in] direction A vector pointing in the direction of the raycast (NOT a point in space). Does not need to be normalized.
@@ -298,6 +304,27 @@ namespace quadmap {
 		virtual bool castRay(const point2d& origin, const point2d& direction, point2d& end,
 							 bool ignoreUnknownCells = false, double maxRange = -1.0) const;
 
+		/// Performs raycasting as castRay() above, searching the cells through cursor. Rays cast
+		/// one after another from nearby origins share the upper part of their search paths then.
+		bool castRay(const point2d& origin, const point2d& direction, point2d& end, SearchCursor& cursor,
+					 bool ignoreUnknownCells = false, double maxRange = -1.0) const;
+
+		/**
+		 * Performs castRay() for a batch of rays, in parallel with OpenMP. Each thread
+		 * searches the cells of its rays through one SearchCursor.
+		 *
+		 * @param[in] origins starting coordinates of the rays
+		 * @param[in] directions directions of the rays, one per origin (need not be normalized)
+		 * @param[out] ends the ends of the rays as castRay() returns them
+		 * @param[out] distances distance from the origin to the end of each ray that hit an occupied cell, -1 otherwise
+		 * @param[in] ignoreUnknownCells whether unknown cells are ignored (= treated as free), see castRay()
+		 * @param[in] maxRange Maximum range after which the raycast is aborted (<= 0: no limit, default)
+		 * @return number of rays that hit an occupied cell
+		 */
+		size_t castRays(const std::vector<point2d>& origins, const std::vector<point2d>& directions,
+						std::vector<point2d>& ends, std::vector<double>& distances,
+						bool ignoreUnknownCells = false, double maxRange = -1.0) const;
+
 		/**
 		 * Retrieves the entry point of a ray into a pixel. This is the closest intersection point of the ray
 		 * originating from origin and a plane of the axis aligned cube.
@@ -352,6 +379,50 @@ namespace quadmap {
 		/// Number of changes since last reset.
 		size_t numChangesDetected() const { return changed_keys.size(); }
 
+		//-- frontier tracking for exploration:
+		/// Connected set of frontier cells, see getFrontierClusters()
+		struct FrontierCluster {
+			std::vector<QuadTreeKey> keys; ///< keys of the frontier cells (lowest tree level)
+			point2d centroid;              ///< mean of the cell centers
+			point2d bbx_min;               ///< minimum of the cell centers
+			point2d bbx_max;               ///< maximum of the cell centers
+		};
+
+		/**
+		 * Maintains an index of the frontier cells: known free cells at the lowest tree
+		 * level with at least one unknown edge neighbor (default: off). The updates of
+		 * leaf nodes record the cells that became known or changed their occupancy, and
+		 * updateFrontiers() checks only these cells and the neighbors of the new ones.
+		 * The scan insertions of SuperRayQuadTree call updateFrontiers() when they are done.
+		 * Enabling builds the index of the current map with rebuildFrontiers().
+		 */
+		void enableFrontierTracking(bool enable);
+		bool isFrontierTrackingEnabled() const { return use_frontier_tracking; }
+
+		/// Checks the cells changed since the last call and updates the frontier index
+		void updateFrontiers();
+
+		/// Builds the frontier index from the whole map. Needed after changes which are not
+		/// recorded: deleteNode() or clear(). Reading a map rebuilds the index.
+		void rebuildFrontiers();
+
+		/// @return keys of all frontier cells, as of the last updateFrontiers()
+		const KeySet& getFrontiers() const { return frontier_keys; }
+
+		/// @return number of frontier cells, as of the last updateFrontiers()
+		size_t numFrontiers() const { return frontier_keys.size(); }
+
+		/// Appends the centers of all frontier cells to node_centers
+		void getFrontierCenters(point2d_list& node_centers) const;
+
+		/**
+		 * Groups the frontier cells into clusters of 8-connected cells. The cost depends
+		 * on the number of frontier cells only, not on the size of the map.
+		 * @param[out] clusters the clusters with at least min_cluster_size cells, largest first
+		 * @param[in] min_cluster_size smaller clusters (e.g. single cells from sensor noise) are dropped
+		 */
+		void getFrontierClusters(std::vector<FrontierCluster>& clusters, size_t min_cluster_size = 1) const;
+
 
 		/**
 		 * Helper for insertPointCloud(). Computes all quadtree nodes affected by the point cloud
@@ -468,6 +539,32 @@ namespace quadmap {
 
 		void updateInnerOccupancyRecurs(NODE* node, unsigned int depth);
 
+		/// Records a leaf key that was created (node_just_created) or changed its occupancy
+		/// for change detection and frontier tracking
+		void trackChange(const QuadTreeKey& key, bool node_just_created);
+
+		/// @return true if key is a known free cell with an unknown edge neighbor
+		bool isFrontier(const QuadTreeKey& key, SearchCursor& cursor) const;
+
+		/// Orders frontier clusters by decreasing size
+		struct FrontierClusterLarger {
+			bool operator()(const FrontierCluster& a, const FrontierCluster& b) const {
+				return a.keys.size() > b.keys.size();
+			}
+		};
+
+		/// @return log2 of the width (in pixels) of the block that castRay() may cross without
+		/// searching, given the result node of the last search through cursor (NULL: unknown)
+		unsigned int rayBlockLevel(const NODE* node, const SearchCursor& cursor) const;
+
+		/// @return true if the centers of all pixels in the block of key at level are within maxRange of origin
+		bool rayBlockInRange(const point2d& origin, const QuadTreeKey& key, unsigned int level, double maxrange_sq) const;
+
+		/// Advances the traversal state of castRay() to the last pixel the ray crosses
+		/// in the block of key at level (2^level pixels wide)
+		static void skipRayBlock(QuadTreeKey& key, const int step[2], double tMax[2], const double tDelta[2],
+								 unsigned int level);
+
 		void toMaxLikelihoodRecurs(NODE* node, unsigned int depth, unsigned int max_depth);
 
 
@@ -482,6 +579,13 @@ namespace quadmap {
 		/// Set of leaf keys (lowest level) which changed since last resetChangeDetection
 		KeyBoolMap changed_keys;
 
+		bool use_frontier_tracking;
+		/// Keys of the frontier cells
+		KeySet frontier_keys;
+		/// Keys changed since the last updateFrontiers(), true if the node was created. A plain
+		/// log (duplicates are removed by updateFrontiers()) does not allocate per change.
+		std::vector<std::pair<QuadTreeKey, bool> > frontier_updates;
+
 
 	};
 
@@ -38,14 +38,16 @@ namespace quadmap {
 
 	template <class NODE>
 	OccupancyQuadTreeBase<NODE>::OccupancyQuadTreeBase(double in_resolution)
-			: QuadTreeBaseImpl<NODE, AbstractOccupancyQuadTree>(in_resolution), use_bbx_limit(false), use_change_detection(false)
+			: QuadTreeBaseImpl<NODE, AbstractOccupancyQuadTree>(in_resolution), use_bbx_limit(false), use_change_detection(false),
+			  use_frontier_tracking(false)
 	{
 
 	}
 
 	template <class NODE>
 	OccupancyQuadTreeBase<NODE>::OccupancyQuadTreeBase(double in_resolution, unsigned int in_tree_depth, unsigned int in_tree_max_val)
-			: QuadTreeBaseImpl<NODE, AbstractOccupancyQuadTree>(in_resolution, in_tree_depth, in_tree_max_val), use_bbx_limit(false), use_change_detection(false)
+			: QuadTreeBaseImpl<NODE, AbstractOccupancyQuadTree>(in_resolution, in_tree_depth, in_tree_max_val), use_bbx_limit(false), use_change_detection(false),
+			  use_frontier_tracking(false)
 	{
 
 	}
@@ -59,7 +61,9 @@ namespace quadmap {
 			QuadTreeBaseImpl<NODE, AbstractOccupancyQuadTree>(rhs), use_bbx_limit(rhs.use_bbx_limit),
 			bbx_min(rhs.bbx_min), bbx_max(rhs.bbx_max),
 			bbx_min_key(rhs.bbx_min_key), bbx_max_key(rhs.bbx_max_key),
-			use_change_detection(rhs.use_change_detection), changed_keys(rhs.changed_keys)
+			use_change_detection(rhs.use_change_detection), changed_keys(rhs.changed_keys),
+			use_frontier_tracking(rhs.use_frontier_tracking), frontier_keys(rhs.frontier_keys),
+			frontier_updates(rhs.frontier_updates)
 	{
 		this->clamping_thres_min = rhs.clamping_thres_min;
 		this->clamping_thres_max = rhs.clamping_thres_max;
@@ -408,20 +412,11 @@ namespace quadmap {
 
 			// at last level, update node, end of recursion
 		else {
-			if (use_change_detection) {
+			if (use_change_detection || use_frontier_tracking) {
 				bool occBefore = this->isNodeOccupied(node);
 				updateNodeLogOdds(node, log_odds_update);
-
-				if (node_just_created){  // new node
-					changed_keys.insert(std::pair<QuadTreeKey, bool>(key, true));
-				}
-				else if (occBefore != this->isNodeOccupied(node)) {  // occupancy changed, track it
-					KeyBoolMap::iterator it = changed_keys.find(key);
-					if (it == changed_keys.end())
-						changed_keys.insert(std::pair<QuadTreeKey, bool>(key, false));
-					else if (it->second == false)
-						changed_keys.erase(it);
-				}
+				if (node_just_created || occBefore != this->isNodeOccupied(node))
+					trackChange(key, node_just_created);
 			}
 			else {
 				updateNodeLogOdds(node, log_odds_update);
@@ -475,20 +470,11 @@ namespace quadmap {
 
 			// at last level, update node, end of recursion
 		else {
-			if (use_change_detection) {
+			if (use_change_detection || use_frontier_tracking) {
 				bool occBefore = this->isNodeOccupied(node);
 				node->setLogOdds(log_odds_value);
-
-				if (node_just_created){  // new node
-					changed_keys.insert(std::pair<QuadTreeKey, bool>(key, true));
-				}
-				else if (occBefore != this->isNodeOccupied(node)) {  // occupancy changed, track it
-					KeyBoolMap::iterator it = changed_keys.find(key);
-					if (it == changed_keys.end())
-						changed_keys.insert(std::pair<QuadTreeKey, bool>(key, false));
-					else if (it->second == false)
-						changed_keys.erase(it);
-				}
+				if (node_just_created || occBefore != this->isNodeOccupied(node))
+					trackChange(key, node_just_created);
 			}
 			else {
 				node->setLogOdds(log_odds_value);
@@ -497,6 +483,198 @@ namespace quadmap {
 		}
 	}
 
+	template <class NODE>
+	void OccupancyQuadTreeBase<NODE>::trackChange(const QuadTreeKey& key, bool node_just_created) {
+		if (use_change_detection) {
+			if (node_just_created){  // new node
+				changed_keys.insert(std::pair<QuadTreeKey, bool>(key, true));
+			}
+			else {  // occupancy changed, track it
+				KeyBoolMap::iterator it = changed_keys.find(key);
+				if (it == changed_keys.end())
+					changed_keys.insert(std::pair<QuadTreeKey, bool>(key, false));
+				else if (it->second == false)
+					changed_keys.erase(it);
+			}
+		}
+		if (use_frontier_tracking) {
+			frontier_updates.push_back(std::pair<QuadTreeKey, bool>(key, node_just_created));
+		}
+	}
+
+	template <class NODE>
+	void OccupancyQuadTreeBase<NODE>::enableFrontierTracking(bool enable) {
+		if (enable == use_frontier_tracking)
+			return;
+		use_frontier_tracking = enable;
+		if (enable)
+			rebuildFrontiers();
+		else {
+			KeySet().swap(frontier_keys);
+			std::vector<std::pair<QuadTreeKey, bool> >().swap(frontier_updates);
+		}
+	}
+
+	template <class NODE>
+	bool OccupancyQuadTreeBase<NODE>::isFrontier(const QuadTreeKey& key, SearchCursor& cursor) const {
+		NODE* node = this->search(key, cursor);
+		if (node == NULL || this->isNodeOccupied(node))
+			return false;
+
+		const key_type max_key = (key_type) (2 * this->tree_max_val - 1);
+		QuadTreeKey neighbor = key;
+		for (unsigned int i = 0; i < 2; ++i) {
+			if (key[i] > 0) {
+				neighbor[i] = key[i] - 1;
+				if (this->search(neighbor, cursor) == NULL)
+					return true;
+			}
+			if (key[i] < max_key) {
+				neighbor[i] = key[i] + 1;
+				if (this->search(neighbor, cursor) == NULL)
+					return true;
+			}
+			neighbor[i] = key[i];
+		}
+		return false;
+	}
+
+	template <class NODE>
+	void OccupancyQuadTreeBase<NODE>::updateFrontiers() {
+		if (frontier_updates.empty())
+			return;
+
+		// A cell that became known can only stop its edge neighbors from being frontiers,
+		// a cell that changed its occupancy can only change its own state
+		const key_type max_key = (key_type) (2 * this->tree_max_val - 1);
+		std::vector<QuadTreeKey> candidates;
+		candidates.reserve(2 * frontier_updates.size());
+		for (std::vector<std::pair<QuadTreeKey, bool> >::const_iterator it = frontier_updates.begin(); it != frontier_updates.end(); ++it) {
+			candidates.push_back(it->first);
+			if (!it->second)
+				continue;
+			for (unsigned int i = 0; i < 2; ++i) {
+				QuadTreeKey neighbor = it->first;
+				if (neighbor[i] > 0) {
+					neighbor[i]--;
+					if (frontier_keys.count(neighbor))
+						candidates.push_back(neighbor);
+					neighbor[i]++;
+				}
+				if (neighbor[i] < max_key) {
+					neighbor[i]++;
+					if (frontier_keys.count(neighbor))
+						candidates.push_back(neighbor);
+				}
+			}
+		}
+		frontier_updates.clear();
+
+		// check the cells along the tree traversal, so that consecutive searches share their paths
+		std::sort(candidates.begin(), candidates.end(), QuadTreeKey::KeyTraversalLess());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+		SearchCursor cursor;
+		for (size_t i = 0; i < candidates.size(); ++i) {
+			if (isFrontier(candidates[i], cursor))
+				frontier_keys.insert(candidates[i]);
+			else
+				frontier_keys.erase(candidates[i]);
+		}
+	}
+
+	template <class NODE>
+	void OccupancyQuadTreeBase<NODE>::rebuildFrontiers() {
+		KeySet().swap(frontier_keys);
+		frontier_updates.clear();
+		if (this->root == NULL)
+			return;
+
+		// Only the cells on the edges of a free leaf can border unknown space, each through
+		// its neighbor on the outer side of the edge
+		const int max_key = 2 * this->tree_max_val - 1;
+		SearchCursor cursor;
+		for (typename QuadTreeBaseImpl<NODE, AbstractOccupancyQuadTree>::leaf_iterator it = this->begin_leafs(),
+			 end = this->end_leafs(); it != end; ++it) {
+			if (this->isNodeOccupied(*it))
+				continue;
+
+			const QuadTreeKey base = it.getIndexKey();
+			const int width = 1 << (this->tree_depth - it.getDepth());
+			for (unsigned int i = 0; i < 2; ++i) {
+				const unsigned int u = 1 - i;
+				for (int side = -1; side <= 1; side += 2) {
+					const int edge = (side < 0) ? base[i] : base[i] + width - 1;
+					if (edge + side < 0 || edge + side > max_key)
+						continue;
+
+					QuadTreeKey key(base), neighbor(base);
+					key[i] = (key_type) edge;
+					neighbor[i] = (key_type) (edge + side);
+					for (int a = 0; a < width; ++a) {
+						key[u] = neighbor[u] = (key_type) (base[u] + a);
+						if (this->search(neighbor, cursor) == NULL)
+							frontier_keys.insert(key);
+					}
+				}
+			}
+		}
+	}
+
+	template <class NODE>
+	void OccupancyQuadTreeBase<NODE>::getFrontierCenters(point2d_list& node_centers) const {
+		for (KeySet::const_iterator it = frontier_keys.begin(); it != frontier_keys.end(); ++it)
+			node_centers.push_back(this->keyToCoord(*it));
+	}
+
+	template <class NODE>
+	void OccupancyQuadTreeBase<NODE>::getFrontierClusters(std::vector<FrontierCluster>& clusters, size_t min_cluster_size) const {
+		clusters.clear();
+
+		// flood fill over the 8-neighborhood, the cells are removed from unvisited when reached
+		KeySet unvisited(frontier_keys);
+		std::vector<QuadTreeKey> keys;
+		const int max_key = 2 * this->tree_max_val - 1;
+		for (KeySet::const_iterator it = frontier_keys.begin(); it != frontier_keys.end(); ++it) {
+			if (unvisited.erase(*it) == 0)
+				continue;
+
+			// the keys of the cluster serve as queue
+			keys.assign(1, *it);
+			for (size_t k = 0; k < keys.size(); ++k) {
+				const QuadTreeKey current = keys[k];
+				for (int dx = -1; dx <= 1; ++dx) {
+					for (int dy = -1; dy <= 1; ++dy) {
+						int x = current[0] + dx, y = current[1] + dy;
+						if (x < 0 || y < 0 || x > max_key || y > max_key)
+							continue;
+						QuadTreeKey neighbor((key_type) x, (key_type) y);
+						if (unvisited.erase(neighbor) != 0)
+							keys.push_back(neighbor);
+					}
+				}
+			}
+			if (keys.size() < min_cluster_size)
+				continue;
+
+			clusters.push_back(FrontierCluster());
+			FrontierCluster& cluster = clusters.back();
+			cluster.keys.swap(keys);
+			double sum[2] = {0.0, 0.0};
+			cluster.bbx_min = cluster.bbx_max = this->keyToCoord(cluster.keys[0]);
+			for (size_t k = 0; k < cluster.keys.size(); ++k) {
+				point2d center = this->keyToCoord(cluster.keys[k]);
+				for (unsigned int i = 0; i < 2; ++i) {
+					sum[i] += center(i);
+					cluster.bbx_min(i) = std::min(cluster.bbx_min(i), center(i));
+					cluster.bbx_max(i) = std::max(cluster.bbx_max(i), center(i));
+				}
+			}
+			cluster.centroid = point2d((float) (sum[0] / cluster.keys.size()), (float) (sum[1] / cluster.keys.size()));
+		}
+
+		std::sort(clusters.begin(), clusters.end(), FrontierClusterLarger());
+	}
+
 	template <class NODE>
 	void OccupancyQuadTreeBase<NODE>::updateInnerOccupancy(){
 		if (this->root)
@@ -557,6 +735,13 @@ namespace quadmap {
 	template <class NODE>
 	bool OccupancyQuadTreeBase<NODE>::castRay(const point2d& origin, const point2d& directionP, point2d& end,
 											  bool ignoreUnknown, double maxRange) const {
+		SearchCursor cursor;
+		return castRay(origin, directionP, end, cursor, ignoreUnknown, maxRange);
+	}
+
+	template <class NODE>
+	bool OccupancyQuadTreeBase<NODE>::castRay(const point2d& origin, const point2d& directionP, point2d& end,
+											  SearchCursor& cursor, bool ignoreUnknown, double maxRange) const {
 
 		/// ----------  see OcTreeBase::computeRayKeys  -----------
 
@@ -567,7 +752,7 @@ namespace quadmap {
 			return false;
 		}
 
-		NODE* startingNode = this->search(current_key);
+		NODE* startingNode = this->search(current_key, cursor);
 		if (startingNode){
 			if (this->isNodeOccupied(startingNode)){
 				// Occupied node found at origin 
@@ -617,6 +802,16 @@ namespace quadmap {
 		// for speedup:
 		double maxrange_sq = maxRange *maxRange;
 
+		// The pixels in the block of a pruned free leaf, or of an unknown subtree if
+		// unknown cells are ignored, need no search: the ray jumps to the last of them
+		// it crosses, or steps through them without searching if the block reaches
+		// beyond maxRange. Keys in the block share the bits of block_key in block_mask.
+		QuadTreeKey block_key = current_key;
+		unsigned int block_level = rayBlockLevel(startingNode, cursor);
+		unsigned int block_mask = ~((1u << block_level) - 1);
+		if (block_level > 0 && (!max_range_set || rayBlockInRange(origin, block_key, block_level, maxrange_sq)))
+			skipRayBlock(current_key, step, tMax, tDelta, block_level);
+
 		// Incremental phase  ---------------------------------------------------------
 
 		bool done = false;
@@ -661,7 +856,11 @@ namespace quadmap {
 
 			}
 
-			NODE* currentNode = this->search(current_key);
+			// still inside the current free or unknown block
+			if ((((current_key[0] ^ block_key[0]) | (current_key[1] ^ block_key[1])) & block_mask) == 0)
+				continue;
+
+			NODE* currentNode = this->search(current_key, cursor);
 			if (currentNode){
 				if (this->isNodeOccupied(currentNode)) {
 					done = true;
@@ -672,11 +871,112 @@ namespace quadmap {
 			else if (!ignoreUnknown){ // no node found, this usually means we are in "unknown" areas
 				return false;
 			}
+			block_key = current_key;
+			block_level = rayBlockLevel(currentNode, cursor);
+			block_mask = ~((1u << block_level) - 1);
+			if (block_level > 0 && (!max_range_set || rayBlockInRange(origin, block_key, block_level, maxrange_sq)))
+				skipRayBlock(current_key, step, tMax, tDelta, block_level);
 		} // end while
 
 		return true;
 	}
 
+	template <class NODE>
+	unsigned int OccupancyQuadTreeBase<NODE>::rayBlockLevel(const NODE* node, const SearchCursor& cursor) const {
+		if (this->root == NULL)
+			return this->tree_depth;
+		// a found node is a leaf at the cursor depth, a missing one is the child below it
+		if (node)
+			return this->tree_depth - cursor.getDepth();
+		else
+			return this->tree_depth - cursor.getDepth() - 1;
+	}
+
+	template <class NODE>
+	bool OccupancyQuadTreeBase<NODE>::rayBlockInRange(const point2d& origin, const QuadTreeKey& key, unsigned int level,
+													  double maxrange_sq) const {
+		// castRay() tests the pixel centers, the farthest one from origin is in a corner of the block
+		const unsigned int block_max = (1u << level) - 1;
+		double dist_from_origin_sq(0.0);
+		for (unsigned int j = 0; j < 2; j++) {
+			float low = float(this->keyToCoord((key_type)(key[j] & ~block_max))) - origin(j);
+			float high = float(this->keyToCoord((key_type)(key[j] | block_max))) - origin(j);
+			dist_from_origin_sq += std::max(low * low, high * high);
+		}
+		return dist_from_origin_sq <= maxrange_sq;
+	}
+
+	template <class NODE>
+	void OccupancyQuadTreeBase<NODE>::skipRayBlock(QuadTreeKey& key, const int step[2], double tMax[2], const double tDelta[2],
+												   unsigned int level) {
+		const unsigned int block_max = (1u << level) - 1;
+
+		// The ray leaves the block in the dimension whose boundary after the last pixel
+		// of the block it crosses first (the higher dimension on ties, as castRay() picks
+		// it). tMax is summed up step by step as in castRay() to reach the same pixels.
+		double tExit[2];
+		unsigned int exit_dim = 2;
+		for (unsigned int i = 0; i < 2; ++i) {
+			if (step[i] == 0)
+				continue;
+			unsigned int steps = (step[i] > 0) ? block_max - (key[i] & block_max) : (key[i] & block_max);
+			tExit[i] = tMax[i];
+			for (unsigned int s = 0; s < steps; ++s)
+				tExit[i] += tDelta[i];
+			if (exit_dim == 2 || tExit[i] <= tExit[exit_dim])
+				exit_dim = i;
+		}
+
+		// the other dimension advances as far as it gets before that crossing
+		for (unsigned int i = 0; i < 2; ++i) {
+			if (step[i] == 0)
+				continue;
+			if (i == exit_dim) {
+				key[i] = (key_type)((step[i] > 0) ? (key[i] | block_max) : (key[i] & ~block_max));
+				tMax[i] = tExit[i];
+			}
+			else {
+				while (tMax[i] < tExit[exit_dim] || (tMax[i] == tExit[exit_dim] && i > exit_dim)) {
+					key[i] += step[i];
+					tMax[i] += tDelta[i];
+				}
+			}
+		}
+	}
+
+	template <class NODE>
+	size_t OccupancyQuadTreeBase<NODE>::castRays(const std::vector<point2d>& origins, const std::vector<point2d>& directions,
+												 std::vector<point2d>& ends, std::vector<double>& distances,
+												 bool ignoreUnknown, double maxRange) const {
+		if (origins.size() != directions.size()) {
+			QUADMAP_ERROR("castRays: %zu origins, but %zu directions given\n", origins.size(), directions.size());
+			return 0;
+		}
+		ends.resize(origins.size());
+		distances.resize(origins.size());
+
+		size_t num_hits = 0;
+#ifdef _OPENMP
+#pragma omp parallel reduction(+ : num_hits)
+#endif
+		{
+			// the rays of a thread come in chunks of neighbours, which share most of their search paths
+			SearchCursor cursor;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+			for (int i = 0; i < (int)origins.size(); ++i) {
+				if (castRay(origins[i], directions[i], ends[i], cursor, ignoreUnknown, maxRange)) {
+					distances[i] = (ends[i] - origins[i]).norm();
+					num_hits++;
+				}
+				else
+					distances[i] = -1.0;
+			}
+		}
+		return num_hits;
+	}
+
 	template <class NODE>
 	bool OccupancyQuadTreeBase<NODE>::getRayIntersection(const point2d& origin, const point2d& direction, const point2d& center,
 														 point2d& intersection, double delta/*=0.0*/) const {
@@ -831,6 +1131,8 @@ namespace quadmap {
 		this->readBinaryNode(s, this->root);
 		this->size_changed = true;
 		this->tree_size = QuadTreeBaseImpl<NODE, AbstractOccupancyQuadTree>::calcNumNodes();  // compute number of nodes    
+		if (use_frontier_tracking)
+			rebuildFrontiers();
 		return s;
 	}
 
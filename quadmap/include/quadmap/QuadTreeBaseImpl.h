@@ -79,6 +79,36 @@ namespace quadmap {
 		// as a member from this file
 #include <quadmap/QuadTreeIterator.hxx>
 
+		/**
+		 * Remembers the root-to-leaf path of the last search() made through it. The next
+		 * search starts at the deepest common ancestor of the old and the new key instead
+		 * of the root, so coherent accesses (ray traversal, neighbour queries) only descend
+		 * the last few levels. The cursor notices node deletions in its tree and restarts
+		 * at the root then; it must not be used after the tree is destroyed.
+		 */
+		class SearchCursor {
+		public:
+			SearchCursor() : tree(NULL), node_deletions(0), depth(0) {}
+
+			/// Forgets the remembered path, the next search starts at the root
+			void reset() { tree = NULL; }
+
+			/// @return depth of the deepest node reached by the last search
+			unsigned int getDepth() const { return depth; }
+
+			/// @return node at depth d <= getDepth() on the path of the last search
+			NODE* getNode(unsigned int d) const { assert(d <= depth); return path[d]; }
+
+		private:
+			friend class QuadTreeBaseImpl<NODE, INTERFACE>;
+
+			const QuadTreeBaseImpl<NODE, INTERFACE>* tree; ///< tree of the path, NULL if none
+			size_t node_deletions; ///< deletion count of the tree when the path was recorded
+			QuadTreeKey key;       ///< key of the last search
+			unsigned int depth;
+			NODE* path[17];        ///< path[0] is the root, the tree depth is at most 16
+		};
+
 		QuadTreeBaseImpl(double resolution);
 		virtual ~QuadTreeBaseImpl();
 
@@ -196,6 +226,14 @@ namespace quadmap {
 		 */
 		NODE* search(const QuadTreeKey& key, unsigned int depth = 0) const;
 
+		/**
+		 *  Search a node like search(key, depth), resuming at the deepest node that the
+		 *  path of the previous search through cursor shares with key. The path to the
+		 *  returned node (or to the deepest existing node above key) is stored in cursor.
+		 *  @return pointer to node if found, NULL otherwise
+		 */
+		NODE* search(const QuadTreeKey& key, SearchCursor& cursor, unsigned int depth = 0) const;
+
 		/**
 		 *  Delete a node (if exists) given a 2d point. Will always
 		 *  delete at the lowest level unless depth !=0, and expand pruned inner nodes as needed.
@@ -543,6 +581,8 @@ namespace quadmap {
 		double resolution_factor; ///< = 1. / resolution
 
 		size_t tree_size; ///< number of nodes in tree
+		/// counts the operations that deleted nodes, invalidates the path of a SearchCursor
+		size_t node_deletions;
 		/// flag to denote whether the quadtree extent changed (for lazy min/max eval)
 		bool size_changed;
 
@@ -45,7 +45,7 @@ namespace quadmap {
 	template <class NODE, class I>
 	QuadTreeBaseImpl<NODE, I>::QuadTreeBaseImpl(double in_resolution) :
 		I(), root(NULL), tree_depth(16), tree_max_val(32768),
-		resolution(in_resolution), tree_size(0)
+		resolution(in_resolution), tree_size(0), node_deletions(0)
 	{
 
 		init();
@@ -56,7 +56,7 @@ namespace quadmap {
 	template <class NODE, class I>
 	QuadTreeBaseImpl<NODE, I>::QuadTreeBaseImpl(double in_resolution, unsigned int in_tree_depth, unsigned int in_tree_max_val) :
 		I(), root(NULL), tree_depth(in_tree_depth), tree_max_val(in_tree_max_val),
-		resolution(in_resolution), tree_size(0)
+		resolution(in_resolution), tree_size(0), node_deletions(0)
 	{
 		init();
 
@@ -73,7 +73,7 @@ namespace quadmap {
 	template <class NODE, class I>
 	QuadTreeBaseImpl<NODE, I>::QuadTreeBaseImpl(const QuadTreeBaseImpl<NODE, I>& rhs) :
 		root(NULL), tree_depth(rhs.tree_depth), tree_max_val(rhs.tree_max_val),
-		resolution(rhs.resolution), tree_size(rhs.tree_size)
+		resolution(rhs.resolution), tree_size(rhs.tree_size), node_deletions(0)
 	{
 		init();
 
@@ -119,6 +119,10 @@ namespace quadmap {
 		size_t this_size = this->tree_size;
 		this->tree_size = other.tree_size;
 		other.tree_size = this_size;
+
+		// the roots changed, invalidate the cursors of both trees
+		this->node_deletions++;
+		other.node_deletions++;
 	}
 
 	template <class NODE, class I>
@@ -194,6 +198,7 @@ namespace quadmap {
 
 		tree_size--;
 		size_changed = true;
+		node_deletions++;
 	}
 
 	template <class NODE, class I>
@@ -474,6 +479,59 @@ namespace quadmap {
 		return curNode;
 	}
 
+	template <class NODE, class I>
+	NODE* QuadTreeBaseImpl<NODE, I>::search(const QuadTreeKey& key, SearchCursor& cursor, unsigned int depth) const {
+		assert(depth <= tree_depth);
+		if (root == NULL){
+			cursor.reset();
+			return NULL;
+		}
+
+		if (depth == 0)
+			depth = tree_depth;
+
+		QuadTreeKey key_at_depth = key;
+		if (depth != tree_depth)
+			key_at_depth = adjustKeyAtDepth(key, depth);
+
+		unsigned int cur_depth = 0;
+		if (cursor.tree != this || cursor.node_deletions != node_deletions){
+			// no usable path, start at the root
+			cursor.tree = this;
+			cursor.node_deletions = node_deletions;
+			cursor.path[0] = root;
+		}
+		else {
+			// both keys share their ancestors down to the highest differing bit
+			unsigned int diff = (key_at_depth[0] ^ cursor.key[0]) | (key_at_depth[1] ^ cursor.key[1]);
+			cur_depth = tree_depth;
+			for (; diff != 0; diff >>= 1)
+				cur_depth--;
+			// neither reuse the path beyond the last search nor beyond the requested depth
+			cur_depth = std::min(std::min(cur_depth, cursor.depth), depth);
+		}
+		cursor.key = key_at_depth;
+
+		NODE* curNode = cursor.path[cur_depth];
+		for (; cur_depth < depth; ++cur_depth) {
+			unsigned int pos = computeChildIdx(key_at_depth, tree_depth - 1 - cur_depth);
+			if (nodeChildExists(curNode, pos)) {
+				curNode = getNodeChild(curNode, pos);
+				cursor.path[cur_depth + 1] = curNode;
+			}
+			else {
+				cursor.depth = cur_depth;
+				// a pruned leaf covers the key, otherwise the search failed
+				if (!nodeHasChildren(curNode))
+					return curNode;
+				else
+					return NULL;
+			}
+		}
+		cursor.depth = cur_depth;
+		return curNode;
+	}
+
 
 	template <class NODE, class I>
 	bool QuadTreeBaseImpl<NODE, I>::deleteNode(const point2d& value, unsigned int depth) {
@@ -518,6 +576,7 @@ namespace quadmap {
 			deleteNodeRecurs(root);
 			this->tree_size = 0;
 			this->root = NULL;
+			this->node_deletions++;
 			// max extent of tree changed:
 			this->size_changed = true;
 		}
@@ -79,7 +79,31 @@ namespace quadmap{
 		 */
         virtual void insertSuperRayCloudRays(const Pointcloud& scan, const point2d& origin, const int threshold);
 
+        /**
+         * Enable or disable the culling by a polar visibility profile instead of the culling region (default: disabled).
+         * The profile keeps the free radius per angular bin around the origin (see buildVisibilityProfile()),
+         * so that each ray is culled at a cutoff distance instead of probing the culling region on every step.
+         * The result is identical.
+         */
+        void enablePolarCulling(bool enable) { use_polar_culling = enable; }
+        bool isPolarCullingEnabled() const { return use_polar_culling; }
+
     protected:
+        /// Polar visibility profile around the origin: the free radius per angular bin
+        struct VisibilityProfile {
+            point2d origin;
+            double bin_width;               ///< angular width of a bin in radians
+            std::vector<double> radius;     ///< radius within which all cells overlapping the bin are fully free
+
+            /// @return free radius in the direction from the origin towards the point
+            double getFreeRadius(const point2d& p) const {
+                if (radius.empty())
+                    return 0.0;
+                int bin = (int)((atan2(p.y() - origin.y(), p.x() - origin.x()) + M_PI) / bin_width);
+                return radius[std::min(std::max(bin, 0), (int)radius.size() - 1)];
+            }
+        };
+
         /**
 		 * Build a culling region by utilizing the occupancy information updated to the map.
 		 * The implementation is based on a priority queue according to the Manhattan distance from the origin cell.
@@ -121,6 +145,67 @@ namespace quadmap{
          */
         bool computeInverseRayKeys(const point2d& origin, const point2d& end, KeyRay& ray, KeySet& cullingregion);
 
+        /**
+         * Build a polar visibility profile by utilizing the occupancy information updated to the map.
+         * The fully free cells connected to the origin cell (8-neighborhood) are flooded, and the radius of each
+         * angular bin is limited by the nearest cell that bounds the flooded cells and overlaps the bin.
+         * Every cell within the radius of a bin is hence fully free, as in the culling region.
+         *
+         * @param origin measurement origin in global reference frame
+         * @param max_propagation maximum range of the flooding in cells from the origin cell
+         * @return visibility profile limited by the range of the flooding
+         */
+        VisibilityProfile buildVisibilityProfile(const point2d& origin, const int max_propagation);
+
+        /**
+         * Build a polar visibility profile by utilizing the occupancy information updated to the map.
+         *
+         * @param scan Pointcloud (measurement endpoints), in global reference frame
+         * @param origin measurement origin in global reference frame
+         * @return visibility profile limited by the range of measurements
+         */
+        VisibilityProfile buildVisibilityProfile(const Pointcloud& scan, const point2d& origin);
+
+        /**
+         * Build a polar visibility profile by utilizing the occupancy information updated to the map.
+         *
+         * @param superrays Super rays computed from the measurements in global reference frame
+         * @param origin measurement origin in global reference frame
+         * @return visibility profile limited by the range of measurements
+         */
+        VisibilityProfile buildVisibilityProfile(const SuperRayCloud& superrays, const point2d& origin);
+
+        /// Limit the radii of the bins overlapping the cell, which is not fully free, by the distance to the cell
+        void blockVisibilityProfile(VisibilityProfile& profile, const QuadTreeKey& key) const;
+
+        /**
+         * Traces a sensor ray from origin (excluding) to end in the inverse direction, as computeInverseRayKeys() above.
+         * The traversal stops when the ray enters the free radius of the visibility profile.
+         *
+         * @param origin start coordinate of ray (end point of sensor ray)
+         * @param end end coordinate of ray (sensor origin)
+         * @param ray KeyRay structure that holds the keys of all nodes traversed by the ray, excluding the origin cell
+         * @param profile visibility profile built for the sensor origin
+         * @return Success of operation. Returning false usually means that one of the coordinates is out of the QuadTree's range
+         */
+        bool computeInverseRayKeys(const point2d& origin, const point2d& end, KeyRay& ray, const VisibilityProfile& profile);
+
+
+        /**
+         * Merge the per-thread batch tables into the tables of the first thread.
+         * The tables are laid out as [thread * num_shards + shard], and each shard holds a disjoint key range
+         * (see computeBatchShard()), so that the shards are merged in parallel without any locking.
+         *
+         * @param batches per-thread batch tables, the merged results are stored in batches[0 .. num_shards-1]
+         * @param num_shards number of the key-range shards per thread
+         */
+        void mergeBatches(std::vector<KeyIntMap>& batches, const unsigned int num_shards);
+
+        /// @return index of the key-range shard containing the key, partitioned along the first axis
+        inline unsigned int computeBatchShard(const QuadTreeKey& key, const unsigned int num_shards) const {
+            return (unsigned int)(((size_t)key[0] * num_shards) / (2 * tree_max_val));
+        }
+
 
         /**
          * Static member object which ensures that this QuadTree's prototype
@@ -146,6 +231,8 @@ namespace quadmap{
         };
         /// static member to ensure static initialization (only once)
         static StaticMemberInitializer cullingregionQuadTreeMemberInit;
+
+        bool use_polar_culling;
     };
 }
 
@@ -31,12 +31,12 @@
 
 namespace quadmap{
     CullingRegionQuadTree::CullingRegionQuadTree(double in_resolution)
-            : OccupancyQuadTreeBase<QuadTreeNode>(in_resolution) {
+            : OccupancyQuadTreeBase<QuadTreeNode>(in_resolution), use_polar_culling(false) {
         cullingregionQuadTreeMemberInit.ensureLinking();
     };
 
     CullingRegionQuadTree::CullingRegionQuadTree(std::string _filename)
-            : OccupancyQuadTreeBase<QuadTreeNode>(0.1)  { // resolution will be set according to tree file
+            : OccupancyQuadTreeBase<QuadTreeNode>(0.1), use_polar_culling(false)  { // resolution will be set according to tree file
         readBinary(_filename);
     }
 
@@ -47,11 +47,17 @@ namespace quadmap{
         if (pc.size() < 1)
             return;
 
-        // Build a culling region
-        KeySet cullingregion = buildCullingRegion(pc, origin);
-
-        // Batch a set of the updates
-        KeyIntMap free_cells, occupied_cells;
+        // Build a culling region, or a visibility profile in the polar culling mode
+        KeySet cullingregion;
+        VisibilityProfile profile;
+        if (use_polar_culling)
+            profile = buildVisibilityProfile(pc, origin);
+        else
+            cullingregion = buildCullingRegion(pc, origin);
+
+        // Batch a set of the updates into the per-thread tables, sharded by key range
+        const unsigned int num_shards = (unsigned int)this->keyrays.size();
+        std::vector<KeyIntMap> free_batches(num_shards * num_shards), hit_batches(num_shards * num_shards);
 #ifdef _OPENMP
         omp_set_num_threads(this->keyrays.size());
 	#pragma omp parallel for
@@ -63,43 +69,32 @@ namespace quadmap{
             threadIdx = omp_get_thread_num();
 #endif
             KeyRay* keyray = &(this->keyrays.at(threadIdx));
-
-            if (this->computeInverseRayKeys(p, origin, *keyray, cullingregion)){
-#ifdef _OPENMP
-#pragma omp critical (free_batch)
-#endif
-                {
-                    // Batch the cells to be updated into the free states
-                    for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); ++it){
-                        const KeyIntMap::iterator& cell = free_cells.find(*it);
-                        if (cell == free_cells.end())
-                            free_cells.insert(std::pair<QuadTreeKey, int>(*it, 1));
-                        else
-                            cell->second = cell->second + 1;
-                    }
-                }
-
-#ifdef _OPENMP
-#pragma omp critical (hit_batch)
-#endif
-                {
-                    // Batch the cells to be updated into the occupied states
-                    QuadTreeKey key = coordToKey(p);
-                    const KeyIntMap::iterator& cell = occupied_cells.find(key);
-                    if (cell == occupied_cells.end())
-                        occupied_cells.insert(std::pair<QuadTreeKey, int>(key, 1));
-                    else
-                        cell->second = cell->second + 1;
-                }
+            KeyIntMap* free_shards = &(free_batches[threadIdx * num_shards]);
+            KeyIntMap* hit_shards = &(hit_batches[threadIdx * num_shards]);
+
+            bool traced = use_polar_culling ? this->computeInverseRayKeys(p, origin, *keyray, profile)
+                                            : this->computeInverseRayKeys(p, origin, *keyray, cullingregion);
+            if (traced){
+                // Batch the cells to be updated into the free states
+                for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); ++it)
+                    free_shards[computeBatchShard(*it, num_shards)][*it] += 1;
+
+                // Batch the cells to be updated into the occupied states
+                QuadTreeKey key = coordToKey(p);
+                hit_shards[computeBatchShard(key, num_shards)][key] += 1;
             }
         }
 
-        // Update the occupancies of the batched cells
-        for (KeyIntMap::iterator it = free_cells.begin(); it != free_cells.end(); ++it) {
-            updateNode(it->first, it->second * prob_miss_log);
+        // Merge the per-thread tables, and then update the occupancies of the batched cells
+        mergeBatches(free_batches, num_shards);
+        mergeBatches(hit_batches, num_shards);
+        for (unsigned int shard = 0; shard < num_shards; shard++) {
+            for (KeyIntMap::iterator it = free_batches[shard].begin(); it != free_batches[shard].end(); ++it)
+                updateNode(it->first, it->second * prob_miss_log);
         }
-        for (KeyIntMap::iterator it = occupied_cells.begin(); it != occupied_cells.end(); ++it) {
-            updateNode(it->first, it->second * prob_hit_log);
+        for (unsigned int shard = 0; shard < num_shards; shard++) {
+            for (KeyIntMap::iterator it = hit_batches[shard].begin(); it != hit_batches[shard].end(); ++it)
+                updateNode(it->first, it->second * prob_hit_log);
         }
     }
 
@@ -113,60 +108,78 @@ namespace quadmap{
         SuperRayCloud srcloud;
         srgenerator.GenerateSuperRay(pc, origin, srcloud);
 
-        // Build a culling region
-        KeySet cullingregion = buildCullingRegion(srcloud, origin);
-
-        // Batch a set of the updates
-        KeyIntMap free_cells, occupied_cells;
+        // Build a culling region, or a visibility profile in the polar culling mode
+        KeySet cullingregion;
+        VisibilityProfile profile;
+        if (use_polar_culling)
+            profile = buildVisibilityProfile(srcloud, origin);
+        else
+            cullingregion = buildCullingRegion(srcloud, origin);
+
+        // Batch a set of the updates into the per-thread tables, sharded by key range
+        const unsigned int num_shards = (unsigned int)this->keyrays.size();
+        std::vector<KeyIntMap> free_batches(num_shards * num_shards), hit_batches(num_shards * num_shards);
 #ifdef _OPENMP
         omp_set_num_threads(this->keyrays.size());
 	#pragma omp parallel for
 #endif
         for (int i = 0; i < (int)srcloud.size(); ++i) {
             const point2d& p = srcloud[i].p;
+            const int w = srcloud[i].w;
             unsigned threadIdx = 0;
 #ifdef _OPENMP
             threadIdx = omp_get_thread_num();
 #endif
             KeyRay* keyray = &(this->keyrays.at(threadIdx));
+            KeyIntMap* free_shards = &(free_batches[threadIdx * num_shards]);
+            KeyIntMap* hit_shards = &(hit_batches[threadIdx * num_shards]);
+
+            bool traced = use_polar_culling ? this->computeInverseRayKeys(p, origin, *keyray, profile)
+                                            : this->computeInverseRayKeys(p, origin, *keyray, cullingregion);
+            if (traced){
+                // Batch the cells to be updated into the free states
+                for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); ++it)
+                    free_shards[computeBatchShard(*it, num_shards)][*it] += w;
+
+                // Batch the cells to be updated into the occupied states
+                QuadTreeKey key = coordToKey(p);
+                hit_shards[computeBatchShard(key, num_shards)][key] += w;
+            }
+        }
 
-            if (this->computeInverseRayKeys(p, origin, *keyray, cullingregion)){
-#ifdef _OPENMP
-#pragma omp critical (free_batch)
-#endif
-                {
-                    // Batch the cells to be updated into the free states
-                    for (KeyRay::iterator it = keyray->begin(); it != keyray->end(); ++it){
-                        const KeyIntMap::iterator& cell = free_cells.find(*it);
-                        if (cell == free_cells.end())
-                            free_cells.insert(std::pair<QuadTreeKey, int>(*it, srcloud[i].w));
-                        else
-                            cell->second = cell->second + srcloud[i].w;
-                    }
-                }
+        // Merge the per-thread tables, and then update the occupancies of the batched cells
+        mergeBatches(free_batches, num_shards);
+        mergeBatches(hit_batches, num_shards);
+        for (unsigned int shard = 0; shard < num_shards; shard++) {
+            for (KeyIntMap::iterator it = free_batches[shard].begin(); it != free_batches[shard].end(); ++it)
+                updateNode(it->first, it->second * prob_miss_log);
+        }
+        for (unsigned int shard = 0; shard < num_shards; shard++) {
+            for (KeyIntMap::iterator it = hit_batches[shard].begin(); it != hit_batches[shard].end(); ++it)
+                updateNode(it->first, it->second * prob_hit_log);
+        }
+    }
 
+    void CullingRegionQuadTree::mergeBatches(std::vector<KeyIntMap>& batches, const unsigned int num_shards)
+    {
+        const unsigned int num_tables = (unsigned int)batches.size() / num_shards;
+
+        // Each shard covers a disjoint key range, so that the shards are merged independently
 #ifdef _OPENMP
-#pragma omp critical (hit_batch)
+        omp_set_num_threads(num_shards);
+	#pragma omp parallel for
 #endif
-                {
-                    // Batch the cells to be updated into the occupied states
-                    QuadTreeKey key = coordToKey(p);
-                    const KeyIntMap::iterator& cell = occupied_cells.find(key);
-                    if (cell == occupied_cells.end())
-                        occupied_cells.insert(std::pair<QuadTreeKey, int>(key, srcloud[i].w));
-                    else
-                        cell->second = cell->second + srcloud[i].w;
-                }
+        for (int shard = 0; shard < (int)num_shards; ++shard) {
+            KeyIntMap& merged = batches[shard];
+            for (unsigned int table = 1; table < num_tables; table++) {
+                KeyIntMap& local = batches[table * num_shards + shard];
+                if (merged.size() < local.size())
+                    merged.swap(local);
+                for (KeyIntMap::iterator it = local.begin(); it != local.end(); ++it)
+                    merged[it->first] += it->second;
+                local.clear();
             }
         }
-
-        // Update the occupancies of the batched cells
-        for (KeyIntMap::iterator it = free_cells.begin(); it != free_cells.end(); ++it) {
-            updateNode(it->first, it->second * prob_miss_log);
-        }
-        for (KeyIntMap::iterator it = occupied_cells.begin(); it != occupied_cells.end(); ++it) {
-            updateNode(it->first, it->second * prob_hit_log);
-        }
     }
 
     KeySet CullingRegionQuadTree::buildCullingRegion(const point2d& origin, const int max_propagation)
@@ -277,6 +290,129 @@ namespace quadmap{
         return buildCullingRegion(origin, (int)(max_dist / resolution));
     }
 
+    CullingRegionQuadTree::VisibilityProfile CullingRegionQuadTree::buildVisibilityProfile(const point2d& origin, const int max_propagation)
+    {
+        VisibilityProfile profile;
+        profile.origin = origin;
+
+        // One bin per cell on the circumference at the maximum range, and no culling beyond the range
+        const int num_bins = std::max(8, (int)ceil(2.0 * M_PI * max_propagation));
+        profile.bin_width = 2.0 * M_PI / num_bins;
+        profile.radius.assign(num_bins, std::max(max_propagation - 1, 0) * resolution);
+
+        QuadTreeKey originKey = coordToKey(origin);
+        QuadTreeNode* node = search(originKey);
+        if (!node || node->getLogOdds() > clamping_thres_min) {
+            std::fill(profile.radius.begin(), profile.radius.end(), 0.0);
+            return profile;
+        }
+
+        // Flood the fully free cells from the origin cell within the window of the propagation
+        const int width = 2 * max_propagation + 1;
+        std::vector<unsigned char> visited(width * width, 0);
+        std::vector<std::pair<int, int> > stack;
+        visited[max_propagation * width + max_propagation] = 1;
+        stack.push_back(std::make_pair(0, 0));
+
+        while (!stack.empty()) {
+            const std::pair<int, int> cell = stack.back();
+            stack.pop_back();
+
+            for (int dx = -1; dx <= 1; dx++) {
+                for (int dy = -1; dy <= 1; dy++) {
+                    const int x = cell.first + dx;
+                    const int y = cell.second + dy;
+                    if (abs(x) > max_propagation || abs(y) > max_propagation)
+                        continue;
+
+                    unsigned char& cell_visited = visited[(y + max_propagation) * width + (x + max_propagation)];
+                    if (cell_visited)
+                        continue;
+                    cell_visited = 1;
+
+                    const int key_x = (int)originKey[0] + x;
+                    const int key_y = (int)originKey[1] + y;
+                    if (key_x < 0 || key_y < 0 || key_x >= 2 * (int)tree_max_val || key_y >= 2 * (int)tree_max_val)
+                        continue;
+
+                    // The fully free cells are flooded, and the others bound the visibility
+                    QuadTreeKey key((key_type)key_x, (key_type)key_y);
+                    node = search(key);
+                    if (node && node->getLogOdds() <= clamping_thres_min)
+                        stack.push_back(std::make_pair(x, y));
+                    else
+                        blockVisibilityProfile(profile, key);
+                }
+            }
+        }
+
+        return profile;
+    }
+
+    CullingRegionQuadTree::VisibilityProfile CullingRegionQuadTree::buildVisibilityProfile(const Pointcloud& pc, const point2d& origin)
+    {
+        // Find the maximum distance between the sensor origin and the end point
+        double max_dist = 0.0;
+        for(int i = 0; i < (int)pc.size(); i++){
+            double distance = (pc[i] - origin).norm();
+            if(distance > max_dist)
+                max_dist = distance;
+        }
+
+        // Build a visibility profile limited by the range of sensor measurements
+        return buildVisibilityProfile(origin, (int)(max_dist / resolution));
+    }
+
+    CullingRegionQuadTree::VisibilityProfile CullingRegionQuadTree::buildVisibilityProfile(const SuperRayCloud& superrays, const point2d& origin)
+    {
+        // Find the maximum distance between the sensor origin and the end point
+        double max_dist = 0.0;
+        for(int i = 0; i < (int)superrays.size(); i++){
+            double distance = (superrays[i].p - origin).norm();
+            if(distance > max_dist)
+                max_dist = distance;
+        }
+
+        // Build a visibility profile limited by the range of sensor measurements
+        return buildVisibilityProfile(origin, (int)(max_dist / resolution));
+    }
+
+    void CullingRegionQuadTree::blockVisibilityProfile(VisibilityProfile& profile, const QuadTreeKey& key) const
+    {
+        const int num_bins = (int)profile.radius.size();
+        const point2d center = keyToCoord(key);
+        const double half = 0.5 * resolution;
+        const double cx = center.x() - profile.origin.x();
+        const double cy = center.y() - profile.origin.y();
+
+        // Nearest distance to the cell, with a margin for the discretization errors of the traversals
+        const double dx = std::max(fabs(cx) - half, 0.0);
+        const double dy = std::max(fabs(cy) - half, 0.0);
+        const double distance = sqrt(dx * dx + dy * dy) - 0.01 * resolution;
+        if (distance <= 0.0) {
+            std::fill(profile.radius.begin(), profile.radius.end(), 0.0);
+            return;
+        }
+
+        // Angular span of the cell seen from the origin, with a margin as well
+        const double center_angle = atan2(cy, cx);
+        double min_angle = 0.0, max_angle = 0.0;
+        for (int corner = 0; corner < 4; corner++) {
+            double angle = atan2(cy + ((corner & 2) ? half : -half), cx + ((corner & 1) ? half : -half)) - center_angle;
+            if (angle > M_PI)           angle -= 2.0 * M_PI;
+            else if (angle < -M_PI)     angle += 2.0 * M_PI;
+            min_angle = std::min(min_angle, angle);
+            max_angle = std::max(max_angle, angle);
+        }
+        const int first_bin = (int)floor((center_angle + min_angle - 1e-4 + M_PI) / profile.bin_width);
+        const int last_bin = (int)floor((center_angle + max_angle + 1e-4 + M_PI) / profile.bin_width);
+
+        for (int bin = first_bin; bin <= last_bin; bin++) {
+            double& radius = profile.radius[((bin % num_bins) + num_bins) % num_bins];
+            radius = std::min(radius, distance);
+        }
+    }
+
     bool CullingRegionQuadTree::computeInverseRayKeys(const point2d& origin, const point2d& end, KeyRay& ray, KeySet& cullingregion)
     {
         // see "A Faster Voxel Traversal Algorithm for Ray Tracing" by Amanatides & Woo
@@ -368,4 +504,99 @@ namespace quadmap{
 
         return true;
     }
-}
\ No newline at end of file
+
+    bool CullingRegionQuadTree::computeInverseRayKeys(const point2d& origin, const point2d& end, KeyRay& ray, const VisibilityProfile& profile)
+    {
+        // see "A Faster Voxel Traversal Algorithm for Ray Tracing" by Amanatides & Woo
+        // basically: DDA in 3D
+
+        ray.reset();
+
+        QuadTreeKey key_origin, key_end;
+        if ( !coordToKeyChecked(origin, key_origin) || !coordToKeyChecked(end, key_end) ) {
+            QUADMAP_WARNING_STR("coordinates ( " << origin << " -> " << end << ") out of bounds in computeRayKeys");
+            return false;
+        }
+
+        if (key_origin == key_end)
+            return true; // same tree cell, we're done.
+
+        // Initialization phase -------------------------------------------------------
+        point2d direction = (end - origin);
+        float length = (float) direction.norm();
+        direction /= length; // normalize vector
+
+        // All cells within the free radius towards the end point are fully free
+        const double free_radius = profile.getFreeRadius(origin);
+
+        int    step[2];
+        double tMax[2];
+        double tDelta[2];
+
+        QuadTreeKey current_key = key_origin;
+
+        for(unsigned int i = 0; i < 2; ++i) {
+            // compute step direction
+            if (direction(i) > 0.0)         step[i] = 1;
+            else if (direction(i) < 0.0)    step[i] = -1;
+            else                            step[i] = 0;
+
+            // compute tMax, tDelta
+            if (step[i] != 0) {
+                // corner point of voxel (in direction of ray)
+                double voxelBorder = this->keyToCoord(current_key[i]);
+                voxelBorder += (float) (step[i] * this->resolution * 0.5);
+
+                tMax[i] = ( voxelBorder - origin(i) ) / direction(i);
+                tDelta[i] = this->resolution / fabs( direction(i) );
+            }
+            else {
+                tMax[i] =  std::numeric_limits<double>::max( );
+                tDelta[i] = std::numeric_limits<double>::max( );
+            }
+        }
+
+        // Incremental phase  ---------------------------------------------------------
+        bool done = false;
+        while (!done) {
+            // find minimum tMax:
+            unsigned int dim = tMax[0] < tMax[1] ? 0 : 1;
+
+            // advance in direction "dim"
+            current_key[dim] += step[dim];
+            tMax[dim] += tDelta[dim];
+
+            assert (current_key[dim] < 2*this->tree_max_val);
+
+            // Culling out the traversal when the current cell reaches into the free radius
+            if (free_radius > 0.0 && length - std::min(tMax[0], tMax[1]) < free_radius){
+                done = true;
+                break;
+            }
+            // reached endpoint, key equv?
+            else if (current_key == key_end) {
+                ray.addKey(current_key);
+                done = true;
+                break;
+            }
+            else {
+                // reached endpoint world coords?
+                // dist_from_origin now contains the length of the ray when traveled until the border of the current voxel
+                double dist_from_origin = std::min(tMax[0], tMax[1]);
+                // if this is longer than the expected ray length, we should have already hit the voxel containing the end point with the code above (key_end).
+                // However, we did not hit it due to accumulating discretization errors, so this is the point here to stop the ray as we would never reach the voxel key_end
+                if (dist_from_origin > length) {
+                    done = true;
+                    break;
+                }
+                else {  // continue to add freespace cells
+                    ray.addKey(current_key);
+                }
+            }
+
+            assert ( ray.size() < ray.sizeMax() - 1);
+        } // end while
+
+        return true;
+    }
+}
@@ -75,6 +75,9 @@ namespace quadmap{
 		for (int i = 0; i < (int)pc.size(); ++i){
 			updateNode(pc[i], true); // update endpoint to be occupied
 		}
+
+		if (isFrontierTrackingEnabled())
+			updateFrontiers();
 	}
 
 	void SuperRayQuadTree::insertSuperRayCloudRays(const Pointcloud& scan, const point2d& origin, const int threshold)
@@ -120,5 +123,8 @@ namespace quadmap{
 		for (int i = 0; i < (int)superray.size(); ++i){
 			updateNode(superray[i].p, prob_hit_log * superray[i].w, false);
 		}
+
+		if (isFrontierTrackingEnabled())
+			updateFrontiers();
 	}
 }
\ No newline at end of file
@@ -16,6 +16,7 @@ void printUsage(char* self){
     std::cout << " -o <OutputFile.bt2 or OutputFile.ot2> (required)" << std::endl;
     std::cout << " -res <resolution[m]> (optional, default 0.1m)" << std::endl;
     std::cout << " -thr <threshold> (optional, default 20)" << std::endl;
+    std::cout << " -polar (optional, culling by a polar visibility profile)" << std::endl;
 
     exit(0);
 }
@@ -24,6 +25,7 @@ int main(int argc, char** argv) {
     // default values
     double res = 0.1;
     int threshold = 20;
+    bool polar = false;
     std::string graphFilename = "";
     std::string treeFilename = "";
 
@@ -42,6 +44,8 @@ int main(int argc, char** argv) {
             res = atof(argv[++arg]);
         else if (!strcmp(argv[arg], "-thr"))
             threshold = atoi(argv[++arg]);
+        else if (!strcmp(argv[arg], "-polar"))
+            polar = true;
         else {
             printUsage(argv[0]);
         }
@@ -82,6 +86,7 @@ int main(int argc, char** argv) {
 
     std::cout << "\nCreating tree\n===========================\n";
     quadmap::CullingRegionQuadTree* tree = new quadmap::CullingRegionQuadTree(res);
+    tree->enablePolarCulling(polar);
 
     double time_to_update = 0.0;	// sec
     size_t currentScan = 1;